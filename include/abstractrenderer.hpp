@@ -215,6 +215,8 @@ public:
     // Drawing commands, which will be buffered and issued at the end of the frame.
 
     void TexturedQuad(TextureHandle texHandle, f32 x, f32 y, f32 w, f32 h, int layer, ColourU8 colour, eBlendModes blendMode = eBlendModes::eNormal, eCoordinateSystem coordinateSystem = eCoordinateSystem::eWorld);
+    // Draws the part of the texture from (u1, v1) to (u2, v2), where (1, 1) is the bottom right of the texture
+    void TexturedQuad(TextureHandle texHandle, f32 x, f32 y, f32 w, f32 h, f32 u1, f32 v1, f32 u2, f32 v2, int layer, ColourU8 colour, eBlendModes blendMode = eBlendModes::eNormal, eCoordinateSystem coordinateSystem = eCoordinateSystem::eWorld);
     void Rect(f32 x, f32 y, f32 w, f32 h, int layer, ColourU8 colour, eBlendModes blendMode = eBlendModes::eNormal, eCoordinateSystem coordinateSystem = eCoordinateSystem::eWorld);
     void Text(f32 x, f32 y, f32 fontSize, const char* text, ColourU8 colour, int layer, eBlendModes blendMode = eBlendModes::eNormal, eCoordinateSystem coordinateSystem = eCoordinateSystem::eWorld);
     void PathBegin();
@@ -265,6 +267,10 @@ private:
         f32 mY;
         f32 mW;
         f32 mH;
+        f32 mU1;
+        f32 mV1;
+        f32 mU2;
+        f32 mV2;
     };
 
     struct CmdRect
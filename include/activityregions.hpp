@@ -0,0 +1,57 @@
+#pragma once
+
+#include "types.hpp"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Gives each object type name a number so that queries compare numbers rather than strings
+class ObjectTypeIds
+{
+public:
+    static const u32 kUnknownType = ~0u;
+
+    u32 Intern(const std::string& name);
+
+    // kUnknownType if name was never interned, so no object can have that type
+    u32 Find(const std::string& name) const;
+
+private:
+    std::unordered_map<std::string, u32> mIds;
+};
+
+// Buckets map objects by the camera cell they are in so that only the objects near the camera
+// subject have to be visited each frame. Objects are identified by their index in the owning
+// container, positions outside of the map are put in the nearest edge cell.
+class ActivityRegions
+{
+public:
+    ActivityRegions();
+    void Reset(f32 cellWidth, f32 cellHeight, u32 cellsX, u32 cellsY);
+
+    // Adds the object or moves it to the cell that x, y is in
+    void Place(u32 index, f32 x, f32 y);
+
+    s32 CellX(f32 x) const;
+    s32 CellY(f32 y) const;
+
+    // Replaces indices with the objects that are within radius cells of cellX, cellY in index order
+    void Gather(s32 cellX, s32 cellY, s32 radius, std::vector<u32>& indices) const;
+
+    // Replaces indices with the objects that could overlap the rect in index order. Objects are
+    // placed by their position but can reach in to the next cell, so one more cell is searched on
+    // each side. Objects bigger than a cell can be missed.
+    void GatherRect(f32 x, f32 y, f32 w, f32 h, std::vector<u32>& indices) const;
+
+    u32 ObjectCount() const { return static_cast<u32>(mObjectCells.size()); }
+
+private:
+    void GatherCells(s32 minX, s32 maxX, s32 minY, s32 maxY, std::vector<u32>& indices) const;
+
+    f32 mCellWidth = 0.0f;
+    f32 mCellHeight = 0.0f;
+    s32 mCellsX = 0;
+    s32 mCellsY = 0;
+    std::vector<std::vector<u32>> mCells;
+    std::vector<s32> mObjectCells;
+};
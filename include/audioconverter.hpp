@@ -1,15 +1,48 @@
 #pragma once
 
+#include <vector>
+#include <memory>
 #include "oddlib/stream.hpp"
 #include "oddlib/lvlarchive.hpp"
 #include <vorbis/vorbisenc.h>
 
 class ISound;
 
-class OggDecoder // TODO
+struct OggVorbis_File;
+
+// Incremental decoder for a stereo ogg file, samples are interleaved 16bit PCM
+class OggStream
+{
+public:
+    OggStream();
+    ~OggStream();
+    OggStream(const OggStream&) = delete;
+    OggStream& operator = (const OggStream&) = delete;
+
+    bool Open(const char* fileName);
+    void Close();
+
+    // Returns the number of samples written to pcm, 0 at the end of the stream or once it is
+    // found to be corrupt
+    u32 Read(s16* pcm, u32 numSamples);
+    bool Rewind();
+    u64 TotalSamples() const;
+
+    // True once Read() has found corrupt data, until the next Open() or Rewind()
+    bool Corrupted() const { return mCorrupted; }
+private:
+    std::unique_ptr<OggVorbis_File> mFile;
+    bool mCorrupted = false;
+};
+
+class OggDecoder
 {
 public:
+    OggDecoder() = delete;
 
+    // Decodes a whole stereo ogg file into interleaved 16bit PCM, fails if the file is corrupt or
+    // is shorter than its header says
+    static bool Decode(const char* fileName, std::vector<s16>& pcm);
 };
 
 class AudioConverter
@@ -19,6 +52,9 @@ public:
 
     template<class EncoderAlgorithm>
     static void Convert(ISound& sound, const char* outputName);
+
+    template<class EncoderAlgorithm>
+    static void Convert(ISound& sound, EncoderAlgorithm& encoder);
 };
 
 class WavHeader
@@ -79,11 +115,12 @@ public:
     explicit OggEncoder(const char* outputName);
     ~OggEncoder();
     void Consume(float* readbuffer, long bufferSizeInBytes);
-    void Finish() { }
+    void Finish();
 private:
-    void InitEncoder();
+    void InitEncoder(int serialNumber);
 
     FILE*            output = nullptr;
+    bool             mEndOfStream = false;
     ogg_stream_state os; // take physical pages, weld into a logical stream of packets
     ogg_page         og; // one Ogg bitstream page.  Vorbis packets are inside
     ogg_packet       op; // one raw packet of data for decode
@@ -92,3 +129,17 @@ private:
     vorbis_dsp_state vd; // central working state for the packet->PCM decoder
     vorbis_block     vb; // local working space for packet->PCM decode
 };
+
+// Writes an ogg file while also keeping a 16bit PCM copy of the audio, used by the
+// sound cache so that a freshly rendered sound doesn't need to be decoded again.
+class OggAndPcmEncoder
+{
+public:
+    explicit OggAndPcmEncoder(const char* outputName);
+    void Consume(float* readbuffer, long bufferSizeInBytes);
+    void Finish();
+    std::vector<s16>& Pcm() { return mPcm; }
+private:
+    OggEncoder mOgg;
+    std::vector<s16> mPcm;
+};
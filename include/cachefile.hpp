@@ -0,0 +1,46 @@
+#pragma once
+
+#include "types.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Oddlib
+{
+    class IStream;
+}
+
+class OSBaseFileSystem;
+
+// A file under {CacheDir}, it starts with a header saying which build and which source data the
+// payload was made from, and the size and hash of the payload so that a truncated or damaged file
+// isn't used.
+class CacheFile
+{
+public:
+    CacheFile(const CacheFile&) = delete;
+    CacheFile& operator = (const CacheFile&) = delete;
+    CacheFile(OSBaseFileSystem& fs, u32 magic, u32 format, u32 maxPayloadSize);
+
+    // Returns the file at the start of its payload, or nullptr if there is no such file, it is from
+    // another build or other source data or it isn't the size its header says. The payload hash
+    // isn't checked, so the caller must check anything it reads.
+    std::unique_ptr<Oddlib::IStream> Open(const std::string& fileName, u64 sourceHash);
+
+    // As Open but reads the whole payload and checks it against its hash, returns false if the
+    // file can't be used
+    bool Read(const std::string& fileName, u64 sourceHash, std::vector<u8>& payload);
+
+    // A partly written file is deleted
+    void Write(const std::string& fileName, u64 sourceHash, const std::vector<u8>& payload);
+
+private:
+    struct Header;
+    std::unique_ptr<Oddlib::IStream> OpenPayload(const std::string& fileName, u64 sourceHash, Header& header);
+
+    OSBaseFileSystem& mFs;
+    u32 mMagic = 0;
+    u32 mFormat = 0;
+    u32 mMaxPayloadSize = 0;
+    u64 mVersionHash = 0;
+};
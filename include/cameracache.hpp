@@ -0,0 +1,36 @@
+#pragma once
+
+#include "types.hpp"
+#include "cachefile.hpp"
+#include "oddlib/sdl_raii.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Oddlib
+{
+    class IBits;
+}
+
+class OSBaseFileSystem;
+
+// Keeps the final camera image and FG1 tiles on disk under {CacheDir} as raw pixels, so that a
+// camera that was built before is loaded with a single read instead of being decoded again.
+// This matters most for mod cameras, which need the original camera decoded, a PNG inflated and
+// the upscaling delta applied.
+class CameraCache
+{
+public:
+    CameraCache(const CameraCache&) = delete;
+    CameraCache& operator = (const CameraCache&) = delete;
+    explicit CameraCache(OSBaseFileSystem& fs);
+
+    // Returns nullptr if name isn't in the cache, or was cached by another build or from other source data
+    std::unique_ptr<Oddlib::IBits> Find(const std::string& name, u64 sourceHash);
+    void Add(const std::string& name, u64 sourceHash, const Oddlib::IBits& bits);
+
+private:
+    std::string DiskCacheFileName(const std::string& name) const;
+
+    CacheFile mFile;
+};
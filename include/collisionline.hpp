@@ -6,13 +6,120 @@
 #include <vector>
 #include <memory>
 #include <map>
+#include <utility>
 
 #include <glm/glm.hpp>
 #include <glm/vec2.hpp>
 #include <glm/gtx/vector_angle.hpp>
 #include "imgui/imgui.h"
 
-using CollisionLines = std::vector<std::unique_ptr<class CollisionLine>>;
+class CollisionLine;
+
+// The collision lines of a map along with a uniform grid over them, so that ray casts and picking
+// only have to test the lines that are near to them. Adding or removing lines rebuilds the grid
+// on the next query, after changing the points of a line call LineMoved() to update it.
+class CollisionLines
+{
+public:
+    using Container = std::vector<std::unique_ptr<CollisionLine>>;
+
+    CollisionLines();
+    ~CollisionLines();
+    CollisionLines(const CollisionLines&) = delete;
+    CollisionLines& operator = (const CollisionLines&) = delete;
+
+    size_t size() const { return mLines.size(); }
+    bool empty() const { return mLines.empty(); }
+
+    std::unique_ptr<CollisionLine>& operator[](size_t index) { return mLines[index]; }
+    const std::unique_ptr<CollisionLine>& operator[](size_t index) const { return mLines[index]; }
+
+    // Non const iteration can reorder the lines so the grid is rebuilt
+    Container::iterator begin() { mDirty = true; return mLines.begin(); }
+    Container::iterator end() { mDirty = true; return mLines.end(); }
+    Container::const_iterator begin() const { return mLines.begin(); }
+    Container::const_iterator end() const { return mLines.end(); }
+
+    template<class... Args>
+    void emplace_back(Args&&... args)
+    {
+        mLines.emplace_back(std::forward<Args>(args)...);
+        mDirty = true;
+    }
+
+    void resize(size_t size);
+    void clear();
+
+    void LineMoved(u32 index);
+
+    // Bit used for a line type in the type masks, all types above 30 share the last bit
+    static u32 TypeBit(u32 type) { return type < 31 ? (1u << type) : (1u << 31); }
+
+    // Sets indices to the lines that might be inside of the area given by min and max and have
+    // a type in typeMask, in ascending order
+    void Query(const glm::vec2& min, const glm::vec2& max, u32 typeMask, std::vector<u32>& indices) const;
+
+    struct RayCastQuery
+    {
+        glm::vec2 mFrom;
+        glm::vec2 mTo;
+        u32 mTypeMask;
+    };
+
+    struct RayCastHit
+    {
+        s32 mLine = -1;
+        glm::vec2 mIntersection;
+    };
+
+    // Finds the nearest line that each ray hits. Rays that are near each other should be cast
+    // together as the lines around them are only looked up and gathered once.
+    void RayCastBatch(const RayCastQuery* rays, u32 count, RayCastHit* hits) const;
+
+private:
+    struct CellRange
+    {
+        s32 mX1 = 0;
+        s32 mY1 = 0;
+        s32 mX2 = -1;
+        s32 mY2 = -1;
+    };
+
+    struct CellEntry
+    {
+        u32 mIndex;
+        u32 mTypeBit;
+    };
+
+    struct Cell
+    {
+        u32 mTypeMask = 0;
+        std::vector<CellEntry> mEntries;
+    };
+
+    void Rebuild() const;
+    bool LineCells(u32 index, CellRange& range) const;
+    void AddToCells(u32 index, const CellRange& range) const;
+    void RemoveFromCells(u32 index, const CellRange& range) const;
+
+    Container mLines;
+
+    // The grid is built when it is first queried, like the rest of the map this isn't thread safe
+    mutable bool mDirty = true;
+    mutable glm::vec2 mOrigin;
+    mutable f32 mCellSize = 0.0f;
+    mutable s32 mCellsX = 0;
+    mutable s32 mCellsY = 0;
+    mutable std::vector<Cell> mCells;
+    mutable std::vector<CellRange> mLineCells;
+
+    // Copy of the line end points and type bits as arrays for the ray cast kernels, kept up to date with the grid
+    mutable std::vector<f32> mP1X;
+    mutable std::vector<f32> mP1Y;
+    mutable std::vector<f32> mP2X;
+    mutable std::vector<f32> mP2Y;
+    mutable std::vector<u32> mTypeBits;
+};
 
 inline glm::vec2 normalize_zero_safe(const glm::vec2& vec)
 {
@@ -114,82 +221,7 @@ public:
     bool SetSelected(bool selected);
 
     template<u32 N>
-    static bool RayCast(const CollisionLines& lines, const glm::vec2& line1p1, const glm::vec2& line1p2, u32 const (&collisionTypes)[N], Physics::raycast_collision* const collision)
-    {
-        const CollisionLine* nearestLine = nullptr;
-        float nearestCollisionX = 0;
-        float nearestCollisionY = 0;
-        float nearestDistance = 0.0f;
-
-        for (const std::unique_ptr<CollisionLine>& line : lines)
-        {
-            bool found = false;
-            for (u32 type : collisionTypes)
-            {
-                if (type == line->mType)
-                {
-                    found = true;
-                    break;
-                }
-            }
-
-            if (!found) { continue; }
-
-            const float line1p1x = line1p1.x;
-            const float line1p1y = line1p1.y;
-            const float line1p2x = line1p2.x;
-            const float line1p2y = line1p2.y;
-
-            const float line2p1x = line->mLine.mP1.x;
-            const float line2p1y = line->mLine.mP1.y;
-            const float line2p2x = line->mLine.mP2.x;
-            const float line2p2y = line->mLine.mP2.y;
-
-            // Get the segments' parameters.
-            const float dx12 = line1p2x - line1p1x;
-            const float dy12 = line1p2y - line1p1y;
-            const float dx34 = line2p2x - line2p1x;
-            const float dy34 = line2p2y - line2p1y;
-
-            // Solve for t1 and t2
-            const float denominator = (dy12 * dx34 - dx12 * dy34);
-            if (denominator == 0.0f) { continue; }
-
-            const float t1 = ((line1p1x - line2p1x) * dy34 + (line2p1y - line1p1y) * dx34) / denominator;
-            const float t2 = ((line2p1x - line1p1x) * dy12 + (line1p1y - line2p1y) * dx12) / -denominator;
-
-            // Find the point of intersection.
-            const float intersectionX = line1p1x + dx12 * t1;
-            const float intersectionY = line1p1y + dy12 * t1;
-
-            // The segments intersect if t1 and t2 are between 0 and 1.
-            const bool hasCollided = ((t1 >= 0) && (t1 <= 1) && (t2 >= 0) && (t2 <= 1));
-
-            if (hasCollided)
-            {
-                const float distance = glm::distance(glm::vec2(line1p1x - intersectionX), glm::vec2(line1p1y - intersectionY));
-                if (!nearestLine || distance < nearestDistance)
-                {
-                    nearestCollisionX = intersectionX;
-                    nearestCollisionY = intersectionY;
-                    nearestDistance = distance;
-                    nearestLine = line.get();
-                }
-            }
-        }
-
-        if (nearestLine)
-        {
-            if (collision)
-            {
-                collision->intersection.x = nearestCollisionX;
-                collision->intersection.y = nearestCollisionY;
-            }
-            return true;
-        }
-
-        return false;
-    }
+    static bool RayCast(const CollisionLines& lines, const glm::vec2& line1p1, const glm::vec2& line1p2, u32 const (&collisionTypes)[N], Physics::raycast_collision* const collision);
 
     struct LineData
     {
@@ -202,3 +234,27 @@ private:
 
     bool mSelected = false;
 };
+
+template<u32 N>
+/*static*/ bool CollisionLine::RayCast(const CollisionLines& lines, const glm::vec2& line1p1, const glm::vec2& line1p2, u32 const (&collisionTypes)[N], Physics::raycast_collision* const collision)
+{
+    CollisionLines::RayCastQuery ray = { line1p1, line1p2, 0 };
+    for (u32 type : collisionTypes)
+    {
+        ray.mTypeMask |= CollisionLines::TypeBit(type);
+    }
+
+    CollisionLines::RayCastHit hit;
+    lines.RayCastBatch(&ray, 1, &hit);
+    if (hit.mLine < 0)
+    {
+        return false;
+    }
+
+    if (collision)
+    {
+        collision->intersection.x = hit.mIntersection.x;
+        collision->intersection.y = hit.mIntersection.y;
+    }
+    return true;
+}
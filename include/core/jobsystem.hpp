@@ -0,0 +1,148 @@
+#pragma once
+
+#include "types.hpp"
+#include "oddlib/worker_pool.hpp"
+#include "stdthread.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <vector>
+
+class JobGroup;
+
+// Runs small jobs on a set of worker threads. Each worker has its own deque for each priority, a
+// worker pushes and pops the jobs it creates at the back of its deques so they run while their data
+// is still in cache, and a worker that runs out of jobs steals from the front of the others' deques.
+class JobSystem : public Oddlib::IParallelFor
+{
+public:
+    enum class ePriority
+    {
+        // Work that a frame is waiting for, always taken before streaming work
+        eFrame,
+
+        // Loading and decoding resources. At most one less than the number of workers run these at
+        // the same time so there is always a worker free for frame work.
+        eStreaming
+    };
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator = (const JobSystem&) = delete;
+
+    // At least two workers are always started so one is free for frame work while another streams.
+    // Jobs still queued when the system is destroyed are dropped.
+    explicit JobSystem(u32 numThreads);
+    ~JobSystem();
+
+    // Adds a job to group, add all of the jobs of a group before calling Then() on it
+    void Run(JobGroup& group, std::function<void()> fn, ePriority priority = ePriority::eFrame);
+
+    // Runs frame jobs while waiting for the jobs of group to finish, and sleeps when there are none
+    // to run. If group has streaming jobs they are run too, otherwise a frame job waiting on them
+    // could wait forever when every worker is doing the same. The first exception thrown by a job of
+    // the group is thrown again here.
+    void Wait(const JobGroup& group);
+
+    // As Wait() but gives up after timeout, returns true if the group is done
+    bool WaitFor(const JobGroup& group, std::chrono::milliseconds timeout);
+
+    // Adds a job to group that is started once the jobs of after have finished
+    void Then(const JobGroup& after, JobGroup& group, std::function<void()> fn, ePriority priority = ePriority::eFrame);
+
+    // Queues fn for RunMainThreadJobs() once the jobs of after have finished
+    void ThenOnMainThread(const JobGroup& after, std::function<void()> fn);
+
+    // Jobs that must run on the main thread, such as adding results to the resource cache or
+    // creating textures. The main thread calls RunMainThreadJobs() once a frame.
+    void RunOnMainThread(std::function<void()> fn);
+    void RunMainThreadJobs();
+
+    // Runs fn for each index as frame jobs and waits for them, the first exception fn throws is
+    // thrown again here
+    virtual void For(u32 count, const std::function<void(u32)>& fn) override;
+
+    u32 NumThreads() const { return static_cast<u32>(mThreads.size()); }
+
+private:
+    friend class JobGroup;
+
+    static const u32 kNumPriorities = 2;
+
+    struct GroupState;
+
+    struct Job
+    {
+        std::function<void()> mFn;
+        std::shared_ptr<GroupState> mGroup;
+    };
+
+    struct Continuation
+    {
+        Job mJob;
+        ePriority mPriority;
+        bool mOnMainThread;
+    };
+
+    struct GroupState
+    {
+        std::atomic<u32> mPending{ 0 };
+        std::atomic<bool> mHasStreamingJobs{ false };
+        std::atomic<u32> mWaiters{ 0 };
+        std::mutex mMutex;
+        std::vector<Continuation> mContinuations;
+        std::exception_ptr mError;
+    };
+
+    struct Worker
+    {
+        std::mutex mMutex;
+        std::deque<Job> mJobs[kNumPriorities];
+    };
+
+    void Push(Job job, ePriority priority);
+    void AddContinuation(const JobGroup& after, Continuation continuation);
+    void Schedule(Continuation& continuation);
+    bool TakeJob(ePriority priority, Job& job);
+    bool TryRunJob(bool allowStreaming, bool needSlot = true);
+    bool WaitUntil(const JobGroup& group, const std::chrono::steady_clock::time_point* deadline);
+    void RunJob(Job& job);
+    void WorkerMain(u32 index);
+
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+    std::vector<std::thread> mThreads;
+    std::atomic<u32> mNextWorker{ 0 };
+
+    // Jobs queued for each priority, workers sleep when there is nothing they can take
+    std::atomic<s32> mQueued[kNumPriorities];
+    std::atomic<u32> mStreamingWorkers{ 0 };
+    u32 mMaxStreamingWorkers = 1;
+
+    std::mutex mMutex;
+    std::condition_variable mWorkCondition;
+    bool mQuit = false;
+
+    // Threads sleeping in Wait() until a job they can run is queued or their group is done
+    std::condition_variable mWaitCondition;
+    u32 mNumWaiting = 0;
+
+    std::mutex mMainThreadMutex;
+    std::vector<std::function<void()>> mMainThreadJobs;
+};
+
+// Jobs that are waited on together. Copies refer to the same group.
+class JobGroup
+{
+public:
+    JobGroup();
+    bool IsDone() const;
+private:
+    friend class JobSystem;
+    std::shared_ptr<JobSystem::GroupState> mState;
+};
+
+// Job system for the engine and resource loading, created on first use. Oddlib's one off jobs such as
+// decoding camera images run on it too, see Oddlib::SetSharedParallelFor().
+JobSystem& SharedJobSystem();
@@ -1,8 +1,26 @@
 #pragma once
 
+#include <chrono>
 #include <functional>
+#include <string>
 #include "types.hpp"
 
+// Adds the time from construction to destruction to totalMs
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(f32& totalMs) : mTotalMs(totalMs), mStart(std::chrono::high_resolution_clock::now()) { }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator = (const ScopedTimer&) = delete;
+    ~ScopedTimer()
+    {
+        mTotalMs += std::chrono::duration<f32, std::milli>(std::chrono::high_resolution_clock::now() - mStart).count();
+    }
+private:
+    f32& mTotalMs;
+    std::chrono::high_resolution_clock::time_point mStart;
+};
+
 struct Debug
 {
     bool mDrawCameras = true;
@@ -48,10 +66,58 @@ struct Debug
 
     class InputState* mInput = nullptr;
 
+    // Time spent in script calls, the totals of the last full frame are shown in the debug UI
+    struct ScriptTiming
+    {
+        f32 mBudgetMs = 4.0f;
+        f32 mFrameMs = 0.0f;
+        u32 mFrameCalls = 0;
+        f32 mLastFrameMs = 0.0f;
+        u32 mLastFrameCalls = 0;
+        f32 mPeakMs = 0.0f;
+        u32 mFramesOverBudget = 0;
+
+        void Add(f32 ms)
+        {
+            mFrameMs += ms;
+            mFrameCalls++;
+        }
+
+        void NextFrame();
+    };
+    ScriptTiming mScriptTiming;
+
+    // Time spent in parts of the game loop this tick. Collision checks are made from scripts so
+    // mCollisionMs is also counted in the script time.
+    struct TickTiming
+    {
+        f32 mCollisionMs = 0.0f;
+        f32 mAnimationMs = 0.0f;
+        f32 mRenderMs = 0.0f;
+    };
+    TickTiming mTickTiming;
+
+    // Objects within mActiveRadius camera cells of the camera subject are updated every frame, those
+    // within mReducedRadius every mReducedInterval frames and the rest sleep
+    struct ObjectActivity
+    {
+        bool mUpdateAll = false;
+        s32 mActiveRadius = 1;
+        s32 mReducedRadius = 2;
+        s32 mReducedInterval = 4;
+        u32 mLastUpdated = 0;
+        u32 mLastRendered = 0;
+        u32 mTotal = 0;
+    };
+    ObjectActivity mObjectActivity;
+
     std::function<void()> mFnReloadPath;
     std::function<void()> mFnNextPath;
     std::function<void(const char*)> fnLoadPath;
 
+    // Called with the name of a path after it has been loaded
+    std::function<void(const std::string&)> mFnPathLoaded;
+
     void Update(class InputState& input);
     void Render(class AbstractRenderer& renderer);
 };
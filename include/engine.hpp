@@ -1,11 +1,15 @@
 #pragma once
 
 #include <memory>
+#include <chrono>
+#include <cstring>
 #include "oddlib/masher.hpp"
 #include "SDL.h"
 #include "core/audiobuffer.hpp"
 #include "resourcemapper.hpp"
 #include "bitutils.hpp"
+#include "debug.hpp"
+#include "inputrecording.hpp"
 
 class StateMachine;
 class InputState;
@@ -277,6 +281,9 @@ public:
 
     const Actions& GetActions() const { return mActions; }
 
+    // Replaces the actions from the keyboard and game pad, used to play back a recording
+    void SetActions(const Actions& actions) { mActions = actions; }
+
 private:
     Actions mActions;
 };
@@ -493,6 +500,9 @@ public:
     }
 
     const InputMapping& Mapping() const { return mInputMapping; }
+
+    // Call after Update() to make objects see the given actions instead of the live input
+    void ReplayActions(const Actions& actions) { mInputMapping.SetActions(actions); }
 private:
     void AddController(s32 i)
     {
@@ -560,20 +570,133 @@ public:
         }
     }
 
+    // Calls fn with self as "this". fn should be looked up once when the script object is created
+    // rather than by name on every call, the arguments are pushed straight onto the VM stack.
+    template<class... Args>
+    static void Call(const Sqrat::Object& fn, const Sqrat::Object& self, const Args&... args)
+    {
+        CallFunction(fn, self, false, args...);
+    }
+
+    // As Call but returns if fn returned a value that is true, a null return counts as false
+    template<class... Args>
+    static bool CallBool(const Sqrat::Object& fn, const Sqrat::Object& self, const Args&... args)
+    {
+        return CallFunction(fn, self, true, args...);
+    }
+
     static void CompileAndRun(ResourceLocator& resourceLocator, const std::string& scriptName)
     {
         TRACE_ENTRYEXIT;
 
-        Sqrat::Script script;
-        script.CompileString(resourceLocator.LocateScript(scriptName.c_str()), scriptName);
-        CheckError();
+        const HSQUIRRELVM vm = Sqrat::DefaultVM::Get();
+        const SQInteger top = sq_gettop(vm);
+        const std::string source = resourceLocator.LocateScript(scriptName.c_str());
+
+        // A script that was compiled before is loaded as it is, if that fails it is compiled again
+        const std::vector<u8>* compiled = resourceLocator.FindCompiledScript(scriptName, source);
+        ClosureReader reader = { compiled, 0 };
+        if (!compiled || SQ_FAILED(sq_readclosure(vm, ReadClosure, &reader)))
+        {
+            sq_settop(vm, top);
+            if (SQ_FAILED(sq_compilebuffer(vm, source.c_str(), static_cast<SQInteger>(source.size()), scriptName.c_str(), SQTrue)))
+            {
+                sq_settop(vm, top);
+                throw Oddlib::Exception(Sqrat::LastErrorString(vm));
+            }
+
+            std::vector<u8> written;
+            if (SQ_SUCCEEDED(sq_writeclosure(vm, WriteClosure, &written)))
+            {
+                resourceLocator.AddCompiledScript(scriptName, source, std::move(written));
+            }
+        }
 
-        script.Run();
-        CheckError();
+        sq_pushroottable(vm);
+        const SQRESULT result = sq_call(vm, 1, SQFalse, SQTrue);
+        sq_settop(vm, top);
+        if (SQ_FAILED(result))
+        {
+            throw Oddlib::Exception(Sqrat::LastErrorString(vm));
+        }
     }
 
     HSQUIRRELVM Handle() const { return mVm; }
 private:
+    struct ClosureReader
+    {
+        const std::vector<u8>* mData;
+        size_t mPos;
+    };
+
+    static SQInteger ReadClosure(SQUserPointer user, SQUserPointer dst, SQInteger size)
+    {
+        ClosureReader& reader = *static_cast<ClosureReader*>(user);
+        if (size < 0 || static_cast<size_t>(size) > reader.mData->size() - reader.mPos)
+        {
+            return -1;
+        }
+        memcpy(dst, reader.mData->data() + reader.mPos, static_cast<size_t>(size));
+        reader.mPos += static_cast<size_t>(size);
+        return size;
+    }
+
+    static SQInteger WriteClosure(SQUserPointer user, SQUserPointer src, SQInteger size)
+    {
+        std::vector<u8>& written = *static_cast<std::vector<u8>*>(user);
+        const u8* bytes = static_cast<const u8*>(src);
+        written.insert(written.end(), bytes, bytes + size);
+        return size;
+    }
+
+    static void PushArgs(HSQUIRRELVM)
+    {
+
+    }
+
+    template<class T, class... Rest>
+    static void PushArgs(HSQUIRRELVM vm, const T& arg, const Rest&... rest)
+    {
+        Sqrat::PushVar(vm, arg);
+        PushArgs(vm, rest...);
+    }
+
+    // Script objects are pushed as they are rather than being copied by PushVar
+    template<class... Rest>
+    static void PushArgs(HSQUIRRELVM vm, const Sqrat::Object& arg, const Rest&... rest)
+    {
+        sq_pushobject(vm, arg.GetObject());
+        PushArgs(vm, rest...);
+    }
+
+    template<class... Args>
+    static bool CallFunction(const Sqrat::Object& fn, const Sqrat::Object& self, bool getResult, const Args&... args)
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+
+        const HSQUIRRELVM vm = Sqrat::DefaultVM::Get();
+        const SQInteger top = sq_gettop(vm);
+        sq_pushobject(vm, fn.GetObject());
+        sq_pushobject(vm, self.GetObject());
+        PushArgs(vm, args...);
+
+        const SQRESULT result = sq_call(vm, 1 + sizeof...(Args), getResult ? SQTrue : SQFalse, SQTrue);
+        SQBool ret = SQFalse;
+        if (SQ_SUCCEEDED(result) && getResult)
+        {
+            sq_tobool(vm, -1, &ret);
+        }
+        sq_settop(vm, top);
+
+        Debugging().mScriptTiming.Add(std::chrono::duration<f32, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+
+        if (SQ_FAILED(result))
+        {
+            throw Oddlib::Exception(Sqrat::LastErrorString(vm));
+        }
+        return ret != SQFalse;
+    }
+
     static void OnPrint(HSQUIRRELVM, const SQChar* s, ...)
     {
         va_list vl;
@@ -641,6 +764,12 @@ private:
     void InitResources();
     void InitImGui();
     void ImGui_WindowResize();
+    InputRecording::Tick RecordedInput() const;
+    std::vector<std::string> ActiveDataSetNames() const;
+    void UpdateRecordingOrReplay();
+    void EndTick(std::chrono::high_resolution_clock::time_point tickStart);
+    void EndReplay();
+    void SaveRecording();
 protected:
     void BindScriptTypes();
     void InitSubSystems();
@@ -665,6 +794,21 @@ protected:
     StateMachine mStateMachine;
 
     SquirrelVm mSquirrelVm;
+
+    // The script update() function, looked up once after main.nut has run
+    Sqrat::Object mScriptUpdate;
+
     TextureHandle mGuiFontHandle = {};
     bool mTryDirectX9 = false;
+    bool mHeadless = false;
+
+    // -record <file> saves the input of the loaded path to file on exit, -replay <file> loads the
+    // recorded path and plays the input back then quits. -benchmark replays without a frame limit.
+    std::string mRecordFileName;
+    InputRecorder mRecorder;
+
+    std::string mReplayFileName;
+    bool mBenchmark = false;
+    InputReplay mReplay;
+    ReplayBenchmark mReplayBenchmark;
 };
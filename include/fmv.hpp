@@ -2,6 +2,10 @@
 
 #include <vector>
 #include <memory>
+#include <array>
+#include <atomic>
+#include <algorithm>
+#include <condition_variable>
 #include "oddlib/masher.hpp"
 #include "SDL.h"
 #include "oddlib/PSXADPCMDecoder.h"
@@ -15,6 +19,73 @@ class GameData;
 class IAudioController;
 class AbstractRenderer;
 
+// Single producer, single consumer ring of audio samples. Neither side ever locks so
+// the audio thread can't be held up by the decoder.
+class AudioRingBuffer
+{
+public:
+    AudioRingBuffer(const AudioRingBuffer&) = delete;
+    AudioRingBuffer& operator = (const AudioRingBuffer&) = delete;
+
+    explicit AudioRingBuffer(size_t capacity)
+        : mSamples(capacity)
+    {
+
+    }
+
+    // Producer context, returns how many samples fitted
+    size_t Write(const s16* samples, size_t count)
+    {
+        const size_t writePos = mWritePos.load(std::memory_order_relaxed);
+        const size_t readPos = mReadPos.load(std::memory_order_acquire);
+        count = std::min(count, mSamples.size() - (writePos - readPos));
+        for (size_t i = 0; i < count; i++)
+        {
+            mSamples[(writePos + i) % mSamples.size()] = samples[i];
+        }
+        mWritePos.store(writePos + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer context, calls consume for each of up to count samples and returns how many there were
+    template<class Consume>
+    size_t Read(size_t count, Consume consume)
+    {
+        const size_t readPos = mReadPos.load(std::memory_order_relaxed);
+        const size_t writePos = mWritePos.load(std::memory_order_acquire);
+        count = std::min(count, writePos - readPos);
+        for (size_t i = 0; i < count; i++)
+        {
+            consume(i, mSamples[(readPos + i) % mSamples.size()]);
+        }
+        mReadPos.store(readPos + count, std::memory_order_release);
+        return count;
+    }
+
+    // Only safe when neither side is running
+    void Clear()
+    {
+        mWritePos = 0;
+        mReadPos = 0;
+    }
+
+    size_t Size() const
+    {
+        // Read position first, the write position can only have moved further on since
+        const size_t readPos = mReadPos.load(std::memory_order_acquire);
+        return mWritePos.load(std::memory_order_acquire) - readPos;
+    }
+
+private:
+    std::vector<s16> mSamples;
+
+    // Total number of samples ever written and read, the difference is what is buffered
+    std::atomic<size_t> mWritePos{ 0 };
+    std::atomic<size_t> mReadPos{ 0 };
+};
+
+// Each movie decodes on its own thread into a small pool of frame buffers, the main thread
+// only picks which decoded frame to show and the audio thread reads from a lock free ring.
 class IMovie : public IAudioPlayer
 {
 public:
@@ -37,10 +108,36 @@ public:
 
     void Start();
     void Stop();
+
+    // Main thread context, jumps to frame. Decoding restarts from the nearest frame the
+    // movie can restart from and any frames before the target are decoded but not shown.
+    void Seek(size_t frame);
+
+    // Main thread context, the frame that is currently being shown
+    size_t FrameNumber() const;
 protected:
-    virtual bool EndOfStream() = 0;
-    virtual bool NeedBuffer() = 0;
-    virtual void FillBuffers() = 0;
+    struct Frame
+    {
+        size_t mFrameNum = 0;
+        u32 mW = 0;
+        u32 mH = 0;
+        std::vector<u8> mPixels;
+    };
+
+    // Decode thread context. Decodes the next video frame in to frame, which is a recycled
+    // buffer so its pixels should be resized rather than replaced, and passes any audio
+    // that comes before it to PushAudio(). Returns false at the end of the stream.
+    virtual bool DecodeFrame(Frame& frame) = 0;
+
+    // Main thread context, only called while the decode thread is stopped. Moves the stream
+    // so the next DecodeFrame() starts at or before frame and returns the frame it starts at.
+    virtual size_t SeekDecoder(size_t frame) = 0;
+
+    // Decode thread context, waits for space in the audio ring if it is full
+    void PushAudio(const s16* samples, size_t count);
+
+    // Must be called by the destructor of each derived class since the thread calls in to it
+    void StopDecodeThread();
 
     // Audio thread context, from IAudioPlayer
     virtual bool Play(f32* stream, u32 len) override;
@@ -49,25 +146,38 @@ protected:
     void RenderFrame(AbstractRenderer& rend, int width, int height, const void* pixels, const char* subtitles);
 
 protected:
-    struct Frame
-    {
-        size_t mFrameNum;
-        u32 mW;
-        u32 mH;
-        std::vector<u8> mPixels;
-    };
-    size_t mFrameCounter = 0;
-    size_t mConsumedAudioBytes = 0;
-    std::mutex mAudioBufferMutex;
-    std::deque<u8> mAudioBuffer;
-    std::deque<Frame> mVideoBuffer;
     IAudioController& mAudioController;
     u32 mAudioBytesPerFrame = 1;
     std::unique_ptr<SubTitleParser> mSubTitles;
     std::string mName;
 
 private:
-    bool mPlaying = false;
+    void DecodeThread();
+
+    // Decoding stops when this many frames are waiting to be shown
+    static const u32 kMaxDecodedFrames = 8;
+
+    std::array<Frame, kMaxDecodedFrames> mFramePool;
+
+    // Guarded by mFramesMutex
+    std::mutex mFramesMutex;
+    std::condition_variable mDecodeCondition;
+    std::vector<Frame*> mFreeFrames;
+    std::vector<Frame*> mVideoBuffer;
+    const Frame* mPresentedFrame = nullptr;
+    size_t mFrameCounter = 0;
+    bool mDecodeFinished = false;
+
+    // Frames before this are being decoded after a seek and are thrown away along with their audio
+    size_t mSkipUntilFrame = 0;
+    bool mQuitDecoding = false;
+
+    std::thread mDecodeThread;
+
+    AudioRingBuffer mAudioBuffer;
+    std::atomic<size_t> mConsumedAudioBytes{ 0 };
+
+    std::atomic<bool> mPlaying{ false };
     //AutoMouseCursorHide mHideMouseCursor;
 };
 
@@ -7,15 +7,34 @@
 #include <vector>
 #include <set>
 #include <map>
+#include <string>
 
-// Maps strings to functions
-template<class ReturnType, class FunctionType>
+// The arguments that a state action/condition was given, bound when the state machine is compiled
+class FsmArguments final
+{
+public:
+    FsmArguments(const std::string* strings, const s32* ints) : mStrings(strings), mInts(ints) { }
+    const std::string& String(u32 index) const { return mStrings[index]; }
+    s32 Int(u32 index) const { return mInts[index]; }
+private:
+    const std::string* mStrings;
+    const s32* mInts;
+};
+
+// Maps strings to functions, context is passed back to the function when it's called
+template<class ReturnType>
 class FunctionMap final
 {
 public:
-    using TEventFuncPtr = std::function < ReturnType(FunctionType) >;
+    using TFunction = ReturnType(*)(void* context, const FsmArguments& arguments);
+
+    struct Binding
+    {
+        TFunction mFunction;
+        void* mContext;
+    };
 
-    void Add(const char* functionName, TEventFuncPtr function)
+    void Add(const char* functionName, TFunction function, void* context = nullptr)
     {
         const auto it = mFunctions.find(functionName);
         if (it != std::end(mFunctions))
@@ -24,76 +43,60 @@ public:
         }
         else
         {
-            mFunctions.insert(std::make_pair(functionName, function));
+            mFunctions.insert(std::make_pair(functionName, Binding{ function, context }));
         }
     }
 
-    ReturnType Evaluate(const std::string& method, class FsmArgumentStack& stack)
+    const Binding* Find(const std::string& functionName) const
     {
-        const auto it = mFunctions.find(method);
-        if (it != std::end(mFunctions))
-        {
-            return it->second(stack);
-        }
-        LOG_ERROR("Missing function: " << method.c_str());
-        return ReturnType();
+        const auto it = mFunctions.find(functionName);
+        return it != std::end(mFunctions) ? &it->second : nullptr;
     }
 
 private:
-    std::map<std::string, TEventFuncPtr> mFunctions;
+    std::map<std::string, Binding> mFunctions;
 };
 
-// This is only sort of a stack, you push arguments for the state action/condition, then during
-// FSM execution the pops happen but don't actually remove anything, and before any pops reset is called
-// which makes up start "fake" popping from the top of the stack again.
+// Arguments for a state action/condition, in the order that the function reads them
 class FsmArgumentStack final
 {
 public:
     FsmArgumentStack() = default;
-    void Reset();
     void Push(std::string str);
     void Push(s32 integer);
-    const std::string& PopString();
-    s32 PopInt();
+    const std::vector<std::string>& Strings() const { return mStringArgs; }
+    const std::vector<s32>& Ints() const { return mIntArgs; }
 private:
-    s32 mStringPos = 0;
     std::vector<std::string> mStringArgs;
-    s32 mIntPos = 0;
     std::vector<s32> mIntArgs;
 };
 
-// Calls a function from FunctionMap by name, and allows adding
-// of arguments to be passed to said function via a stack.
-template<class T, class ReturnType>
-class FsmExecutor final
+// A call to a function from a FunctionMap by name with its arguments. For conditions a name
+// starting with ! calls the function and negates the result.
+class FsmCall final
 {
 public:
-    FsmExecutor(const std::string& name) : mName(name) { }
-
-    ReturnType Execute(T& functions)
-    {
-        mArguments.Reset();
-        return functions.Evaluate(mName, mArguments);
-    }
-
+    FsmCall(const std::string& name) : mName(name) { }
+    const std::string& Name() const { return mName; }
     FsmArgumentStack& Arguments() { return mArguments; }
+    const FsmArgumentStack& Arguments() const { return mArguments; }
 private:
     std::string mName;
     FsmArgumentStack mArguments;
 };
 
-using TActions = FunctionMap < void, FsmArgumentStack& >;
-using TConditions = FunctionMap < bool, FsmArgumentStack& >;
-using StateCondition = FsmExecutor < TConditions, bool >;
-using StateAction = FsmExecutor < TActions, void >;
+using TActions = FunctionMap<void>;
+using TConditions = FunctionMap<bool>;
+using StateCondition = FsmCall;
+using StateAction = FsmCall;
 
 class FsmStateTransition final
 {
 public:
     FsmStateTransition(const std::string& name) : mTargetStateName(name) { }
-    void AddCondition(StateCondition condition);
-    bool Evaulate(TConditions& events);
+    void AddCondition(StateCondition condition) { mConditions.push_back(condition); }
     const std::string& Name() const { return mTargetStateName; }
+    const std::vector<StateCondition>& Conditions() const { return mConditions; }
 private:
     std::string mTargetStateName;
     std::vector<StateCondition> mConditions;
@@ -103,29 +106,87 @@ class FsmState final
 {
 public:
     FsmState(const std::string& name) : mStateName(name) { }
-    void Enter(TActions& actions);
-    const std::string* Update(TConditions& states);
     const std::string& Name() const { return mStateName; }
     void AddEnterAction(StateAction action) { mEnterActions.push_back(action); }
     void AddTransition(FsmStateTransition transition) { mTransistions.push_back(transition); }
+    const std::vector<StateAction>& EnterActions() const { return mEnterActions; }
+    const std::vector<FsmStateTransition>& Transitions() const { return mTransistions; }
 private:
     std::string mStateName;
     std::vector<StateAction> mEnterActions;
     std::vector<FsmStateTransition> mTransistions;
 };
 
+// States are added by name and then compiled in to flat tables of indices and function pointers,
+// so that Update() doesn't look anything up by name.
 class FiniteStateMachine final
 {
 public:
     FiniteStateMachine() = default;
+    FiniteStateMachine(const FiniteStateMachine&) = delete;
+    FiniteStateMachine& operator = (const FiniteStateMachine&) = delete;
+
     void Construct();
+    void AddState(FsmState state) { mStates.push_back(std::move(state)); }
+
+    // Resolves the state, condition and action names, call again after adding states or functions
+    void Compile();
+
     void Update();
     bool ToState(const char* stateName);
+    const std::string* ActiveStateName() const;
     TConditions& Conditions() { return mConditions; }
     TActions& Actions() { return mActions; }
 private:
+    static const u32 kNoState = ~0u;
+
+    struct CompiledCondition
+    {
+        TConditions::TFunction mFunction;
+        void* mContext;
+        bool mNegate;
+        u32 mFirstString;
+        u32 mFirstInt;
+    };
+
+    struct CompiledAction
+    {
+        TActions::TFunction mFunction;
+        void* mContext;
+        u32 mFirstString;
+        u32 mFirstInt;
+    };
+
+    struct CompiledTransition
+    {
+        u32 mTargetState;
+        u32 mFirstCondition;
+        u32 mNumConditions;
+    };
+
+    struct CompiledState
+    {
+        u32 mFirstEnterAction;
+        u32 mNumEnterActions;
+        u32 mFirstTransition;
+        u32 mNumTransitions;
+    };
+
+    template<class ReturnType>
+    bool BindCall(const FunctionMap<ReturnType>& functions, const std::string& name, typename FunctionMap<ReturnType>::TFunction& function, void*& context);
+    void BindArguments(const FsmArgumentStack& arguments, u32& firstString, u32& firstInt);
+    FsmArguments Arguments(u32 firstString, u32 firstInt) const;
+    void EnterState(u32 stateIndex);
+
     std::vector<FsmState> mStates;
     TConditions mConditions;
     TActions mActions;
-    FsmState* mActiveState = nullptr;
+
+    std::vector<CompiledState> mCompiledStates;
+    std::vector<CompiledTransition> mCompiledTransitions;
+    std::vector<CompiledCondition> mCompiledConditions;
+    std::vector<CompiledAction> mCompiledActions;
+    std::vector<std::string> mStringArgs;
+    std::vector<s32> mIntArgs;
+    u32 mActiveState = kNoState;
 };
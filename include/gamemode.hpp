@@ -12,5 +12,11 @@ public:
     void Update(const InputState& input, CoordinateSpace& coords);
     void Render(AbstractRenderer& rend) const;
 private:
+    void UpdateObjects(const Sqrat::Object& actions);
+    void UpdateObject(u32 index, const Sqrat::Object& actions);
+
     GridMapState& mMapState;
+    u32 mFrame = 0;
+    std::vector<u32> mNearbyObjects;
+    mutable std::vector<u32> mVisibleObjects;
 };
@@ -12,7 +12,8 @@ public:
             class Sound& sound, 
             class Level& level,
             ResourceLocator& resLocator,
-            IFileSystem& newFs)
+            IFileSystem& newFs,
+            const std::string& autoStartDataSet)
       : IState(stateMachine),
         mGameDefinitions(gameDefinitions),
         mSound(sound),
@@ -21,6 +22,10 @@ public:
         mFs(newFs)
     {
         mVisibleGameDefinitions = GameDefinition::GetVisibleGameDefinitions(mGameDefinitions);
+        if (!autoStartDataSet.empty())
+        {
+            SelectForAutoStart(autoStartDataSet);
+        }
     }
     virtual void Render(int w, int h, AbstractRenderer& renderer) override;
     virtual void Update(const InputState& input, CoordinateSpace& coords) override;
@@ -31,6 +36,10 @@ private:
     void RenderSelectGame();
     void RenderFindDataSets();
     void LoadGameDefinition();
+    void StartGame();
+
+    // Throws Oddlib::Exception if there is no game definition for the data set
+    void SelectForAutoStart(const std::string& dataSetName);
 
     const std::vector<GameDefinition>& mGameDefinitions;
     std::vector<const GameDefinition*> mVisibleGameDefinitions;
@@ -39,6 +48,10 @@ private:
     ResourceLocator& mResLocator;
     size_t mSelectedGameDefintionIndex = 0;
     IFileSystem& mFs;
+
+    // Start the selected game on the first update as if "Start game" was pressed
+    bool mAutoStart = false;
+    bool mSelectDeveloperMode = true;
     enum class eState
     {
         eSelectGame,
@@ -11,6 +11,7 @@
 #include "fsm.hpp"
 #include "abstractrenderer.hpp"
 #include "collisionline.hpp"
+#include "activityregions.hpp"
 #include "proxy_sqrat.hpp"
 #include "mapobject.hpp"
 #include "imgui/imgui.h"
@@ -106,6 +107,10 @@ public:
     CollisionLines mCollisionItems;
     std::vector<std::unique_ptr<MapObject>> mObjs;
 
+    // Camera cells of mObjs, by index, the objects keep their own cells up to date
+    ActivityRegions mActivityRegions;
+    ObjectTypeIds mObjectTypeIds;
+
     enum class eStates
     {
         eInGame,
@@ -137,7 +142,10 @@ public:
     void Render(AbstractRenderer& rend) const;
     static void RegisterScriptBindings();
 private:
+    // The first object of the type at the point or overlapping the rect, only the objects in
+    // the camera cells around it are tested
     MapObject* GetMapObject(s32 x, s32 y, const char* type);
+    MapObject* GetMapObjectInRect(s32 x, s32 y, s32 w, s32 h, const char* type);
     
     void UpdateToEditorOrToGame(const InputState& input, CoordinateSpace& coords);
     void RenderToEditorOrToGame(AbstractRenderer& rend) const;
@@ -151,4 +159,5 @@ private:
     std::unique_ptr<class GameMode> mGameMode;
     std::unique_ptr<class Fmv> mFmv;
     InstanceBinder<class GridMap> mScriptInstance;
+    std::vector<u32> mQueryObjects;
 };
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "types.hpp"
+#include <string>
+#include <vector>
+
+namespace hash_util
+{
+    const u64 kFnv1aSeed = 14695981039346656037ull;
+
+    // FNV-1a, pass the previous result as the seed to hash more than one source
+    inline u64 Fnv1a(const u8* data, size_t size, u64 seed = kFnv1aSeed)
+    {
+        u64 hash = seed;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= data[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    inline u64 Fnv1a(const std::vector<u8>& data, u64 seed = kFnv1aSeed)
+    {
+        return Fnv1a(data.data(), data.size(), seed);
+    }
+
+    inline u64 Fnv1a(const std::string& data, u64 seed = kFnv1aSeed)
+    {
+        return Fnv1a(reinterpret_cast<const u8*>(data.data()), data.size(), seed);
+    }
+}
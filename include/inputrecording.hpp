@@ -0,0 +1,115 @@
+#pragma once
+
+#include "types.hpp"
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace Oddlib
+{
+    class IStream;
+}
+
+// The input actions of every simulation tick since a path was loaded, so that the session can be
+// played back. Only the actions that the map objects see are kept, not the raw keys and buttons.
+// The data sets that were active are kept too, the first is the data set of the game that was
+// started, as the same input played on other data gives a different game.
+class InputRecording
+{
+public:
+    struct Tick
+    {
+        u32 mIsPressed;
+        u32 mIsReleased;
+        u32 mIsDown;
+        u32 mRawDownState;
+    };
+
+    // Throws away the ticks recorded so far
+    void Start(const std::string& pathName, const std::vector<std::string>& dataSetNames);
+    void Add(const Tick& tick) { mTicks.push_back(tick); }
+
+    void Write(Oddlib::IStream& stream) const;
+
+    // Throws Oddlib::Exception if the stream isn't a recording
+    void Read(Oddlib::IStream& stream);
+
+    const std::string& PathName() const { return mPathName; }
+    const std::vector<std::string>& DataSetNames() const { return mDataSetNames; }
+    const std::vector<Tick>& Ticks() const { return mTicks; }
+
+private:
+    std::string mPathName;
+    std::vector<std::string> mDataSetNames;
+    std::vector<Tick> mTicks;
+};
+
+// Records the input of the last path that was loaded. A path is loaded part way through a tick,
+// before the map is updated with that tick's input, so that tick is the first one recorded.
+class InputRecorder
+{
+public:
+    // Called at the start of every tick with its input
+    void Tick(const InputRecording::Tick& tick);
+
+    // Called when a path has been loaded with the active data sets and the input of the tick that
+    // loaded it
+    void PathLoaded(const std::string& pathName, const std::vector<std::string>& dataSetNames, const InputRecording::Tick& tick);
+
+    bool IsRecording() const { return mRecording; }
+    const InputRecording& Recording() const { return mInput; }
+
+private:
+    bool mRecording = false;
+    InputRecording mInput;
+};
+
+// Plays a recording back in the same order it was recorded in. The path is loaded by the first
+// tick, which then gets the first recorded input so that it drives the first map update after the
+// load, just as it did when it was recorded.
+class InputReplay
+{
+public:
+    explicit InputReplay(InputRecording recording = InputRecording()) : mInput(std::move(recording)) { }
+
+    // Called at the start of every tick once paths can be loaded. Returns the input to use for this
+    // tick, or nullptr once all of the ticks have been played.
+    const InputRecording::Tick* NextTick(const std::function<void(const std::string&)>& fnLoadPath);
+
+    bool IsStarted() const { return mStarted; }
+    bool IsFinished() const { return mStarted && mNextTick == mInput.Ticks().size(); }
+    u32 TicksPlayed() const { return mNextTick; }
+    const InputRecording& Recording() const { return mInput; }
+
+private:
+    InputRecording mInput;
+    bool mStarted = false;
+    u32 mNextTick = 0;
+};
+
+// Timings of each tick of a replayed recording
+class ReplayBenchmark
+{
+public:
+    struct Tick
+    {
+        f32 mScriptMs;
+        f32 mCollisionMs;
+        f32 mAnimationMs;
+        f32 mRenderMs;
+        f32 mTotalMs;
+    };
+
+    void Add(const Tick& tick) { mTicks.push_back(tick); }
+    u32 NumTicks() const { return static_cast<u32>(mTicks.size()); }
+
+    // A line for each part with the mean, median, 95th percentile and worst tick in ms
+    std::string Summary() const;
+
+    // A row for each tick
+    void WriteCsv(std::ostream& stream) const;
+
+private:
+    std::vector<Tick> mTicks;
+};
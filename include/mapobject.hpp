@@ -1,9 +1,12 @@
 #pragma once
 
 #include <string>
+#include <memory>
+#include <vector>
 #include "types.hpp"
 #include "proxy_sqrat.hpp"
 #include "logger.hpp"
+#include "activityregions.hpp"
 
 struct ObjRect
 {
@@ -32,6 +35,7 @@ namespace Oddlib
 class InputState;
 class AbstractRenderer;
 class Animation;
+class AnimationRequest;
 class ResourceLocator;
 class IMap;
 
@@ -66,20 +70,36 @@ public:
         mScriptObject = obj;
     }
 
+    // Starts locating the animations in the script's kAnimationResources, FinishInit() waits for them
     void Init();
-    void Update(const InputState& input);
+    void FinishInit();
+
+    // actions is the script instance of the input actions, the caller makes it once per frame for all objects
+    void Update(const Sqrat::Object& actions);
     void Render(AbstractRenderer& rend, int x, int y, float scale, int layer) const;
     void ReloadScript();
     static void RegisterScriptBindings();
 
     bool ContainsPoint(s32 x, s32 y) const;
+    bool OverlapsRect(s32 x, s32 y, s32 w, s32 h) const;
     const std::string& Name() const { return mName; }
 
+    // Interned Name() from the map's ObjectTypeIds, set once the script has named the object
+    u32 TypeId() const { return mTypeId; }
+    void SetTypeId(u32 typeId) { mTypeId = typeId; }
+
     // TODO: Shouldn't be part of this object
     void SnapXToGrid();
 
-    float mXPos = 50.0f;
-    float mYPos = 100.0f;
+    f32 XPos() const { return mXPos; }
+    f32 YPos() const { return mYPos; }
+    void SetXPos(f32 x);
+    void SetYPos(f32 y);
+    void SetPosition(f32 x, f32 y);
+
+    // Every move from then on, by any script or the editor, moves the object to its new camera
+    // cell in regions. index is the object's slot in regions.
+    void SetActivityRegions(ActivityRegions& regions, u32 index);
 
     s32 Id() const { return mId; }
     bool WallCollision(IMap& map, f32 dx, f32 dy) const;
@@ -89,6 +109,8 @@ public:
 private:
     void ScriptLoadAnimations();
     std::map<std::string, std::shared_ptr<Animation>> mAnims;
+    std::unique_ptr<AnimationRequest> mAnimationRequest;
+    std::vector<std::string> mAnimationRequestNames;
     Animation* mAnim = nullptr;
 
     void LoadScript();
@@ -113,6 +135,12 @@ private:
     std::string mScriptName;
     std::string mName;
     s32 mId = 0;
+    u32 mTypeId = ObjectTypeIds::kUnknownType;
     ObjRect mRect;
+    float mXPos = 50.0f;
+    float mYPos = 100.0f;
+    ActivityRegions* mActivityRegions = nullptr;
+    u32 mActivityIndex = 0;
     Sqrat::Object mScriptObject; // Derived script object instance
+    Sqrat::Object mUpdateFn; // mScriptObject.Update, looked up once in Init()
 };
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "abstractrenderer.hpp"
+#include <cstdint>
+
+// Renderer without a window or GPU for running headless. The draw commands are still built and
+// sorted every frame, but nothing is drawn and textures are only handles.
+class NullRenderer : public AbstractRenderer
+{
+public:
+    virtual TextureHandle CreateTexture(eTextureFormats internalFormat, u32 width, u32 height, eTextureFormats inputFormat, const void *pixels, bool interpolation) override;
+    virtual void DestroyTextures() override;
+    virtual const char* Name() const override;
+    virtual void SetVSync(bool on) override;
+
+private:
+    virtual void OnSetRenderState(CmdState& info) override;
+
+    virtual void ClearFrameBufferImpl(f32 r, f32 g, f32 b, f32 a) override;
+    virtual void RenderCommandsImpl() override;
+    virtual void ImGuiRender() override;
+
+    uintptr_t mNextTexture = 1;
+};
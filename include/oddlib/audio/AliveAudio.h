@@ -19,15 +19,6 @@
 #include "stdthread.h"
 #include "AudioInterpolation.h"
 
-#ifdef _MSC_VER
-#pragma warning(push)
-#pragma warning(disable:4267) //  'return' : conversion from 'size_t' to 'unsigned long', possible loss of data
-#endif
-#include "stk/include/FreeVerb.h"
-#ifdef _MSC_VER
-#pragma warning(pop)
-#endif
-
 const int kAliveAudioSampleRate = 44100;
 
 class FileSystem;
@@ -51,14 +42,16 @@ public:
 
     u64 mCurrentSampleIndex = 0;
 
-    void Play(f32* stream, u32 len);
+    // Reverberant voices are split between stream and reverbSend according to ReverbMix,
+    // reverbSend is the shared ReverbBus input. If it's null everything is mixed dry.
+    void Play(f32* stream, f32* reverbSend, u32 len);
 
     u32 NumberOfActiveVoices() const { return static_cast<u32>(m_Voices.size()); }
 
     // Can be changed from outside class
     AudioInterpolation Interpolation = AudioInterpolation_hermite;
     bool ForceReverb = false;
-    f32 ReverbMix = 0.5f;
+    f32 ReverbMix = 0.5f; // Amount of the reverberant voices that goes to the reverb send
     bool DebugDisableVoiceResampling = false;
 
     // TODO: Temp for sound effect debugging
@@ -70,8 +63,6 @@ private:
     std::vector<f32> m_DryChannelBuffer;
     std::vector<f32> m_ReverbChannelBuffer;
 
-    stk::FreeVerb m_Reverb;
-
     void CleanVoices();
-    void AliveRenderAudio(f32* AudioStream, int StreamLength);
+    void AliveRenderAudio(f32* AudioStream, f32* ReverbSend, int StreamLength);
 };
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include "types.hpp"
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable:4267) //  'return' : conversion from 'size_t' to 'unsigned long', possible loss of data
+#endif
+#include "stk/include/FreeVerb.h"
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+// A single reverb effect shared by every player that is mixed into the same output.
+// Players add the reverberant part of their signal into Send() and the bus then
+// runs the reverb once over the summed signal. When nothing has been sent and the
+// tail has died away the reverb isn't ticked at all.
+class ReverbBus
+{
+public:
+    ReverbBus();
+    ReverbBus(ReverbBus&&) = delete;
+    ReverbBus(const ReverbBus&) = delete;
+    ReverbBus& operator = (const ReverbBus&) = delete;
+    ReverbBus& operator = (ReverbBus&&) = delete;
+
+    // Clears the send buffer ready for len interleaved stereo samples to be accumulated into it
+    void Begin(u32 len);
+
+    // Buffer of interleaved stereo samples players should add their wet signal to
+    f32* Send() { return mSendBuffer.data(); }
+
+    // Runs the reverb over the send buffer and adds the result to stream
+    void Mix(f32* stream, u32 len);
+
+    bool Active() const { return mActive; }
+
+    void Reset();
+private:
+    stk::FreeVerb mReverb;
+    stk::StkFrames mFrames;
+    std::vector<f32> mSendBuffer;
+
+    // True while there is input or the reverb tail is still audible
+    bool mActive = false;
+};
@@ -79,7 +79,8 @@ public:
 
     bool AtEnd() const;
     void Restart();
-    void Play(f32* stream, u32 len);
+    void Play(f32* stream, f32* reverbSend, u32 len);
+    void SetInterpolation(AudioInterpolation interpolation);
 
     const std::string& Name() const { return mName; }
 
@@ -7,7 +7,13 @@
 namespace Oddlib
 {
     class IStream;
-    struct BitsLogic;
+
+    // How many words past the end of a strip AeVlcDecode may load
+    const u32 kAeVlcReadAheadWords = 4;
+
+    // Decodes the VLC codes of one camera image strip up to and including the raw word of 1 that
+    // ends it. The 2 words after the last decoded word are cleared.
+    void AeVlcDecode(const u16* aCamSeg, u16* aDst);
 
     class AeBitsPc : public IBits
     {
@@ -18,19 +24,9 @@ namespace Oddlib
         virtual SDL_Surface* GetSurface() const override;
         virtual IFg1* GetFg1() const override;
     private:
-        void vlc_decode(const std::vector<u16>& aCamSeg, std::vector<u16>& aDst);
-        void process_segment(u16* aVlcBufferPtr, int xPos);
-        int next_bits();
-        void vlc_decoder(int aR, int aG, int aB, signed int aWidth, int aVramX, int aVramY);
-        void write_4_pixel_block(const BitsLogic& aR, const BitsLogic& aG, const BitsLogic& aB, int aVramX, int aVramY);
-
-        signed int g_left7_array = 0;
-        unsigned short int* g_pointer_to_vlc_buffer = nullptr;
-        int g_right25_array = 0;
+        // Each strip only writes its own 16 columns so they are decoded in parallel
         unsigned short int g_vram[240][640];
 
-        friend struct BitsLogic;
-
         void GenerateImage(IStream& stream);
         SDL_SurfacePtr mSurface;
 
@@ -3,6 +3,7 @@
 #include "SDL.h"
 #include <memory>
 #include <string>
+#include <vector>
 #include "oddlib/lvlarchive.hpp"
 #include "sdl_raii.hpp"
 
@@ -10,16 +11,41 @@ namespace Oddlib
 {
     class IStream;
 
+    // FG1 blocks are at most 32x16, every tile is made of one or more used blocks
+    const u32 kFg1BlockWidth = 32;
+    const u32 kFg1BlockHeight = 16;
+
+    // Part of the foreground layer that has something to draw. mX, mY, mW and mH are the area of the
+    // camera that it covers and mAtlasX, mAtlasY is where those pixels start in the atlas.
+    struct Fg1Tile
+    {
+        u16 mX;
+        u16 mY;
+        u16 mW;
+        u16 mH;
+        u16 mAtlasX;
+        u16 mAtlasY;
+    };
+
     class IFg1
     {
     public:
         virtual ~IFg1() = default;
-        virtual SDL_Surface* GetSurface() const = 0;
 
-        void Save(const std::string& baseName)
+        // The pixels of every tile packed into one surface, nullptr if there are no tiles
+        virtual SDL_Surface* GetAtlas() const = 0;
+        virtual const std::vector<Fg1Tile>& GetTiles() const = 0;
+
+        bool IsEmpty() const { return GetTiles().empty(); }
+
+        // Puts the tiles back into a camera sized image
+        SDL_SurfacePtr MakeSurface(u32 width, u32 height) const;
+
+        void Save(const std::string& baseName, u32 width, u32 height)
         {
             static int i = 1;
-            SDLHelpers::SaveSurfaceAsPng((baseName + "_camera_fg1" + std::to_string(i++) + ".png").c_str(), GetSurface());
+            SDL_SurfacePtr surface = MakeSurface(width, height);
+            SDLHelpers::SaveSurfaceAsPng((baseName + "_camera_fg1" + std::to_string(i++) + ".png").c_str(), surface.get());
         }
     };
 
@@ -38,6 +64,7 @@ namespace Oddlib
     };
 
     bool IsPsxCamera(IStream& stream);
-    std::unique_ptr<IBits> MakeBits(SDL_SurfacePtr camImage);
+    std::unique_ptr<IFg1> MakeFg1(SDL_SurfacePtr atlas, std::vector<Fg1Tile> tiles);
+    std::unique_ptr<IBits> MakeBits(SDL_SurfacePtr camImage, std::unique_ptr<IFg1> fg1 = nullptr);
     std::unique_ptr<IBits> MakeBits(IStream& bitsStream, IStream* fg1Stream);
 }
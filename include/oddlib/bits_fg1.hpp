@@ -1,14 +1,30 @@
+#pragma once
+
 #include "oddlib/bits_factory.hpp"
 #include <vector>
 
 namespace Oddlib
 {
-    class BitsFg1 : public IFg1
+    // Keeps only the parts of the foreground layer that have something to draw
+    class TiledFg1 : public IFg1
     {
     public:
-        BitsFg1(SDL_Surface* camera, IStream& stream, bool bBitMaskedPartialBlocks);
-        virtual SDL_Surface* GetSurface() const;
+        TiledFg1(SDL_SurfacePtr atlas, std::vector<Fg1Tile> tiles);
+        virtual SDL_Surface* GetAtlas() const override;
+        virtual const std::vector<Fg1Tile>& GetTiles() const override;
+    protected:
+        TiledFg1() = default;
+
+        // Finds the areas of fg1 with any alpha and copies them into the atlas
+        void BuildTiles(const SDL_Surface* fg1);
     private:
-        SDL_SurfacePtr mSurface;
+        SDL_SurfacePtr mAtlas;
+        std::vector<Fg1Tile> mTiles;
+    };
+
+    class BitsFg1 : public TiledFg1
+    {
+    public:
+        BitsFg1(SDL_Surface* camera, IStream& stream, bool bBitMaskedPartialBlocks);
     };
 }
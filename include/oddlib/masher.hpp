@@ -3,10 +3,13 @@
 #include "types.hpp"
 #include "stream.hpp"
 #include "oddlib/exceptions.hpp"
+#include <array>
 
 
 namespace Oddlib
 {
+    struct VideoKernels;
+
     class AudioDecompressor
     {
     public:
@@ -16,9 +19,6 @@ namespace Oddlib
         s32 mAudioFrameSizeBytes = 0;
         u16* mAudioFrameDataPtr = nullptr;
 
-        static u8 gSndTbl_byte_62EEB0[256];
-
-        AudioDecompressor();
         static s32 GetSoundTableValue(s16 tblIndex);
         s16 sub_408F50(s16 a1);
         s32 ReadNextAudioWord(s32 value);
@@ -28,7 +28,6 @@ namespace Oddlib
         void decode_16bit_audio_frame(u16* outPtr, s32 numSamplesPerFrame, bool isLast);
         u16* SetupAudioDecodePtrs(u16 *rawFrameBuffer);
         s32 SetAudioFrameSizeBytesAndBits(s32 audioFrameSizeBytes);
-        static void init_Snd_tbl();
     };
 
     class InvalidDdv : public Exception
@@ -54,6 +53,9 @@ namespace Oddlib
 
         bool Update(u32* pixelBuffer, u8* audioBuffer);
 
+        // Moves to frame so the next Update() decodes it, returns the frame decoding restarts from
+        u32 Seek(u32 frame);
+
         u32 Width() const  { return mVideoHeader.mWidth;  }
         u32 Height() const { return mVideoHeader.mHeight; }
         bool HasVideo() const { return mbHasVideo; }
@@ -63,8 +65,12 @@ namespace Oddlib
         u32 FrameNumber() const { return mCurrentFrame; }
         u32 FrameRate() const { return mFileHeader.mFrameRate; }
         u32 NumberOfFrames() const { return mFileHeader.mNumberOfFrames; }
+        u32 KeyFrameRate() const { return mVideoHeader.mKeyFrameRate; }
     protected:
         void decode_audio_frame(u16 *rawFrameBuffer, u16 *outPtr, signed int numSamplesPerFrame);
+
+        // Decodes with kernels instead of the fastest ones this CPU supports
+        void SetVideoKernels(const VideoKernels& kernels) { mVideoKernels = &kernels; }
     private:
         void Read();
         void ParseVideoFrame(u32* pixelBuffer);
@@ -116,6 +122,9 @@ namespace Oddlib
         std::vector<uint32_t> mAudioFrameSizes;
         std::vector<uint32_t> mFrameSizes;
 
+        // Stream position of each frame plus the end of the last one, built from mFrameSizes on open
+        std::vector<size_t> mFrameOffsets;
+
         uint32_t mCurrentFrame = 0;
 
         std::vector<uint8_t> mVideoFrameData;
@@ -123,6 +132,13 @@ namespace Oddlib
 
         std::vector<u16> mMacroBlockBuffer;
 
+        // nullptr for BestVideoKernels()
+        const VideoKernels* mVideoKernels = nullptr;
+
+        // Dequantisation tables for the current frame, scaled by its quant scale
+        std::array<u32, 64> mYQuantTable = {};
+        std::array<u32, 64> mCbCrQuantTable = {};
+
     protected:
         std::vector<u16> mDecodedVideoFrameData;
     };
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "types.hpp"
+
+namespace Oddlib
+{
+    // IDCT output of one Masher macroblock
+    struct MasherMacroBlock
+    {
+        s32 mCr[64];
+        s32 mCb[64];
+        s32 mY[4][64]; // Top left, top right, bottom left, bottom right
+    };
+
+    // The inner loops of the FMV decoders. The scalar set is the reference, every
+    // SIMD set must produce bit identical output to it.
+    struct VideoKernels
+    {
+        const char* mName;
+
+        // Masher IDCT, the 64 coefficients are the low 16 bits of each dword of input
+        void(*mMasherIdct)(const s16* input, s32* output);
+
+        // PSX MDEC IDCT of an 8x8 block, in place
+        void(*mPsxIdct)(s16* block);
+
+        // Fixed point YCbCr to RGB of a 16x16 macroblock, only the part of it that is inside
+        // of width * height is written to pixels
+        void(*mMasherYCbCrToRgb)(const MasherMacroBlock& block, u32* pixels, s32 xoff, s32 yoff, s32 width, s32 height);
+    };
+
+    const VideoKernels& ScalarVideoKernels();
+
+    // These return nullptr if the build or the CPU doesn't support them
+    const VideoKernels* Sse2VideoKernels();
+    const VideoKernels* Avx2VideoKernels();
+
+    // The fastest set this CPU supports
+    const VideoKernels& BestVideoKernels();
+}
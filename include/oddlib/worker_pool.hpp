@@ -0,0 +1,64 @@
+#pragma once
+
+#include "types.hpp"
+#include "stdthread.h"
+#include <atomic>
+#include <condition_variable>
+#include <vector>
+
+namespace Oddlib
+{
+    // Runs a function over a range of indices in parallel. The calling thread takes part too, so
+    // For() returns once every index has been processed.
+    class IParallelFor
+    {
+    public:
+        virtual ~IParallelFor() = default;
+        virtual void For(u32 count, const std::function<void(u32)>& fn) = 0;
+    };
+
+    // Threads that run a function over a range of indices. Calls to For() from different
+    // threads are run one after the other.
+    class WorkerPool : public IParallelFor
+    {
+    public:
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator = (const WorkerPool&) = delete;
+        explicit WorkerPool(u32 numThreads);
+        ~WorkerPool();
+
+        virtual void For(u32 count, const std::function<void(u32)>& fn) override;
+
+        u32 NumThreads() const { return static_cast<u32>(mThreads.size()); }
+
+    private:
+        void RunItems();
+        void WorkerMain();
+
+        std::vector<std::thread> mThreads;
+        std::mutex mForMutex;
+        std::mutex mMutex;
+        std::condition_variable mWorkCondition;
+        std::condition_variable mDoneCondition;
+
+        const std::function<void(u32)>* mFn = nullptr;
+        u32 mCount = 0;
+        std::atomic<u32> mNext{ 0 };
+        u32 mBusyWorkers = 0;
+        u64 mGeneration = 0;
+        bool mQuit = false;
+    };
+
+    // One thread less than the number of cores since the caller of For() does work too
+    u32 DefaultWorkerThreadCount();
+
+    // Pool for one off jobs such as decoding camera images, created on first use
+    WorkerPool& SharedWorkerPool();
+
+    // What oddlib runs its one off jobs on. This is SharedWorkerPool() unless the application
+    // has set threads of its own with SetSharedParallelFor(), so there is one set of threads.
+    IParallelFor& SharedParallelFor();
+
+    // parallelFor must outlive its use, nullptr goes back to SharedWorkerPool()
+    void SetSharedParallelFor(IParallelFor* parallelFor);
+}
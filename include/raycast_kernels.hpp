@@ -0,0 +1,49 @@
+#pragma once
+
+#include "types.hpp"
+
+// End points and type bits of collision lines as separate arrays, so that SIMD kernels can
+// load the same value of several lines at once. The arrays must be padded to a multiple of
+// kRayKernelBatch lines, padding lines should have no type bits set.
+struct CollisionLineSoA
+{
+    const f32* mP1X;
+    const f32* mP1Y;
+    const f32* mP2X;
+    const f32* mP2Y;
+    const u32* mTypeBits;
+};
+
+static const u32 kRayKernelBatch = 8;
+
+// Written as the distance of lines that the ray doesn't hit
+static const f32 kRayMiss = 1e30f;
+
+struct RayKernelRay
+{
+    f32 mFromX;
+    f32 mFromY;
+    f32 mToX;
+    f32 mToY;
+    u32 mTypeMask;
+};
+
+// The scalar set is the reference, every SIMD set must give bit identical results to it
+struct RayKernels
+{
+    const char* mName;
+
+    // For each of count lines writes the distance to where the ray crosses it and the crossing
+    // point, or kRayMiss as the distance if it doesn't cross or none of its type bits are in the
+    // ray's mask. count must be a multiple of kRayKernelBatch.
+    void(*mIntersect)(const RayKernelRay& ray, const CollisionLineSoA& lines, u32 count, f32* distance, f32* hitX, f32* hitY);
+};
+
+const RayKernels& ScalarRayKernels();
+
+// These return nullptr if the build or the CPU doesn't support them
+const RayKernels* Sse2RayKernels();
+const RayKernels* AvxRayKernels();
+
+// The fastest set this CPU supports
+const RayKernels& BestRayKernels();
@@ -8,5 +8,5 @@ class AbstractRenderer;
 class RendererFactory
 {
 public:
-    static std::unique_ptr<AbstractRenderer> Create(SDL_Window* window, bool tryDirectX9);
+    static std::unique_ptr<AbstractRenderer> Create(SDL_Window* window, bool tryDirectX9, bool headless);
 };
@@ -14,6 +14,7 @@
 #include "oddlib/path.hpp"
 #include "oddlib/audio/vab.hpp"
 #include "debug.hpp"
+#include "core/jobsystem.hpp"
 #include "proxy_rapidjson.hpp"
 #include "filesystem.hpp"
 #include "sound_resources.hpp"
@@ -495,6 +496,12 @@ inline bool PointInRect(T px, T py, T x, T y, T w, T h)
     return true;
 }
 
+template<class T>
+inline bool RectsOverlap(T x1, T y1, T w1, T h1, T x2, T y2, T w2, T h2)
+{
+    return x1 < x2 + w2 && x2 < x1 + w1 && y1 < y2 + h2 && y2 < y1 + h1;
+}
+
 class Animation
 {
 public:
@@ -525,6 +532,7 @@ public:
     void SetFrame(u32 frame);
     void Restart();
     bool Collision(s32 x, s32 y) const;
+    bool Collision(s32 x, s32 y, s32 w, s32 h) const;
     void SetXPos(s32 xpos);
     void SetYPos(s32 ypos);
     s32 XPos() const;
@@ -541,6 +549,9 @@ private:
 
     f32 ScaleX() const;
 
+    // World rect of the current frame
+    void FrameRect(s32& x, s32& y, s32& w, s32& h) const;
+
     AnimationSetHolder mAnim;
     bool mIsPsx = false;
     bool mScaleFrameOffsets = false;
@@ -638,6 +649,63 @@ private:
     std::map<std::string, std::weak_ptr<Oddlib::AnimationSet>> mAnimationSets;
 };
 
+// An animation set chunk that was read from its LVL and is decoded by a streaming job
+struct PendingAnimationSet
+{
+    std::string mDataSetName;
+    std::string mLvlName;
+    std::string mFileName;
+    u32 mChunkId = 0;
+    bool mIsPsx = false;
+    std::vector<u8> mData;
+
+    // Written by the job, which keeps the set alive until it has finished
+    std::unique_ptr<Oddlib::AnimationSet> mDecoded;
+    std::string mError;
+    JobGroup mDone;
+
+    // Set when the first request that completes adds mDecoded to the cache
+    std::shared_ptr<Oddlib::AnimationSet> mCached;
+};
+
+// Animations asked for by ResourceLocator::LocateAnimations. The animation sets that weren't cached
+// are decoded in parallel while the caller carries on, requests that want a set that another
+// request is already decoding wait for that one instead of decoding it again.
+class AnimationRequest
+{
+public:
+    AnimationRequest() = default;
+    AnimationRequest(AnimationRequest&&) = default;
+    AnimationRequest& operator = (AnimationRequest&&) = delete;
+
+    // Waits for the decoding to finish and returns the animations in the order that their names
+    // were requested in, nullptr for the ones that weren't found. Must be called on the thread that
+    // made the request since it adds the decoded sets to the resource cache.
+    std::vector<std::unique_ptr<Animation>> Get();
+
+private:
+    friend class ResourceLocator;
+
+    struct Item
+    {
+        bool mFound = false;
+        std::shared_ptr<Oddlib::LvlArchive> mLvl;
+
+        // Either already in the cache or still being decoded
+        std::shared_ptr<Oddlib::AnimationSet> mAnimSet;
+        std::shared_ptr<PendingAnimationSet> mPending;
+
+        u32 mAnimationIndex = 0;
+        bool mIsPsx = false;
+        bool mScaleFrameOffsets = false;
+        u32 mBlendingMode = 0;
+        std::string mDataSetName;
+    };
+
+    ResourceCache* mCache = nullptr;
+    std::vector<Item> mItems;
+};
+
 // TODO: Provide higher level abstraction
 class ISound
 {
@@ -645,7 +713,9 @@ public:
     virtual void Load() = 0;
     virtual ~ISound() = default;
     virtual void DebugUi() = 0;
-    virtual void Play(f32* stream, u32 len) = 0;
+
+    // reverbSend is the input of the shared ReverbBus, it can be null
+    virtual void Play(f32* stream, f32* reverbSend, u32 len) = 0;
     virtual bool AtEnd() const = 0;
     virtual void Restart() = 0;
     virtual void Update() = 0;
@@ -657,7 +727,7 @@ class BaseSeqSound : public ISound
 public:
     BaseSeqSound(const char* soundName, std::unique_ptr<Vab> vab);
     virtual void DebugUi() override;
-    virtual void Play(f32* stream, u32 len) override;
+    virtual void Play(f32* stream, f32* reverbSend, u32 len) override;
     virtual bool AtEnd() const override;
     virtual void Restart() override;
     virtual void Update() override;
@@ -713,27 +783,60 @@ public:
     std::unique_ptr<class IMovie> LocateFmv(class IAudioController& audioController, const char* resourceName);
     std::unique_ptr<Animation> LocateAnimation(const char* resourceName);
 
+    // Same as calling LocateAnimation for each name, except that the animation sets are only
+    // decoded once each and on worker threads. The LVL lookups and reads are done before returning.
+    AnimationRequest LocateAnimations(const std::vector<std::string>& resourceNames);
 
     // This method should be used for debugging only - i.e so we can compare what resource X looks like
     // in dataset A and B.
     std::unique_ptr<Animation> LocateAnimation(const char* resourceName, const char* dataSetName);
 
     std::vector<std::tuple<const char*, const char*, bool>> DebugUi(const char* dataSetFilter, const char* nameFilter);
+
+    // Keep every camera that is located in a disk cache, off unless this is called
+    void EnableCameraCache(OSBaseFileSystem& fs);
+
+    // Keep compiled scripts in memory and in a disk cache, off unless this is called
+    void EnableScriptCache(OSBaseFileSystem& fs);
+
+    // Returns the compiled form of source that LocateScript returned for scriptName, or nullptr if
+    // it hasn't been compiled before
+    const std::vector<u8>* FindCompiledScript(const std::string& scriptName, const std::string& source);
+    void AddCompiledScript(const std::string& scriptName, const std::string& source, std::vector<u8> compiled);
 private:
     std::unique_ptr<ISound> DoLoadSoundEffect(const char* resourceName, const DataPaths::FileSystemInfo& fs, const std::string& strSb, const SoundEffectResource& sfxRes, const SoundEffectResourceLocation& sfxResLoc);
     std::unique_ptr<ISound> DoLoadSoundMusic(const char* resourceName, const DataPaths::FileSystemInfo& fs, const std::string& strSb, const MusicResource& sfxRes);
 
     std::unique_ptr<Animation> DoLocateAnimation(const DataPaths::FileSystemInfo& fs, const char* resourceName, const ResourceMapper::AnimMapping& animMapping);
 
+    // Where an animation lives in a data set, mLvl is the opened LVL
+    struct AnimationLocation
+    {
+        const ResourceMapper::AnimFile* mAnimFile = nullptr;
+        const ResourceMapper::DataSetFileAttributes* mAttributes = nullptr;
+        std::shared_ptr<Oddlib::LvlArchive> mLvl;
+    };
+    bool FindAnimation(const DataPaths::FileSystemInfo& fs, const ResourceMapper::AnimMapping& animMapping, AnimationLocation& location);
+    Oddlib::LvlArchive::FileChunk* FindAnimationChunk(const AnimationLocation& location);
+
     std::unique_ptr<IMovie> DoLocateFmv(IAudioController& audioController, const char* resourceName, const DataPaths::FileSystemInfo& fs, const ResourceMapper::FmvMapping& fmvMapping);
 
     std::unique_ptr<Oddlib::IBits> DoLocateCamera(const char* resourceName, bool ignoreMods);
+    bool LoadCameraChunks(const DataPaths::FileSystemInfo& fs, const char* resourceName, std::vector<u8>& bits, std::vector<u8>& fg1);
+    std::unique_ptr<Oddlib::IBits> FindCachedCamera(const std::string& name, u64 sourceHash);
+    std::unique_ptr<Oddlib::IBits> AddCachedCamera(const std::string& name, u64 sourceHash, std::unique_ptr<Oddlib::IBits> bits);
 
     std::shared_ptr<Oddlib::LvlArchive> OpenLvl(IFileSystem& fs, const std::string& dataSetName, const std::string& lvlName);
 
     ResourceCache mCache;
+
+    // Animation sets that a request is decoding, keyed the same as in mCache
+    std::map<std::string, std::weak_ptr<PendingAnimationSet>> mPendingAnimSets;
+
     ResourceMapper mResMapper;
     DataPaths mDataPaths;
+    std::unique_ptr<class CameraCache> mCameraCache;
+    std::unique_ptr<class ScriptCache> mScriptCache;
 
     friend class Fmv; // TODO: Temp debug ui
     friend class Level; // TODO: Temp debug ui
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "types.hpp"
+#include "cachefile.hpp"
+#include <map>
+#include <string>
+#include <vector>
+
+class OSBaseFileSystem;
+
+// Keeps compiled script closures, as written by sq_writeclosure, in memory and on disk under
+// {CacheDir}. They are keyed on a hash of the script source so an edited script or one that a
+// mod replaces is compiled again, and a script that is run again such as when a path is loaded
+// skips parsing and compiling.
+class ScriptCache
+{
+public:
+    ScriptCache(const ScriptCache&) = delete;
+    ScriptCache& operator = (const ScriptCache&) = delete;
+    explicit ScriptCache(OSBaseFileSystem& fs);
+
+    static u64 Hash(const std::string& scriptName, const std::string& source);
+
+    // Returns nullptr if the script isn't cached, or was compiled by another build or from other source
+    const std::vector<u8>* Find(const std::string& scriptName, u64 sourceHash);
+    void Add(const std::string& scriptName, u64 sourceHash, std::vector<u8> compiled);
+
+private:
+    std::string DiskCacheFileName(const std::string& scriptName) const;
+
+    CacheFile mFile;
+    std::map<u64, std::vector<u8>> mCompiled;
+};
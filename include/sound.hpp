@@ -5,8 +5,10 @@
 #include <string>
 #include <map>
 #include <mutex>
+#include <functional>
 #include "proxy_sqrat.hpp"
 #include "core/audiobuffer.hpp"
+#include "oddlib/audio/ReverbBus.h"
 
 class GameData;
 class IAudioController;
@@ -64,6 +66,9 @@ namespace Oddlib
     class MemoryStream;
 }
 
+// Sounds are rendered once into ogg files under {CacheDir}. Short sounds are held in
+// memory as interleaved 16bit stereo PCM, long ones (music/ambiance) are streamed from
+// the disk cache. Adding to the cache is thread safe so it can be populated from worker threads.
 class SoundCache
 {
 public:
@@ -71,12 +76,19 @@ public:
     void Sync();
     void DeleteAll();
     bool ExistsInMemoryCache(const std::string& name) const;
+    bool ExistsInDiskCache(const std::string& name) const;
+
+    // Returns the in memory copy if there is one, else streams from the disk cache
     std::unique_ptr<ISound> GetCached(const std::string& name);
     void AddToMemoryAndDiskCache(ISound& sound);
+    void AddToDiskCache(ISound& sound);
     bool AddToMemoryCacheFromDiskCache(const std::string& name);
 private:
+    std::string DiskCacheFileName(const std::string& name) const;
+
     OSBaseFileSystem& mFs;
-    std::map<std::string, std::shared_ptr<std::vector<u8>>> mSoundDataCache;
+    mutable std::mutex mMutex;
+    std::map<std::string, std::shared_ptr<std::vector<s16>>> mSoundDataCache;
 public:
     void RemoveFromMemoryCache(const std::string& name);
 };
@@ -93,10 +105,11 @@ public:
     void Render(int w, int h);
     void HandleEvent(const char* eventName);
     void SetTheme(const char* themeName);
-    void CacheMemoryResidentSounds();
+    // progress is called on the calling thread with the number of sounds done so far
+    void CacheMemoryResidentSounds(std::function<void(u32, u32)> progress = nullptr);
 private:
     void CacheActiveTheme(bool add);
-    void CacheSound(const std::string& name);
+    void CacheSounds(const std::vector<std::string>& names, bool memoryResident, const std::function<void(u32, u32)>& progress);
     void PlaySoundScript(const char* soundName);
     std::unique_ptr<ISound> PlaySound(const char* soundName, const char* explicitSoundBankName, bool useMusicRecord, bool useSfxRecord, bool useCache);
     void SoundBrowserUi();
@@ -118,5 +131,8 @@ private:
 
     std::vector<std::unique_ptr<ISound>> mSoundPlayers;
 
+    // Only accessed from the audio thread with mSoundPlayersMutex held
+    ReverbBus mReverbBus;
+
     InstanceBinder<class Sound> mScriptInstance;
 };
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "oddlib/stream.hpp"
+#include "types.hpp"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// The zip file that the streams of its entries read from. The entry streams and the ZipFileSystem
+// share the stream so every read locks the mutex and seeks to where it needs to be first.
+struct ZipArchive
+{
+    std::unique_ptr<Oddlib::IStream> mStream;
+    std::mutex mMutex;
+};
+
+// Read only stream of an entry in a zip, the entry data is read from the zip as the stream is read
+class ZipEntryStream : public Oddlib::IStream
+{
+public:
+    ZipEntryStream(const ZipEntryStream&) = delete;
+    ZipEntryStream& operator = (const ZipEntryStream&) = delete;
+
+    virtual IStream* Clone(u32 start, u32 size) override;
+    virtual void WriteBytes(const u8* pSrc, size_t srcSize) override;
+    virtual size_t Pos() const override { return mPos; }
+    virtual size_t Size() const override { return mSize; }
+    virtual bool AtEnd() const override { return mPos >= mSize; }
+    virtual const std::string& Name() const override { return mName; }
+    virtual std::string LoadAllToString() override;
+
+protected:
+    // dataOffset is where the entry data starts in the zip and dataSize is its size in the zip
+    ZipEntryStream(std::shared_ptr<ZipArchive> archive, u32 dataOffset, u32 dataSize, u32 size, const std::string& name);
+
+    // Reads from the entry data in the zip, returns how many bytes were read
+    size_t ReadData(u32 dataPos, u8* pDest, size_t destSize);
+
+    std::shared_ptr<ZipArchive> mArchive;
+    u32 mDataOffset = 0;
+    u32 mDataSize = 0;
+    size_t mSize = 0;
+    size_t mPos = 0;
+    std::string mName;
+};
+
+// Entry stored without compression (method 0). Small reads are served from a buffer that is read
+// ahead from the zip so they don't each lock and seek the zip, large reads go straight to the zip.
+class ZipStoredStream : public ZipEntryStream
+{
+public:
+    ZipStoredStream(std::shared_ptr<ZipArchive> archive, u32 dataOffset, u32 size, const std::string& name);
+
+    virtual IStream* Clone() override;
+    virtual IStream* Clone(u32 start, u32 size) override;
+    virtual void ReadBytes(u8* pDest, size_t destSize) override;
+    virtual void Seek(size_t pos) override;
+
+private:
+    static const u32 kReadAheadSize = 8192;
+
+    // Entry data from mBufferStart up to mBufferEnd
+    std::vector<u8> mBuffer;
+    size_t mBufferStart = 0;
+    size_t mBufferEnd = 0;
+};
+
+// Entry compressed with deflate (method 8), inflated as it is read. Only the last 32KB of output and
+// a buffer of compressed data are kept. Every kCheckpointInterval bytes of output the inflate state is
+// saved, a seek starts again from the nearest checkpoint before it and inflates and throws away the
+// data in between.
+class ZipInflateStream : public ZipEntryStream
+{
+public:
+    ZipInflateStream(std::shared_ptr<ZipArchive> archive, u32 dataOffset, u32 compressedSize, u32 size, const std::string& name);
+
+    virtual IStream* Clone() override;
+    virtual void ReadBytes(u8* pDest, size_t destSize) override;
+    virtual void Seek(size_t pos) override;
+
+private:
+    static const u32 kWindowSize = 32768;
+    static const u32 kInputBufferSize = 16384;
+    static const u32 kMaxCodeLength = 15;
+    static const u32 kFastBits = 10;
+    static const u32 kCheckpointInterval = 512 * 1024;
+
+    // Canonical Huffman code, codes of up to kFastBits bits are decoded with one look up
+    struct HuffmanTable
+    {
+        u16 mCount[kMaxCodeLength + 1];
+        u16 mSymbol[288];
+
+        // Symbol << 4 | code length, 0 when the code is longer than kFastBits
+        u16 mFast[1 << kFastBits];
+
+        void Build(const u8* lengths, u32 numSymbols);
+    };
+
+    enum class eState
+    {
+        eBlockHeader,
+        eStored,
+        eHuffman,
+        eDone
+    };
+
+    // Inflate state at an output position, the compressed input is read again from mDataPos
+    struct Checkpoint
+    {
+        std::vector<u8> mWindow;
+        u32 mWindowPos;
+        u32 mDataPos;
+        u64 mBitBuffer;
+        u32 mBitCount;
+        eState mState;
+        bool mFinalBlock;
+        u32 mStoredRemaining;
+        u32 mMatchRemaining;
+        u32 mMatchDistance;
+        HuffmanTable mLiteralTable;
+        HuffmanTable mDistanceTable;
+    };
+
+    void Restart();
+    void SaveCheckpoint();
+    void RestoreCheckpoint(const Checkpoint& checkpoint, size_t pos);
+    size_t Inflate(u8* pDest, size_t destSize);
+    void ReadBlockHeader();
+    void ReadDynamicTables();
+    void FillBits();
+    u32 GetBits(u32 count);
+    u32 Decode(const HuffmanTable& table);
+    void Output(u8* pDest, size_t& written, u8 value);
+
+    // Compressed input
+    std::vector<u8> mInput;
+    u32 mInputPos = 0;
+    u32 mInputEnd = 0;
+    u32 mDataPos = 0;
+    u64 mBitBuffer = 0;
+    u32 mBitCount = 0;
+
+    // Last kWindowSize bytes of output for matches to copy from
+    std::vector<u8> mWindow;
+    u32 mWindowPos = 0;
+
+    eState mState = eState::eBlockHeader;
+    bool mFinalBlock = false;
+    u32 mStoredRemaining = 0;
+    u32 mMatchRemaining = 0;
+    u32 mMatchDistance = 0;
+    HuffmanTable mLiteralTable;
+    HuffmanTable mDistanceTable;
+
+    // Checkpoint i is at output position (i + 1) * kCheckpointInterval
+    std::vector<Checkpoint> mCheckpoints;
+};
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "filesystem.hpp"
+#include "zipentrystream.hpp"
 #include "types.hpp"
+#include <unordered_map>
 
 // Actually "ZIP64" file system, which removes 65k file limit and 4GB zip file size limit
 // TODO: Add ZIP64 extensions, currently only supports "ZIP32" which is enough for now
@@ -20,6 +22,9 @@ public:
     virtual bool FileExists(std::string& fileName) override;
     virtual std::string FsPath() const override;
 
+    // The most names that looking up one name compares with, however many entries the zip has
+    u32 MaxLookupComparisons() const;
+
 private:
     const u32 kEndOfCentralDirectory = 0x06054b50;
     const u32 kEndOfCentralDirectoryRecordSizeWithMagic = 22;
@@ -42,7 +47,7 @@ private:
     bool LocateEndOfCentralDirectoryRecord();
     bool LoadCentralDirectoryRecords();
 
-    std::unique_ptr<Oddlib::IStream> mStream;
+    std::shared_ptr<ZipArchive> mArchive;
     std::string mFileName;
 
 
@@ -93,4 +98,9 @@ private:
 
 
     std::vector<CentralDirectoryRecord> mRecords;
+
+    // Index in to mRecords by IndexName() of the file name, built once by Init()
+    std::unordered_map<std::string, u32> mRecordIndex;
+    static std::string IndexName(std::string fileName);
+    const CentralDirectoryRecord* FindRecord(const std::string& fileName) const;
 };
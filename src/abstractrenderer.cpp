@@ -380,8 +380,8 @@ void AbstractRenderer::generateImGuiCommands()
             mDrawList.PrimRectUV(
                 { cmd->mX, cmd->mY },
                 { cmd->mX + cmd->mW, cmd->mY + cmd->mH },
-                { 0.0f, 0.0f },
-                { 1.0f, 1.0f },
+                { cmd->mU1, cmd->mV1 },
+                { cmd->mU2, cmd->mV2 },
                 ToImCol(cmd->mHeader.mColour));
         }
         break;
@@ -462,6 +462,11 @@ void AbstractRenderer::generateImGuiCommands()
 }
 
 void AbstractRenderer::TexturedQuad(TextureHandle texHandle, f32 x, f32 y, f32 w, f32 h, int layer, ColourU8 colour, eBlendModes blendMode, eCoordinateSystem coordinateSystem)
+{
+    TexturedQuad(texHandle, x, y, w, h, 0.0f, 0.0f, 1.0f, 1.0f, layer, colour, blendMode, coordinateSystem);
+}
+
+void AbstractRenderer::TexturedQuad(TextureHandle texHandle, f32 x, f32 y, f32 w, f32 h, f32 u1, f32 v1, f32 u2, f32 v2, int layer, ColourU8 colour, eBlendModes blendMode, eCoordinateSystem coordinateSystem)
 {
     assert(mInPath == false);
     EnsureCmdFreeSpace(sizeof(CmdTexturedQuad));
@@ -476,6 +481,10 @@ void AbstractRenderer::TexturedQuad(TextureHandle texHandle, f32 x, f32 y, f32 w
     cmd->mY = y;
     cmd->mW = w;
     cmd->mH = h;
+    cmd->mU1 = u1;
+    cmd->mV1 = v1;
+    cmd->mU2 = u2;
+    cmd->mV2 = v2;
     cmd->mTexture = texHandle;
     cmd->mHeader.mState.mBlendMode = blendMode;
     cmd->mHeader.mState.mCoordinateSystem = coordinateSystem;
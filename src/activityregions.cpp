@@ -0,0 +1,100 @@
+#include "activityregions.hpp"
+#include <algorithm>
+#include <cmath>
+
+static const s32 kNoCell = -1;
+
+const u32 ObjectTypeIds::kUnknownType;
+
+u32 ObjectTypeIds::Intern(const std::string& name)
+{
+    return mIds.insert(std::make_pair(name, static_cast<u32>(mIds.size()))).first->second;
+}
+
+u32 ObjectTypeIds::Find(const std::string& name) const
+{
+    const auto it = mIds.find(name);
+    return it != std::end(mIds) ? it->second : kUnknownType;
+}
+
+ActivityRegions::ActivityRegions()
+{
+    Reset(1.0f, 1.0f, 1, 1);
+}
+
+void ActivityRegions::Reset(f32 cellWidth, f32 cellHeight, u32 cellsX, u32 cellsY)
+{
+    mCellWidth = cellWidth > 0.0f ? cellWidth : 1.0f;
+    mCellHeight = cellHeight > 0.0f ? cellHeight : 1.0f;
+    mCellsX = std::max(static_cast<s32>(cellsX), 1);
+    mCellsY = std::max(static_cast<s32>(cellsY), 1);
+    mCells.clear();
+    mCells.resize(mCellsX * mCellsY);
+    mObjectCells.clear();
+}
+
+s32 ActivityRegions::CellX(f32 x) const
+{
+    return std::min(std::max(static_cast<s32>(std::floor(x / mCellWidth)), 0), mCellsX - 1);
+}
+
+s32 ActivityRegions::CellY(f32 y) const
+{
+    return std::min(std::max(static_cast<s32>(std::floor(y / mCellHeight)), 0), mCellsY - 1);
+}
+
+void ActivityRegions::Place(u32 index, f32 x, f32 y)
+{
+    if (index >= mObjectCells.size())
+    {
+        mObjectCells.resize(index + 1, kNoCell);
+    }
+
+    const s32 cell = (CellX(x) * mCellsY) + CellY(y);
+    const s32 oldCell = mObjectCells[index];
+    if (cell == oldCell)
+    {
+        return;
+    }
+
+    if (oldCell != kNoCell)
+    {
+        auto& objects = mCells[oldCell];
+        objects.erase(std::find(objects.begin(), objects.end(), index));
+    }
+
+    mCells[cell].push_back(index);
+    mObjectCells[index] = cell;
+}
+
+void ActivityRegions::Gather(s32 cellX, s32 cellY, s32 radius, std::vector<u32>& indices) const
+{
+    GatherCells(cellX - radius, cellX + radius, cellY - radius, cellY + radius, indices);
+}
+
+void ActivityRegions::GatherRect(f32 x, f32 y, f32 w, f32 h, std::vector<u32>& indices) const
+{
+    GatherCells(CellX(x) - 1, CellX(x + w) + 1, CellY(y) - 1, CellY(y + h) + 1, indices);
+}
+
+void ActivityRegions::GatherCells(s32 minX, s32 maxX, s32 minY, s32 maxY, std::vector<u32>& indices) const
+{
+    indices.clear();
+
+    minX = std::max(minX, 0);
+    maxX = std::min(maxX, mCellsX - 1);
+    minY = std::max(minY, 0);
+    maxY = std::min(maxY, mCellsY - 1);
+    for (s32 x = minX; x <= maxX; x++)
+    {
+        for (s32 y = minY; y <= maxY; y++)
+        {
+            const auto& objects = mCells[(x * mCellsY) + y];
+            indices.insert(indices.end(), objects.begin(), objects.end());
+        }
+    }
+
+    // Objects are updated and drawn in the same order as when every object was visited, and
+    // queries find the same object first as a scan of every object would
+    std::sort(indices.begin(), indices.end());
+}
@@ -1,15 +1,31 @@
 #include "audioconverter.hpp"
 #include "resourcemapper.hpp"
+#include "oddlib/audio/ReverbBus.h"
+#include <algorithm>
+#include <atomic>
+#include <ctime>
+
+// Don't want the unused static callbacks from vorbisfile.h
+#define OV_EXCLUDE_STATIC_CALLBACKS
+#include <vorbis/vorbisfile.h>
 
 template void AudioConverter::Convert<OggEncoder>(ISound& sound, const char* outputName);
 template void AudioConverter::Convert<WavEncoder>(ISound& sound, const char* outputName);
+template void AudioConverter::Convert<OggAndPcmEncoder>(ISound& sound, OggAndPcmEncoder& encoder);
 
 template<class EncoderAlgorithm>
 void AudioConverter::Convert(ISound& sound, const char* outputName)
+{
+    EncoderAlgorithm encoder(outputName);
+    Convert(sound, encoder);
+}
+
+template<class EncoderAlgorithm>
+void AudioConverter::Convert(ISound& sound, EncoderAlgorithm& encoder)
 {
     TRACE_ENTRYEXIT;
 
-    EncoderAlgorithm encoder(outputName);
+    ReverbBus reverb;
 
     for (;;)
     {
@@ -17,7 +33,9 @@ void AudioConverter::Convert(ISound& sound, const char* outputName)
 
         sound.Update();
 
-        sound.Play(buffer, 1024);
+        reverb.Begin(1024);
+        sound.Play(buffer, reverb.Send(), 1024);
+        reverb.Mix(buffer, 1024);
         const bool endOfAudio = sound.AtEnd();
         u32 numSamplesToUse = 1024;
         if (endOfAudio)
@@ -33,7 +51,11 @@ void AudioConverter::Convert(ISound& sound, const char* outputName)
             }
         }
 
-        encoder.Consume(buffer, numSamplesToUse * sizeof(f32));
+        // An empty buffer marks the end of the stream for some encoders, that is left to Finish()
+        if (numSamplesToUse > 0)
+        {
+            encoder.Consume(buffer, numSamplesToUse * sizeof(f32));
+        }
 
         if (endOfAudio)
         {
@@ -119,10 +141,14 @@ void WavEncoder::Finish()
     mHeader.FixHeaderSizes(mStream);
 }
 
+// Serial numbers only need to differ between streams that could be chained together, encoders
+// run on the sound cache workers so this can't use rand()
+static std::atomic<int> sNextOggSerialNumber{ static_cast<int>(time(NULL)) };
+
 OggEncoder::OggEncoder(const char* outputName)
 {
     output = fopen(outputName, "wb");
-    InitEncoder();
+    InitEncoder(sNextOggSerialNumber++);
 }
 
 OggEncoder::~OggEncoder()
@@ -138,9 +164,16 @@ OggEncoder::~OggEncoder()
 
 void OggEncoder::Consume(float* readbuffer, long bufferSizeInBytes)
 {
+    if (mEndOfStream)
+    {
+        // libvorbis would carry on writing pages after the end of stream page
+        return;
+    }
+
     if (bufferSizeInBytes == 0)
     {
         // Mark as the last frame
+        mEndOfStream = true;
         vorbis_analysis_wrote(&vd, 0);
     }
     else
@@ -179,20 +212,33 @@ void OggEncoder::Consume(float* readbuffer, long bufferSizeInBytes)
             ogg_stream_packetin(&os, &op);
 
             /* write out pages (if any) */
-            int result = ogg_stream_pageout(&os, &og);
-            if (result == 0)
+            for (;;)
             {
-                // Error or not enough data, ogg_stream_flush can force a new page
-                break;
-            }
+                if (ogg_stream_pageout(&os, &og) == 0)
+                {
+                    // Not enough data for a full page yet
+                    break;
+                }
+
+                fwrite(og.header, 1, og.header_len, output);
+                fwrite(og.body, 1, og.body_len, output);
 
-            fwrite(og.header, 1, og.header_len, output);
-            fwrite(og.body, 1, og.body_len, output);
+                if (ogg_page_eos(&og))
+                {
+                    break;
+                }
+            }
         }
     }
 }
 
-void OggEncoder::InitEncoder()
+void OggEncoder::Finish()
+{
+    // Marks the end of the stream which flushes out the remaining pages
+    Consume(nullptr, 0);
+}
+
+void OggEncoder::InitEncoder(int serialNumber)
 {
     vorbis_info_init(&vi);
 
@@ -207,10 +253,7 @@ void OggEncoder::InitEncoder()
     vorbis_block_init(&vd, &vb);
 
     /* set up our packet->stream encoder */
-    /* pick a random serial number; that way we can more likely build
-    chained streams just by concatenation */
-    srand(static_cast<unsigned int>(time(NULL)));
-    ogg_stream_init(&os, rand());
+    ogg_stream_init(&os, serialNumber);
 
     /* Vorbis streams begin with three headers; the initial header (with
     most of the codec setup parameters) which is mandated by the Ogg
@@ -236,3 +279,158 @@ void OggEncoder::InitEncoder()
     fwrite(og.header, 1, og.header_len, output);
     fwrite(og.body, 1, og.body_len, output);
 }
+
+OggAndPcmEncoder::OggAndPcmEncoder(const char* outputName)
+    : mOgg(outputName)
+{
+
+}
+
+void OggAndPcmEncoder::Consume(float* readbuffer, long bufferSizeInBytes)
+{
+    if (bufferSizeInBytes == 0)
+    {
+        return;
+    }
+
+    mOgg.Consume(readbuffer, bufferSizeInBytes);
+
+    const u32 kNumFloats = bufferSizeInBytes / sizeof(float);
+    for (u32 i = 0; i < kNumFloats; i++)
+    {
+        const f32 clamped = std::max(-1.0f, std::min(1.0f, readbuffer[i]));
+        mPcm.push_back(static_cast<s16>(clamped * 32767.0f));
+    }
+}
+
+void OggAndPcmEncoder::Finish()
+{
+    mOgg.Finish();
+    mPcm.shrink_to_fit();
+}
+
+OggStream::OggStream()
+{
+
+}
+
+OggStream::~OggStream()
+{
+    Close();
+}
+
+bool OggStream::Open(const char* fileName)
+{
+    Close();
+    mCorrupted = false;
+
+    mFile = std::make_unique<OggVorbis_File>();
+    if (ov_fopen(fileName, mFile.get()) != 0)
+    {
+        LOG_ERROR("Failed to open ogg file: " << fileName);
+        mFile = nullptr;
+        return false;
+    }
+
+    const vorbis_info* info = ov_info(mFile.get(), -1);
+    if (!info || info->channels != 2)
+    {
+        LOG_ERROR("Expected a stereo ogg file: " << fileName);
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void OggStream::Close()
+{
+    if (mFile)
+    {
+        ov_clear(mFile.get());
+        mFile = nullptr;
+    }
+}
+
+u32 OggStream::Read(s16* pcm, u32 numSamples)
+{
+    if (!mFile || mCorrupted)
+    {
+        return 0;
+    }
+
+    u32 samplesRead = 0;
+    while (samplesRead < numSamples)
+    {
+        // Little endian, 16bit, signed
+        int bitStream = 0;
+        const long bytesRead = ov_read(mFile.get(), reinterpret_cast<char*>(pcm + samplesRead), static_cast<int>((numSamples - samplesRead) * sizeof(s16)), 0, 2, 1, &bitStream);
+        if (bytesRead == 0)
+        {
+            break;
+        }
+
+        if (bytesRead == OV_HOLE)
+        {
+            // Recoverable gap in the data
+            continue;
+        }
+
+        if (bytesRead < 0)
+        {
+            LOG_ERROR("Corrupted ogg stream");
+            mCorrupted = true;
+            break;
+        }
+
+        samplesRead += static_cast<u32>(bytesRead / sizeof(s16));
+    }
+    return samplesRead;
+}
+
+bool OggStream::Rewind()
+{
+    mCorrupted = false;
+    return mFile && ov_pcm_seek(mFile.get(), 0) == 0;
+}
+
+u64 OggStream::TotalSamples() const
+{
+    if (!mFile)
+    {
+        return 0;
+    }
+
+    const ogg_int64_t frames = ov_pcm_total(mFile.get(), -1);
+    return frames > 0 ? static_cast<u64>(frames) * 2 : 0;
+}
+
+/*static*/ bool OggDecoder::Decode(const char* fileName, std::vector<s16>& pcm)
+{
+    OggStream stream;
+    if (!stream.Open(fileName))
+    {
+        return false;
+    }
+
+    pcm.clear();
+    pcm.reserve(static_cast<size_t>(stream.TotalSamples()));
+
+    s16 buffer[4096];
+    for (;;)
+    {
+        const u32 samplesRead = stream.Read(buffer, 4096);
+        if (samplesRead == 0)
+        {
+            break;
+        }
+        pcm.insert(pcm.end(), buffer, buffer + samplesRead);
+    }
+
+    if (stream.Corrupted() || pcm.size() != stream.TotalSamples())
+    {
+        LOG_ERROR("Decoded " << pcm.size() << " of " << stream.TotalSamples() << " samples from " << fileName);
+        pcm.clear();
+        return false;
+    }
+    return true;
+}
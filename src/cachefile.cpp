@@ -0,0 +1,110 @@
+#include "cachefile.hpp"
+#include "hash_util.hpp"
+#include "filesystem.hpp"
+#include "oddlib/stream.hpp"
+#include "oddlib/exceptions.hpp"
+#include "logger.hpp"
+#include "alive_version.h"
+
+struct CacheFile::Header
+{
+    u32 mMagic;
+    u32 mFormat;
+    u32 mPayloadSize;
+    u32 mPadding;
+    u64 mVersionHash;
+    u64 mSourceHash;
+    u64 mPayloadHash;
+};
+
+CacheFile::CacheFile(OSBaseFileSystem& fs, u32 magic, u32 format, u32 maxPayloadSize)
+    : mFs(fs), mMagic(magic), mFormat(format), mMaxPayloadSize(maxPayloadSize)
+{
+    // Decoder or Squirrel changes can change what is cached, so files from other builds are never used
+    const std::string version = ALIVE_VERSION;
+    mVersionHash = hash_util::Fnv1a(version);
+}
+
+std::unique_ptr<Oddlib::IStream> CacheFile::OpenPayload(const std::string& fileName, u64 sourceHash, Header& header)
+{
+    std::string name = fileName;
+    if (!mFs.FileExists(name))
+    {
+        return nullptr;
+    }
+
+    auto stream = mFs.Open(fileName);
+    if (stream->Size() < sizeof(header))
+    {
+        return nullptr;
+    }
+
+    stream->ReadBytes(reinterpret_cast<u8*>(&header), sizeof(header));
+    if (header.mMagic != mMagic || header.mFormat != mFormat || header.mVersionHash != mVersionHash || header.mSourceHash != sourceHash)
+    {
+        // Stale, will be replaced when it is added again
+        return nullptr;
+    }
+
+    if (header.mPayloadSize == 0 || header.mPayloadSize > mMaxPayloadSize || stream->Size() - sizeof(header) != header.mPayloadSize)
+    {
+        LOG_ERROR("Cache file " << fileName << " is truncated");
+        return nullptr;
+    }
+    return stream;
+}
+
+std::unique_ptr<Oddlib::IStream> CacheFile::Open(const std::string& fileName, u64 sourceHash)
+{
+    Header header = {};
+    return OpenPayload(fileName, sourceHash, header);
+}
+
+bool CacheFile::Read(const std::string& fileName, u64 sourceHash, std::vector<u8>& payload)
+{
+    Header header = {};
+    auto stream = OpenPayload(fileName, sourceHash, header);
+    if (!stream)
+    {
+        return false;
+    }
+
+    payload.resize(header.mPayloadSize);
+    stream->ReadBytes(payload.data(), payload.size());
+    if (hash_util::Fnv1a(payload) != header.mPayloadHash)
+    {
+        LOG_ERROR("Cache file " << fileName << " is corrupt");
+        payload.clear();
+        return false;
+    }
+    return true;
+}
+
+void CacheFile::Write(const std::string& fileName, u64 sourceHash, const std::vector<u8>& payload)
+{
+    if (payload.empty() || payload.size() > mMaxPayloadSize)
+    {
+        return;
+    }
+
+    try
+    {
+        auto stream = mFs.Create(fileName);
+
+        Header header = {};
+        header.mMagic = mMagic;
+        header.mFormat = mFormat;
+        header.mPayloadSize = static_cast<u32>(payload.size());
+        header.mVersionHash = mVersionHash;
+        header.mSourceHash = sourceHash;
+        header.mPayloadHash = hash_util::Fnv1a(payload);
+        stream->WriteBytes(reinterpret_cast<const u8*>(&header), sizeof(header));
+        stream->WriteBytes(payload.data(), payload.size());
+    }
+    catch (const Oddlib::Exception& ex)
+    {
+        // Don't leave a partial file behind
+        LOG_ERROR("Failed to write cache file " << fileName << ": " << ex.what());
+        mFs.DeleteFile(mFs.ExpandPath(fileName));
+    }
+}
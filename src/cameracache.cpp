@@ -0,0 +1,207 @@
+#include "cameracache.hpp"
+#include "oddlib/bits_factory.hpp"
+#include "oddlib/lvlarchive.hpp"
+#include "oddlib/stream.hpp"
+#include "logger.hpp"
+
+// The payload of the cache file is the number of images, then for the camera and the optional FG1
+// atlas an image header followed by its rows of pixels without any padding, then the number of
+// FG1 tiles and the tiles
+static const u32 kCameraCacheMagic = Oddlib::MakeType("CAMC");
+static const u32 kCameraCacheFormat = 3;
+static const u32 kMaxImageSize = 4096;
+static const u32 kMaxPayloadSize = 2 * kMaxImageSize * kMaxImageSize * sizeof(u32) + 1024 * 1024;
+
+struct CameraCacheImageHeader
+{
+    u32 mWidth;
+    u32 mHeight;
+    u32 mBitsPerPixel;
+    u32 mRMask;
+    u32 mGMask;
+    u32 mBMask;
+    u32 mAMask;
+};
+
+static void Append(std::vector<u8>& payload, const void* data, size_t size)
+{
+    payload.insert(payload.end(), static_cast<const u8*>(data), static_cast<const u8*>(data) + size);
+}
+
+static void WriteImage(std::vector<u8>& payload, const SDL_Surface* surface)
+{
+    CameraCacheImageHeader header = {};
+    header.mWidth = surface->w;
+    header.mHeight = surface->h;
+    header.mBitsPerPixel = surface->format->BitsPerPixel;
+    header.mRMask = surface->format->Rmask;
+    header.mGMask = surface->format->Gmask;
+    header.mBMask = surface->format->Bmask;
+    header.mAMask = surface->format->Amask;
+    Append(payload, &header, sizeof(header));
+
+    const u32 rowSize = surface->w * surface->format->BytesPerPixel;
+    const u8* pixels = static_cast<const u8*>(surface->pixels);
+    for (int y = 0; y < surface->h; y++)
+    {
+        Append(payload, pixels + (y * surface->pitch), rowSize);
+    }
+}
+
+static SDL_SurfacePtr ReadImage(Oddlib::IStream& stream)
+{
+    CameraCacheImageHeader header = {};
+    stream.ReadBytes(reinterpret_cast<u8*>(&header), sizeof(header));
+    if (header.mWidth == 0 || header.mWidth > kMaxImageSize || header.mHeight == 0 || header.mHeight > kMaxImageSize)
+    {
+        return nullptr;
+    }
+
+    // Don't allocate an image that is bigger than what is left to read
+    const u64 imageSize = static_cast<u64>(header.mWidth) * header.mHeight * ((header.mBitsPerPixel + 7) / 8);
+    if (header.mBitsPerPixel == 0 || header.mBitsPerPixel > 32 || imageSize > stream.Size() - stream.Pos())
+    {
+        return nullptr;
+    }
+
+    SDL_SurfacePtr surface(SDL_CreateRGBSurface(0, header.mWidth, header.mHeight, header.mBitsPerPixel, header.mRMask, header.mGMask, header.mBMask, header.mAMask));
+    if (!surface)
+    {
+        return nullptr;
+    }
+
+    // Usually the rows aren't padded so the whole image is one read
+    const u32 rowSize = surface->w * surface->format->BytesPerPixel;
+    u8* pixels = static_cast<u8*>(surface->pixels);
+    if (static_cast<u32>(surface->pitch) == rowSize)
+    {
+        stream.ReadBytes(pixels, rowSize * surface->h);
+    }
+    else
+    {
+        for (int y = 0; y < surface->h; y++)
+        {
+            stream.ReadBytes(pixels + (y * surface->pitch), rowSize);
+        }
+    }
+    return surface;
+}
+
+static void WriteFg1(std::vector<u8>& payload, const Oddlib::IFg1& fg1)
+{
+    WriteImage(payload, fg1.GetAtlas());
+
+    const std::vector<Oddlib::Fg1Tile>& tiles = fg1.GetTiles();
+    const u32 numTiles = static_cast<u32>(tiles.size());
+    Append(payload, &numTiles, sizeof(numTiles));
+    Append(payload, tiles.data(), sizeof(Oddlib::Fg1Tile) * numTiles);
+}
+
+static std::unique_ptr<Oddlib::IFg1> ReadFg1(Oddlib::IStream& stream, const SDL_Surface* camera)
+{
+    SDL_SurfacePtr atlas = ReadImage(stream);
+    if (!atlas || atlas->format->BitsPerPixel != 32)
+    {
+        return nullptr;
+    }
+
+    u32 numTiles = 0;
+    stream.ReadBytes(reinterpret_cast<u8*>(&numTiles), sizeof(numTiles));
+
+    // Each tile has at least one FG1 block of the camera to itself
+    const u32 maxTiles = ((camera->w + Oddlib::kFg1BlockWidth - 1) / Oddlib::kFg1BlockWidth) * ((camera->h + Oddlib::kFg1BlockHeight - 1) / Oddlib::kFg1BlockHeight);
+    if (numTiles == 0 || numTiles > maxTiles || sizeof(Oddlib::Fg1Tile) * numTiles > stream.Size() - stream.Pos())
+    {
+        return nullptr;
+    }
+
+    std::vector<Oddlib::Fg1Tile> tiles(numTiles);
+    stream.ReadBytes(reinterpret_cast<u8*>(tiles.data()), sizeof(Oddlib::Fg1Tile) * numTiles);
+    for (const Oddlib::Fg1Tile& tile : tiles)
+    {
+        if (tile.mX + tile.mW > camera->w || tile.mY + tile.mH > camera->h ||
+            tile.mAtlasX + tile.mW > atlas->w || tile.mAtlasY + tile.mH > atlas->h)
+        {
+            return nullptr;
+        }
+    }
+    return Oddlib::MakeFg1(std::move(atlas), std::move(tiles));
+}
+
+CameraCache::CameraCache(OSBaseFileSystem& fs)
+    : mFile(fs, kCameraCacheMagic, kCameraCacheFormat, kMaxPayloadSize)
+{
+
+}
+
+std::string CameraCache::DiskCacheFileName(const std::string& name) const
+{
+    return "{CacheDir}/" + name + ".camcache";
+}
+
+std::unique_ptr<Oddlib::IBits> CameraCache::Find(const std::string& name, u64 sourceHash)
+{
+    const std::string fileName = DiskCacheFileName(name);
+    try
+    {
+        // The payload isn't hashed as that would be another pass over every pixel on each load,
+        // everything read is checked instead and damaged pixels do no harm
+        auto stream = mFile.Open(fileName, sourceHash);
+        if (!stream)
+        {
+            return nullptr;
+        }
+
+        u32 numImages = 0;
+        stream->ReadBytes(reinterpret_cast<u8*>(&numImages), sizeof(numImages));
+        if (numImages != 1 && numImages != 2)
+        {
+            return nullptr;
+        }
+
+        SDL_SurfacePtr camera = ReadImage(*stream);
+        if (!camera)
+        {
+            return nullptr;
+        }
+
+        std::unique_ptr<Oddlib::IFg1> fg1;
+        if (numImages == 2)
+        {
+            fg1 = ReadFg1(*stream, camera.get());
+            if (!fg1)
+            {
+                return nullptr;
+            }
+        }
+
+        LOG_INFO("Loaded camera " << name << " from disk cache");
+        return Oddlib::MakeBits(std::move(camera), std::move(fg1));
+    }
+    catch (const Oddlib::Exception& ex)
+    {
+        LOG_ERROR("Failed to read cached camera " << fileName << ": " << ex.what());
+        return nullptr;
+    }
+}
+
+void CameraCache::Add(const std::string& name, u64 sourceHash, const Oddlib::IBits& bits)
+{
+    const SDL_Surface* camera = bits.GetSurface();
+    // An FG1 without tiles draws nothing so it isn't kept
+    const Oddlib::IFg1* fg1 = bits.GetFg1() && !bits.GetFg1()->IsEmpty() ? bits.GetFg1() : nullptr;
+    if (!camera)
+    {
+        return;
+    }
+
+    const u32 numImages = fg1 ? 2 : 1;
+    std::vector<u8> payload;
+    Append(payload, &numImages, sizeof(numImages));
+    WriteImage(payload, camera);
+    if (fg1)
+    {
+        WriteFg1(payload, *fg1);
+    }
+    mFile.Write(DiskCacheFileName(name), sourceHash, payload);
+}
@@ -1,7 +1,10 @@
 #include "collisionline.hpp"
+#include "raycast_kernels.hpp"
 #include <glm/glm.hpp>
 #include <glm/gtx/vector_angle.hpp>
 #include "reverse_for.hpp"
+#include <algorithm>
+#include <cmath>
 
 /*static*/ const std::map<CollisionLine::eLineTypes, CollisionLine::LineData> CollisionLine::mData =
 {
@@ -23,6 +26,279 @@
     { eUnknown,             { "Unknown",                { 255, 0, 255, 255 } } }
 };
 
+// Smallest size of a grid cell in world units, a camera is 375x260
+static const f32 kCellSize = 128.0f;
+
+// Cells get bigger on maps that are so large that they would need more than this many
+static const s32 kMaxCellsPerAxis = 256;
+
+// Lines are added to the cells around them too so rounding in the intersection tests can't
+// find a hit in a cell that the line wasn't added to
+static const f32 kLineMargin = 1.0f;
+
+CollisionLines::CollisionLines() = default;
+
+CollisionLines::~CollisionLines() = default;
+
+void CollisionLines::resize(size_t size)
+{
+    mLines.resize(size);
+    mDirty = true;
+}
+
+void CollisionLines::clear()
+{
+    mLines.clear();
+    mDirty = true;
+}
+
+void CollisionLines::LineMoved(u32 index)
+{
+    if (mDirty)
+    {
+        return;
+    }
+
+    CellRange range;
+    if (!LineCells(index, range))
+    {
+        // Moved off the grid, it will be rebuilt to cover the new area
+        mDirty = true;
+        return;
+    }
+
+    RemoveFromCells(index, mLineCells[index]);
+    AddToCells(index, range);
+
+    const Line& line = mLines[index]->mLine;
+    mP1X[index] = line.mP1.x;
+    mP1Y[index] = line.mP1.y;
+    mP2X[index] = line.mP2.x;
+    mP2Y[index] = line.mP2.y;
+}
+
+void CollisionLines::Query(const glm::vec2& min, const glm::vec2& max, u32 typeMask, std::vector<u32>& indices) const
+{
+    if (mDirty)
+    {
+        Rebuild();
+    }
+
+    indices.clear();
+    if (mCells.empty())
+    {
+        return;
+    }
+
+    // Every line is inside of the grid so only the cells the area overlaps need checking
+    const s32 x1 = std::max(static_cast<s32>(std::floor((min.x - mOrigin.x) / mCellSize)), 0);
+    const s32 y1 = std::max(static_cast<s32>(std::floor((min.y - mOrigin.y) / mCellSize)), 0);
+    const s32 x2 = std::min(static_cast<s32>(std::floor((max.x - mOrigin.x) / mCellSize)), mCellsX - 1);
+    const s32 y2 = std::min(static_cast<s32>(std::floor((max.y - mOrigin.y) / mCellSize)), mCellsY - 1);
+    for (s32 y = y1; y <= y2; y++)
+    {
+        for (s32 x = x1; x <= x2; x++)
+        {
+            const Cell& cell = mCells[(y * mCellsX) + x];
+            if (!(cell.mTypeMask & typeMask))
+            {
+                continue;
+            }
+
+            for (const CellEntry& entry : cell.mEntries)
+            {
+                if (entry.mTypeBit & typeMask)
+                {
+                    indices.push_back(entry.mIndex);
+                }
+            }
+        }
+    }
+
+    // Lines that cross cells are found more than once, keeping the original order also
+    // means that the first line wins when two are hit at the same distance as before
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+}
+
+namespace
+{
+    // The candidate lines of a batch packed for the kernels, along with the kernel outputs
+    struct RayBatchScratch
+    {
+        std::vector<u32> mCandidates;
+        std::vector<f32> mP1X;
+        std::vector<f32> mP1Y;
+        std::vector<f32> mP2X;
+        std::vector<f32> mP2Y;
+        std::vector<u32> mTypeBits;
+        std::vector<f32> mDistance;
+        std::vector<f32> mHitX;
+        std::vector<f32> mHitY;
+    };
+}
+
+void CollisionLines::RayCastBatch(const RayCastQuery* rays, u32 count, RayCastHit* hits) const
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    glm::vec2 min = glm::min(rays[0].mFrom, rays[0].mTo);
+    glm::vec2 max = glm::max(rays[0].mFrom, rays[0].mTo);
+    u32 typeMask = 0;
+    for (u32 i = 0; i < count; i++)
+    {
+        min = glm::min(min, glm::min(rays[i].mFrom, rays[i].mTo));
+        max = glm::max(max, glm::max(rays[i].mFrom, rays[i].mTo));
+        typeMask |= rays[i].mTypeMask;
+        hits[i] = RayCastHit();
+    }
+
+    thread_local RayBatchScratch scratch;
+    Query(min, max, typeMask, scratch.mCandidates);
+    const u32 numCandidates = static_cast<u32>(scratch.mCandidates.size());
+    if (numCandidates == 0)
+    {
+        return;
+    }
+
+    // Padding lines have no type bits so they are never hit
+    const u32 paddedCount = ((numCandidates + kRayKernelBatch - 1) / kRayKernelBatch) * kRayKernelBatch;
+    scratch.mP1X.resize(paddedCount);
+    scratch.mP1Y.resize(paddedCount);
+    scratch.mP2X.resize(paddedCount);
+    scratch.mP2Y.resize(paddedCount);
+    scratch.mTypeBits.resize(paddedCount);
+    scratch.mDistance.resize(paddedCount);
+    scratch.mHitX.resize(paddedCount);
+    scratch.mHitY.resize(paddedCount);
+    for (u32 i = 0; i < paddedCount; i++)
+    {
+        const u32 index = i < numCandidates ? scratch.mCandidates[i] : 0;
+        scratch.mP1X[i] = mP1X[index];
+        scratch.mP1Y[i] = mP1Y[index];
+        scratch.mP2X[i] = mP2X[index];
+        scratch.mP2Y[i] = mP2Y[index];
+        scratch.mTypeBits[i] = i < numCandidates ? mTypeBits[index] : 0;
+    }
+
+    const CollisionLineSoA soa = { scratch.mP1X.data(), scratch.mP1Y.data(), scratch.mP2X.data(), scratch.mP2Y.data(), scratch.mTypeBits.data() };
+    static const RayKernels& kernels = BestRayKernels();
+    for (u32 i = 0; i < count; i++)
+    {
+        const RayKernelRay ray = { rays[i].mFrom.x, rays[i].mFrom.y, rays[i].mTo.x, rays[i].mTo.y, rays[i].mTypeMask };
+        kernels.mIntersect(ray, soa, paddedCount, scratch.mDistance.data(), scratch.mHitX.data(), scratch.mHitY.data());
+
+        // Candidates are in line order so the first of two lines at the same distance wins, as it always has
+        f32 nearestDistance = kRayMiss;
+        for (u32 j = 0; j < numCandidates; j++)
+        {
+            if (scratch.mDistance[j] < nearestDistance)
+            {
+                nearestDistance = scratch.mDistance[j];
+                hits[i].mLine = static_cast<s32>(scratch.mCandidates[j]);
+                hits[i].mIntersection = glm::vec2(scratch.mHitX[j], scratch.mHitY[j]);
+            }
+        }
+    }
+}
+
+void CollisionLines::Rebuild() const
+{
+    mDirty = false;
+    mCells.clear();
+    mLineCells.assign(mLines.size(), CellRange());
+    mP1X.resize(mLines.size());
+    mP1Y.resize(mLines.size());
+    mP2X.resize(mLines.size());
+    mP2Y.resize(mLines.size());
+    mTypeBits.resize(mLines.size());
+    mCellsX = 0;
+    mCellsY = 0;
+    if (mLines.empty())
+    {
+        return;
+    }
+
+    glm::vec2 min = glm::min(mLines[0]->mLine.mP1, mLines[0]->mLine.mP2);
+    glm::vec2 max = glm::max(mLines[0]->mLine.mP1, mLines[0]->mLine.mP2);
+    for (const std::unique_ptr<CollisionLine>& line : mLines)
+    {
+        min = glm::min(min, glm::min(line->mLine.mP1, line->mLine.mP2));
+        max = glm::max(max, glm::max(line->mLine.mP1, line->mLine.mP2));
+    }
+    min -= glm::vec2(kLineMargin);
+    max += glm::vec2(kLineMargin);
+
+    const glm::vec2 size = max - min;
+    mOrigin = min;
+    mCellSize = std::max(kCellSize, std::max(size.x, size.y) / kMaxCellsPerAxis);
+    mCellsX = static_cast<s32>(size.x / mCellSize) + 1;
+    mCellsY = static_cast<s32>(size.y / mCellSize) + 1;
+    mCells.resize(mCellsX * mCellsY);
+
+    for (u32 i = 0; i < mLines.size(); i++)
+    {
+        CellRange range;
+        LineCells(i, range);
+        AddToCells(i, range);
+
+        const CollisionLine& line = *mLines[i];
+        mP1X[i] = line.mLine.mP1.x;
+        mP1Y[i] = line.mLine.mP1.y;
+        mP2X[i] = line.mLine.mP2.x;
+        mP2Y[i] = line.mLine.mP2.y;
+        mTypeBits[i] = TypeBit(line.mType);
+    }
+}
+
+bool CollisionLines::LineCells(u32 index, CellRange& range) const
+{
+    const Line& line = mLines[index]->mLine;
+    const glm::vec2 min = glm::min(line.mP1, line.mP2) - glm::vec2(kLineMargin) - mOrigin;
+    const glm::vec2 max = glm::max(line.mP1, line.mP2) + glm::vec2(kLineMargin) - mOrigin;
+    range.mX1 = static_cast<s32>(std::floor(min.x / mCellSize));
+    range.mY1 = static_cast<s32>(std::floor(min.y / mCellSize));
+    range.mX2 = static_cast<s32>(std::floor(max.x / mCellSize));
+    range.mY2 = static_cast<s32>(std::floor(max.y / mCellSize));
+    return range.mX1 >= 0 && range.mY1 >= 0 && range.mX2 < mCellsX && range.mY2 < mCellsY;
+}
+
+void CollisionLines::AddToCells(u32 index, const CellRange& range) const
+{
+    const u32 typeBit = TypeBit(mLines[index]->mType);
+    for (s32 y = range.mY1; y <= range.mY2; y++)
+    {
+        for (s32 x = range.mX1; x <= range.mX2; x++)
+        {
+            Cell& cell = mCells[(y * mCellsX) + x];
+            cell.mEntries.push_back({ index, typeBit });
+            cell.mTypeMask |= typeBit;
+        }
+    }
+    mLineCells[index] = range;
+}
+
+void CollisionLines::RemoveFromCells(u32 index, const CellRange& range) const
+{
+    for (s32 y = range.mY1; y <= range.mY2; y++)
+    {
+        for (s32 x = range.mX1; x <= range.mX2; x++)
+        {
+            Cell& cell = mCells[(y * mCellsX) + x];
+            cell.mEntries.erase(std::remove_if(cell.mEntries.begin(), cell.mEntries.end(), [index](const CellEntry& entry) { return entry.mIndex == index; }), cell.mEntries.end());
+
+            cell.mTypeMask = 0;
+            for (const CellEntry& entry : cell.mEntries)
+            {
+                cell.mTypeMask |= entry.mTypeBit;
+            }
+        }
+    }
+}
+
 bool CollisionLine::SetSelected(bool selected)
 {
     mSelected = selected;
@@ -84,10 +360,14 @@ static glm::vec2 ArrowHeadP2(const Line& line, const glm::vec2& unitVec)
     }
     */
 
-    s32 idx = static_cast<s32>(lines.size());
-    for (const std::unique_ptr<CollisionLine>& item : reverse_for(lines))
+    // Only lines in the cells around pos can be close enough, the last line wins as it is drawn on top
+    const f32 width = 10.0f * lineScale;
+    const glm::vec2 margin((width / 2.0f) + 1.0f);
+    std::vector<u32> candidates;
+    lines.Query(pos - margin, pos + margin, ~0u, candidates);
+    for (u32 idx : reverse_for(candidates))
     {
-        idx--;
+        const std::unique_ptr<CollisionLine>& item = lines[idx];
 
         /*
         // Check collision with the arrow head triangle, if there is one
@@ -106,9 +386,9 @@ static glm::vec2 ArrowHeadP2(const Line& line, const glm::vec2& unitVec)
 
         // TODO: Adjust P1 depending on if there is an arrow head or not
         // Check collision with the main line segment
-        if (Physics::IsPointInThickLine(item->mLine.mP1, item->mLine.mP2, pos, 10.0f * lineScale))
+        if (Physics::IsPointInThickLine(item->mLine.mP1, item->mLine.mP2, pos, width))
         {
-            return idx;
+            return static_cast<s32>(idx);
         }
 
         /*
@@ -0,0 +1,412 @@
+#include "core/jobsystem.hpp"
+#include "logger.hpp"
+#include <algorithm>
+
+// The job system and worker index of the current thread, if it is a worker
+static thread_local const JobSystem* tJobSystem = nullptr;
+static thread_local u32 tWorkerIndex = 0;
+
+// Set while a worker runs a streaming job, jobs it runs while waiting inside it don't take another
+// streaming slot
+static thread_local bool tRunningStreaming = false;
+
+JobGroup::JobGroup()
+    : mState(std::make_shared<JobSystem::GroupState>())
+{
+
+}
+
+bool JobGroup::IsDone() const
+{
+    return mState->mPending == 0;
+}
+
+JobSystem::JobSystem(u32 numThreads)
+{
+    numThreads = std::max(numThreads, 2u);
+    mMaxStreamingWorkers = numThreads - 1;
+    for (std::atomic<s32>& queued : mQueued)
+    {
+        queued = 0;
+    }
+
+    for (u32 i = 0; i < numThreads; i++)
+    {
+        mWorkers.push_back(std::make_unique<Worker>());
+    }
+
+    for (u32 i = 0; i < numThreads; i++)
+    {
+        mThreads.emplace_back(std::thread(&JobSystem::WorkerMain, this, i));
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQuit = true;
+    }
+    mWorkCondition.notify_all();
+
+    for (std::thread& thread : mThreads)
+    {
+        thread.join();
+    }
+}
+
+void JobSystem::Run(JobGroup& group, std::function<void()> fn, ePriority priority)
+{
+    group.mState->mPending++;
+    if (priority == ePriority::eStreaming)
+    {
+        group.mState->mHasStreamingJobs = true;
+    }
+    Push(Job{ std::move(fn), group.mState }, priority);
+}
+
+void JobSystem::Wait(const JobGroup& group)
+{
+    WaitUntil(group, nullptr);
+}
+
+bool JobSystem::WaitFor(const JobGroup& group, std::chrono::milliseconds timeout)
+{
+    const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + timeout;
+    return WaitUntil(group, &deadline);
+}
+
+bool JobSystem::WaitUntil(const JobGroup& group, const std::chrono::steady_clock::time_point* deadline)
+{
+    // Streaming jobs are left to the workers so a wait for frame work doesn't get stuck behind a
+    // long decode, unless this is a worker that is already running a streaming job or the group is
+    // waiting for streaming jobs itself. This thread is busy until the group is done either way so
+    // it doesn't need a streaming slot for them.
+    GroupState& state = *group.mState;
+    const bool waitingForStreaming = state.mHasStreamingJobs;
+    const bool allowStreaming = tRunningStreaming || waitingForStreaming;
+    while (!group.IsDone())
+    {
+        if (TryRunJob(allowStreaming, !waitingForStreaming))
+        {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        auto canContinue = [&]()
+        {
+            return group.IsDone()
+                || mQueued[static_cast<u32>(ePriority::eFrame)] > 0
+                || (allowStreaming && mQueued[static_cast<u32>(ePriority::eStreaming)] > 0);
+        };
+
+        // The group's last job notifies if it sees a waiter, so the count goes up before the group
+        // is checked again
+        state.mWaiters++;
+        mNumWaiting++;
+        bool ready = true;
+        if (deadline)
+        {
+            ready = mWaitCondition.wait_until(lock, *deadline, canContinue);
+        }
+        else
+        {
+            mWaitCondition.wait(lock, canContinue);
+        }
+        mNumWaiting--;
+        state.mWaiters--;
+
+        if (!ready)
+        {
+            return false;
+        }
+    }
+
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(state.mMutex);
+        error = state.mError;
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+    return true;
+}
+
+void JobSystem::Then(const JobGroup& after, JobGroup& group, std::function<void()> fn, ePriority priority)
+{
+    group.mState->mPending++;
+    if (priority == ePriority::eStreaming)
+    {
+        group.mState->mHasStreamingJobs = true;
+    }
+    AddContinuation(after, Continuation{ Job{ std::move(fn), group.mState }, priority, false });
+}
+
+void JobSystem::For(u32 count, const std::function<void(u32)>& fn)
+{
+    // One job per thread that pulls indices until there are none left, the caller helps in Wait()
+    const u32 numJobs = std::min(count, NumThreads() + 1);
+    std::atomic<u32> next{ 0 };
+    JobGroup group;
+    for (u32 i = 0; i < numJobs; i++)
+    {
+        Run(group, [&]()
+        {
+            for (u32 index = next++; index < count; index = next++)
+            {
+                fn(index);
+            }
+        });
+    }
+    Wait(group);
+}
+
+void JobSystem::ThenOnMainThread(const JobGroup& after, std::function<void()> fn)
+{
+    AddContinuation(after, Continuation{ Job{ std::move(fn), nullptr }, ePriority::eFrame, true });
+}
+
+void JobSystem::RunOnMainThread(std::function<void()> fn)
+{
+    std::lock_guard<std::mutex> lock(mMainThreadMutex);
+    mMainThreadJobs.push_back(std::move(fn));
+}
+
+void JobSystem::RunMainThreadJobs()
+{
+    // Jobs queued by these jobs run on the next call
+    std::vector<std::function<void()>> jobs;
+    {
+        std::lock_guard<std::mutex> lock(mMainThreadMutex);
+        jobs.swap(mMainThreadJobs);
+    }
+
+    for (std::function<void()>& fn : jobs)
+    {
+        Job job{ std::move(fn), nullptr };
+        RunJob(job);
+    }
+}
+
+void JobSystem::Push(Job job, ePriority priority)
+{
+    const u32 index = tJobSystem == this ? tWorkerIndex : mNextWorker++ % static_cast<u32>(mWorkers.size());
+    Worker& worker = *mWorkers[index];
+    {
+        std::lock_guard<std::mutex> lock(worker.mMutex);
+        worker.mJobs[static_cast<u32>(priority)].push_back(std::move(job));
+    }
+
+    bool wakeWaiters = false;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQueued[static_cast<u32>(priority)]++;
+        wakeWaiters = mNumWaiting > 0;
+    }
+    mWorkCondition.notify_one();
+    if (wakeWaiters)
+    {
+        mWaitCondition.notify_all();
+    }
+}
+
+void JobSystem::AddContinuation(const JobGroup& after, Continuation continuation)
+{
+    {
+        std::lock_guard<std::mutex> lock(after.mState->mMutex);
+        if (after.mState->mPending != 0)
+        {
+            after.mState->mContinuations.push_back(std::move(continuation));
+            return;
+        }
+    }
+    Schedule(continuation);
+}
+
+void JobSystem::Schedule(Continuation& continuation)
+{
+    if (continuation.mOnMainThread)
+    {
+        RunOnMainThread(std::move(continuation.mJob.mFn));
+    }
+    else
+    {
+        Push(std::move(continuation.mJob), continuation.mPriority);
+    }
+}
+
+bool JobSystem::TakeJob(ePriority priority, Job& job)
+{
+    const u32 numWorkers = static_cast<u32>(mWorkers.size());
+    const u32 queue = static_cast<u32>(priority);
+
+    // Newest job from our own deque first, then the oldest job of the others
+    const bool isWorker = tJobSystem == this;
+    const u32 start = isWorker ? tWorkerIndex : 0;
+    for (u32 i = 0; i < numWorkers; i++)
+    {
+        Worker& worker = *mWorkers[(start + i) % numWorkers];
+        std::lock_guard<std::mutex> lock(worker.mMutex);
+        std::deque<Job>& jobs = worker.mJobs[queue];
+        if (!jobs.empty())
+        {
+            if (isWorker && i == 0)
+            {
+                job = std::move(jobs.back());
+                jobs.pop_back();
+            }
+            else
+            {
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            mQueued[queue]--;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JobSystem::TryRunJob(bool allowStreaming, bool needSlot)
+{
+    Job job;
+    if (TakeJob(ePriority::eFrame, job))
+    {
+        RunJob(job);
+        return true;
+    }
+
+    if (!allowStreaming || mQueued[static_cast<u32>(ePriority::eStreaming)] <= 0)
+    {
+        return false;
+    }
+
+    if (tRunningStreaming || !needSlot)
+    {
+        if (TakeJob(ePriority::eStreaming, job))
+        {
+            const bool wasRunningStreaming = tRunningStreaming;
+            tRunningStreaming = true;
+            RunJob(job);
+            tRunningStreaming = wasRunningStreaming;
+            return true;
+        }
+        return false;
+    }
+
+    // Take a streaming slot, if they are all in use leave the job for later
+    u32 running = mStreamingWorkers;
+    do
+    {
+        if (running >= mMaxStreamingWorkers)
+        {
+            return false;
+        }
+    } while (!mStreamingWorkers.compare_exchange_weak(running, running + 1));
+
+    const bool found = TakeJob(ePriority::eStreaming, job);
+    if (found)
+    {
+        tRunningStreaming = true;
+        RunJob(job);
+        tRunningStreaming = false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStreamingWorkers--;
+    }
+    mWorkCondition.notify_one();
+    return found;
+}
+
+void JobSystem::RunJob(Job& job)
+{
+    std::exception_ptr error;
+    try
+    {
+        job.mFn();
+    }
+    catch (const std::exception& ex)
+    {
+        LOG_ERROR("Job failed: " << ex.what());
+        error = std::current_exception();
+    }
+    catch (...)
+    {
+        LOG_ERROR("Job failed");
+        error = std::current_exception();
+    }
+
+    if (job.mGroup)
+    {
+        std::vector<Continuation> continuations;
+        bool done = false;
+        {
+            std::lock_guard<std::mutex> lock(job.mGroup->mMutex);
+            if (error && !job.mGroup->mError)
+            {
+                job.mGroup->mError = error;
+            }
+
+            if (--job.mGroup->mPending == 0)
+            {
+                continuations.swap(job.mGroup->mContinuations);
+                done = true;
+            }
+        }
+
+        if (done && job.mGroup->mWaiters > 0)
+        {
+            // Taking the lock means a waiter that saw the group as not done is already asleep
+            std::lock_guard<std::mutex> lock(mMutex);
+            mWaitCondition.notify_all();
+        }
+
+        for (Continuation& continuation : continuations)
+        {
+            Schedule(continuation);
+        }
+    }
+}
+
+void JobSystem::WorkerMain(u32 index)
+{
+    tJobSystem = this;
+    tWorkerIndex = index;
+
+    for (;;)
+    {
+        if (TryRunJob(true))
+        {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        mWorkCondition.wait(lock, [this]()
+        {
+            return mQuit
+                || mQueued[static_cast<u32>(ePriority::eFrame)] > 0
+                || (mQueued[static_cast<u32>(ePriority::eStreaming)] > 0 && mStreamingWorkers < mMaxStreamingWorkers);
+        });
+
+        if (mQuit)
+        {
+            return;
+        }
+    }
+}
+
+JobSystem& SharedJobSystem()
+{
+    static JobSystem* jobSystem = []()
+    {
+        // Oddlib would otherwise start a pool of the same size next to this one
+        static JobSystem system(Oddlib::DefaultWorkerThreadCount());
+        Oddlib::SetSharedParallelFor(&system);
+        return &system;
+    }();
+    return *jobSystem;
+}
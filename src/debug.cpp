@@ -1,6 +1,7 @@
 #include "debug.hpp"
 #include "engine.hpp"
 #include "abstractrenderer.hpp"
+#include <algorithm>
 
 struct Key
 {
@@ -21,6 +22,19 @@ Debug& Debugging()
     return d;
 }
 
+void Debug::ScriptTiming::NextFrame()
+{
+    mLastFrameMs = mFrameMs;
+    mLastFrameCalls = mFrameCalls;
+    mPeakMs = std::max(mPeakMs, mFrameMs);
+    if (mFrameMs > mBudgetMs)
+    {
+        mFramesOverBudget++;
+    }
+    mFrameMs = 0.0f;
+    mFrameCalls = 0;
+}
+
 void Debug::Update(class InputState& input)
 {
     if (input.mKeys[SDL_SCANCODE_F1].IsPressed())
@@ -84,6 +98,29 @@ void Debug::Update(class InputState& input)
                 }
             }
 
+            if (ImGui::CollapsingHeader("Script timing"))
+            {
+                ImGui::Text("Last frame: %.3f ms in %u calls", mScriptTiming.mLastFrameMs, mScriptTiming.mLastFrameCalls);
+                ImGui::Text("Peak: %.3f ms", mScriptTiming.mPeakMs);
+                ImGui::Text("Frames over budget: %u", mScriptTiming.mFramesOverBudget);
+                ImGui::SliderFloat("Budget (ms)", &mScriptTiming.mBudgetMs, 0.5f, 16.0f);
+                if (ImGui::Button("Reset"))
+                {
+                    mScriptTiming.mPeakMs = 0.0f;
+                    mScriptTiming.mFramesOverBudget = 0;
+                }
+            }
+
+            if (ImGui::CollapsingHeader("Object activity"))
+            {
+                ImGui::Text("Updated: %u of %u", mObjectActivity.mLastUpdated, mObjectActivity.mTotal);
+                ImGui::Text("Rendered: %u", mObjectActivity.mLastRendered);
+                ImGui::Checkbox("Update all objects", &mObjectActivity.mUpdateAll);
+                ImGui::SliderInt("Active radius", &mObjectActivity.mActiveRadius, 0, 4);
+                ImGui::SliderInt("Reduced radius", &mObjectActivity.mReducedRadius, 0, 8);
+                ImGui::SliderInt("Reduced interval", &mObjectActivity.mReducedInterval, 1, 30);
+            }
+
             if (ImGui::CollapsingHeader("Object debug"))
             {
                 if (ImGui::Checkbox("Single step object", &mSingleStepObject))
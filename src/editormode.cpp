@@ -101,11 +101,13 @@ public:
     virtual void Redo() final
     {
         Point() = mNewPos;
+        mLines.LineMoved(*mSelection.SelectedLines().begin());
     }
 
     virtual void Undo() final
     {
         Point() = mOldPos;
+        mLines.LineMoved(*mSelection.SelectedLines().begin());
     }
 
     virtual bool CanMerge() const final { return true; }
@@ -151,6 +153,7 @@ public:
         {
             mLines[idx]->mLine.mP1 += mDelta;
             mLines[idx]->mLine.mP2 += mDelta;
+            mLines.LineMoved(idx);
         }
     }
 
@@ -160,6 +163,7 @@ public:
         {
             mLines[idx]->mLine.mP1 -= mDelta;
             mLines[idx]->mLine.mP2 -= mDelta;
+            mLines.LineMoved(idx);
         }
     }
 
@@ -281,8 +285,7 @@ void EditorMode::Update(const InputState& input, CoordinateSpace& coords)
 
         if (mMapState.mCameraSubject)
         {
-            mMapState.mCameraSubject->mXPos = mMapState.mCameraPosition.x;
-            mMapState.mCameraSubject->mYPos = mMapState.mCameraPosition.y;
+            mMapState.mCameraSubject->SetPosition(mMapState.mCameraPosition.x, mMapState.mCameraPosition.y);
         }
     }
 
@@ -2,6 +2,7 @@
 #include <iostream>
 #include "oddlib/masher.hpp"
 #include "oddlib/exceptions.hpp"
+#include "oddlib/stream.hpp"
 #include "logger.hpp"
 #include "jsonxx/jsonxx.h"
 #include <fstream>
@@ -14,6 +15,7 @@
 #include "gamefilesystem.hpp"
 #include "fmv.hpp"
 #include "rendererfactory.hpp"
+#include "core/jobsystem.hpp"
 
 #ifdef _WIN32
 #ifndef NOMINMAX
@@ -199,8 +201,10 @@ void InputMapping::Update(const InputState& input)
 Engine::Engine(const std::vector<std::string>& commandLineArguments)
     : mAudioHandler(1024, 44100)
 {
-    for (const std::string& argument : commandLineArguments)
+    for (size_t i = 0; i < commandLineArguments.size(); i++)
     {
+        const std::string& argument = commandLineArguments[i];
+        const bool hasValue = i + 1 < commandLineArguments.size();
         if (string_util::iequals("-opengl", argument))
         {
             mTryDirectX9 = false;
@@ -213,6 +217,22 @@ Engine::Engine(const std::vector<std::string>& commandLineArguments)
             mTryDirectX9 = true;
 #endif
         }
+        else if (string_util::iequals("-headless", argument))
+        {
+            mHeadless = true;
+        }
+        else if (string_util::iequals("-benchmark", argument))
+        {
+            mBenchmark = true;
+        }
+        else if (string_util::iequals("-record", argument) && hasValue)
+        {
+            mRecordFileName = commandLineArguments[++i];
+        }
+        else if (string_util::iequals("-replay", argument) && hasValue)
+        {
+            mReplayFileName = commandLineArguments[++i];
+        }
     }
 }
 
@@ -238,6 +258,9 @@ bool Engine::Init()
 {
     try
     {
+        // Create the job system before anything is loaded so oddlib's decoding runs on its workers
+        SharedJobSystem();
+
         // load the list of data paths (if any) and discover what they are
         mFileSystem = std::make_unique<GameFileSystem>();
         if (!mFileSystem->Init())
@@ -258,8 +281,28 @@ bool Engine::Init()
         InitSubSystems();
 
         Debugging().mInput = &mInputState;
-        
-        mStateMachine.ToState(std::make_unique<GameSelectionScreen>(mStateMachine, mGameDefinitions, *mSound, *mLevel, *mResourceLocator, *mFileSystem));
+
+        if (!mReplayFileName.empty())
+        {
+            Oddlib::FileStream stream(mReplayFileName, Oddlib::IStream::ReadMode::ReadOnly);
+            InputRecording recording;
+            recording.Read(stream);
+            mReplay = InputReplay(std::move(recording));
+        }
+
+        if (!mRecordFileName.empty())
+        {
+            // Each path that is loaded starts the recording again, the map is updated with the
+            // input of the tick that loaded it
+            Debugging().mFnPathLoaded = [this](const std::string& pathName)
+            {
+                mRecorder.PathLoaded(pathName, ActiveDataSetNames(), RecordedInput());
+            };
+        }
+
+        // A replay starts the game it was recorded with without waiting for the user
+        const std::string autoStartDataSet = mReplayFileName.empty() ? "" : mReplay.Recording().DataSetNames().front();
+        mStateMachine.ToState(std::make_unique<GameSelectionScreen>(mStateMachine, mGameDefinitions, *mSound, *mLevel, *mResourceLocator, *mFileSystem, autoStartDataSet));
 
         return true;
     }
@@ -308,7 +351,7 @@ void Engine::InitSubSystems()
 
     BindScriptTypes();
 
-    mRenderer = RendererFactory::Create(mWindow, mTryDirectX9);
+    mRenderer = RendererFactory::Create(mWindow, mTryDirectX9, mHeadless);
 
     mRenderer->Init
     (
@@ -330,6 +373,8 @@ void Engine::InitSubSystems()
     Sqrat::Function initFunc(Sqrat::RootTable(), "init");
     initFunc.Execute();
     SquirrelVm::CheckError();
+
+    mScriptUpdate = Sqrat::RootTable().GetSlot("update");
 }
 
 // TODO: Using averaging value or anything that is more accurate than this
@@ -382,14 +427,22 @@ int Engine::Run()
         const Sint64 timePassed = std::chrono::duration_cast<std::chrono::nanoseconds>(totalRunTime).count();
 
 
-        if (timePassed >= 16666666)
+        const THighResClock::time_point tickStart = THighResClock::now();
+        bool ticked = false;
+        if (mBenchmark || timePassed >= 16666666)
         {
             Update();
             ImGui::Render();
             startTime = THighResClock::now();
+            ticked = true;
         }
 
         Render();
+        if (ticked)
+        {
+            EndTick(tickStart);
+        }
+
         fpsCounter.Update([&](f32 fps)
         {
             SDL_SetWindowTitle(mWindow, WindowTitle(mRenderer->Name(), fps));
@@ -398,9 +451,124 @@ int Engine::Run()
 
     mRenderer->DestroyTexture(mGuiFontHandle);
 
+    SaveRecording();
+
     return 0;
 }
 
+InputRecording::Tick Engine::RecordedInput() const
+{
+    const Actions& actions = mInputState.Mapping().GetActions();
+    return { actions.mIsPressed, actions.mIsReleased, actions.mIsDown, actions.mRawDownState };
+}
+
+std::vector<std::string> Engine::ActiveDataSetNames() const
+{
+    std::vector<std::string> names;
+    for (const DataPaths::FileSystemInfo& fs : mResourceLocator->GetDataPaths().ActiveDataPaths())
+    {
+        names.push_back(fs.mDataSetName);
+    }
+    return names;
+}
+
+void Engine::UpdateRecordingOrReplay()
+{
+    mRecorder.Tick(RecordedInput());
+
+    if (mReplayFileName.empty())
+    {
+        return;
+    }
+
+    // Wait for the game selection screen to set up the data paths
+    if (!mReplay.IsStarted() && mResourceLocator->GetDataPaths().ActiveDataPaths().empty())
+    {
+        return;
+    }
+
+    if (!mReplay.IsStarted() && ActiveDataSetNames() != mReplay.Recording().DataSetNames())
+    {
+        // The same input on other data would silently play a different game
+        std::string recorded;
+        for (const std::string& name : mReplay.Recording().DataSetNames())
+        {
+            recorded += " " + name;
+        }
+        LOG_ERROR("Replay " << mReplayFileName << " was recorded with the data sets" << recorded << " which aren't all available");
+        mReplayFileName.clear();
+        mStateMachine.ToState(nullptr);
+        return;
+    }
+
+    const InputRecording::Tick* tick = mReplay.NextTick([this](const std::string& pathName)
+    {
+        LOG_INFO("Replaying " << mReplay.Recording().Ticks().size() << " ticks of " << pathName);
+        Debugging().fnLoadPath(pathName.c_str());
+    });
+
+    if (tick)
+    {
+        Actions actions = mInputState.Mapping().GetActions();
+        actions.mIsPressed = tick->mIsPressed;
+        actions.mIsReleased = tick->mIsReleased;
+        actions.mIsDown = tick->mIsDown;
+        actions.mRawDownState = tick->mRawDownState;
+        mInputState.ReplayActions(actions);
+    }
+}
+
+void Engine::EndTick(THighResClock::time_point tickStart)
+{
+    if (!mReplay.IsStarted())
+    {
+        return;
+    }
+
+    // Only the ticks that replayed input are measured
+    if (mReplayBenchmark.NumTicks() < mReplay.TicksPlayed())
+    {
+        const Debug::TickTiming& timing = Debugging().mTickTiming;
+        const f32 totalMs = std::chrono::duration<f32, std::milli>(THighResClock::now() - tickStart).count();
+        mReplayBenchmark.Add({ Debugging().mScriptTiming.mFrameMs, timing.mCollisionMs, timing.mAnimationMs, timing.mRenderMs, totalMs });
+    }
+
+    if (mReplay.IsFinished())
+    {
+        EndReplay();
+    }
+}
+
+void Engine::EndReplay()
+{
+    LOG_INFO("Replay of " << mReplay.Recording().PathName() << " finished\n" << mReplayBenchmark.Summary());
+
+    const std::string csvFileName = mReplayFileName + ".csv";
+    std::ofstream csv(csvFileName);
+    if (csv)
+    {
+        mReplayBenchmark.WriteCsv(csv);
+        LOG_INFO("Wrote tick times to " << csvFileName);
+    }
+    else
+    {
+        LOG_ERROR("Failed to write tick times to " << csvFileName);
+    }
+
+    mStateMachine.ToState(nullptr);
+}
+
+void Engine::SaveRecording()
+{
+    if (mRecorder.IsRecording())
+    {
+        const InputRecording& recording = mRecorder.Recording();
+        Oddlib::FileStream stream(mRecordFileName, Oddlib::IStream::ReadMode::ReadWrite);
+        recording.Write(stream);
+        LOG_INFO("Wrote " << recording.Ticks().size() << " ticks of " << recording.PathName() << " to " << mRecordFileName);
+    }
+}
+
 static bool mousePressed[4] = { false, false };
 static ImVec2 mousePosScale(1.0f, 1.0f);
 
@@ -651,12 +819,16 @@ void Engine::Update()
     ImGui::NewFrame();
 
     mInputState.Update();
+    UpdateRecordingOrReplay();
+    Debugging().mScriptTiming.NextFrame();
+    Debugging().mTickTiming = Debug::TickTiming();
     Debugging().Update(mInputState);
 
+    // Results of background work that have to be handled on the main thread
+    SharedJobSystem().RunMainThreadJobs();
+
     // HACK: Should be called from within the "init/starting" state
-    Sqrat::Function initFunc(Sqrat::RootTable(), "update");
-    initFunc.Execute();
-    SquirrelVm::CheckError();
+    SquirrelVm::Call(mScriptUpdate, Sqrat::RootTable());
 
     UpdateImGui();
     mStateMachine.Update(mInputState, *mRenderer);
@@ -672,7 +844,10 @@ void Engine::Render()
     mRenderer->UpdateCamera();
     mRenderer->BeginFrame(w, h);
 
-    mStateMachine.Render(w, h, *mRenderer);
+    {
+        ScopedTimer timer(Debugging().mTickTiming.mRenderMs);
+        mStateMachine.Render(w, h, *mRenderer);
+    }
 
     Debugging().Render(*mRenderer);
 
@@ -699,7 +874,7 @@ bool Engine::InitSDL()
 
     mWindow = SDL_CreateWindow(title.c_str(),
         SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 640, 480,
-        SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE);
+        mHeadless ? SDL_WINDOW_HIDDEN : (SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE));
     if (!mWindow)
     {
         LOG_ERROR("Failed to create window: " << SDL_GetError());
@@ -792,6 +967,8 @@ void Engine::InitResources()
         "{GameDir}/data/fmvs.json");
 
     mResourceLocator = std::make_unique<ResourceLocator>(std::move(mapper), std::move(dataPaths));
+    mResourceLocator->EnableCameraCache(*mFileSystem);
+    mResourceLocator->EnableScriptCache(*mFileSystem);
 
     // TODO: After user selects game def then add/validate the required paths/data sets in the res mapper
     // also add in any extra maps for resources defined by the mod @ game selection screen
@@ -5,6 +5,7 @@
 #include "resourcemapper.hpp"
 #include "cdromfilesystem.hpp"
 #include "soxr.h"
+#include <cstddef>
 
 class AutoMouseCursorHide
 {
@@ -47,33 +48,133 @@ static void RenderSubtitles(AbstractRenderer& rend, const char* msg, float x, fl
         AbstractRenderer::eCoordinateSystem::eScreen);
 }
 
+// How often a blocked decode thread checks if the audio thread has made progress, the audio
+// thread never signals the decoder since that would mean locking
+static const std::chrono::milliseconds kDecodePollInterval(5);
+
+// The audio ring holds this much output audio
+static const u32 kAudioBufferSeconds = 2;
+
 IMovie::IMovie(const std::string& resourceName, IAudioController& controller, std::unique_ptr<SubTitleParser> subtitles)
-    : mAudioController(controller), mSubTitles(std::move(subtitles)), mName(resourceName)
+    : mAudioController(controller), mSubTitles(std::move(subtitles)), mName(resourceName),
+      mAudioBuffer(controller.SampleRate() * 2 * kAudioBufferSeconds)
 {
-
+    // Reserved up front so moving frames between the lists never allocates
+    mFreeFrames.reserve(kMaxDecodedFrames);
+    mVideoBuffer.reserve(kMaxDecodedFrames);
+    for (Frame& frame : mFramePool)
+    {
+        mFreeFrames.push_back(&frame);
+    }
 }
 
 IMovie::~IMovie()
 {
-
+    StopDecodeThread();
 }
 
+void IMovie::StopDecodeThread()
+{
+    {
+        std::lock_guard<std::mutex> lock(mFramesMutex);
+        mQuitDecoding = true;
+    }
+    mDecodeCondition.notify_all();
 
-// Main thread context
-void IMovie::OnRenderFrame(AbstractRenderer& rend)
+    if (mDecodeThread.joinable())
+    {
+        mDecodeThread.join();
+    }
+}
+
+// Decode thread context
+void IMovie::DecodeThread()
 {
-    // TODO: Populate mAudioBuffer and mVideoBuffer
-    // for up to N buffered frames
-    std::lock_guard<std::mutex> lock(mAudioBufferMutex);
+    const size_t audioSamplesPerFrame = mAudioBytesPerFrame / sizeof(s16);
+    for (;;)
+    {
+        Frame* frame = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mFramesMutex);
+            while (!mQuitDecoding && mFreeFrames.empty())
+            {
+                if (mVideoBuffer.size() > 1 && mAudioBuffer.Size() < audioSamplesPerFrame)
+                {
+                    // The audio for the queued frames is further on in the stream, drop the oldest
+                    // frame that isn't on screen rather than letting the audio run dry
+                    const auto oldest = mVideoBuffer.front() == mPresentedFrame ? mVideoBuffer.begin() + 1 : mVideoBuffer.begin();
+                    mFreeFrames.push_back(*oldest);
+                    mVideoBuffer.erase(oldest);
+                    break;
+                }
+                mDecodeCondition.wait_for(lock, kDecodePollInterval);
+            }
 
-    if (!mPlaying)
+            if (mQuitDecoding)
+            {
+                return;
+            }
+
+            frame = mFreeFrames.back();
+            mFreeFrames.pop_back();
+        }
+
+        const bool decoded = DecodeFrame(*frame);
+
+        std::lock_guard<std::mutex> lock(mFramesMutex);
+        if (!decoded)
+        {
+            mFreeFrames.push_back(frame);
+            mDecodeFinished = true;
+            return;
+        }
+
+        frame->mFrameNum = mFrameCounter++;
+        if (frame->mFrameNum < mSkipUntilFrame)
+        {
+            mFreeFrames.push_back(frame);
+        }
+        else
+        {
+            mVideoBuffer.push_back(frame);
+        }
+    }
+}
+
+// Decode thread context
+void IMovie::PushAudio(const s16* samples, size_t count)
+{
+    if (mFrameCounter < mSkipUntilFrame)
     {
+        // Audio of a frame before the seek target
         return;
     }
 
-    while (NeedBuffer())
+    for (;;)
+    {
+        const size_t written = mAudioBuffer.Write(samples, count);
+        samples += written;
+        count -= written;
+        if (count == 0)
+        {
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(mFramesMutex);
+        if (mQuitDecoding)
+        {
+            return;
+        }
+        mDecodeCondition.wait_for(lock, kDecodePollInterval);
+    }
+}
+
+// Main thread context
+void IMovie::OnRenderFrame(AbstractRenderer& rend)
+{
+    if (!mPlaying)
     {
-        FillBuffers();
+        return;
     }
 
     // TODO: If the buffer call back for audio is large, then this might only get called every N frames meaning
@@ -96,51 +197,44 @@ void IMovie::OnRenderFrame(AbstractRenderer& rend)
         }
     }
 
-    bool played = false;
-    while (!mVideoBuffer.empty())
+    const Frame* toRender = nullptr;
+    bool recycled = false;
     {
-        Frame& f = mVideoBuffer.front();
-        if (f.mFrameNum < videoFrameIndex)
-        {
-            if (mVideoBuffer.size() == 1)
-            {
-                // Don't remove everything otherwise we won't have any frame to display at all
-                break;
-            }
+        std::lock_guard<std::mutex> lock(mFramesMutex);
 
-            mVideoBuffer.pop_front();
-            continue;
+        // Don't remove everything otherwise we won't have any frame to display at all. This also means
+        // that when the video ends and we are still playing audio the last frame stays up.
+        while (mVideoBuffer.size() > 1 && mVideoBuffer.front()->mFrameNum < videoFrameIndex)
+        {
+            mFreeFrames.push_back(mVideoBuffer.front());
+            mVideoBuffer.erase(mVideoBuffer.begin());
+            recycled = true;
         }
 
-        if (f.mFrameNum == videoFrameIndex)
+        if (!mVideoBuffer.empty())
         {
-            // Don't pop frame after rendering for the case when the video ends and we are playing
-            // audio but there are no more frames. In the case we just keep displaying whatever the last
-            // frame was (since we didn't pop it).
-            RenderFrame(rend, f.mW, f.mH, f.mPixels.data(), current_subs);
-            played = true;
-            break;
+            // The decode thread won't recycle this one so it stays valid after unlocking
+            toRender = mVideoBuffer.front();
         }
-
+        mPresentedFrame = toRender;
     }
 
-    if (!played && !mVideoBuffer.empty())
+    if (recycled)
     {
-        Frame& f = mVideoBuffer.front();
-        RenderFrame(rend, f.mW, f.mH, f.mPixels.data(), current_subs);
+        mDecodeCondition.notify_one();
     }
 
-    while (NeedBuffer())
+    if (toRender)
     {
-        FillBuffers();
+        RenderFrame(rend, toRender->mW, toRender->mH, toRender->mPixels.data(), current_subs);
     }
 }
 
 // Main thread context
 bool IMovie::IsEnd()
 {
-    std::lock_guard<std::mutex> lock(mAudioBufferMutex);
-    const auto ret = EndOfStream() && mAudioBuffer.empty();
+    std::lock_guard<std::mutex> lock(mFramesMutex);
+    const auto ret = mDecodeFinished && mAudioBuffer.Size() == 0;
     if (ret && mVideoBuffer.size() > 1)
     {
         LOG_ERROR("Still " << mVideoBuffer.size() << " frames left after audio finished");
@@ -151,46 +245,80 @@ bool IMovie::IsEnd()
 // Main thread context
 void IMovie::Start()
 {
-    std::lock_guard<std::mutex> lock(mAudioBufferMutex);
-    mAudioController.SetExclusiveAudioPlayer(this);
+    if (!mDecodeThread.joinable())
+    {
+        mDecodeThread = std::thread(&IMovie::DecodeThread, this);
+    }
     mPlaying = true;
+    mAudioController.SetExclusiveAudioPlayer(this);
 }
 
 // Main thread context
 void IMovie::Stop()
 {
-    std::lock_guard<std::mutex> lock(mAudioBufferMutex);
     mAudioController.SetExclusiveAudioPlayer(nullptr);
     mPlaying = false;
 }
 
+// Main thread context
+void IMovie::Seek(size_t frame)
+{
+    // Neither the audio thread or the decode thread can be running while everything is reset,
+    // this only waits for the decoding of the current frame to finish
+    const bool playing = mPlaying;
+    if (playing)
+    {
+        mAudioController.SetExclusiveAudioPlayer(nullptr);
+    }
+    StopDecodeThread();
+
+    const size_t restartFrame = SeekDecoder(frame);
+
+    mVideoBuffer.clear();
+    mFreeFrames.clear();
+    for (Frame& poolFrame : mFramePool)
+    {
+        mFreeFrames.push_back(&poolFrame);
+    }
+    mPresentedFrame = nullptr;
+    mAudioBuffer.Clear();
+
+    mFrameCounter = restartFrame;
+    mSkipUntilFrame = frame;
+    mConsumedAudioBytes = frame * mAudioBytesPerFrame;
+    mDecodeFinished = false;
+    mQuitDecoding = false;
+
+    mDecodeThread = std::thread(&IMovie::DecodeThread, this);
+    if (playing)
+    {
+        mAudioController.SetExclusiveAudioPlayer(this);
+    }
+}
+
+// Main thread context
+size_t IMovie::FrameNumber() const
+{
+    return mConsumedAudioBytes / mAudioBytesPerFrame;
+}
+
 // Audio thread context, from IAudioPlayer
 bool IMovie::Play(f32* stream, u32 len)
 {
-    std::lock_guard<std::mutex> lock(mAudioBufferMutex);
+    // TODO: Add a proper audio mixing algorithm/API, this will clip/overflow and cause weridnes when
+    // 2 streams of diff sample rates are mixed
+    const size_t take = mAudioBuffer.Read(len, [stream](size_t i, s16 sample)
+    {
+        stream[i] += sample / 32768.0f;
+    });
 
-    // Consume mAudioBuffer and update the amount of consumed bytes
-    size_t have = mAudioBuffer.size()/sizeof(int16_t);
-    size_t take = len;
-    if (take > have)
+    if (take < len)
     {
         // Buffer underflow - we don't have enough data to fill the requested buffer
         // audio glitches ahoy!
-        LOG_ERROR("Audio buffer underflow want " << take << " samples " << " have " << have << " samples");
-        take = have;
+        LOG_ERROR("Audio buffer underflow want " << len << " samples " << " have " << take << " samples");
     }
 
-    for (auto i = 0u; i < take; i++)
-    {
-        uint8_t low = mAudioBuffer[i*sizeof(int16_t)];
-        uint8_t high = mAudioBuffer[i*sizeof(int16_t) + 1];
-        int16_t fixed = (int16_t)(low | (high << 8));
-
-        // TODO: Add a proper audio mixing algorithm/API, this will clip/overflow and cause weridnes when
-        // 2 streams of diff sample rates are mixed
-        stream[i] += fixed / 32768.0f;
-    }
-    mAudioBuffer.erase(mAudioBuffer.begin(), mAudioBuffer.begin() + take*sizeof(int16_t));
     mConsumedAudioBytes += take*sizeof(int16_t);
     return false;
 }
@@ -224,6 +352,113 @@ void IMovie::RenderFrame(AbstractRenderer &rend, int width, int height, const vo
     rend.DestroyTexture(texhandle);
 }
 
+// Resamples interleaved s16 stereo audio. The soxr state is kept for the whole movie so
+// the filter is only built once and consecutive blocks join up without discontinuities.
+class StreamingResampler
+{
+public:
+    StreamingResampler(const StreamingResampler&) = delete;
+    StreamingResampler& operator = (const StreamingResampler&) = delete;
+
+    StreamingResampler(u32 inputRate, u32 outputRate)
+        : mRatio(static_cast<f64>(outputRate) / inputRate)
+    {
+        const soxr_io_spec_t ioSpec = soxr_io_spec(
+            SOXR_INT16_I,   // In type
+            SOXR_INT16_I);  // Out type
+
+        soxr_error_t error = nullptr;
+        mSoxr = soxr_create(
+            inputRate,
+            outputRate,
+            kNumChannels,
+            &error,
+            &ioSpec,    // IO spec
+            nullptr,    // Quality spec
+            nullptr);   // Runtime spec
+
+        if (error)
+        {
+            throw Oddlib::Exception(std::string("soxr_create failed: ") + error);
+        }
+    }
+
+    ~StreamingResampler()
+    {
+        soxr_delete(mSoxr);
+    }
+
+    // Resamples numFrames stereo frames from in and appends the result to out
+    void Process(const s16* in, size_t numFrames, std::vector<s16>& out)
+    {
+        // Some extra space for anything the filter was still holding from the previous call
+        const size_t outFrames = static_cast<size_t>(numFrames * mRatio) + 64;
+        if (mOutput.size() < outFrames * kNumChannels)
+        {
+            mOutput.resize(outFrames * kNumChannels);
+        }
+
+        while (numFrames > 0)
+        {
+            size_t consumedFrames = 0;
+            size_t wroteFrames = 0;
+            soxr_process(mSoxr, in, numFrames, &consumedFrames, mOutput.data(), outFrames, &wroteFrames);
+            Append(wroteFrames, out);
+
+            if (consumedFrames == 0 && wroteFrames == 0)
+            {
+                break;
+            }
+
+            in += consumedFrames * kNumChannels;
+            numFrames -= consumedFrames;
+        }
+    }
+
+    // Drains whatever the filter is still holding at the end of the stream
+    void Flush(std::vector<s16>& out)
+    {
+        if (mOutput.empty())
+        {
+            return;
+        }
+
+        for (;;)
+        {
+            size_t wroteFrames = 0;
+            soxr_process(mSoxr, nullptr, 0, nullptr, mOutput.data(), mOutput.size() / kNumChannels, &wroteFrames);
+            if (wroteFrames == 0)
+            {
+                break;
+            }
+            Append(wroteFrames, out);
+        }
+    }
+
+    // Drops any buffered audio, used when the input jumps to somewhere else in the stream
+    void Reset()
+    {
+        soxr_clear(mSoxr);
+    }
+
+    // How many output frames numFrames input frames turn into
+    u32 OutputFrames(u32 numFrames) const
+    {
+        return static_cast<u32>(numFrames * mRatio);
+    }
+
+private:
+    void Append(size_t numFrames, std::vector<s16>& out)
+    {
+        out.insert(out.end(), mOutput.begin(), mOutput.begin() + (numFrames * kNumChannels));
+    }
+
+    static const u32 kNumChannels = 2;
+    f64 mRatio = 1.0;
+    soxr_t mSoxr = nullptr;
+    std::vector<s16> mOutput;
+};
+
 // PSX MOV/STR format, all PSX game versions use this.
 class MovMovie : public IMovie
 {
@@ -231,21 +466,26 @@ protected:
     std::unique_ptr<Oddlib::IStream> mFmvStream;
     bool mPsx = false;
     MovMovie(const std::string& resourceName, IAudioController& audioController, std::unique_ptr<SubTitleParser> subtitles)
-        : IMovie(resourceName, audioController, std::move(subtitles))
+        : IMovie(resourceName, audioController, std::move(subtitles)),
+          mResampler(kXaSampleRate, audioController.SampleRate())
     {
 
     }
+
+    // XA audio is always resampled from this rate to the output device rate
+    static const u32 kXaSampleRate = 37800;
 public:
     MovMovie(MovMovie&&) = delete;
     MovMovie& operator = (MovMovie&&) = delete;
 
     ~MovMovie()
     {
-
+        StopDecodeThread();
     }
 
     MovMovie(const std::string& resourceName, IAudioController& audioController, std::unique_ptr<Oddlib::IStream> stream, std::unique_ptr<SubTitleParser> subtitles, u32 startSector, u32 numberOfSectors)
-        : IMovie(resourceName, audioController, std::move(subtitles))
+        : IMovie(resourceName, audioController, std::move(subtitles)),
+          mResampler(kXaSampleRate, audioController.SampleRate())
     {
         if (numberOfSectors == 0)
         {
@@ -257,13 +497,11 @@ public:
             mFmvStream.reset(stream->Clone(startSector, numberOfSectors));
         }
 
-        const int kSampleRate = 44100;// 37800;
-        const int kFps = 15;
+        const u32 kSampleRate = mAudioController.SampleRate();
+        const u32 kFps = 15;
         const u32 kNumChannels = 2;
         mAudioBytesPerFrame = (kSampleRate / kFps) * kNumChannels * sizeof(u16);
 
-        //mAudioController.SetAudioSpec(kSampleRate / kFps, kSampleRate);
-
         mPsx = true;
     }
 
@@ -307,155 +545,165 @@ public:
     };
 #pragma pack(pop)
 
-    virtual bool EndOfStream() override
-    {
-        return mFmvStream->AtEnd();
-    }
-
-    virtual bool NeedBuffer() override
+    virtual bool DecodeFrame(Frame& frame) override
     {
-        const u32 kNumChans = 2;
-        const u32 requiredSize = mAudioController.SampleRate() * sizeof(u16) * kNumChans;
+        const int kXaFrameDataSize = 2016;
+        const int kNumAudioChannels = 2;
+        const int kBytesPerSample = 2;
+        std::array<s16, (kXaFrameDataSize * kNumAudioChannels * kBytesPerSample) / 2> outPtr;
 
-        return (mVideoBuffer.size() == 0 || mAudioBuffer.size() < (requiredSize*2)) && !mFmvStream->AtEnd();
-    }
+        if (mDemuxBuffer.empty())
+        {
+            mDemuxBuffer.resize(1024 * 1024);
+        }
 
-    virtual void FillBuffers() override
-    {
-        while (NeedBuffer())
+        for (;;)
         {
-            const int kXaFrameDataSize = 2016;
-            const int kNumAudioChannels = 2;
-            const int kBytesPerSample = 2;
-            std::array<s16, (kXaFrameDataSize * kNumAudioChannels * kBytesPerSample) / 2> outPtr;
 
-            if (mDemuxBuffer.empty())
+            PsxStrHeader w;
+            if (mFmvStream->AtEnd())
             {
-                mDemuxBuffer.resize(1024 * 1024);
+                mResampledAudio.clear();
+                mResampler.Flush(mResampledAudio);
+                PushAudio(mResampledAudio.data(), mResampledAudio.size());
+                return false;
             }
+            mFmvStream->ReadBytes(reinterpret_cast<u8*>(&w), sizeof(w));
 
-            std::vector<u8> pixelBuffer;
-            for (;;)
+            // PC sector must start with "MOIR" if video, else starts with "VALE"
+            if (!mPsx && w.mSectorType != 0x52494f4d)
             {
+                // abort();
+            }
 
-                PsxStrHeader w;
-                if (mFmvStream->AtEnd())
-                {
-                    return;
-                }
-                mFmvStream->ReadBytes(reinterpret_cast<u8*>(&w), sizeof(w));
-
-                // PC sector must start with "MOIR" if video, else starts with "VALE"
-                if (!mPsx && w.mSectorType != 0x52494f4d)
-                {
-                    // abort();
-                }
-
-                // AKIK is 0x80010160 in PSX
-                const auto kMagic = mPsx ? 0x80010160 : 0x4b494b41;
-                bool noAudio = false;
-                if (w.mAkikMagic != kMagic)
+            if (!IsVideoSector(w))
+            {
+                if (mPsx)
                 {
-                    if (mPsx)
+                    /*
+                    std::cout <<
+                    (CHECK_BIT(xa->subheader.coding_info, 0) ? "Mono " : "Stereo ") <<
+                    (CHECK_BIT(xa->subheader.coding_info, 2) ? "37800Hz " : "18900Hz ") <<
+                    (CHECK_BIT(xa->subheader.coding_info, 4) ? "4bit " : "8bit ")
+                    */
+
+                    RawCdImage::CDXASector* rawXa = (RawCdImage::CDXASector*)&w;
+                    if (rawXa->subheader.coding_info != 0)
                     {
-                        /*
-                        std::cout <<
-                        (CHECK_BIT(xa->subheader.coding_info, 0) ? "Mono " : "Stereo ") <<
-                        (CHECK_BIT(xa->subheader.coding_info, 2) ? "37800Hz " : "18900Hz ") <<
-                        (CHECK_BIT(xa->subheader.coding_info, 4) ? "4bit " : "8bit ")
-                        */
-
-                        RawCdImage::CDXASector* rawXa = (RawCdImage::CDXASector*)&w;
-                        if (rawXa->subheader.coding_info != 0)
-                        {
-                            mAdpcm.DecodeFrameToPCM(outPtr, &rawXa->data[0]);
-                        }
-                        else
-                        {
-                            // Blank/empty audio frame, play silence so video stays in sync
-                            //numBytes = 2016 * 2 * 2;
-                            mAudioBuffer.resize(mAudioBuffer.size() + (2352*4));
-                            noAudio = true;
-                        }
+                        mAdpcm.DecodeFrameToPCM(outPtr, &rawXa->data[0]);
                     }
                     else
                     {
-                        mAdpcm.DecodeFrameToPCM(outPtr, (uint8_t *)&w.mAkikMagic);
-                    }
-
-                    if (!noAudio)
-                    {
-                        size_t consumedSrc = 0;
-                        size_t wroteSamples = 0;
-                        size_t inLenSampsPerChan = kXaFrameDataSize;
-                        size_t outLenSampsPerChan = inLenSampsPerChan * 2;
-                        std::vector<u8> tmp2(2352 * 4);
-
-                        soxr_io_spec_t ioSpec = soxr_io_spec(
-                            SOXR_INT16_I,   // In type
-                            SOXR_INT16_I);  // Out type
-
-                        soxr_oneshot(
-                            37800,       // Input rate
-                            44100,      // Output rate
-                            2,          // Num channels
-                            outPtr.data(),
-                            inLenSampsPerChan,
-                            &consumedSrc,
-                            tmp2.data(),
-                            outLenSampsPerChan,
-                            &wroteSamples,
-                            &ioSpec,    // IO spec
-                            nullptr,    // Quality spec
-                            nullptr     // Runtime spec
-                        );
-
-
-                        for (auto i = 0u; i < wroteSamples * 4; i++)
-                        {
-                            mAudioBuffer.push_back(tmp2[i]);
-                        }
+                        // Blank/empty audio frame, play silence so video stays in sync. This still
+                        // goes through the resampler so its output stays continuous.
+                        outPtr.fill(0);
                     }
-
-                    // Must be VALE
-                    continue;
                 }
                 else
                 {
-                    const u16 frameW = w.mWidth;
-                    const u16 frameH = w.mHeight;
+                    mAdpcm.DecodeFrameToPCM(outPtr, (uint8_t *)&w.mAkikMagic);
+                }
 
-                    uint32_t bytes_to_copy = w.mFrameDataLen - w.mSectorNumberInFrame *kXaFrameDataSize;
-                    if (bytes_to_copy > 0)
-                    {
-                        if (bytes_to_copy > kXaFrameDataSize)
-                        {
-                            bytes_to_copy = kXaFrameDataSize;
-                        }
+                mResampledAudio.clear();
+                mResampler.Process(outPtr.data(), kXaFrameDataSize, mResampledAudio);
+                PushAudio(mResampledAudio.data(), mResampledAudio.size());
 
-                        memcpy(mDemuxBuffer.data() + w.mSectorNumberInFrame * kXaFrameDataSize, w.frame, bytes_to_copy);
-                    }
+                // Must be VALE
+                continue;
+            }
+            else
+            {
+                const u16 frameW = w.mWidth;
+                const u16 frameH = w.mHeight;
 
-                    if (w.mSectorNumberInFrame == w.mNumSectorsInFrame - 1)
+                uint32_t bytes_to_copy = w.mFrameDataLen - w.mSectorNumberInFrame *kXaFrameDataSize;
+                if (bytes_to_copy > 0)
+                {
+                    if (bytes_to_copy > kXaFrameDataSize)
                     {
-                        // Always resize as its possible for a stream to change its frame size to be smaller or larger
-                        // this happens in the AE PSX MI.MOV streams
-                        pixelBuffer.resize(frameW * frameH * 4); // 4 bytes per pixel
+                        bytes_to_copy = kXaFrameDataSize;
+                    }
+
+                    memcpy(mDemuxBuffer.data() + w.mSectorNumberInFrame * kXaFrameDataSize, w.frame, bytes_to_copy);
+                }
+
+                if (w.mSectorNumberInFrame == w.mNumSectorsInFrame - 1)
+                {
+                    // Always resize as its possible for a stream to change its frame size to be smaller or larger
+                    // this happens in the AE PSX MI.MOV streams. The pooled buffer only reallocates if it grows.
+                    frame.mW = frameW;
+                    frame.mH = frameH;
+                    frame.mPixels.resize(frameW * frameH * 4); // 4 bytes per pixel
 
-                        mMdec.DecodeFrameToABGR32((uint16_t*)pixelBuffer.data(), (uint16_t*)mDemuxBuffer.data(), frameW, frameH);
-                        mVideoBuffer.push_back(Frame{ mFrameCounter++, frameW, frameH, pixelBuffer });
+                    mMdec.DecodeFrameToABGR32((uint16_t*)frame.mPixels.data(), (uint16_t*)mDemuxBuffer.data(), frameW, frameH);
 
-                        return;
+                    // The next frame starts from here, including any audio sectors before its video
+                    if (mFrameIndex.size() == mNextFrame + 1)
+                    {
+                        mFrameIndex.push_back(mFmvStream->Pos());
                     }
+                    mNextFrame++;
+                    return true;
                 }
             }
         }
     }
 
+    virtual size_t SeekDecoder(size_t frame) override
+    {
+        while (mFrameIndex.size() <= frame && IndexNextFrame())
+        {
+
+        }
+
+        // Every MDEC frame is intra coded and XA audio sectors are decoded on their own, so
+        // decoding can restart from any frame
+        mNextFrame = std::min(frame, mFrameIndex.size() - 1);
+        mFmvStream->Seek(mFrameIndex[mNextFrame]);
+        mResampler.Reset();
+        return mNextFrame;
+    }
+
 private:
+    bool IsVideoSector(const PsxStrHeader& w) const
+    {
+        // AKIK is 0x80010160 in PSX
+        const auto kMagic = mPsx ? 0x80010160 : 0x4b494b41;
+        return w.mAkikMagic == kMagic;
+    }
+
+    // Finds where the frame after the last indexed one starts by reading only sector headers
+    bool IndexNextFrame()
+    {
+        mFmvStream->Seek(mFrameIndex.back());
+        while (!mFmvStream->AtEnd())
+        {
+            const size_t sectorStart = mFmvStream->Pos();
+            PsxStrHeader w;
+            mFmvStream->ReadBytes(reinterpret_cast<u8*>(&w), offsetof(PsxStrHeader, frame));
+            mFmvStream->Seek(sectorStart + sizeof(PsxStrHeader));
+
+            if (IsVideoSector(w) && w.mSectorNumberInFrame == w.mNumSectorsInFrame - 1)
+            {
+                mFrameIndex.push_back(mFmvStream->Pos());
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Stream position each frame starts decoding from, filled in as frames are decoded or
+    // seeked past. The first frame is always at the start of the stream.
+    std::vector<size_t> mFrameIndex = std::vector<size_t>(1, 0);
+    size_t mNextFrame = 0;
+
     std::vector<unsigned char> mDemuxBuffer;
     PSXMDECDecoder mMdec;
     PSXADPCMDecoder mAdpcm;
+    StreamingResampler mResampler;
+
+    // Reused for every block of audio so decoding doesn't allocate
+    std::vector<s16> mResampledAudio;
 };
 
 // Same as MOV/STR format but with modified magic in the video frames
@@ -469,12 +717,10 @@ public:
         : MovMovie(resourceName, audioController, std::move(subtitles))
     {
         mPsx = false;
-        const int kSampleRate = 44100;// 37800;
-       // const u32 kAudioFreq = 37800;
+        const u32 kSampleRate = mAudioController.SampleRate();
         const u32 kNumChannels = 2;
         const u32 kFps = 15;
         mAudioBytesPerFrame = (kSampleRate / kFps) * kNumChannels * sizeof(u16);
-        //mAudioController.SetAudioSpec(kAudioFreq / kFps, kAudioFreq);
         mFmvStream = std::move(stream);
     }
 };
@@ -489,63 +735,70 @@ public:
     {
         mMasher = std::make_unique<Oddlib::Masher>(std::move(stream));
 
-        if (mMasher->HasAudio())
+        u32 outputFramesPerVideoFrame = mMasher->SingleAudioFrameSizeSamples();
+        if (mMasher->HasAudio() && mMasher->AudioSampleRate() != mAudioController.SampleRate())
         {
-            //mAudioController.SetAudioSpec(static_cast<u16>(mMasher->SingleAudioFrameSizeSamples()), mMasher->AudioSampleRate());
-        }
-
-        if (mMasher->HasVideo())
-        {
-            mFramePixels.resize(mMasher->Width() * mMasher->Height() * sizeof(u32));
+            mResampler = std::make_unique<StreamingResampler>(mMasher->AudioSampleRate(), mAudioController.SampleRate());
+            outputFramesPerVideoFrame = mResampler->OutputFrames(outputFramesPerVideoFrame);
         }
 
         const u32 kNumChannels = 2;
-        mAudioBytesPerFrame = sizeof(u16) * kNumChannels * mMasher->SingleAudioFrameSizeSamples();
+        mAudioBytesPerFrame = sizeof(u16) * kNumChannels * outputFramesPerVideoFrame;
+        mDecodedAudioFrame.resize(mMasher->SingleAudioFrameSizeSamples() * kNumChannels * sizeof(s16));
     }
 
     ~MasherMovie()
     {
-
+        StopDecodeThread();
     }
 
-    virtual bool EndOfStream() override
+    virtual bool DecodeFrame(Frame& frame) override
     {
-        return mAtEndOfStream;
-    }
+        frame.mW = mMasher->Width();
+        frame.mH = mMasher->Height();
+        frame.mPixels.resize(frame.mW * frame.mH * sizeof(u32));
 
-    virtual bool NeedBuffer() override
-    {
-        return (mVideoBuffer.size() == 0 || mAudioBuffer.size() < (mMasher->SingleAudioFrameSizeSamples()*2*2*4)) && !mAtEndOfStream;
+        if (!mMasher->Update(reinterpret_cast<u32*>(frame.mPixels.data()), mDecodedAudioFrame.data()))
+        {
+            if (mResampler)
+            {
+                mResampledAudio.clear();
+                mResampler->Flush(mResampledAudio);
+                PushAudio(mResampledAudio.data(), mResampledAudio.size());
+            }
+            return false;
+        }
+
+        // Copy to audio threads buffer
+        if (mResampler)
+        {
+            mResampledAudio.clear();
+            mResampler->Process(reinterpret_cast<const s16*>(mDecodedAudioFrame.data()), mMasher->SingleAudioFrameSizeSamples(), mResampledAudio);
+            PushAudio(mResampledAudio.data(), mResampledAudio.size());
+        }
+        else
+        {
+            PushAudio(reinterpret_cast<const s16*>(mDecodedAudioFrame.data()), mDecodedAudioFrame.size() / sizeof(s16));
+        }
+        return true;
     }
 
-    virtual void FillBuffers() override
+    virtual size_t SeekDecoder(size_t frame) override
     {
-        while (NeedBuffer())
+        if (mResampler)
         {
-            const s32 kNumChannels = 2;
-            std::vector<u8> decodedAudioFrame(mMasher->SingleAudioFrameSizeSamples() * kNumChannels * sizeof(s16));
-            mAtEndOfStream = !mMasher->Update((u32*)mFramePixels.data(), decodedAudioFrame.data());
-            if (!mAtEndOfStream)
-            {
-                // Copy to audio threads buffer
-                for (size_t i = 0; i < decodedAudioFrame.size(); i++)
-                {
-                    mAudioBuffer.push_back(decodedAudioFrame[i]);
-                }
-
-                mVideoBuffer.push_back(Frame{ mFrameCounter++, mMasher->Width(), mMasher->Height(), mFramePixels });
-            }
-            else
-            {
-                break;
-            }
+            mResampler->Reset();
         }
+        return mMasher->Seek(static_cast<u32>(std::min(frame, static_cast<size_t>(mMasher->NumberOfFrames()))));
     }
 
 private:
-    bool mAtEndOfStream = false;
     std::unique_ptr<Oddlib::Masher> mMasher;
-    std::vector<u8> mFramePixels;
+    std::vector<u8> mDecodedAudioFrame;
+
+    // Only used when the DDV sample rate isn't the output device rate
+    std::unique_ptr<StreamingResampler> mResampler;
+    std::vector<s16> mResampledAudio;
 };
 
 
@@ -683,6 +936,23 @@ void Fmv::DebugUi()
 
     if (ImGui::Begin("Video player"))
     {
+        if (mFmv)
+        {
+            // All movies play at 15 fps
+            const size_t kFramesToSkip = 15 * 5;
+            const size_t frame = mFmv->FrameNumber();
+            ImGui::Text("%s frame %d", mFmvName.c_str(), static_cast<int>(frame));
+            if (ImGui::Button("Back 5 seconds"))
+            {
+                mFmv->Seek(frame > kFramesToSkip ? frame - kFramesToSkip : 0);
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Forward 5 seconds"))
+            {
+                mFmv->Seek(frame + kFramesToSkip);
+            }
+        }
+
         bool rebuild = false;
         if (ImGui::InputText("Filter", mFilterString, sizeof(mFilterString)))
         {
@@ -2,12 +2,6 @@
 
 // =========================================================================
 
-void FsmArgumentStack::Reset()
-{
-    mStringPos = 0;
-    mIntPos = 0;
-}
-
 void FsmArgumentStack::Push(std::string str)
 {
     mStringArgs.push_back(str);
@@ -18,92 +12,170 @@ void FsmArgumentStack::Push(s32 integer)
     mIntArgs.push_back(integer);
 }
 
-const std::string& FsmArgumentStack::PopString()
+// =========================================================================
+
+// Bound in place of functions that don't exist so Update() doesn't have to check
+static bool MissingCondition(void*, const FsmArguments&)
 {
-    return mStringArgs[mStringPos++];
+    return false;
 }
 
-s32 FsmArgumentStack::PopInt()
+static void MissingAction(void*, const FsmArguments&)
 {
-    return mIntArgs[mIntPos++];
+
 }
 
-// =========================================================================
+template<class ReturnType>
+bool FiniteStateMachine::BindCall(const FunctionMap<ReturnType>& functions, const std::string& name, typename FunctionMap<ReturnType>::TFunction& function, void*& context)
+{
+    const typename FunctionMap<ReturnType>::Binding* binding = functions.Find(name);
+    if (!binding)
+    {
+        LOG_ERROR("Missing function: " << name.c_str());
+        return false;
+    }
+    function = binding->mFunction;
+    context = binding->mContext;
+    return true;
+}
+
+void FiniteStateMachine::BindArguments(const FsmArgumentStack& arguments, u32& firstString, u32& firstInt)
+{
+    firstString = static_cast<u32>(mStringArgs.size());
+    firstInt = static_cast<u32>(mIntArgs.size());
+    mStringArgs.insert(mStringArgs.end(), arguments.Strings().begin(), arguments.Strings().end());
+    mIntArgs.insert(mIntArgs.end(), arguments.Ints().begin(), arguments.Ints().end());
+}
 
-void FsmStateTransition::AddCondition(StateCondition condition)
+FsmArguments FiniteStateMachine::Arguments(u32 firstString, u32 firstInt) const
 {
-    mConditions.push_back(condition);
+    return FsmArguments(mStringArgs.data() + firstString, mIntArgs.data() + firstInt);
 }
 
-bool FsmStateTransition::Evaulate(TConditions& events)
+void FiniteStateMachine::Compile()
 {
-    // Nothing to check, just move to next state
-    if (mConditions.empty())
+    mCompiledStates.clear();
+    mCompiledTransitions.clear();
+    mCompiledConditions.clear();
+    mCompiledActions.clear();
+    mStringArgs.clear();
+    mIntArgs.clear();
+
+    std::map<std::string, u32> stateIndices;
+    for (u32 i = 0; i < mStates.size(); i++)
     {
-        return true;
+        stateIndices.insert(std::make_pair(mStates[i].Name(), i));
     }
 
-    for (StateCondition& event : mConditions)
+    for (const FsmState& state : mStates)
     {
-        if (!event.Execute(events))
+        CompiledState compiledState = {};
+        compiledState.mFirstEnterAction = static_cast<u32>(mCompiledActions.size());
+        for (const StateAction& action : state.EnterActions())
         {
-            // An event isn't true so can't go to next state yet
-            return false;
+            CompiledAction compiledAction = { MissingAction, nullptr, 0, 0 };
+            BindCall(mActions, action.Name(), compiledAction.mFunction, compiledAction.mContext);
+            BindArguments(action.Arguments(), compiledAction.mFirstString, compiledAction.mFirstInt);
+            mCompiledActions.push_back(compiledAction);
         }
-    }
+        compiledState.mNumEnterActions = static_cast<u32>(mCompiledActions.size()) - compiledState.mFirstEnterAction;
 
-    // All events are true, go to next state
-    return true;
-}
+        compiledState.mFirstTransition = static_cast<u32>(mCompiledTransitions.size());
+        for (const FsmStateTransition& transition : state.Transitions())
+        {
+            const auto target = stateIndices.find(transition.Name());
+            if (target == std::end(stateIndices))
+            {
+                LOG_ERROR("State: " << state.Name() << " has a transition to " << transition.Name() << " which is not found");
+                continue;
+            }
+
+            CompiledTransition compiledTransition = {};
+            compiledTransition.mTargetState = target->second;
+            compiledTransition.mFirstCondition = static_cast<u32>(mCompiledConditions.size());
+            for (const StateCondition& condition : transition.Conditions())
+            {
+                CompiledCondition compiledCondition = { MissingCondition, nullptr, false, 0, 0 };
+                const bool negate = !condition.Name().empty() && condition.Name()[0] == '!';
+                if (BindCall(mConditions, negate ? condition.Name().substr(1) : condition.Name(), compiledCondition.mFunction, compiledCondition.mContext))
+                {
+                    compiledCondition.mNegate = negate;
+                }
+                BindArguments(condition.Arguments(), compiledCondition.mFirstString, compiledCondition.mFirstInt);
+                mCompiledConditions.push_back(compiledCondition);
+            }
+            compiledTransition.mNumConditions = static_cast<u32>(mCompiledConditions.size()) - compiledTransition.mFirstCondition;
+            mCompiledTransitions.push_back(compiledTransition);
+        }
+        compiledState.mNumTransitions = static_cast<u32>(mCompiledTransitions.size()) - compiledState.mFirstTransition;
 
-// =========================================================================
+        mCompiledStates.push_back(compiledState);
+    }
 
-void FsmState::Enter(TActions& actions)
-{
-    LOG_INFO(mStateName.c_str());
-    for (StateAction& action : mEnterActions)
+    if (mActiveState >= mCompiledStates.size())
     {
-        action.Execute(actions);
+        mActiveState = kNoState;
     }
 }
 
-const std::string* FsmState::Update(TConditions& states)
+void FiniteStateMachine::Update()
 {
+    if (mActiveState == kNoState)
+    {
+        return;
+    }
+
     // TODO: Need "Running" actions - for playing sound effects
     // per anim frame?
 
-    for (FsmStateTransition& trans : mTransistions)
+    // Go to the target of the first transition that has all of its conditions true, one with no
+    // conditions is always taken
+    const CompiledState& state = mCompiledStates[mActiveState];
+    const CompiledTransition* transition = mCompiledTransitions.data() + state.mFirstTransition;
+    const CompiledTransition* transitionsEnd = transition + state.mNumTransitions;
+    for (; transition != transitionsEnd; transition++)
     {
-        if (trans.Evaulate(states))
+        const CompiledCondition* condition = mCompiledConditions.data() + transition->mFirstCondition;
+        const CompiledCondition* conditionsEnd = condition + transition->mNumConditions;
+        while (condition != conditionsEnd &&
+            condition->mFunction(condition->mContext, Arguments(condition->mFirstString, condition->mFirstInt)) != condition->mNegate)
         {
-            return &trans.Name();
+            condition++;
+        }
+
+        if (condition == conditionsEnd)
+        {
+            EnterState(transition->mTargetState);
+            return;
         }
     }
-    return nullptr;
 }
 
-// =========================================================================
-
-void FiniteStateMachine::Update()
+void FiniteStateMachine::EnterState(u32 stateIndex)
 {
-    if (mActiveState)
+    mActiveState = stateIndex;
+    LOG_INFO(mStates[stateIndex].Name().c_str());
+
+    const CompiledState& state = mCompiledStates[stateIndex];
+    for (u32 i = state.mFirstEnterAction; i < state.mFirstEnterAction + state.mNumEnterActions; i++)
     {
-        const std::string* nextState = mActiveState->Update(mConditions);
-        if (nextState)
-        {
-            ToState(nextState->c_str());
-        }
+        const CompiledAction& action = mCompiledActions[i];
+        action.mFunction(action.mContext, Arguments(action.mFirstString, action.mFirstInt));
     }
 }
 
 bool FiniteStateMachine::ToState(const char* stateName)
 {
-    for (FsmState& state : mStates)
+    if (mCompiledStates.size() != mStates.size())
+    {
+        Compile();
+    }
+
+    for (u32 i = 0; i < mStates.size(); i++)
     {
-        if (state.Name() == stateName)
+        if (mStates[i].Name() == stateName)
         {
-            mActiveState = &state;
-            mActiveState->Enter(mActions);
+            EnterState(i);
             return true;
         }
     }
@@ -112,6 +184,11 @@ bool FiniteStateMachine::ToState(const char* stateName)
     return false;
 }
 
+const std::string* FiniteStateMachine::ActiveStateName() const
+{
+    return mActiveState != kNoState ? &mStates[mActiveState].Name() : nullptr;
+}
+
 void FiniteStateMachine::Construct()
 {
 
@@ -134,7 +211,7 @@ void FiniteStateMachine::Construct()
 
         state.AddTransition(trans);
 
-        mStates.push_back(state);
+        AddState(state);
     }
 
     {
@@ -152,7 +229,7 @@ void FiniteStateMachine::Construct()
 
         state.AddTransition(trans);
 
-        mStates.push_back(state);
+        AddState(state);
     }
 
     {
@@ -174,7 +251,7 @@ void FiniteStateMachine::Construct()
 
         state.AddTransition(trans);
 
-        mStates.push_back(state);
+        AddState(state);
     }
 
     {
@@ -192,8 +269,9 @@ void FiniteStateMachine::Construct()
 
         state.AddTransition(trans);
 
-        mStates.push_back(state);
+        AddState(state);
     }
 
+    Compile();
     ToState("Idle");
 }
@@ -1,5 +1,7 @@
 #include "gamemode.hpp"
 #include "engine.hpp"
+#include <algorithm>
+#include <cstdlib>
 
 GameMode::GameMode(GridMapState& mapState)
     : mMapState(mapState)
@@ -38,16 +40,15 @@ void GameMode::Update(const InputState& input, CoordinateSpace& coords)
     coords.SetScreenSize(mMapState.kVirtualScreenSize);
 
 
-    for (auto& obj : mMapState.mObjs)
-    {
-        obj->Update(input);
-    }
+    // One script instance of the actions for all of the objects instead of a copy for each
+    const Sqrat::Object actions(const_cast<Actions*>(&input.Mapping().GetActions()));
+    UpdateObjects(actions);
 
 
     if (mMapState.mCameraSubject)
     {
-        const s32 camX = static_cast<s32>(mMapState.mCameraSubject->mXPos / mMapState.kCameraBlockSize.x);
-        const s32 camY = static_cast<s32>(mMapState.mCameraSubject->mYPos / mMapState.kCameraBlockSize.y);
+        const s32 camX = static_cast<s32>(mMapState.mCameraSubject->XPos() / mMapState.kCameraBlockSize.x);
+        const s32 camY = static_cast<s32>(mMapState.mCameraSubject->YPos() / mMapState.kCameraBlockSize.y);
 
         const glm::vec2 camPos = glm::vec2(
             (camX * mMapState.kCameraBlockSize.x) + mMapState.kCameraBlockImageOffset.x,
@@ -64,13 +65,64 @@ void GameMode::Update(const InputState& input, CoordinateSpace& coords)
     }
 }
 
+void GameMode::UpdateObject(u32 index, const Sqrat::Object& actions)
+{
+    // Moves are placed in mActivityRegions as they happen
+    mMapState.mObjs[index]->Update(actions);
+}
+
+void GameMode::UpdateObjects(const Sqrat::Object& actions)
+{
+    Debug::ObjectActivity& activity = Debugging().mObjectActivity;
+    const u32 count = static_cast<u32>(mMapState.mObjs.size());
+    activity.mTotal = count;
+    mFrame++;
+
+    const MapObject* subject = mMapState.mCameraSubject;
+    if (activity.mUpdateAll || !subject)
+    {
+        for (u32 i = 0; i < count; i++)
+        {
+            UpdateObject(i, actions);
+        }
+        activity.mLastUpdated = count;
+        return;
+    }
+
+    const ActivityRegions& regions = mMapState.mActivityRegions;
+    const s32 cellX = regions.CellX(subject->XPos());
+    const s32 cellY = regions.CellY(subject->YPos());
+    const s32 activeRadius = std::max(activity.mActiveRadius, 0);
+    const s32 reducedRadius = std::max(activity.mReducedRadius, activeRadius);
+    const u32 reducedInterval = static_cast<u32>(std::max(activity.mReducedInterval, 1));
+    regions.Gather(cellX, cellY, reducedRadius, mNearbyObjects);
+
+    u32 updated = 0;
+    for (const u32 index : mNearbyObjects)
+    {
+        const MapObject* obj = mMapState.mObjs[index].get();
+        const s32 distance = std::max(std::abs(regions.CellX(obj->XPos()) - cellX), std::abs(regions.CellY(obj->YPos()) - cellY));
+
+        // Spread the objects on a reduced rate over the frames of the interval. The camera subject is
+        // always in its own cell so it is always gathered, even if another script has just moved it.
+        if (obj != subject && distance > activeRadius && (mFrame + index) % reducedInterval != 0)
+        {
+            continue;
+        }
+
+        UpdateObject(index, actions);
+        updated++;
+    }
+
+    activity.mLastUpdated = updated;
+}
 
 void GameMode::Render(AbstractRenderer& rend) const
 {
     if (mMapState.mCameraSubject && Debugging().mDrawCameras)
     {
-        const s32 camX = static_cast<s32>(mMapState.mCameraSubject->mXPos / mMapState.kCameraBlockSize.x);
-        const s32 camY = static_cast<s32>(mMapState.mCameraSubject->mYPos / mMapState.kCameraBlockSize.y);
+        const s32 camX = static_cast<s32>(mMapState.mCameraSubject->XPos() / mMapState.kCameraBlockSize.x);
+        const s32 camY = static_cast<s32>(mMapState.mCameraSubject->YPos() / mMapState.kCameraBlockSize.y);
 
 
         // Culling is disabled until proper camera position updating order is fixed
@@ -94,9 +146,25 @@ void GameMode::Render(AbstractRenderer& rend) const
 
     if (Debugging().mDrawObjects)
     {
-        for (const auto& obj : mMapState.mObjs)
+        Debug::ObjectActivity& activity = Debugging().mObjectActivity;
+        if (activity.mUpdateAll || !mMapState.mCameraSubject)
         {
-            obj->Render(rend, 0, 0, 1.0f, AbstractRenderer::eForegroundLayer0);
+            for (const auto& obj : mMapState.mObjs)
+            {
+                obj->Render(rend, 0, 0, 1.0f, AbstractRenderer::eForegroundLayer0);
+            }
+            activity.mLastRendered = static_cast<u32>(mMapState.mObjs.size());
+        }
+        else
+        {
+            // Objects in the cells around the one on screen can still overlap it
+            const ActivityRegions& regions = mMapState.mActivityRegions;
+            regions.Gather(regions.CellX(mMapState.mCameraSubject->XPos()), regions.CellY(mMapState.mCameraSubject->YPos()), 1, mVisibleObjects);
+            for (const u32 index : mVisibleObjects)
+            {
+                mMapState.mObjs[index]->Render(rend, 0, 0, 1.0f, AbstractRenderer::eForegroundLayer0);
+            }
+            activity.mLastRendered = static_cast<u32>(mVisibleObjects.size());
         }
     }
 
@@ -104,36 +172,36 @@ void GameMode::Render(AbstractRenderer& rend) const
     {
         // Test raycasting for shadows
         mMapState.DebugRayCast(rend,
-            glm::vec2(mMapState.mCameraSubject->mXPos, mMapState.mCameraSubject->mYPos),
-            glm::vec2(mMapState.mCameraSubject->mXPos, mMapState.mCameraSubject->mYPos + 500),
+            glm::vec2(mMapState.mCameraSubject->XPos(), mMapState.mCameraSubject->YPos()),
+            glm::vec2(mMapState.mCameraSubject->XPos(), mMapState.mCameraSubject->YPos() + 500),
             0,
             glm::vec2(0, -10)); // -10 so when we are *ON* a line you can see something
 
         mMapState.DebugRayCast(rend,
-            glm::vec2(mMapState.mCameraSubject->mXPos, mMapState.mCameraSubject->mYPos - 2),
-            glm::vec2(mMapState.mCameraSubject->mXPos, mMapState.mCameraSubject->mYPos - 60),
+            glm::vec2(mMapState.mCameraSubject->XPos(), mMapState.mCameraSubject->YPos() - 2),
+            glm::vec2(mMapState.mCameraSubject->XPos(), mMapState.mCameraSubject->YPos() - 60),
             3,
             glm::vec2(0, 0));
 
         if (mMapState.mCameraSubject->mFlipX)
         {
             mMapState.DebugRayCast(rend,
-                glm::vec2(mMapState.mCameraSubject->mXPos, mMapState.mCameraSubject->mYPos - 20),
-                glm::vec2(mMapState.mCameraSubject->mXPos - 25, mMapState.mCameraSubject->mYPos - 20), 1);
+                glm::vec2(mMapState.mCameraSubject->XPos(), mMapState.mCameraSubject->YPos() - 20),
+                glm::vec2(mMapState.mCameraSubject->XPos() - 25, mMapState.mCameraSubject->YPos() - 20), 1);
 
             mMapState.DebugRayCast(rend,
-                glm::vec2(mMapState.mCameraSubject->mXPos, mMapState.mCameraSubject->mYPos - 50),
-                glm::vec2(mMapState.mCameraSubject->mXPos - 25, mMapState.mCameraSubject->mYPos - 50), 1);
+                glm::vec2(mMapState.mCameraSubject->XPos(), mMapState.mCameraSubject->YPos() - 50),
+                glm::vec2(mMapState.mCameraSubject->XPos() - 25, mMapState.mCameraSubject->YPos() - 50), 1);
         }
         else
         {
             mMapState.DebugRayCast(rend,
-                glm::vec2(mMapState.mCameraSubject->mXPos, mMapState.mCameraSubject->mYPos - 20),
-                glm::vec2(mMapState.mCameraSubject->mXPos + 25, mMapState.mCameraSubject->mYPos - 20), 2);
+                glm::vec2(mMapState.mCameraSubject->XPos(), mMapState.mCameraSubject->YPos() - 20),
+                glm::vec2(mMapState.mCameraSubject->XPos() + 25, mMapState.mCameraSubject->YPos() - 20), 2);
 
             mMapState.DebugRayCast(rend,
-                glm::vec2(mMapState.mCameraSubject->mXPos, mMapState.mCameraSubject->mYPos - 50),
-                glm::vec2(mMapState.mCameraSubject->mXPos + 25, mMapState.mCameraSubject->mYPos - 50), 2);
+                glm::vec2(mMapState.mCameraSubject->XPos(), mMapState.mCameraSubject->YPos() - 50),
+                glm::vec2(mMapState.mCameraSubject->XPos() + 25, mMapState.mCameraSubject->YPos() - 50), 2);
         }
     }
 }
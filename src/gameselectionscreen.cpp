@@ -1,5 +1,6 @@
 #include "gameselectionscreen.hpp"
 #include "developerscreen.hpp"
+#include "oddlib/exceptions.hpp"
 #include "nfd.h"
 
 namespace
@@ -48,6 +49,21 @@ void GameSelectionScreen::ExitState()
 
 }
 
+void GameSelectionScreen::SelectForAutoStart(const std::string& dataSetName)
+{
+    for (size_t idx = 0; idx < mVisibleGameDefinitions.size(); idx++)
+    {
+        if (mVisibleGameDefinitions[idx]->DataSetName() == dataSetName)
+        {
+            mSelectedGameDefintionIndex = idx;
+            mSelectDeveloperMode = false;
+            mAutoStart = true;
+            return;
+        }
+    }
+    throw Oddlib::Exception("No game definition for data set " + dataSetName + " to replay with");
+}
+
 void GameSelectionScreen::LoadGameDefinition()
 {
     // Save out the paths for next time/purge bad paths
@@ -118,6 +134,49 @@ void GameSelectionScreen::RenderFindDataSets()
     }
 }
 
+void GameSelectionScreen::StartGame()
+{
+    const GameDefinition& userSelectedGameDef = *mVisibleGameDefinitions[mSelectedGameDefintionIndex];
+
+    std::set<std::string> missingDataSets;
+
+    std::vector<const GameDefinition*> allGameDefs;
+    for (const GameDefinition& t : mGameDefinitions)
+    {
+        allGameDefs.push_back(&t);
+    }
+
+    // Check we have the required data sets
+    GameDefinition::GetDependencies(mRequiredDataSets, missingDataSets, &userSelectedGameDef, allGameDefs);
+    if (missingDataSets.empty())
+    {
+        // Check we have a valid path to the "builtin" (i.e original) game files
+        mRequiredDataSetNames.clear();
+        for (const DataPaths::Path& dataSet : mRequiredDataSets)
+        {
+            if (!dataSet.mSourceGameDefinition->IsMod())
+            {
+                mRequiredDataSetNames.push_back(dataSet.mDataSetName);
+            }
+        }
+
+        mMissingDataPaths = mResLocator.GetDataPaths().MissingDataSetPaths(mRequiredDataSetNames);
+        if (!mMissingDataPaths.empty())
+        {
+            mState = eState::eFindDataSets;
+        }
+        else
+        {
+            LoadGameDefinition();
+        }
+    }
+    else
+    {
+        // Need user to download missing game defs, no in game way to recover from this
+        LOG_ERROR(missingDataSets.size() << " data sets are missing");
+    }
+}
+
 void GameSelectionScreen::RenderSelectGame()
 {
     if (ImGui::Begin("Select game"))
@@ -133,7 +192,7 @@ void GameSelectionScreen::RenderSelectGame()
 
         // Select developer mode by default
         static bool setFirstIndex = false;
-        if (!setFirstIndex)
+        if (!setFirstIndex && mSelectDeveloperMode)
         {
             if (!mVisibleGameDefinitions.empty())
             {
@@ -150,47 +209,10 @@ void GameSelectionScreen::RenderSelectGame()
             setFirstIndex = true;
         }
 
-        if (ImGui::Button("Start game"))
+        if (ImGui::Button("Start game") || mAutoStart)
         {
-            const GameDefinition& userSelectedGameDef = *mVisibleGameDefinitions[mSelectedGameDefintionIndex];
-
-            std::set<std::string> missingDataSets;
-
-            std::vector<const GameDefinition*> allGameDefs;
-            for (const GameDefinition& t : mGameDefinitions)
-            {
-                allGameDefs.push_back(&t);
-            }
-
-            // Check we have the required data sets
-            GameDefinition::GetDependencies(mRequiredDataSets, missingDataSets, &userSelectedGameDef, allGameDefs);
-            if (missingDataSets.empty())
-            {
-                // Check we have a valid path to the "builtin" (i.e original) game files
-                mRequiredDataSetNames.clear();
-                for (const DataPaths::Path& dataSet : mRequiredDataSets)
-                {
-                    if (!dataSet.mSourceGameDefinition->IsMod())
-                    {
-                        mRequiredDataSetNames.push_back(dataSet.mDataSetName);
-                    }
-                }
-
-                mMissingDataPaths = mResLocator.GetDataPaths().MissingDataSetPaths(mRequiredDataSetNames);
-                if (!mMissingDataPaths.empty())
-                {
-                    mState = eState::eFindDataSets;
-                }
-                else
-                {
-                    LoadGameDefinition();
-                }
-            }
-            else
-            {
-                // Need user to download missing game defs, no in game way to recover from this
-                LOG_ERROR(missingDataSets.size() << " data sets are missing");
-            }
+            mAutoStart = false;
+            StartGame();
         }
     }
     ImGui::End();
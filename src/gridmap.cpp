@@ -34,6 +34,10 @@ Level::Level(Sound& sound, IAudioController& audioController, ResourceLocator& l
             }
             mMap->LoadMap(*path, mLocator, rend);
             currentPathName = name;
+            if (Debugging().mFnPathLoaded)
+            {
+                Debugging().mFnPathLoaded(currentPathName);
+            }
         }
         else
         {
@@ -58,6 +62,10 @@ Level::Level(Sound& sound, IAudioController& audioController, ResourceLocator& l
                     mMap->LoadMap(*path, mLocator, rend);
 
                     currentPathName = pathMap.first;
+                    if (Debugging().mFnPathLoaded)
+                    {
+                        Debugging().mFnPathLoaded(currentPathName);
+                    }
                     nextPathIndex = idx +1;
                     if (nextPathIndex > static_cast<s32>(mLocator.mResMapper.mPathMaps.size()))
                     {
@@ -89,6 +97,10 @@ Level::Level(Sound& sound, IAudioController& audioController, ResourceLocator& l
                     mMap = std::make_unique<GridMap>(audioController, mLocator);
                 }
                 mMap->LoadMap(*path, mLocator, rend);
+                if (Debugging().mFnPathLoaded)
+                {
+                    Debugging().mFnPathLoaded(currentPathName);
+                }
             }
             else
             {
@@ -172,13 +184,11 @@ void GridScreen::LoadTextures()
 
             if (!mTexHandle2.IsValid())
             {
-                if (mCam->GetFg1())
+                // Only the tiles of FG1 that have something to draw are uploaded, nothing at all when it is empty
+                if (mCam->GetFg1() && !mCam->GetFg1()->IsEmpty())
                 {
-                    SDL_Surface* fg1Surf = mCam->GetFg1()->GetSurface();
-                    if (fg1Surf)
-                    {
-                        mTexHandle2 = mRend.CreateTexture(AbstractRenderer::eTextureFormats::eRGBA, fg1Surf->w, fg1Surf->h, AbstractRenderer::eTextureFormats::eRGBA, fg1Surf->pixels, true);
-                    }
+                    SDL_Surface* fg1Atlas = mCam->GetFg1()->GetAtlas();
+                    mTexHandle2 = mRend.CreateTexture(AbstractRenderer::eTextureFormats::eRGBA, fg1Atlas->w, fg1Atlas->h, AbstractRenderer::eTextureFormats::eRGBA, fg1Atlas->pixels, true);
                 }
             }
         }
@@ -209,7 +219,20 @@ void GridScreen::Render(float x, float y, float w, float h)
 
     if (mTexHandle2.IsValid())
     {
-        mRend.TexturedQuad(mTexHandle2, x, y, w, h, AbstractRenderer::eForegroundLayer1, ColourU8{ 255, 255, 255, 255 });
+        // Tiles are in camera pixels, scale them to the size the camera is drawn at
+        const SDL_Surface* camera = mCam->GetSurface();
+        const SDL_Surface* fg1Atlas = mCam->GetFg1()->GetAtlas();
+        const f32 scaleX = w / camera->w;
+        const f32 scaleY = h / camera->h;
+        const f32 atlasW = static_cast<f32>(fg1Atlas->w);
+        const f32 atlasH = static_cast<f32>(fg1Atlas->h);
+        for (const Oddlib::Fg1Tile& tile : mCam->GetFg1()->GetTiles())
+        {
+            mRend.TexturedQuad(mTexHandle2,
+                x + (tile.mX * scaleX), y + (tile.mY * scaleY), tile.mW * scaleX, tile.mH * scaleY,
+                tile.mAtlasX / atlasW, tile.mAtlasY / atlasH, (tile.mAtlasX + tile.mW) / atlasW, (tile.mAtlasY + tile.mH) / atlasH,
+                AbstractRenderer::eForegroundLayer1, ColourU8{ 255, 255, 255, 255 });
+        }
     }
 }
 
@@ -221,6 +244,7 @@ void GridScreen::Render(float x, float y, float w, float h)
     Sqrat::DerivedClass<GridMap, IMap, Sqrat::NoConstructor<GridMap>> gm(Sqrat::DefaultVM::Get(), "GridMap");
 
     gm.Func("GetMapObject", &GridMap::GetMapObject);
+    gm.Func("GetMapObjectInRect", &GridMap::GetMapObjectInRect);
 
     Sqrat::RootTable().Bind("GridMap", gm);
 }
@@ -241,6 +265,7 @@ void GridMap::LoadMap(Oddlib::Path& path, ResourceLocator& locator, AbstractRend
 {
     // Clear out existing objects from previous map
     mMapState.mObjs.clear();
+    mMapState.mCameraSubject = nullptr;
     mMapState.mCollisionItems.clear();
     mEditorMode->OnMapChanged();
 
@@ -275,6 +300,9 @@ void GridMap::LoadMap(Oddlib::Path& path, ResourceLocator& locator, AbstractRend
 
     SquirrelVm::CompileAndRun(locator, "map.nut");
 
+    const Sqrat::RootTable root;
+    const Sqrat::Object objFactory = root.GetSlot("object_factory");
+
     // Load objects
     for (auto x = 0u; x < mMapState.mScreens.size(); x++)
     {
@@ -297,11 +325,8 @@ void GridMap::LoadMap(Oddlib::Path& path, ResourceLocator& locator, AbstractRend
                 auto tmp = std::make_unique<MapObject>(locator, rect);
 
 
-                Sqrat::Function objFactory(Sqrat::RootTable(), "object_factory");
                 Oddlib::IStream* s = &ms; // Script only knows about IStream, not the derived types
-                Sqrat::SharedPtr<bool> ret = objFactory.Evaluate<bool>(tmp.get(), this, path.IsAo(), obj.mType, rect, s); // TODO: Don't need to pass rect?
-                SquirrelVm::CheckError();
-                if (ret.get() && *ret)
+                if (SquirrelVm::CallBool(objFactory, root, tmp.get(), this, path.IsAo(), obj.mType, rect, s)) // TODO: Don't need to pass rect?
                 {
                     tmp->Init();
                     mMapState.mObjs.push_back(std::move(tmp));
@@ -312,7 +337,7 @@ void GridMap::LoadMap(Oddlib::Path& path, ResourceLocator& locator, AbstractRend
 
     // TODO: Need to figure out what the right way to figure out where abe goes is
     // HACK: Place the player in the first screen that isn't blank
-    for (auto x = 0u; x < mMapState.mScreens.size(); x++)
+    for (auto x = 0u; x < mMapState.mScreens.size() && !mMapState.mCameraSubject; x++)
     {
         for (auto y = 0u; y < mMapState.mScreens[x].size(); y++)
         {
@@ -334,11 +359,25 @@ void GridMap::LoadMap(Oddlib::Path& path, ResourceLocator& locator, AbstractRend
                     tmp->SnapXToGrid(); // Ensure player is locked to grid
                     mMapState.mCameraSubject = tmp.get();
                     mMapState.mObjs.push_back(std::move(tmp));
-                    return;
+                    break;
                 }
             }
         }
     }
+
+    // The animation sets were decoded while the objects were being created
+    for (auto& obj : mMapState.mObjs)
+    {
+        obj->FinishInit();
+    }
+
+    mMapState.mActivityRegions.Reset(mMapState.kCameraBlockSize.x, mMapState.kCameraBlockSize.y, path.XSize(), path.YSize());
+    for (u32 i = 0; i < mMapState.mObjs.size(); i++)
+    {
+        MapObject& obj = *mMapState.mObjs[i];
+        obj.SetTypeId(mMapState.mObjectTypeIds.Intern(obj.Name()));
+        obj.SetActivityRegions(mMapState.mActivityRegions, i);
+    }
 }
 
 GridMap::~GridMap()
@@ -397,14 +436,39 @@ void GridMap::UpdateToEditorOrToGame(const InputState& input, CoordinateSpace& c
 
 MapObject* GridMap::GetMapObject(s32 x, s32 y, const char* type)
 {
-    for (auto& obj : mMapState.mObjs)
+    const u32 typeId = mMapState.mObjectTypeIds.Find(type);
+    if (typeId == ObjectTypeIds::kUnknownType)
+    {
+        return nullptr;
+    }
+
+    mMapState.mActivityRegions.GatherRect(static_cast<f32>(x), static_cast<f32>(y), 0.0f, 0.0f, mQueryObjects);
+    for (const u32 index : mQueryObjects)
     {
-        if (obj->Name() == type)
+        MapObject* obj = mMapState.mObjs[index].get();
+        if (obj->TypeId() == typeId && obj->ContainsPoint(x, y))
         {
-            if (obj->ContainsPoint(x, y))
-            {
-                return obj.get();
-            }
+            return obj;
+        }
+    }
+    return nullptr;
+}
+
+MapObject* GridMap::GetMapObjectInRect(s32 x, s32 y, s32 w, s32 h, const char* type)
+{
+    const u32 typeId = mMapState.mObjectTypeIds.Find(type);
+    if (typeId == ObjectTypeIds::kUnknownType)
+    {
+        return nullptr;
+    }
+
+    mMapState.mActivityRegions.GatherRect(static_cast<f32>(x), static_cast<f32>(y), static_cast<f32>(w), static_cast<f32>(h), mQueryObjects);
+    for (const u32 index : mQueryObjects)
+    {
+        MapObject* obj = mMapState.mObjs[index].get();
+        if (obj->TypeId() == typeId && obj->OverlapsRect(x, y, w, h))
+        {
+            return obj;
         }
     }
     return nullptr;
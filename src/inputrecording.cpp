@@ -0,0 +1,185 @@
+#include "inputrecording.hpp"
+#include "oddlib/stream.hpp"
+#include "oddlib/lvlarchive.hpp"
+#include "oddlib/exceptions.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+
+// File layout: magic, format, path name, data set count then the data set names, tick count then the
+// ticks. Names are a length then the characters.
+static const u32 kInputRecordingMagic = Oddlib::MakeType("ALIR");
+static const u32 kInputRecordingFormat = 2;
+
+// Over 50 hours at 60 ticks a second, anything more is a corrupt file
+static const u32 kMaxTicks = 60 * 60 * 60 * 50;
+static const u32 kMaxPathNameLength = 256;
+static const u32 kMaxDataSets = 64;
+
+static void WriteName(Oddlib::IStream& stream, const std::string& name)
+{
+    stream.Write(static_cast<u32>(name.size()));
+    stream.Write(name);
+}
+
+static std::string ReadName(Oddlib::IStream& stream)
+{
+    const u32 length = Oddlib::ReadU32(stream);
+    if (length > kMaxPathNameLength)
+    {
+        throw Oddlib::Exception("Input recording name is too long");
+    }
+    std::string name(length, '\0');
+    stream.Read(name);
+    return name;
+}
+
+void InputRecording::Start(const std::string& pathName, const std::vector<std::string>& dataSetNames)
+{
+    mPathName = pathName;
+    mDataSetNames = dataSetNames;
+    mTicks.clear();
+}
+
+void InputRecording::Write(Oddlib::IStream& stream) const
+{
+    stream.Write(kInputRecordingMagic);
+    stream.Write(kInputRecordingFormat);
+    WriteName(stream, mPathName);
+    stream.Write(static_cast<u32>(mDataSetNames.size()));
+    for (const std::string& dataSetName : mDataSetNames)
+    {
+        WriteName(stream, dataSetName);
+    }
+    stream.Write(static_cast<u32>(mTicks.size()));
+    stream.WriteBytes(reinterpret_cast<const u8*>(mTicks.data()), mTicks.size() * sizeof(Tick));
+}
+
+void InputRecording::Read(Oddlib::IStream& stream)
+{
+    if (Oddlib::ReadU32(stream) != kInputRecordingMagic)
+    {
+        throw Oddlib::Exception("Not an input recording");
+    }
+
+    if (Oddlib::ReadU32(stream) != kInputRecordingFormat)
+    {
+        throw Oddlib::Exception("Unsupported input recording format");
+    }
+
+    std::string pathName = ReadName(stream);
+
+    const u32 numDataSets = Oddlib::ReadU32(stream);
+    if (numDataSets == 0 || numDataSets > kMaxDataSets)
+    {
+        throw Oddlib::Exception("Input recording has a bad data set count");
+    }
+    std::vector<std::string> dataSetNames;
+    for (u32 i = 0; i < numDataSets; i++)
+    {
+        dataSetNames.push_back(ReadName(stream));
+    }
+
+    const u32 numTicks = Oddlib::ReadU32(stream);
+    if (numTicks > kMaxTicks)
+    {
+        throw Oddlib::Exception("Input recording has too many ticks");
+    }
+    std::vector<Tick> ticks(numTicks);
+    stream.ReadBytes(reinterpret_cast<u8*>(ticks.data()), ticks.size() * sizeof(Tick));
+
+    mPathName = std::move(pathName);
+    mDataSetNames = std::move(dataSetNames);
+    mTicks = std::move(ticks);
+}
+
+void InputRecorder::Tick(const InputRecording::Tick& tick)
+{
+    if (mRecording)
+    {
+        mInput.Add(tick);
+    }
+}
+
+void InputRecorder::PathLoaded(const std::string& pathName, const std::vector<std::string>& dataSetNames, const InputRecording::Tick& tick)
+{
+    // Tick() already gave this tick to the previous path, if there was one
+    mInput.Start(pathName, dataSetNames);
+    mInput.Add(tick);
+    mRecording = true;
+}
+
+const InputRecording::Tick* InputReplay::NextTick(const std::function<void(const std::string&)>& fnLoadPath)
+{
+    if (!mStarted)
+    {
+        fnLoadPath(mInput.PathName());
+        mStarted = true;
+    }
+
+    if (mNextTick == mInput.Ticks().size())
+    {
+        return nullptr;
+    }
+    return &mInput.Ticks()[mNextTick++];
+}
+
+static void AddSummaryLine(std::ostream& out, const char* name, std::vector<f32> times)
+{
+    if (times.empty())
+    {
+        return;
+    }
+
+    std::sort(times.begin(), times.end());
+    f32 total = 0.0f;
+    for (f32 time : times)
+    {
+        total += time;
+    }
+
+    out << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(3)
+        << " mean " << std::setw(8) << total / times.size()
+        << " median " << std::setw(8) << times[times.size() / 2]
+        << " p95 " << std::setw(8) << times[(times.size() * 95) / 100]
+        << " max " << std::setw(8) << times.back()
+        << "\n";
+}
+
+std::string ReplayBenchmark::Summary() const
+{
+    std::ostringstream out;
+    out << mTicks.size() << " ticks, times in ms\n";
+
+    const std::pair<const char*, f32 Tick::*> parts[] =
+    {
+        { "script", &Tick::mScriptMs },
+        { "collision", &Tick::mCollisionMs },
+        { "animation", &Tick::mAnimationMs },
+        { "render", &Tick::mRenderMs },
+        { "total", &Tick::mTotalMs }
+    };
+
+    for (const auto& part : parts)
+    {
+        std::vector<f32> times;
+        times.reserve(mTicks.size());
+        for (const Tick& tick : mTicks)
+        {
+            times.push_back(tick.*part.second);
+        }
+        AddSummaryLine(out, part.first, std::move(times));
+    }
+    return out.str();
+}
+
+void ReplayBenchmark::WriteCsv(std::ostream& stream) const
+{
+    stream << "tick,script_ms,collision_ms,animation_ms,render_ms,total_ms\n";
+    for (size_t i = 0; i < mTicks.size(); i++)
+    {
+        const Tick& tick = mTicks[i];
+        stream << i << "," << tick.mScriptMs << "," << tick.mCollisionMs << "," << tick.mAnimationMs << "," << tick.mRenderMs << "," << tick.mTotalMs << "\n";
+    }
+}
@@ -1,6 +1,7 @@
 #include "SDL.h"
 #include "engine.hpp"
 #include "logger.hpp"
+#include "string_util.hpp"
 #include "msvc_sdl_link.hpp"
 #include <vector>
 
@@ -14,6 +15,13 @@ int main(int argc, char** argv)
     for (int i = 0; i < argc; i++)
     {
         args.push_back(argv[i]);
+
+        // The drivers must be picked before the engine starts SDL
+        if (string_util::iequals("-headless", args.back()))
+        {
+            SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+            SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+        }
     }
 
     try
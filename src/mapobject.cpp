@@ -30,8 +30,8 @@
 
         c.Func("FacingRight", &MapObject::FacingRight);
         c.Func("FlipXDirection", &MapObject::FlipXDirection);
-        c.Var("mXPos", &MapObject::mXPos);
-        c.Var("mYPos", &MapObject::mYPos);
+        c.Prop("mXPos", &MapObject::XPos, &MapObject::SetXPos);
+        c.Prop("mYPos", &MapObject::YPos, &MapObject::SetYPos);
         c.Var("mName", &MapObject::mName);
         Sqrat::RootTable().Bind("MapObject", c);
     }
@@ -78,15 +78,34 @@ void MapObject::Init()
     // Read the kAnimationResources array and kSoundResources
     IterateArray<std::string>(mScriptObject, "kAnimationResources", [&](const std::string& anim)
     {
-        LoadAnimation(anim);
+        mAnimationRequestNames.push_back(anim);
     });
+    mAnimationRequest = std::make_unique<AnimationRequest>(mLocator.LocateAnimations(mAnimationRequestNames));
 
     IterateArray<std::string>(mScriptObject, "kSoundResources", [&](const std::string& anim)
     {
         LOG_INFO(anim);
     });
 
+    mUpdateFn = mScriptObject.GetSlot("Update");
+    if (mUpdateFn.IsNull())
+    {
+        LOG_ERROR("Script object has no Update function");
+    }
+}
 
+void MapObject::FinishInit()
+{
+    if (mAnimationRequest)
+    {
+        std::vector<std::unique_ptr<Animation>> anims = mAnimationRequest->Get();
+        for (size_t i = 0; i < anims.size(); i++)
+        {
+            mAnims[mAnimationRequestNames[i]] = std::move(anims[i]);
+        }
+        mAnimationRequest.reset();
+        mAnimationRequestNames.clear();
+    }
 }
 
 bool MapObject::WallCollision(IMap& map, f32 dx, f32 dy) const
@@ -94,6 +113,7 @@ bool MapObject::WallCollision(IMap& map, f32 dx, f32 dy) const
     // The game checks for both kinds of walls no matter the direction
     // ddcheat into a tunnel and the "inside out" wall will still force
     // a crouch.
+    ScopedTimer timer(Debugging().mTickTiming.mCollisionMs);
     return
         CollisionLine::RayCast<2>(map.Lines(),
             glm::vec2(mXPos, mYPos + dy),
@@ -103,6 +123,7 @@ bool MapObject::WallCollision(IMap& map, f32 dx, f32 dy) const
 
 bool MapObject::CellingCollision(IMap& map, f32 dx, f32 dy) const
 {
+    ScopedTimer timer(Debugging().mTickTiming.mCollisionMs);
     return CollisionLine::RayCast<1>(map.Lines(),
         glm::vec2(mXPos + (mFlipX ? -dx : dx), mYPos - 2), // avoid collision if we are standing on a celling
         glm::vec2(mXPos + (mFlipX ? -dx : dx), mYPos + dy),
@@ -111,6 +132,7 @@ bool MapObject::CellingCollision(IMap& map, f32 dx, f32 dy) const
 
 CollisionResult MapObject::FloorCollision(IMap& map) const
 {
+    ScopedTimer timer(Debugging().mTickTiming.mCollisionMs);
     Physics::raycast_collision c;
     if (CollisionLine::RayCast<1>(map.Lines(),
         glm::vec2(mXPos, mYPos),
@@ -158,7 +180,7 @@ void MapObject::LoadScript()
     */
 }
 
-void MapObject::Update(const InputState& input)
+void MapObject::Update(const Sqrat::Object& actions)
 {
     //TRACE_ENTRYEXIT;
 
@@ -168,12 +190,9 @@ void MapObject::Update(const InputState& input)
         return;
     }
 
-    //if (mAnim)
+    if (!mUpdateFn.IsNull())
     {
-
-        Sqrat::Function updateFn(mScriptObject, "Update");
-        updateFn.Execute(input.Mapping().GetActions());
-        SquirrelVm::CheckError();
+        SquirrelVm::Call(mUpdateFn, mScriptObject, actions);
 
         /*
         sol::protected_function f = mLuaState["update"];
@@ -256,6 +275,7 @@ void MapObject::SetAnimationAtFrame(const std::string& animation, u32 frame)
 
 bool MapObject::AnimUpdate()
 {
+    ScopedTimer timer(Debugging().mTickTiming.mAnimationMs);
     return mAnim->Update();
 }
 
@@ -308,6 +328,43 @@ bool MapObject::ContainsPoint(s32 x, s32 y) const
     return mAnim->Collision(x, y);
 }
 
+bool MapObject::OverlapsRect(s32 x, s32 y, s32 w, s32 h) const
+{
+    if (!mAnim)
+    {
+        return RectsOverlap(x, y, w, h, mRect.x, mRect.y, mRect.w, mRect.h);
+    }
+
+    return mAnim->Collision(x, y, w, h);
+}
+
+void MapObject::SetXPos(f32 x)
+{
+    SetPosition(x, mYPos);
+}
+
+void MapObject::SetYPos(f32 y)
+{
+    SetPosition(mXPos, y);
+}
+
+void MapObject::SetPosition(f32 x, f32 y)
+{
+    mXPos = x;
+    mYPos = y;
+    if (mActivityRegions)
+    {
+        mActivityRegions->Place(mActivityIndex, mXPos, mYPos);
+    }
+}
+
+void MapObject::SetActivityRegions(ActivityRegions& regions, u32 index)
+{
+    mActivityRegions = &regions;
+    mActivityIndex = index;
+    mActivityRegions->Place(mActivityIndex, mXPos, mYPos);
+}
+
 void MapObject::SnapXToGrid()
 {
     //25x20 grid hack
@@ -316,11 +373,11 @@ void MapObject::SnapXToGrid()
     const s32 gridPos = (xpos - 12) % 25;
     if (gridPos >= 13)
     {
-        mXPos = static_cast<float>(xpos - gridPos + 25);
+        SetXPos(static_cast<float>(xpos - gridPos + 25));
     }
     else
     {
-        mXPos = static_cast<float>(xpos - gridPos);
+        SetXPos(static_cast<float>(xpos - gridPos));
     }
 
     LOG_INFO("SnapX: " << oldX << " to " << mXPos);
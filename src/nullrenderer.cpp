@@ -0,0 +1,44 @@
+#include "nullrenderer.hpp"
+
+TextureHandle NullRenderer::CreateTexture(eTextureFormats /*internalFormat*/, u32 /*width*/, u32 /*height*/, eTextureFormats /*inputFormat*/, const void* /*pixels*/, bool /*interpolation*/)
+{
+    // Each texture gets its own non null handle so IsValid() works as it does with a real renderer
+    TextureHandle handle;
+    handle.mData = reinterpret_cast<void*>(mNextTexture++);
+    return handle;
+}
+
+void NullRenderer::DestroyTextures()
+{
+    mDestroyTextureList.clear();
+}
+
+const char* NullRenderer::Name() const
+{
+    return "Null";
+}
+
+void NullRenderer::SetVSync(bool /*on*/)
+{
+
+}
+
+void NullRenderer::OnSetRenderState(CmdState& /*info*/)
+{
+
+}
+
+void NullRenderer::ClearFrameBufferImpl(f32 /*r*/, f32 /*g*/, f32 /*b*/, f32 /*a*/)
+{
+
+}
+
+void NullRenderer::RenderCommandsImpl()
+{
+
+}
+
+void NullRenderer::ImGuiRender()
+{
+
+}
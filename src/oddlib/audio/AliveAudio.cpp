@@ -21,7 +21,7 @@ void AliveAudio::CleanVoices()
     }
 }
 
-void AliveAudio::AliveRenderAudio(f32 * AudioStream, int StreamLength)
+void AliveAudio::AliveRenderAudio(f32 * AudioStream, f32* ReverbSend, int StreamLength)
 {
     // Reset buffers
     for (int i = 0; i < StreamLength; ++i)
@@ -34,6 +34,7 @@ void AliveAudio::AliveRenderAudio(f32 * AudioStream, int StreamLength)
 
     AliveAudioVoice ** rawPointer = m_Voices.data(); // Real nice speed boost here.
 
+    bool hasReverb = false;
     for (int i = 0; i < StreamLength; i += 2)
     {
         for (size_t v = 0; v < voiceCount; v++)
@@ -81,6 +82,7 @@ void AliveAudio::AliveRenderAudio(f32 * AudioStream, int StreamLength)
             {
                 m_ReverbChannelBuffer[i] += leftSample;
                 m_ReverbChannelBuffer[i + 1] += rightSample;
+                hasReverb = true;
             }
             else
             {
@@ -92,30 +94,32 @@ void AliveAudio::AliveRenderAudio(f32 * AudioStream, int StreamLength)
         mCurrentSampleIndex++;
     }
 
-    m_Reverb.setEffectMix(ReverbMix);
-
-    // TODO: Find a better way of feeding the data in
-    for (int i = 0; i < StreamLength; i += 2)
+    if (hasReverb)
     {
-        const f32 left = static_cast<f32>(m_Reverb.tick(m_ReverbChannelBuffer[i], m_ReverbChannelBuffer[i + 1], 0));
-        const f32 right = static_cast<f32>(m_Reverb.lastOut(1));
-        m_ReverbChannelBuffer[i] = left;
-        m_ReverbChannelBuffer[i + 1] = right;
-    }
-   
-    for (int i = 0; i < StreamLength; i += 2)
-    {
-        const f32 left = m_DryChannelBuffer[i] + m_ReverbChannelBuffer[i];
-        const f32 right = m_DryChannelBuffer[i + 1] + m_ReverbChannelBuffer[i + 1];
-        SDL_MixAudioFormat((u8 *)(AudioStream + i), (const u8*)&left, AUDIO_F32, sizeof(f32), SDL_MIX_MAXVOLUME);
-        SDL_MixAudioFormat((u8 *)(AudioStream + i + 1), (const u8*)&right, AUDIO_F32, sizeof(f32), SDL_MIX_MAXVOLUME);
+        // The reverb itself is shared, here we only split the signal between the dry
+        // output and the send. Without a send the reverberant voices are played dry.
+        const f32 dryLevel = ReverbSend ? 1.0f - ReverbMix : 1.0f;
+        for (int i = 0; i < StreamLength; i++)
+        {
+            m_DryChannelBuffer[i] += m_ReverbChannelBuffer[i] * dryLevel;
+        }
+
+        if (ReverbSend)
+        {
+            for (int i = 0; i < StreamLength; i++)
+            {
+                ReverbSend[i] += m_ReverbChannelBuffer[i] * ReverbMix;
+            }
+        }
     }
 
+    SDL_MixAudioFormat((u8 *)AudioStream, (const u8*)m_DryChannelBuffer.data(), AUDIO_F32, StreamLength * sizeof(f32), SDL_MIX_MAXVOLUME);
+
     CleanVoices();
 }
 
 
-void AliveAudio::Play(f32* stream, u32 len)
+void AliveAudio::Play(f32* stream, f32* reverbSend, u32 len)
 {
     if (m_DryChannelBuffer.size() != len)
     {
@@ -126,7 +130,7 @@ void AliveAudio::Play(f32* stream, u32 len)
     }
 
 
-    AliveRenderAudio(stream, len);
+    AliveRenderAudio(stream, reverbSend, len);
 }
 
 void AliveAudio::VabBrowserUi()
@@ -0,0 +1,69 @@
+#include "oddlib/audio/ReverbBus.h"
+#include <algorithm>
+#include <cmath>
+
+// Once the tail output drops below this the reverb is considered silent
+static const f32 kReverbSilenceThreshold = 1.0f / 65536.0f;
+
+ReverbBus::ReverbBus()
+{
+    // Only wet signal comes out of the bus, each player mixes its own dry signal
+    mReverb.setEffectMix(1.0);
+}
+
+void ReverbBus::Begin(u32 len)
+{
+    if (mSendBuffer.size() != len)
+    {
+        // Only happens if the audio frame size changes
+        mSendBuffer.resize(len);
+    }
+    std::fill(mSendBuffer.begin(), mSendBuffer.end(), 0.0f);
+}
+
+void ReverbBus::Mix(f32* stream, u32 len)
+{
+    len = std::min(len, static_cast<u32>(mSendBuffer.size()));
+
+    const bool hasInput = std::any_of(mSendBuffer.begin(), mSendBuffer.begin() + len, [](f32 s) { return s != 0.0f; });
+    if (!hasInput && !mActive)
+    {
+        // Nothing sent and the tail has already decayed, so skip the reverb entirely
+        return;
+    }
+
+    const u32 numFrames = len / 2;
+    if (mFrames.frames() != numFrames)
+    {
+        mFrames.resize(numFrames, 2);
+    }
+
+    for (u32 i = 0; i < numFrames * 2; i++)
+    {
+        mFrames[i] = mSendBuffer[i];
+    }
+
+    // Processes both channels of the whole block in place
+    mReverb.tick(mFrames);
+
+    f32 peak = 0.0f;
+    for (u32 i = 0; i < numFrames * 2; i++)
+    {
+        const f32 out = static_cast<f32>(mFrames[i]);
+        stream[i] += out;
+        peak = std::max(peak, std::abs(out));
+    }
+
+    mActive = hasInput || peak > kReverbSilenceThreshold;
+    if (!mActive)
+    {
+        // Flush the remaining denormal-ish tail so the next input starts clean
+        mReverb.clear();
+    }
+}
+
+void ReverbBus::Reset()
+{
+    mReverb.clear();
+    mActive = false;
+}
@@ -117,11 +117,18 @@ bool SequencePlayer::AtEnd() const
     return m_PlayerState == ALIVE_SEQUENCER_FINISHED && mAliveAudio.NumberOfActiveVoices() == 0;
 }
 
-void SequencePlayer::Play(f32* stream, u32 len)
+void SequencePlayer::Play(f32* stream, f32* reverbSend, u32 len)
 {
     std::lock_guard<std::mutex> lock(mMutex);
 
-    mAliveAudio.Play(stream, len);
+    mAliveAudio.Play(stream, reverbSend, len);
+}
+
+void SequencePlayer::SetInterpolation(AudioInterpolation interpolation)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    mAliveAudio.Interpolation = interpolation;
 }
 
 u64 SequencePlayer::GetPlaybackPositionSample()
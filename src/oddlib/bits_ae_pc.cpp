@@ -2,7 +2,9 @@
 #include "oddlib/stream.hpp"
 #include "oddlib/vlctable.hpp"
 #include "oddlib/bits_fg1.hpp"
+#include "oddlib/worker_pool.hpp"
 #include "logger.hpp"
+#include <array>
 
 namespace Oddlib
 {
@@ -53,6 +55,31 @@ namespace Oddlib
         0x7C0, 0x7C0, 0x7C0, 0x7C0, 0x000         // 60
     };
 
+    struct BitsLogic;
+
+    // The decoding state of one 16x240 strip, strips share nothing but the vram they write to
+    class AeStripDecoder
+    {
+    public:
+        explicit AeStripDecoder(unsigned short int (&aVram)[240][640])
+            : g_vram(aVram)
+        {
+
+        }
+
+        void process_segment(u16* aVlcBufferPtr, int xPos);
+        int next_bits();
+
+    private:
+        void vlc_decoder(int aR, int aG, int aB, signed int aWidth, int aVramX, int aVramY);
+        void write_4_pixel_block(const BitsLogic& aR, const BitsLogic& aG, const BitsLogic& aB, int aVramX, int aVramY);
+
+        signed int g_left7_array = 0;
+        unsigned short int* g_pointer_to_vlc_buffer = nullptr;
+        int g_right25_array = 0;
+        unsigned short int (&g_vram)[240][640];
+    };
+
     // Encapsulates the logic of vlc_decoder() each call can read 3 words or 6 bytes max
     struct BitsLogic
     {
@@ -62,7 +89,7 @@ namespace Oddlib
 
         }
 
-        BitsLogic(int& aPrev, AeBitsPc* aStrat)
+        BitsLogic(int& aPrev, AeStripDecoder* aStrat)
             : param1(0), param2(0), param3(0), param4(0)
         {
             // Grab 3x next bits
@@ -128,33 +155,45 @@ namespace Oddlib
 
         memset(g_vram, 0, sizeof(g_vram));
 
+        // Read every strip up front since the stream can only be used from one thread. The
+        // AeVlcDecode reads futher that what we read from the file, hence each strip is followed
+        // by as much zero padding as it has data, and the last one by a few more words!
+        std::vector<u16> rawBitsFromFile;
+        std::array<size_t, kNumStrips> stripOffsets = {};
+        std::array<u16, kNumStrips> stripSizes = {};
         for (u32 i = 0; i < kNumStrips; i++)
         {
             // Read the size of the image strip
             u16 stripSize = 0;
             stream.Read(stripSize);
 
+            stripSizes[i] = stripSize;
+            stripOffsets[i] = rawBitsFromFile.size();
             if (stripSize > 0)
             {
                 // Raw segment from the CAM bits chunk
-                std::vector<u16> rawBitsFromFile;
-                rawBitsFromFile.resize(stripSize / sizeof(u16));
-                stream.Read(rawBitsFromFile);
-                
-                // The vlc_decode reads futher that what we read from the file, hence keep double size!
-                rawBitsFromFile.resize(stripSize);
+                rawBitsFromFile.resize(stripOffsets[i] + stripSize);
+                stream.ReadBytes(reinterpret_cast<u8*>(rawBitsFromFile.data() + stripOffsets[i]), (stripSize / sizeof(u16)) * sizeof(u16));
+            }
+        }
+        rawBitsFromFile.resize(rawBitsFromFile.size() + kAeVlcReadAheadWords);
 
-                // Create a "VLC" buffer to store the decompressed data in.
-                std::vector<u16> vlcBuf;
-                vlcBuf.resize(0x7E00); // 4KB
+        SharedParallelFor().For(kNumStrips, [&](u32 i)
+        {
+            if (stripSizes[i] > 0)
+            {
+                // Create a "VLC" buffer to store the decompressed data in, each worker keeps its own
+                thread_local std::vector<u16> vlcBuf;
+                vlcBuf.assign(0x7E00, 0);
 
                 // Decompress the segment into the vlc buffer
-                vlc_decode(rawBitsFromFile, vlcBuf);
+                AeVlcDecode(rawBitsFromFile.data() + stripOffsets[i], vlcBuf.data());
 
                 // write out the decoded pixels
-                process_segment(vlcBuf.data(), i * 16);
+                AeStripDecoder decoder(g_vram);
+                decoder.process_segment(vlcBuf.data(), i * kStripSize);
             }
-        }
+        });
 
         mSurface.reset(SDL_CreateRGBSurfaceFrom(g_vram, 640, 240, 16, 640 * sizeof(u16), red_mask, green_mask, blue_mask, 0));
         if (mSurface->format->format != SDL_PIXELFORMAT_RGB24)
@@ -163,99 +202,93 @@ namespace Oddlib
         }
     }
 
-    void AeBitsPc::vlc_decode(const std::vector<u16>& aCamSeg, std::vector<u16>& aDst)
+    // g_VlcTab holds 4 words for each 11 bit code: the code length followed by up to 3 decoded
+    // words, ended early by 0 or by 0xFFFF when a raw 13 bit word follows the code. This is the
+    // same table with the words counted up front so decoding a code has no branches.
+    struct VlcCode
     {
-        unsigned int vlcPtrIndex = 0;
-        unsigned int camSrcPtrIndex = 0;
-        unsigned int vlcTabIndex = 0;
-
-        // Or two source words together to make a DWORD
-        unsigned int dstVlcWord = aCamSeg[camSrcPtrIndex + 1] | (aCamSeg[camSrcPtrIndex] << 16);
-        camSrcPtrIndex += 2; // Skip the two words we just OR'ed
-
-        signed int totalBitsToShiftBy = 0;
+        u16 mWords[3];
+        u8 mLength;
+        u8 mNumWords;
+        bool mRawWordFollows;
+    };
 
-        for (;;)
+    static std::array<VlcCode, 2048> MakeVlcCodes()
+    {
+        std::array<VlcCode, 2048> codes = {};
+        for (u32 i = 0; i < codes.size(); i++)
         {
-            // Get 11 bits
-            const unsigned int shiftedData = (dstVlcWord >> 21);
-
-            // 0b11111111111 = 2047 * 4 =8192 = 8kb max index of 11 bits
-            vlcTabIndex = 4 * shiftedData;
-
-            // Grab vlc tab short using 11bit index * 4
-            const unsigned int bitsToShiftBy = g_VlcTab[vlcTabIndex];
-
-            // Shift var
-            totalBitsToShiftBy += bitsToShiftBy;
-
-            // Shift the other way by the vlc word
-            dstVlcWord = dstVlcWord << bitsToShiftBy;
-
-            // If we've shifted more than sizeof(short)
-            if (totalBitsToShiftBy > 0xF)
-            {
-                // Limit to short, and set 1st short to the next
-                // source word
-                totalBitsToShiftBy = totalBitsToShiftBy & 0xF;
-                dstVlcWord |= aCamSeg[camSrcPtrIndex++] << totalBitsToShiftBy;
-            }
-
-            int counter = 4;
-            while (--counter)
+            const unsigned short int* entry = &g_VlcTab[i * 4];
+            VlcCode& code = codes[i];
+            code.mLength = static_cast<u8>(entry[0]);
+            for (u32 j = 1; j < 4; j++)
             {
-                unsigned short vlcWord = g_VlcTab[++vlcTabIndex];
-                if (vlcWord == 0)
+                if (entry[j] == 0)
                 {
-                    counter = 0; // continue
                     break;
                 }
-                else if (vlcWord == 0xFFFF) // 1. Get an index that results in >0xf before here and ends up in here.
+                else if (entry[j] == 0xFFFF)
                 {
-                    counter = 1; // don't continue
+                    code.mRawWordFollows = true;
                     break;
                 }
-                else
-                {
-                    // Copy next table word
-                    aDst[vlcPtrIndex++] = vlcWord;
-                }
-            }
-            if (counter == 0)
-            {
-                ++vlcTabIndex;
-                continue;
+                code.mWords[code.mNumWords++] = entry[j];
             }
+        }
+        return codes;
+    }
 
-            // 2. Then get a none "1" value here and we can just take the 13bits to get
-            // whatever value we want? Would have to assume we always want 0-0x1fff
-            // values!
-
-            // This can happen a lot (i.e this exit path is not taken once)
-            // 0x1fff = 0b1111111111111 = max of >> 19 (13bits)
-            aDst[vlcPtrIndex++] = dstVlcWord >> 19; // Thus the last word is always 1?
+    void AeVlcDecode(const u16* aCamSeg, u16* aDst)
+    {
+        static const std::array<VlcCode, 2048> kCodes = MakeVlcCodes();
 
-            if (dstVlcWord >> 19 == 1) // If bit 1 of the shifted 13bits is enabled only (could be &1 == 1)
+        // The next bits are at the top of bitBuffer, a refill tops it up with two source words so that
+        // there is always enough for an 11 bit code and a 13 bit raw word
+        u64 bitBuffer = 0;
+        s32 numBits = 0;
+        u16* dst = aDst;
+        for (;;)
+        {
+            if (numBits < 32)
             {
-                // Exit function!
+                const u64 words = (static_cast<u64>(aCamSeg[0]) << 16) | aCamSeg[1];
+                aCamSeg += 2;
+                bitBuffer |= words << (32 - numBits);
+                numBits += 32;
+            }
 
-                // TODO: Can resize vector at this point..?
+            const VlcCode& code = kCodes[bitBuffer >> 53];
+            bitBuffer <<= code.mLength;
+            numBits -= code.mLength;
 
-                break; // or return
-            }
-            totalBitsToShiftBy += 0xD;
-            dstVlcWord = dstVlcWord << 0xD; // 0xD = 13 jib the bits above?
+            // Always copy all 3 words and only keep the ones the code has
+            dst[0] = code.mWords[0];
+            dst[1] = code.mWords[1];
+            dst[2] = code.mWords[2];
+            dst += code.mNumWords;
 
-            if (totalBitsToShiftBy > 0xF) // Limit to 16 and pull another shifted byte in
+            if (code.mRawWordFollows)
             {
-                totalBitsToShiftBy = totalBitsToShiftBy & 0xF; // Could just assign here?
-                dstVlcWord |= aCamSeg[camSrcPtrIndex++] << totalBitsToShiftBy; // Move the word over if 0xF!
+                const u16 rawWord = static_cast<u16>(bitBuffer >> 51);
+                *dst++ = rawWord;
+
+                // A raw word of 1 marks the end of the strip
+                if (rawWord == 1)
+                {
+                    break;
+                }
+                bitBuffer <<= 13;
+                numBits -= 13;
             }
         }
+
+        // Clear anything the unused word copies wrote past the end
+        dst[0] = 0;
+        dst[1] = 0;
     }
 
     // This function takes a 16x240 strip of bits and processes as 16x16 sized macro blocks, thus there are 240/16=15 macro blocks
-    void AeBitsPc::process_segment(u16 *aVlcBufferPtr, int xPos)
+    void AeStripDecoder::process_segment(u16 *aVlcBufferPtr, int xPos)
     {
         g_pointer_to_vlc_buffer = aVlcBufferPtr;       // This is decoding one 16x240 seg
 
@@ -275,7 +308,7 @@ namespace Oddlib
     }
 
     // Get 25 bits, keep looping until the next 7bits hits zero (use it as a counter)
-    int AeBitsPc::next_bits()
+    int AeStripDecoder::next_bits()
     {
         int ret = 0;
         if (g_left7_array <= 0)
@@ -300,7 +333,7 @@ namespace Oddlib
         return ret;
     }
 
-    void AeBitsPc::vlc_decoder(int aR, int aG, int aB, signed int aWidth, int aVramX, int aVramY)
+    void AeStripDecoder::vlc_decoder(int aR, int aG, int aB, signed int aWidth, int aVramX, int aVramY)
     {
         while (aWidth != 2) // Quad tree through 16, 8, 4, 2 sizes
         {
@@ -328,7 +361,7 @@ namespace Oddlib
 
 
 
-    void AeBitsPc::write_4_pixel_block(const BitsLogic& aR, const BitsLogic& aG, const BitsLogic& aB, int aVramX, int aVramY)
+    void AeStripDecoder::write_4_pixel_block(const BitsLogic& aR, const BitsLogic& aG, const BitsLogic& aB, int aVramX, int aVramY)
     {
         // BL
         if (aVramY < 240 && aVramX < 640)
@@ -1,6 +1,7 @@
 #include "oddlib/bits_ao_pc.hpp"
 #include "oddlib/stream.hpp"
 #include "oddlib/bits_fg1.hpp"
+#include <algorithm>
 
 namespace Oddlib
 {
@@ -34,7 +35,11 @@ namespace Oddlib
        
         const u32 kStripSize = 16;
         const u32 kNumStrips = 640 / kStripSize;
+        const u32 kStripPitch = kStripSize * sizeof(u16);
 
+        // The strips are raw pixels so there's nothing worth spreading over threads, each one is
+        // copied straight into the image rather than being wrapped in a surface and blitted
+        u8* pixels = static_cast<u8*>(mSurface->pixels);
         for (u32 i = 0; i < kNumStrips; i++)
         {
             // Read the size of the image strip
@@ -45,16 +50,11 @@ namespace Oddlib
             buffer.resize(stripSize);
             stream.Read(buffer);
 
-            // Convert to an SDL surface
-            SDL_SurfacePtr strip(SDL_CreateRGBSurfaceFrom(buffer.data(), 16, 240, 16, kStripSize*sizeof(u16), red_mask, green_mask, blue_mask, 0));
-
-            // Copy paste the strip into the full image
-            SDL_Rect dstRect;
-            dstRect.x = kStripSize * i;
-            dstRect.y = 0;
-            dstRect.w = kStripSize;
-            dstRect.h = 240;
-            SDL_BlitSurface(strip.get(), NULL, mSurface.get(), &dstRect);
+            const u32 numRows = std::min(240u, static_cast<u32>(buffer.size() / kStripPitch));
+            for (u32 y = 0; y < numRows; y++)
+            {
+                memcpy(pixels + (y * mSurface->pitch) + (i * kStripPitch), buffer.data() + (y * kStripPitch), kStripPitch);
+            }
         } 
         if (mSurface->format->format != SDL_PIXELFORMAT_RGB24)
         {
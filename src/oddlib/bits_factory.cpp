@@ -147,8 +147,8 @@ namespace Oddlib
     class Bits : public IBits
     {
     public:
-        Bits(SDL_SurfacePtr camImage)
-            : mCameraImage(std::move(camImage))
+        Bits(SDL_SurfacePtr camImage, std::unique_ptr<IFg1> fg1)
+            : mCameraImage(std::move(camImage)), mFg1(std::move(fg1))
         {
 
         }
@@ -158,15 +158,21 @@ namespace Oddlib
             return mCameraImage.get();
         }
 
-        virtual IFg1* GetFg1() const override { return nullptr; }
+        virtual IFg1* GetFg1() const override { return mFg1.get(); }
 
     private:
         SDL_SurfacePtr mCameraImage;
+        std::unique_ptr<IFg1> mFg1;
     };
 
-    std::unique_ptr<IBits> MakeBits(SDL_SurfacePtr camImage)
+    std::unique_ptr<IFg1> MakeFg1(SDL_SurfacePtr atlas, std::vector<Fg1Tile> tiles)
     {
-        return std::make_unique<Bits>(std::move(camImage));
+        return std::make_unique<TiledFg1>(std::move(atlas), std::move(tiles));
+    }
+
+    std::unique_ptr<IBits> MakeBits(SDL_SurfacePtr camImage, std::unique_ptr<IFg1> fg1)
+    {
+        return std::make_unique<Bits>(std::move(camImage), std::move(fg1));
     }
 
     std::unique_ptr<IBits> MakeBits(IStream& bitsStream, IStream* fg1Stream)
@@ -1,6 +1,8 @@
 #include "oddlib/bits_fg1.hpp"
 #include "oddlib/compressiontype4or5.hpp"
 #include "bitutils.hpp"
+#include <algorithm>
+#include <cstring>
 
 namespace Oddlib
 {
@@ -138,12 +140,149 @@ namespace Oddlib
         }
     }
 
+    // Each tile in the atlas is surrounded by its neighbouring pixels so that texture filtering
+    // at the edges of a tile gives the same result as it did with the full image
+    static const u32 kTileBorder = 1;
+
+    static u32* PixelPtr(const SDL_Surface* surface, u32 x, u32 y)
+    {
+        return reinterpret_cast<u32*>(static_cast<u8*>(surface->pixels) + (y * surface->pitch) + (x * sizeof(u32)));
+    }
+
+    static SDL_SurfacePtr CreateFg1Surface(u32 width, u32 height)
+    {
+        // TODO: Common masks
+        return SDL_SurfacePtr(SDL_CreateRGBSurface(0, width, height, 32, 0x000000ff, 0x0000ff00, 0x00ff0000, 0));
+    }
+
+    TiledFg1::TiledFg1(SDL_SurfacePtr atlas, std::vector<Fg1Tile> tiles)
+        : mAtlas(std::move(atlas)), mTiles(std::move(tiles))
+    {
+
+    }
+
+    SDL_Surface* TiledFg1::GetAtlas() const
+    {
+        return mAtlas.get();
+    }
+
+    const std::vector<Fg1Tile>& TiledFg1::GetTiles() const
+    {
+        return mTiles;
+    }
+
+    void TiledFg1::BuildTiles(const SDL_Surface* fg1)
+    {
+        const u32 width = static_cast<u32>(fg1->w);
+        const u32 height = static_cast<u32>(fg1->h);
+
+        // Used blocks that are next to each other on a row become one tile
+        mTiles.clear();
+        for (u32 blockY = 0; blockY < height; blockY += kFg1BlockHeight)
+        {
+            const u32 blockEndY = std::min(blockY + kFg1BlockHeight, height);
+
+            bool inTile = false;
+            u32 minX = 0;
+            u32 maxX = 0;
+            u32 minY = 0;
+            u32 maxY = 0;
+            for (u32 blockX = 0; blockX < width; blockX += kFg1BlockWidth)
+            {
+                const u32 blockEndX = std::min(blockX + kFg1BlockWidth, width);
+
+                bool used = false;
+                for (u32 y = blockY; y < blockEndY; y++)
+                {
+                    const u32* row = PixelPtr(fg1, 0, y);
+                    for (u32 x = blockX; x < blockEndX; x++)
+                    {
+                        if (row[x] >> 24)
+                        {
+                            if (!inTile && !used)
+                            {
+                                minX = x;
+                                maxX = x;
+                                minY = y;
+                                maxY = y;
+                            }
+                            minX = std::min(minX, x);
+                            maxX = std::max(maxX, x);
+                            minY = std::min(minY, y);
+                            maxY = std::max(maxY, y);
+                            used = true;
+                        }
+                    }
+                }
+
+                if (used)
+                {
+                    inTile = true;
+                }
+                else if (inTile)
+                {
+                    mTiles.push_back({ static_cast<u16>(minX), static_cast<u16>(minY), static_cast<u16>(maxX - minX + 1), static_cast<u16>(maxY - minY + 1), 0, 0 });
+                    inTile = false;
+                }
+            }
+
+            if (inTile)
+            {
+                mTiles.push_back({ static_cast<u16>(minX), static_cast<u16>(minY), static_cast<u16>(maxX - minX + 1), static_cast<u16>(maxY - minY + 1), 0, 0 });
+            }
+        }
+
+        if (mTiles.empty())
+        {
+            mAtlas = nullptr;
+            return;
+        }
+
+        // Pack the tiles into rows, a tile is never wider than the image so that is the widest a row can be
+        const u32 maxRowWidth = width + (kTileBorder * 2);
+        u32 atlasWidth = 0;
+        u32 rowX = 0;
+        u32 rowY = 0;
+        u32 rowHeight = 0;
+        for (Fg1Tile& tile : mTiles)
+        {
+            const u32 tileWidth = tile.mW + (kTileBorder * 2);
+            const u32 tileHeight = tile.mH + (kTileBorder * 2);
+            if (rowX + tileWidth > maxRowWidth)
+            {
+                rowX = 0;
+                rowY += rowHeight;
+                rowHeight = 0;
+            }
+            tile.mAtlasX = static_cast<u16>(rowX + kTileBorder);
+            tile.mAtlasY = static_cast<u16>(rowY + kTileBorder);
+            rowX += tileWidth;
+            rowHeight = std::max(rowHeight, tileHeight);
+            atlasWidth = std::max(atlasWidth, rowX);
+        }
+
+        mAtlas = CreateFg1Surface(atlasWidth, rowY + rowHeight);
+        for (const Fg1Tile& tile : mTiles)
+        {
+            // Pixels past the edge of the image repeat the edge like a clamped texture would
+            for (int y = -static_cast<int>(kTileBorder); y < tile.mH + static_cast<int>(kTileBorder); y++)
+            {
+                const u32 srcY = static_cast<u32>(std::min(std::max(tile.mY + y, 0), static_cast<int>(height) - 1));
+                const u32* src = PixelPtr(fg1, 0, srcY);
+                u32* dst = PixelPtr(mAtlas.get(), tile.mAtlasX - kTileBorder, tile.mAtlasY + y);
+                for (int x = -static_cast<int>(kTileBorder); x < tile.mW + static_cast<int>(kTileBorder); x++)
+                {
+                    *dst++ = src[std::min(std::max(tile.mX + x, 0), static_cast<int>(width) - 1)];
+                }
+            }
+        }
+    }
+
     BitsFg1::BitsFg1(SDL_Surface* camera, IStream& stream, bool bBitMaskedPartialBlocks)
     {
         TRACE_ENTRYEXIT;
 
-        // TODO: Common masks
-        SDL_SurfacePtr fg1(SDL_CreateRGBSurface(0, camera->w, camera->h, 32, 0x000000ff, 0x0000ff00, 0x00ff0000, 0));
+        SDL_SurfacePtr fg1 = CreateFg1Surface(camera->w, camera->h);
 
         u32 numberOfPartialChunks = 0;
         stream.Read(numberOfPartialChunks);
@@ -155,13 +294,22 @@ namespace Oddlib
 
         u32 chunksRead = 0;
         ProcessFG1(fg1.get(), stream, numberOfPartialChunks, chunksRead, bBitMaskedPartialBlocks);
-      
-        mSurface = std::move(fg1);
+
+        // Most of the image is usually transparent so only the used parts are kept
+        BuildTiles(fg1.get());
     }
 
-    SDL_Surface* BitsFg1::GetSurface() const
+    SDL_SurfacePtr IFg1::MakeSurface(u32 width, u32 height) const
     {
-        return mSurface.get();
+        SDL_SurfacePtr surface = CreateFg1Surface(width, height);
+        const SDL_Surface* atlas = GetAtlas();
+        for (const Fg1Tile& tile : GetTiles())
+        {
+            for (u32 y = 0; y < tile.mH; y++)
+            {
+                memcpy(PixelPtr(surface.get(), tile.mX, tile.mY + y), PixelPtr(atlas, tile.mAtlasX, tile.mAtlasY + y), tile.mW * sizeof(u32));
+            }
+        }
+        return surface;
     }
-
 }
@@ -4,6 +4,7 @@
 #include "logger.hpp"
 #include <string>
 #include "oddlib/bits_fg1.hpp"
+#include "oddlib/worker_pool.hpp"
 
 namespace Oddlib
 {
@@ -52,11 +53,15 @@ namespace Oddlib
 #endif
 
 
-        int numSlices = (384 / 32);
-        for (int u = 0; u < numSlices; u++)
-        {
-            PSXMDECDecoder mdec;
+        const u32 numSlices = singleSlice ? 1 : (384 / 32);
 
+        // Read every slice up front since the stream can only be used from one thread, the
+        // decoder reads past the end of the data so each slice is followed by as much zero padding
+        std::vector<u8> buffer;
+        std::vector<size_t> sliceOffsets(numSlices);
+        std::vector<SDL_SurfacePtr> strips(numSlices);
+        for (u32 u = 0; u < numSlices; u++)
+        {
             u16 w = 0;
             if (singleSlice)
             {
@@ -67,7 +72,7 @@ namespace Oddlib
                 w = (u == numSlices - 1) ? 16 : 32;
             }
 
-            SDL_SurfacePtr strip(SDL_CreateRGBSurface(0, w, 240, 32, rmask, gmask, bmask, amask));
+            strips[u].reset(SDL_CreateRGBSurface(0, w, 240, 32, rmask, gmask, bmask, amask));
 
             u16 len = 0;
             if (singleSlice)
@@ -84,24 +89,27 @@ namespace Oddlib
                 }
             }
 
-            std::vector<u8> buffer(len);
-            stream.Read(buffer);
-            buffer.resize(buffer.size()*2 );
-
+            sliceOffsets[u] = buffer.size();
+            buffer.resize(sliceOffsets[u] + (len * 2));
+            stream.ReadBytes(buffer.data() + sliceOffsets[u], len);
+        }
 
-            mdec.DecodeFrameToABGR32((uint16_t*)strip->pixels, (uint16_t*)(buffer.data()),w, 240);
+        // Each slice has its own decoder and output surface
+        SharedParallelFor().For(numSlices, [&](u32 u)
+        {
+            PSXMDECDecoder mdec;
+            SDL_Surface* strip = strips[u].get();
+            mdec.DecodeFrameToABGR32((uint16_t*)strip->pixels, (uint16_t*)(buffer.data() + sliceOffsets[u]), static_cast<u16>(strip->w), 240);
+        });
 
+        for (u32 u = 0; u < numSlices; u++)
+        {
             SDL_Rect dstRect = {};
             dstRect.x = 32 * u;
             dstRect.y = 0;
-            dstRect.w = w;
+            dstRect.w = strips[u]->w;
             dstRect.h = 240;
-            SDL_BlitSurface(strip.get(), NULL, mSurface.get(), &dstRect);
-
-            if (singleSlice)
-            {
-                break;
-            }
+            SDL_BlitSurface(strips[u].get(), NULL, mSurface.get(), &dstRect);
         }
 
         if (mSurface->format->format != SDL_PIXELFORMAT_RGB24)
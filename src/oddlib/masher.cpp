@@ -1,8 +1,11 @@
 #include "oddlib/masher.hpp"
 #include "oddlib/lvlarchive.hpp"
 #include "oddlib/masher_tables.hpp"
+#include "oddlib/video_kernels.hpp"
+#include "oddlib/worker_pool.hpp"
 #include "logger.hpp"
 #include <assert.h>
+#include <algorithm>
 #include <array>
 #include "oddlib/PSXMDECDecoder.h"
 
@@ -94,6 +97,15 @@ namespace Oddlib
             mStream->Seek(mStream->Pos() + totalSize);
         }
 
+        // When there is video and audio each frame starts with the size of its video data
+        const size_t frameHeaderSize = (mbHasVideo && mbHasAudio) ? sizeof(uint32_t) : 0;
+        mFrameOffsets.resize(mFileHeader.mNumberOfFrames + 1);
+        mFrameOffsets[0] = mStream->Pos();
+        for (uint32_t i = 0; i < mFileHeader.mNumberOfFrames; i++)
+        {
+            mFrameOffsets[i + 1] = mFrameOffsets[i] + frameHeaderSize + mFrameSizes[i];
+        }
+
         mMacroBlockBuffer.resize((mNumMacroblocksX * kMacroBlockWidth) * (mNumMacroblocksY * kMacroBlockHeight) * kNumberOfBlocks);
 
         mDecodedVideoFrameData.resize(mVideoHeader.mMaxVideoFrameSize);
@@ -390,16 +402,13 @@ namespace Oddlib
         0x00000036, 0x0000002F, 0x00000037, 0x0000003E, 0x0000003F, 0x0000098E, 0x0000098E, 0x0000F384
     };
 
-    u32 g_252_buffer_unk_635A0C[64] = {};
-    u32 g_252_buffer_unk_63580C[64] = {};
-
     // Return val becomes param 1
 
     // for Cr, Cb, Y1, Y2, Y3, Y4
-    int16_t* ddv_func7_DecodeMacroBlock_impl(int16_t* inPtr, int16_t* outputBlockPtr, bool isYBlock)
+    int16_t* ddv_func7_DecodeMacroBlock_impl(int16_t* inPtr, int16_t* outputBlockPtr, bool isYBlock, const std::array<u32, 64>& quantTable)
     {
         const int v1 = isYBlock;
-        const u32* pTable = isYBlock ? &g_252_buffer_unk_63580C[1] : &g_252_buffer_unk_635A0C[1];
+        const u32* pTable = &quantTable[1];
         unsigned int counter = 0;
         u16* pInput = (u16*)inPtr;
         u32* pOutput = (u32*)outputBlockPtr;              // off 10 quantised coefficients
@@ -518,164 +527,10 @@ namespace Oddlib
         return (int16_t*)pInput;
     }
 
-    // TODO: Should probably just be 64? Making this bigger fixes a sound glitch which is probably caused
-    // by an out of bounds write somewhere.
-    typedef std::array<int32_t, 64 * 4> T64IntsArray;
-
-    static T64IntsArray Cr_block = {};
-    static T64IntsArray Cb_block = {};
-    static T64IntsArray Y1_block = {};
-    static T64IntsArray Y2_block = {};
-    static T64IntsArray Y3_block = {};
-    static T64IntsArray Y4_block = {};
-
-
-    void half_idct(T64IntsArray& pSource, T64IntsArray& pDestination, int nPitch, int nIncrement, int nShift)
-    {
-        std::array<int32_t, 8> pTemp;
-
-        size_t sourceIdx = 0;
-        size_t destinationIdx = 0;
-
-        for (int i = 0; i < 8; i++)
-        {
-            pTemp[4] = pSource[(0 * nPitch) + sourceIdx] * 8192 + pSource[(2 * nPitch) + sourceIdx] * 10703 + pSource[(4 * nPitch) + sourceIdx] * 8192 + pSource[(6 * nPitch) + sourceIdx] * 4433;
-            pTemp[5] = pSource[(0 * nPitch) + sourceIdx] * 8192 + pSource[(2 * nPitch) + sourceIdx] * 4433 - pSource[(4 * nPitch) + sourceIdx] * 8192 - pSource[(6 * nPitch) + sourceIdx] * 10704;
-            pTemp[6] = pSource[(0 * nPitch) + sourceIdx] * 8192 - pSource[(2 * nPitch) + sourceIdx] * 4433 - pSource[(4 * nPitch) + sourceIdx] * 8192 + pSource[(6 * nPitch) + sourceIdx] * 10704;
-            pTemp[7] = pSource[(0 * nPitch) + sourceIdx] * 8192 - pSource[(2 * nPitch) + sourceIdx] * 10703 + pSource[(4 * nPitch) + sourceIdx] * 8192 - pSource[(6 * nPitch) + sourceIdx] * 4433;
-
-            pTemp[0] = pSource[(1 * nPitch) + sourceIdx] * 11363 + pSource[(3 * nPitch) + sourceIdx] * 9633 + pSource[(5 * nPitch) + sourceIdx] * 6437 + pSource[(7 * nPitch) + sourceIdx] * 2260;
-            pTemp[1] = pSource[(1 * nPitch) + sourceIdx] * 9633 - pSource[(3 * nPitch) + sourceIdx] * 2259 - pSource[(5 * nPitch) + sourceIdx] * 11362 - pSource[(7 * nPitch) + sourceIdx] * 6436;
-            pTemp[2] = pSource[(1 * nPitch) + sourceIdx] * 6437 - pSource[(3 * nPitch) + sourceIdx] * 11362 + pSource[(5 * nPitch) + sourceIdx] * 2261 + pSource[(7 * nPitch) + sourceIdx] * 9633;
-            pTemp[3] = pSource[(1 * nPitch) + sourceIdx] * 2260 - pSource[(3 * nPitch) + sourceIdx] * 6436 + pSource[(5 * nPitch) + sourceIdx] * 9633 - pSource[(7 * nPitch) + sourceIdx] * 11363;
-
-            pDestination[(0 * nPitch) + destinationIdx] = (pTemp[4] + pTemp[0]) >> nShift;
-            pDestination[(1 * nPitch) + destinationIdx] = (pTemp[5] + pTemp[1]) >> nShift;
-            pDestination[(2 * nPitch) + destinationIdx] = (pTemp[6] + pTemp[2]) >> nShift;
-            pDestination[(3 * nPitch) + destinationIdx] = (pTemp[7] + pTemp[3]) >> nShift;
-            pDestination[(4 * nPitch) + destinationIdx] = (pTemp[7] - pTemp[3]) >> nShift;
-            pDestination[(5 * nPitch) + destinationIdx] = (pTemp[6] - pTemp[2]) >> nShift;
-            pDestination[(6 * nPitch) + destinationIdx] = (pTemp[5] - pTemp[1]) >> nShift;
-            pDestination[(7 * nPitch) + destinationIdx] = (pTemp[4] - pTemp[0]) >> nShift;
-
-            sourceIdx += nIncrement;
-            destinationIdx += nIncrement;
-        }
-    }
-
-    // 0x40ED90
-    void idct(int16_t* input, T64IntsArray& pDestination) // dst is 64 dwords
-    {
-        T64IntsArray pTemp;
-        T64IntsArray pExtendedSource;
-
-        // Source is passed as signed 16 bits stored every 32 bits
-        // We sign extend it at the beginning like Masher does
-        for (int i = 0; i < 64; i++)
-        {
-            pExtendedSource[i] = input[i * 2];
-        }
-
-        half_idct(pExtendedSource, pTemp, 8, 1, 11);
-        half_idct(pTemp, pDestination, 1, 8, 18);
-    }
-
-    static int To1d(int x, int y)
-    {
-        // 8x8 index to x64 index
-        return y * 8 + x;
-    }
-
-    unsigned char Clamp(f32 v)
-    {
-        if (v < 0.0f) v = 0.0f;
-        if (v > 255.0f) v = 255.0f;
-        return (unsigned char)v;
-    }
-
-    void SetElement(int x, int y, int width, u32* ptr, u32 value)
-    {
-        ptr[(width * y) + x] = value;
-    }
-
-    static void ConvertYuvToRgbAndBlit(u32* pixelBuffer, int xoff, int yoff, int width, int height)
-    {
-        // convert the Y1 Y2 Y3 Y4 and Cb and Cr blocks into a 16x16 array of (Y, Cb, Cr) pixels
-        struct Macroblock_YCbCr_Struct
-        {
-            f32 Y;
-            f32 Cb;
-            f32 Cr;
-        };
-
-        std::array< std::array<Macroblock_YCbCr_Struct, 16>, 16> Macroblock_YCbCr = {};
-
-        for (int x = 0; x < 8; x++)
-        {
-            for (int y = 0; y < 8; y++)
-            {
-                Macroblock_YCbCr[x][y].Y = static_cast<f32>(Y1_block[To1d(x, y)]);
-                Macroblock_YCbCr[x + 8][y].Y = static_cast<f32>(Y2_block[To1d(x, y)]);
-                Macroblock_YCbCr[x][y + 8].Y = static_cast<f32>(Y3_block[To1d(x, y)]);
-                Macroblock_YCbCr[x + 8][y + 8].Y = static_cast<f32>(Y4_block[To1d(x, y)]);
-
-                Macroblock_YCbCr[x * 2][y * 2].Cb = static_cast<f32>(Cb_block[To1d(x, y)]);
-                Macroblock_YCbCr[x * 2 + 1][y * 2].Cb = static_cast<f32>(Cb_block[To1d(x, y)]);
-                Macroblock_YCbCr[x * 2][y * 2 + 1].Cb = static_cast<f32>(Cb_block[To1d(x, y)]);
-                Macroblock_YCbCr[x * 2 + 1][y * 2 + 1].Cb = static_cast<f32>(Cb_block[To1d(x, y)]);
-
-                Macroblock_YCbCr[x * 2][y * 2].Cr = static_cast<f32>(Cr_block[To1d(x, y)]);
-                Macroblock_YCbCr[x * 2 + 1][y * 2].Cr = static_cast<f32>(Cr_block[To1d(x, y)]);
-                Macroblock_YCbCr[x * 2][y * 2 + 1].Cr = static_cast<f32>(Cr_block[To1d(x, y)]);
-                Macroblock_YCbCr[x * 2 + 1][y * 2 + 1].Cr = static_cast<f32>(Cr_block[To1d(x, y)]);
-            }
-        }
-
-        // Convert the (Y, Cb, Cr) pixels into RGB pixels
-        struct Macroblock_RGB_Struct
-        {
-            unsigned char Red;
-            unsigned char Green;
-            unsigned char Blue;
-            unsigned char A;
-        };
-
-        std::array< std::array<Macroblock_RGB_Struct, 16>, 16> Macroblock_RGB = {};
-
-        for (u32 x = 0; x < kMacroBlockWidth; x++)
-        {
-            for (u32 y = 0; y < kMacroBlockHeight; y++)
-            {
-                const f32 r = (Macroblock_YCbCr[x][y].Y) + 1.402f *  Macroblock_YCbCr[x][y].Cb;
-                const f32 g = (Macroblock_YCbCr[x][y].Y) - 0.3437f * Macroblock_YCbCr[x][y].Cr - 0.7143f * Macroblock_YCbCr[x][y].Cb;
-                const f32 b = (Macroblock_YCbCr[x][y].Y) + 1.772f *  Macroblock_YCbCr[x][y].Cr;
-
-                Macroblock_RGB[x][y].Red = Clamp(r);
-                Macroblock_RGB[x][y].Green = Clamp(g);
-                Macroblock_RGB[x][y].Blue = Clamp(b);
-
-                // Due to macro block padding this can be out of bounds
-                int xpos = x + xoff;
-                int ypos = y + yoff;
-                if (xpos < width && ypos < height)
-                {
-                    u32 pixelValue = 0;
-                    pixelValue = (pixelValue << 8) + Macroblock_RGB[x][y].Blue;
-                    pixelValue = (pixelValue << 8) + Macroblock_RGB[x][y].Green;
-                    pixelValue = (pixelValue << 8) + Macroblock_RGB[x][y].Red;
-
-                    // Actually is no alpha in FMVs
-                    // pixelValue = (pixelValue << 8) + Macroblock_RGB[x][y].A
-                    SetElement(xpos, ypos, width, pixelBuffer, pixelValue);
-                }
-            }
-        }
-    }
-
-    static void after_block_decode_no_effect_q_impl(int quantScale)
+    static void after_block_decode_no_effect_q_impl(int quantScale, std::array<u32, 64>& yQuantTable, std::array<u32, 64>& cbCrQuantTable)
     {
-        g_252_buffer_unk_63580C[0] = 16;
-        g_252_buffer_unk_635A0C[0] = 16;
+        yQuantTable[0] = 16;
+        cbCrQuantTable[0] = 16;
         if (quantScale > 0)
         {
             signed int result = 0;
@@ -683,8 +538,8 @@ namespace Oddlib
             {
                 auto val = gQuant1_dword_42AEC8[result];
                 result++;
-                g_252_buffer_unk_63580C[result] = quantScale * val;
-                g_252_buffer_unk_635A0C[result] = quantScale * gQaunt2_dword_42AFC4[result];
+                yQuantTable[result] = quantScale * val;
+                cbCrQuantTable[result] = quantScale * gQaunt2_dword_42AFC4[result];
 
 
             } while (result < 63);                   // 252/4=63
@@ -694,11 +549,11 @@ namespace Oddlib
             // These are simply null buffers to start with
             for (int i = 0; i < 64; i++)
             {
-                g_252_buffer_unk_635A0C[i] = 16;
-                g_252_buffer_unk_63580C[i] = 16;
+                cbCrQuantTable[i] = 16;
+                yQuantTable[i] = 16;
             }
-            // memset(&g_252_buffer_unk_635A0C[1], 16, 252  /*sizeof(g_252_buffer_unk_635A0C)*/); // u32[63]
-            // memset(&g_252_buffer_unk_63580C[1], 16, 252 /*sizeof(g_252_buffer_unk_63580C)*/);
+            // memset(&cbCrQuantTable[1], 16, 252  /*sizeof(cbCrQuantTable)*/); // u32[63]
+            // memset(&yQuantTable[1], 16, 252 /*sizeof(yQuantTable)*/);
         }
 
     }
@@ -712,63 +567,75 @@ namespace Oddlib
 
         const int quantScale = decode_bitstream((u16*)mVideoFrameData.data(), mDecodedVideoFrameData.data());
 
-        after_block_decode_no_effect_q_impl(quantScale);
+        after_block_decode_no_effect_q_impl(quantScale, mYQuantTable, mCbCrQuantTable);
 
+        const int dataSizeBytes = 64 * 4;// thisPtr->mBlockDataSize_q * 4; // Convert to byte count 64*4=256
 
+        // The run length data has no block boundaries so it can only be walked in order,
+        // this also dequantises each block into its slot in the macroblock buffer.
         int16_t* bitstreamCurPos = (int16_t*)mDecodedVideoFrameData.data();
-        int16_t* block1Output = (int16_t*)mMacroBlockBuffer.data();
+        int16_t* blockOutput = (int16_t*)mMacroBlockBuffer.data();
+        for (unsigned int macroBlock = 0; macroBlock < mNumMacroblocksX * mNumMacroblocksY; macroBlock++)
+        {
+            // Cr, Cb, Y1, Y2, Y3, Y4
+            for (u32 i = 0; i < kNumberOfBlocks; i++)
+            {
+                const bool isYBlock = i >= 2;
+                bitstreamCurPos = ddv_func7_DecodeMacroBlock_impl(bitstreamCurPos, blockOutput, isYBlock, isYBlock ? mYQuantTable : mCbCrQuantTable);
+                blockOutput += dataSizeBytes;
+            }
+        }
 
-        int xoff = 0;
-        for (unsigned int xBlock = 0; xBlock < mNumMacroblocksX; xBlock++)
+        // Each macroblock column only touches its own blocks and pixels so they can be finished in parallel
+        const int16_t* macroBlockBuffer = (const int16_t*)mMacroBlockBuffer.data();
+        const VideoKernels& kernels = mVideoKernels ? *mVideoKernels : BestVideoKernels();
+        SharedParallelFor().For(mNumMacroblocksX, [&](u32 xBlock)
         {
-            int yoff = 0;
+            MasherMacroBlock decoded;
+            const int xoff = xBlock * kMacroBlockWidth;
             for (unsigned int yBlock = 0; yBlock < mNumMacroblocksY; yBlock++)
             {
-                const int dataSizeBytes = 64 * 4;// thisPtr->mBlockDataSize_q * 4; // Convert to byte count 64*4=256
-
-                int16_t* afterBlock1Ptr = ddv_func7_DecodeMacroBlock_impl(bitstreamCurPos, block1Output, 0);
-                idct(block1Output, Cr_block);
-                int16_t* block2Output = dataSizeBytes + block1Output;
-
-                int16_t* afterBlock2Ptr = ddv_func7_DecodeMacroBlock_impl(afterBlock1Ptr, block2Output, 0);
-                idct(block2Output, Cb_block);
-                int16_t* block3Output = dataSizeBytes + block2Output;
-
-                int16_t* afterBlock3Ptr = ddv_func7_DecodeMacroBlock_impl(afterBlock2Ptr, block3Output, 1);
-                idct(block3Output, Y1_block);
-                int16_t* block4Output = dataSizeBytes + block3Output;
+                const int16_t* block = macroBlockBuffer + (((xBlock * mNumMacroblocksY) + yBlock) * kNumberOfBlocks * dataSizeBytes);
 
-                int16_t* afterBlock4Ptr = ddv_func7_DecodeMacroBlock_impl(afterBlock3Ptr, block4Output, 1);
-                idct(block4Output, Y2_block);
-                int16_t* block5Output = dataSizeBytes + block4Output;
-
-                int16_t* afterBlock5Ptr = ddv_func7_DecodeMacroBlock_impl(afterBlock4Ptr, block5Output, 1);
-                idct(block5Output, Y3_block);
-                int16_t* block6Output = dataSizeBytes + block5Output;
-
-                bitstreamCurPos = ddv_func7_DecodeMacroBlock_impl(afterBlock5Ptr, block6Output, 1);
-                idct(block6Output, Y4_block);
-                block1Output = dataSizeBytes + block6Output;
-
-                ConvertYuvToRgbAndBlit(pixelBuffer, xoff, yoff, mVideoHeader.mWidth, mVideoHeader.mHeight);
+                kernels.mMasherIdct(block + (0 * dataSizeBytes), decoded.mCr);
+                kernels.mMasherIdct(block + (1 * dataSizeBytes), decoded.mCb);
+                for (int i = 0; i < 4; i++)
+                {
+                    kernels.mMasherIdct(block + ((2 + i) * dataSizeBytes), decoded.mY[i]);
+                }
 
-                yoff += kMacroBlockHeight;
+                kernels.mMasherYCbCrToRgb(decoded, pixelBuffer, xoff, yBlock * kMacroBlockHeight, mVideoHeader.mWidth, mVideoHeader.mHeight);
             }
-            xoff += kMacroBlockWidth;
-        }
-
+        });
     }
 
-    AudioDecompressor::AudioDecompressor()
+    // Number of bits needed to hold each byte value, built once on first use. Movies decode on
+    // their own threads so this relies on function local statics being initialized thread safely.
+    static const std::array<u8, 256>& SoundTable()
     {
-        init_Snd_tbl();
+        static const std::array<u8, 256> table = []()
+        {
+            std::array<u8, 256> bits = {};
+            for (u32 index = 0; index < bits.size(); index++)
+            {
+                u8 tableValue = 0;
+                for (u32 i = index; i > 0; i >>= 1)
+                {
+                    tableValue++;
+                }
+                bits[index] = tableValue;
+            }
+            return bits;
+        }();
+        return table;
     }
 
     /*static*/ s32 AudioDecompressor::GetSoundTableValue(s16 tblIndex)
     {
+        const std::array<u8, 256>& soundTable = SoundTable();
         const s32 positiveTblIdx = static_cast<s32>(abs(tblIndex));
         const u32 shiftedIdx = (positiveTblIdx >> 7) & 0xFF;
-        s32 result = (u16)((s16)gSndTbl_byte_62EEB0[shiftedIdx] << 7) | (u16)(positiveTblIdx >> gSndTbl_byte_62EEB0[shiftedIdx]);
+        s32 result = (u16)((s16)soundTable[shiftedIdx] << 7) | (u16)(positiveTblIdx >> soundTable[shiftedIdx]);
         if (tblIndex < 0)
         {
             result = -result;
@@ -935,28 +802,6 @@ namespace Oddlib
         return mAudioFrameSizeBytes;
     }
 
-    /*static*/ void AudioDecompressor::init_Snd_tbl()
-    {
-        static bool done = false;
-        if (!done)
-        {
-            done = true;
-            int index = 0;
-            do
-            {
-                int tableValue = 0;
-                for (int i = index; i > 0; ++tableValue)
-                {
-                    i >>= 1;
-                }
-                gSndTbl_byte_62EEB0[index++] = static_cast<u8>(tableValue);
-            } while (index < 256);
-        }
-    }
-
-
-    /*static*/ u8 AudioDecompressor::gSndTbl_byte_62EEB0[256];
-
     void Masher::decode_audio_frame(u16 *rawFrameBuffer, u16 *outPtr, signed int numSamplesPerFrame)
     {
         AudioDecompressor decompressor;
@@ -988,6 +833,17 @@ namespace Oddlib
         }
     }
 
+    u32 Masher::Seek(u32 frame)
+    {
+        // Every video frame is decoded without reference to any other frame, and each audio frame
+        // uses a new AudioDecompressor, so decoding can restart from any frame and not just on
+        // mKeyFrameRate boundaries
+        frame = std::min(frame, mFileHeader.mNumberOfFrames);
+        mStream->Seek(mFrameOffsets[frame]);
+        mCurrentFrame = frame;
+        return frame;
+    }
+
     bool Masher::Update(u32* pixelBuffer, u8* audioBuffer)
     {
         if (mCurrentFrame < mFileHeader.mNumberOfFrames)
@@ -0,0 +1,710 @@
+#include "oddlib/video_kernels.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ODDLIB_VIDEO_KERNELS_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC allows AVX2 intrinsics in any function
+#define ODDLIB_TARGET_AVX2
+#else
+#define ODDLIB_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace Oddlib
+{
+    // Masher IDCT fixed point constants
+    constexpr s32 kMasherPass1Shift = 11;
+    constexpr s32 kMasherPass2Shift = 18;
+
+    // PSX MDEC IDCT fixed point constants
+    constexpr s32 kPsxIdctConstBits = 8;
+    constexpr s32 kPsxIdctPass2Shift = 5;
+    constexpr s32 kPsxIdctFix_1_082392200 = 277;
+    constexpr s32 kPsxIdctFix_1_414213562 = 362;
+    constexpr s32 kPsxIdctFix_1_847759065 = 473;
+    constexpr s32 kPsxIdctFix_2_613125930 = 669;
+
+    // YCbCr to RGB in 16.16 fixed point
+    constexpr s32 kColourBits = 16;
+    constexpr s32 kCbToRed = 91881;     // 1.402
+    constexpr s32 kCrToGreen = 22525;   // 0.3437
+    constexpr s32 kCbToGreen = 46812;   // 0.7143
+    constexpr s32 kCrToBlue = 116130;   // 1.772
+
+    constexpr s32 kMacroBlockSize = 16;
+
+    // ---- Scalar reference ----
+
+    static void MasherHalfIdctScalar(const s32* pSource, s32* pDestination, int nPitch, int nIncrement, int nShift)
+    {
+        std::array<s32, 8> pTemp;
+
+        size_t sourceIdx = 0;
+        size_t destinationIdx = 0;
+
+        for (int i = 0; i < 8; i++)
+        {
+            pTemp[4] = pSource[(0 * nPitch) + sourceIdx] * 8192 + pSource[(2 * nPitch) + sourceIdx] * 10703 + pSource[(4 * nPitch) + sourceIdx] * 8192 + pSource[(6 * nPitch) + sourceIdx] * 4433;
+            pTemp[5] = pSource[(0 * nPitch) + sourceIdx] * 8192 + pSource[(2 * nPitch) + sourceIdx] * 4433 - pSource[(4 * nPitch) + sourceIdx] * 8192 - pSource[(6 * nPitch) + sourceIdx] * 10704;
+            pTemp[6] = pSource[(0 * nPitch) + sourceIdx] * 8192 - pSource[(2 * nPitch) + sourceIdx] * 4433 - pSource[(4 * nPitch) + sourceIdx] * 8192 + pSource[(6 * nPitch) + sourceIdx] * 10704;
+            pTemp[7] = pSource[(0 * nPitch) + sourceIdx] * 8192 - pSource[(2 * nPitch) + sourceIdx] * 10703 + pSource[(4 * nPitch) + sourceIdx] * 8192 - pSource[(6 * nPitch) + sourceIdx] * 4433;
+
+            pTemp[0] = pSource[(1 * nPitch) + sourceIdx] * 11363 + pSource[(3 * nPitch) + sourceIdx] * 9633 + pSource[(5 * nPitch) + sourceIdx] * 6437 + pSource[(7 * nPitch) + sourceIdx] * 2260;
+            pTemp[1] = pSource[(1 * nPitch) + sourceIdx] * 9633 - pSource[(3 * nPitch) + sourceIdx] * 2259 - pSource[(5 * nPitch) + sourceIdx] * 11362 - pSource[(7 * nPitch) + sourceIdx] * 6436;
+            pTemp[2] = pSource[(1 * nPitch) + sourceIdx] * 6437 - pSource[(3 * nPitch) + sourceIdx] * 11362 + pSource[(5 * nPitch) + sourceIdx] * 2261 + pSource[(7 * nPitch) + sourceIdx] * 9633;
+            pTemp[3] = pSource[(1 * nPitch) + sourceIdx] * 2260 - pSource[(3 * nPitch) + sourceIdx] * 6436 + pSource[(5 * nPitch) + sourceIdx] * 9633 - pSource[(7 * nPitch) + sourceIdx] * 11363;
+
+            pDestination[(0 * nPitch) + destinationIdx] = (pTemp[4] + pTemp[0]) >> nShift;
+            pDestination[(1 * nPitch) + destinationIdx] = (pTemp[5] + pTemp[1]) >> nShift;
+            pDestination[(2 * nPitch) + destinationIdx] = (pTemp[6] + pTemp[2]) >> nShift;
+            pDestination[(3 * nPitch) + destinationIdx] = (pTemp[7] + pTemp[3]) >> nShift;
+            pDestination[(4 * nPitch) + destinationIdx] = (pTemp[7] - pTemp[3]) >> nShift;
+            pDestination[(5 * nPitch) + destinationIdx] = (pTemp[6] - pTemp[2]) >> nShift;
+            pDestination[(6 * nPitch) + destinationIdx] = (pTemp[5] - pTemp[1]) >> nShift;
+            pDestination[(7 * nPitch) + destinationIdx] = (pTemp[4] - pTemp[0]) >> nShift;
+
+            sourceIdx += nIncrement;
+            destinationIdx += nIncrement;
+        }
+    }
+
+    // 0x40ED90
+    static void MasherIdctScalar(const s16* input, s32* output)
+    {
+        std::array<s32, 64> pTemp;
+        std::array<s32, 64> pExtendedSource;
+
+        // Source is passed as signed 16 bits stored every 32 bits
+        // We sign extend it at the beginning like Masher does
+        for (int i = 0; i < 64; i++)
+        {
+            pExtendedSource[i] = input[i * 2];
+        }
+
+        MasherHalfIdctScalar(pExtendedSource.data(), pTemp.data(), 8, 1, kMasherPass1Shift);
+        MasherHalfIdctScalar(pTemp.data(), output, 1, 8, kMasherPass2Shift);
+    }
+
+    static void PsxIdctScalar(s16* block)
+    {
+        const int DCT_SIZE = 8;
+
+        s16 *ptr = block;
+        s16 tmp0, tmp1, tmp2, tmp3, tmp4, tmp5, tmp6, tmp7;
+        s16 z5, z10, z11, z12, z13;
+        for (u8 i = 0; i < DCT_SIZE; i++, ptr++)
+        {
+            if ((ptr[DCT_SIZE * 1] | ptr[DCT_SIZE * 2] | ptr[DCT_SIZE * 3] |
+                ptr[DCT_SIZE * 4] | ptr[DCT_SIZE * 5] | ptr[DCT_SIZE * 6] |
+                ptr[DCT_SIZE * 7]) == 0)
+            {
+                ptr[DCT_SIZE * 0] = ptr[DCT_SIZE * 1] = ptr[DCT_SIZE * 2] =
+                    ptr[DCT_SIZE * 3] = ptr[DCT_SIZE * 4] = ptr[DCT_SIZE * 5] =
+                    ptr[DCT_SIZE * 6] = ptr[DCT_SIZE * 7] = ptr[DCT_SIZE * 0];
+
+                continue;
+            }
+
+            z10 = ptr[DCT_SIZE * 0] + ptr[DCT_SIZE * 4];
+            z11 = ptr[DCT_SIZE * 0] - ptr[DCT_SIZE * 4];
+            z13 = ptr[DCT_SIZE * 2] + ptr[DCT_SIZE * 6];
+            z12 = (((ptr[DCT_SIZE * 2] - ptr[DCT_SIZE * 6]) * kPsxIdctFix_1_414213562)
+                >> kPsxIdctConstBits) - z13;
+
+            tmp0 = z10 + z13;
+            tmp3 = z10 - z13;
+            tmp1 = z11 + z12;
+            tmp2 = z11 - z12;
+
+            z13 = ptr[DCT_SIZE * 3] + ptr[DCT_SIZE * 5];
+            z10 = ptr[DCT_SIZE * 3] - ptr[DCT_SIZE * 5];
+            z11 = ptr[DCT_SIZE * 1] + ptr[DCT_SIZE * 7];
+            z12 = ptr[DCT_SIZE * 1] - ptr[DCT_SIZE * 7];
+
+            z5 = (((z12 - z10) * kPsxIdctFix_1_847759065) >> kPsxIdctConstBits);
+            tmp7 = z11 + z13;
+            tmp6 = ((z10 * kPsxIdctFix_2_613125930) >> kPsxIdctConstBits) + z5 - tmp7;
+            tmp5 = (((z11 - z13) * kPsxIdctFix_1_414213562) >> kPsxIdctConstBits) - tmp6;
+            tmp4 = ((z12 * kPsxIdctFix_1_082392200) >> kPsxIdctConstBits) - z5 + tmp5;
+
+            ptr[DCT_SIZE * 0] = (tmp0 + tmp7);
+            ptr[DCT_SIZE * 7] = (tmp0 - tmp7);
+            ptr[DCT_SIZE * 1] = (tmp1 + tmp6);
+            ptr[DCT_SIZE * 6] = (tmp1 - tmp6);
+            ptr[DCT_SIZE * 2] = (tmp2 + tmp5);
+            ptr[DCT_SIZE * 5] = (tmp2 - tmp5);
+            ptr[DCT_SIZE * 4] = (tmp3 + tmp4);
+            ptr[DCT_SIZE * 3] = (tmp3 - tmp4);
+        }
+
+        ptr = block;
+        for (u8 i = 0; i < DCT_SIZE; i++, ptr += DCT_SIZE)
+        {
+            if ((ptr[1] | ptr[2] | ptr[3] | ptr[4] | ptr[5] | ptr[6] | ptr[7]) == 0)
+            {
+                ptr[0] = ptr[1] = ptr[2] = ptr[3] = ptr[4] = ptr[5] = ptr[6] =
+                    ptr[7] = (ptr[0] >> kPsxIdctPass2Shift);
+
+                continue;
+            }
+
+            z10 = ptr[0] + ptr[4];
+            z11 = ptr[0] - ptr[4];
+            z13 = ptr[2] + ptr[6];
+            z12 = (((ptr[2] - ptr[6]) * kPsxIdctFix_1_414213562) >> kPsxIdctConstBits) -
+                z13;
+
+            tmp0 = z10 + z13;
+            tmp3 = z10 - z13;
+            tmp1 = z11 + z12;
+            tmp2 = z11 - z12;
+
+            z13 = ptr[3] + ptr[5];
+            z10 = ptr[3] - ptr[5];
+            z11 = ptr[1] + ptr[7];
+            z12 = ptr[1] - ptr[7];
+
+            z5 = (((z12 - z10) * kPsxIdctFix_1_847759065) >> kPsxIdctConstBits);
+            tmp7 = z11 + z13;
+            tmp6 = ((z10 * kPsxIdctFix_2_613125930) >> kPsxIdctConstBits) + z5 - tmp7;
+            tmp5 = (((z11 - z13) * kPsxIdctFix_1_414213562) >> kPsxIdctConstBits) - tmp6;
+            tmp4 = ((z12 * kPsxIdctFix_1_082392200) >> kPsxIdctConstBits) - z5 + tmp5;
+
+            ptr[0] = (tmp0 + tmp7) >> kPsxIdctPass2Shift;
+            ptr[7] = (tmp0 - tmp7) >> kPsxIdctPass2Shift;
+            ptr[1] = (tmp1 + tmp6) >> kPsxIdctPass2Shift;
+            ptr[6] = (tmp1 - tmp6) >> kPsxIdctPass2Shift;
+            ptr[2] = (tmp2 + tmp5) >> kPsxIdctPass2Shift;
+            ptr[5] = (tmp2 - tmp5) >> kPsxIdctPass2Shift;
+            ptr[4] = (tmp3 + tmp4) >> kPsxIdctPass2Shift;
+            ptr[3] = (tmp3 - tmp4) >> kPsxIdctPass2Shift;
+        }
+    }
+
+    static u8 ClampToByte(s32 v)
+    {
+        return static_cast<u8>(std::min(std::max(v, 0), 255));
+    }
+
+    static void MasherYCbCrToRgbScalar(const MasherMacroBlock& block, u32* pixels, s32 xoff, s32 yoff, s32 width, s32 height)
+    {
+        const s32 visibleWidth = std::min(kMacroBlockSize, width - xoff);
+        const s32 visibleHeight = std::min(kMacroBlockSize, height - yoff);
+        for (s32 y = 0; y < visibleHeight; y++)
+        {
+            u32* row = pixels + ((yoff + y) * width) + xoff;
+            for (s32 x = 0; x < visibleWidth; x++)
+            {
+                const s32 luma = block.mY[((y / 8) * 2) + (x / 8)][((y % 8) * 8) + (x % 8)];
+                const s32 cb = block.mCb[((y / 2) * 8) + (x / 2)];
+                const s32 cr = block.mCr[((y / 2) * 8) + (x / 2)];
+
+                const s32 r = luma + ((cb * kCbToRed) >> kColourBits);
+                const s32 g = luma + ((-(cr * kCrToGreen) - (cb * kCbToGreen)) >> kColourBits);
+                const s32 b = luma + ((cr * kCrToBlue) >> kColourBits);
+
+                // Actually is no alpha in FMVs
+                row[x] = (ClampToByte(b) << 16) | (ClampToByte(g) << 8) | ClampToByte(r);
+            }
+        }
+    }
+
+    static const VideoKernels kScalarKernels =
+    {
+        "Scalar",
+        MasherIdctScalar,
+        PsxIdctScalar,
+        MasherYCbCrToRgbScalar
+    };
+
+    const VideoKernels& ScalarVideoKernels()
+    {
+        return kScalarKernels;
+    }
+
+#ifdef ODDLIB_VIDEO_KERNELS_X86
+
+    // ---- SSE2 ----
+
+    // SSE2 has no 32 bit multiply that keeps the low half, so do the odd and even lanes separately
+    static inline __m128i MulSse2(__m128i a, s32 constant)
+    {
+        const __m128i b = _mm_set1_epi32(constant);
+        const __m128i even = _mm_mul_epu32(a, b);
+        const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), b);
+        return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+    }
+
+    static inline __m128i SignExtend16Sse2(__m128i v)
+    {
+        return _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+    }
+
+    static inline void Transpose4x4Sse2(__m128i& a, __m128i& b, __m128i& c, __m128i& d)
+    {
+        const __m128i t0 = _mm_unpacklo_epi32(a, b);
+        const __m128i t1 = _mm_unpacklo_epi32(c, d);
+        const __m128i t2 = _mm_unpackhi_epi32(a, b);
+        const __m128i t3 = _mm_unpackhi_epi32(c, d);
+        a = _mm_unpacklo_epi64(t0, t1);
+        b = _mm_unpackhi_epi64(t0, t1);
+        c = _mm_unpacklo_epi64(t2, t3);
+        d = _mm_unpackhi_epi64(t2, t3);
+    }
+
+    // Rows are split in to columns 0-3 and 4-7
+    static inline void Transpose8x8Sse2(__m128i* lo, __m128i* hi)
+    {
+        Transpose4x4Sse2(lo[0], lo[1], lo[2], lo[3]);
+        Transpose4x4Sse2(hi[0], hi[1], hi[2], hi[3]);
+        Transpose4x4Sse2(lo[4], lo[5], lo[6], lo[7]);
+        Transpose4x4Sse2(hi[4], hi[5], hi[6], hi[7]);
+
+        // Swap the top right and bottom left 4x4 tiles
+        for (int i = 0; i < 4; i++)
+        {
+            std::swap(hi[i], lo[i + 4]);
+        }
+    }
+
+    // One 1D Masher IDCT of 4 columns at a time, v holds the 8 rows
+    static inline void MasherColumnPassSse2(__m128i* v, __m128i shift)
+    {
+        const __m128i s0 = _mm_slli_epi32(v[0], 13); // * 8192
+        const __m128i s4 = _mm_slli_epi32(v[4], 13);
+
+        const __m128i t4 = _mm_add_epi32(_mm_add_epi32(s0, MulSse2(v[2], 10703)), _mm_add_epi32(s4, MulSse2(v[6], 4433)));
+        const __m128i t5 = _mm_sub_epi32(_mm_sub_epi32(_mm_add_epi32(s0, MulSse2(v[2], 4433)), s4), MulSse2(v[6], 10704));
+        const __m128i t6 = _mm_add_epi32(_mm_sub_epi32(_mm_sub_epi32(s0, MulSse2(v[2], 4433)), s4), MulSse2(v[6], 10704));
+        const __m128i t7 = _mm_sub_epi32(_mm_add_epi32(_mm_sub_epi32(s0, MulSse2(v[2], 10703)), s4), MulSse2(v[6], 4433));
+
+        const __m128i t0 = _mm_add_epi32(_mm_add_epi32(MulSse2(v[1], 11363), MulSse2(v[3], 9633)), _mm_add_epi32(MulSse2(v[5], 6437), MulSse2(v[7], 2260)));
+        const __m128i t1 = _mm_sub_epi32(_mm_sub_epi32(_mm_sub_epi32(MulSse2(v[1], 9633), MulSse2(v[3], 2259)), MulSse2(v[5], 11362)), MulSse2(v[7], 6436));
+        const __m128i t2 = _mm_add_epi32(_mm_add_epi32(_mm_sub_epi32(MulSse2(v[1], 6437), MulSse2(v[3], 11362)), MulSse2(v[5], 2261)), MulSse2(v[7], 9633));
+        const __m128i t3 = _mm_sub_epi32(_mm_add_epi32(_mm_sub_epi32(MulSse2(v[1], 2260), MulSse2(v[3], 6436)), MulSse2(v[5], 9633)), MulSse2(v[7], 11363));
+
+        v[0] = _mm_sra_epi32(_mm_add_epi32(t4, t0), shift);
+        v[1] = _mm_sra_epi32(_mm_add_epi32(t5, t1), shift);
+        v[2] = _mm_sra_epi32(_mm_add_epi32(t6, t2), shift);
+        v[3] = _mm_sra_epi32(_mm_add_epi32(t7, t3), shift);
+        v[4] = _mm_sra_epi32(_mm_sub_epi32(t7, t3), shift);
+        v[5] = _mm_sra_epi32(_mm_sub_epi32(t6, t2), shift);
+        v[6] = _mm_sra_epi32(_mm_sub_epi32(t5, t1), shift);
+        v[7] = _mm_sra_epi32(_mm_sub_epi32(t4, t0), shift);
+    }
+
+    static void MasherIdctSse2(const s16* input, s32* output)
+    {
+        __m128i lo[8];
+        __m128i hi[8];
+        for (int row = 0; row < 8; row++)
+        {
+            lo[row] = SignExtend16Sse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + (row * 16))));
+            hi[row] = SignExtend16Sse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + (row * 16) + 8)));
+        }
+
+        const __m128i pass1Shift = _mm_cvtsi32_si128(kMasherPass1Shift);
+        MasherColumnPassSse2(lo, pass1Shift);
+        MasherColumnPassSse2(hi, pass1Shift);
+
+        // The second pass is over rows
+        Transpose8x8Sse2(lo, hi);
+        const __m128i pass2Shift = _mm_cvtsi32_si128(kMasherPass2Shift);
+        MasherColumnPassSse2(lo, pass2Shift);
+        MasherColumnPassSse2(hi, pass2Shift);
+        Transpose8x8Sse2(lo, hi);
+
+        for (int row = 0; row < 8; row++)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + (row * 8)), lo[row]);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + (row * 8) + 4), hi[row]);
+        }
+    }
+
+    static inline __m128i MulShiftSse2(__m128i a, s32 constant)
+    {
+        return _mm_srai_epi32(MulSse2(a, constant), kPsxIdctConstBits);
+    }
+
+    // One 1D PSX IDCT of 4 columns at a time. The scalar version stores every temporary in
+    // an s16, so each one is truncated back to 16 bits here too.
+    static inline void PsxColumnPassSse2(__m128i* p, __m128i shift)
+    {
+        __m128i z10 = SignExtend16Sse2(_mm_add_epi32(p[0], p[4]));
+        __m128i z11 = SignExtend16Sse2(_mm_sub_epi32(p[0], p[4]));
+        __m128i z13 = SignExtend16Sse2(_mm_add_epi32(p[2], p[6]));
+        __m128i z12 = SignExtend16Sse2(_mm_sub_epi32(MulShiftSse2(_mm_sub_epi32(p[2], p[6]), kPsxIdctFix_1_414213562), z13));
+
+        const __m128i tmp0 = SignExtend16Sse2(_mm_add_epi32(z10, z13));
+        const __m128i tmp3 = SignExtend16Sse2(_mm_sub_epi32(z10, z13));
+        const __m128i tmp1 = SignExtend16Sse2(_mm_add_epi32(z11, z12));
+        const __m128i tmp2 = SignExtend16Sse2(_mm_sub_epi32(z11, z12));
+
+        z13 = SignExtend16Sse2(_mm_add_epi32(p[3], p[5]));
+        z10 = SignExtend16Sse2(_mm_sub_epi32(p[3], p[5]));
+        z11 = SignExtend16Sse2(_mm_add_epi32(p[1], p[7]));
+        z12 = SignExtend16Sse2(_mm_sub_epi32(p[1], p[7]));
+
+        const __m128i z5 = SignExtend16Sse2(MulShiftSse2(_mm_sub_epi32(z12, z10), kPsxIdctFix_1_847759065));
+        const __m128i tmp7 = SignExtend16Sse2(_mm_add_epi32(z11, z13));
+        const __m128i tmp6 = SignExtend16Sse2(_mm_sub_epi32(_mm_add_epi32(MulShiftSse2(z10, kPsxIdctFix_2_613125930), z5), tmp7));
+        const __m128i tmp5 = SignExtend16Sse2(_mm_sub_epi32(MulShiftSse2(_mm_sub_epi32(z11, z13), kPsxIdctFix_1_414213562), tmp6));
+        const __m128i tmp4 = SignExtend16Sse2(_mm_add_epi32(_mm_sub_epi32(MulShiftSse2(z12, kPsxIdctFix_1_082392200), z5), tmp5));
+
+        p[0] = SignExtend16Sse2(_mm_sra_epi32(_mm_add_epi32(tmp0, tmp7), shift));
+        p[7] = SignExtend16Sse2(_mm_sra_epi32(_mm_sub_epi32(tmp0, tmp7), shift));
+        p[1] = SignExtend16Sse2(_mm_sra_epi32(_mm_add_epi32(tmp1, tmp6), shift));
+        p[6] = SignExtend16Sse2(_mm_sra_epi32(_mm_sub_epi32(tmp1, tmp6), shift));
+        p[2] = SignExtend16Sse2(_mm_sra_epi32(_mm_add_epi32(tmp2, tmp5), shift));
+        p[5] = SignExtend16Sse2(_mm_sra_epi32(_mm_sub_epi32(tmp2, tmp5), shift));
+        p[4] = SignExtend16Sse2(_mm_sra_epi32(_mm_add_epi32(tmp3, tmp4), shift));
+        p[3] = SignExtend16Sse2(_mm_sra_epi32(_mm_sub_epi32(tmp3, tmp4), shift));
+    }
+
+    // The scalar version skips columns and rows that only have a DC value, the full
+    // calculation gives the same result for them so that isn't needed here.
+    static void PsxIdctSse2(s16* block)
+    {
+        __m128i lo[8];
+        __m128i hi[8];
+        for (int row = 0; row < 8; row++)
+        {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + (row * 8)));
+            lo[row] = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+            hi[row] = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        }
+
+        const __m128i noShift = _mm_cvtsi32_si128(0);
+        PsxColumnPassSse2(lo, noShift);
+        PsxColumnPassSse2(hi, noShift);
+
+        Transpose8x8Sse2(lo, hi);
+        const __m128i pass2Shift = _mm_cvtsi32_si128(kPsxIdctPass2Shift);
+        PsxColumnPassSse2(lo, pass2Shift);
+        PsxColumnPassSse2(hi, pass2Shift);
+        Transpose8x8Sse2(lo, hi);
+
+        // Everything is already within s16 range so the saturating pack is exact
+        for (int row = 0; row < 8; row++)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(block + (row * 8)), _mm_packs_epi32(lo[row], hi[row]));
+        }
+    }
+
+    // Chroma terms for 8 horizontally adjacent chroma samples, the lanes are in pixel order
+    struct ChromaTermsSse2
+    {
+        __m128i mRed[2];
+        __m128i mGreen[2];
+        __m128i mBlue[2];
+    };
+
+    static inline ChromaTermsSse2 CalcChromaTermsSse2(const s32* cb, const s32* cr)
+    {
+        ChromaTermsSse2 terms;
+        const __m128i colourShift = _mm_cvtsi32_si128(kColourBits);
+        for (int i = 0; i < 2; i++)
+        {
+            const __m128i vCb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cb + (i * 4)));
+            const __m128i vCr = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cr + (i * 4)));
+            terms.mRed[i] = _mm_sra_epi32(MulSse2(vCb, kCbToRed), colourShift);
+            terms.mGreen[i] = _mm_sra_epi32(_mm_sub_epi32(_mm_setzero_si128(), _mm_add_epi32(MulSse2(vCr, kCrToGreen), MulSse2(vCb, kCbToGreen))), colourShift);
+            terms.mBlue[i] = _mm_sra_epi32(MulSse2(vCr, kCrToBlue), colourShift);
+        }
+        return terms;
+    }
+
+    // Adds one chroma term per 2 pixels to 16 luma values and saturates to bytes
+    static inline __m128i ChannelRowSse2(const __m128i* luma, const __m128i* chroma)
+    {
+        const __m128i c0 = _mm_unpacklo_epi32(chroma[0], chroma[0]);
+        const __m128i c1 = _mm_unpackhi_epi32(chroma[0], chroma[0]);
+        const __m128i c2 = _mm_unpacklo_epi32(chroma[1], chroma[1]);
+        const __m128i c3 = _mm_unpackhi_epi32(chroma[1], chroma[1]);
+
+        const __m128i lo = _mm_packs_epi32(_mm_add_epi32(luma[0], c0), _mm_add_epi32(luma[1], c1));
+        const __m128i hi = _mm_packs_epi32(_mm_add_epi32(luma[2], c2), _mm_add_epi32(luma[3], c3));
+        return _mm_packus_epi16(lo, hi);
+    }
+
+    static void MasherYCbCrToRgbSse2(const MasherMacroBlock& block, u32* pixels, s32 xoff, s32 yoff, s32 width, s32 height)
+    {
+        const s32 visibleWidth = std::min(kMacroBlockSize, width - xoff);
+        const s32 visibleHeight = std::min(kMacroBlockSize, height - yoff);
+
+        ChromaTermsSse2 terms = {};
+        for (s32 y = 0; y < visibleHeight; y++)
+        {
+            if (y % 2 == 0)
+            {
+                terms = CalcChromaTermsSse2(&block.mCb[(y / 2) * 8], &block.mCr[(y / 2) * 8]);
+            }
+
+            const s32* left = &block.mY[(y / 8) * 2][(y % 8) * 8];
+            const s32* right = &block.mY[((y / 8) * 2) + 1][(y % 8) * 8];
+            const __m128i luma[4] =
+            {
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(left)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(left + 4)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(right)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(right + 4))
+            };
+
+            const __m128i r = ChannelRowSse2(luma, terms.mRed);
+            const __m128i g = ChannelRowSse2(luma, terms.mGreen);
+            const __m128i b = ChannelRowSse2(luma, terms.mBlue);
+
+            // Interleave to R, G, B, 0 bytes
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i rgLo = _mm_unpacklo_epi8(r, g);
+            const __m128i rgHi = _mm_unpackhi_epi8(r, g);
+            const __m128i b0Lo = _mm_unpacklo_epi8(b, zero);
+            const __m128i b0Hi = _mm_unpackhi_epi8(b, zero);
+
+            u32* row = pixels + ((yoff + y) * width) + xoff;
+            if (visibleWidth == kMacroBlockSize)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(row), _mm_unpacklo_epi16(rgLo, b0Lo));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(row + 4), _mm_unpackhi_epi16(rgLo, b0Lo));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(row + 8), _mm_unpacklo_epi16(rgHi, b0Hi));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(row + 12), _mm_unpackhi_epi16(rgHi, b0Hi));
+            }
+            else
+            {
+                // Macroblock padding on the right edge of the frame
+                u32 temp[kMacroBlockSize];
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(temp), _mm_unpacklo_epi16(rgLo, b0Lo));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(temp + 4), _mm_unpackhi_epi16(rgLo, b0Lo));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(temp + 8), _mm_unpacklo_epi16(rgHi, b0Hi));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(temp + 12), _mm_unpackhi_epi16(rgHi, b0Hi));
+                memcpy(row, temp, visibleWidth * sizeof(u32));
+            }
+        }
+    }
+
+    static const VideoKernels kSse2Kernels =
+    {
+        "SSE2",
+        MasherIdctSse2,
+        PsxIdctSse2,
+        MasherYCbCrToRgbSse2
+    };
+
+    // ---- AVX2, a whole 8 wide row fits in one register ----
+
+    ODDLIB_TARGET_AVX2 static inline __m256i MulAvx2(__m256i a, s32 constant)
+    {
+        return _mm256_mullo_epi32(a, _mm256_set1_epi32(constant));
+    }
+
+    ODDLIB_TARGET_AVX2 static inline __m256i SignExtend16Avx2(__m256i v)
+    {
+        return _mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16);
+    }
+
+    ODDLIB_TARGET_AVX2 static inline void Transpose8x8Avx2(__m256i* r)
+    {
+        const __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+        const __m256i t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+        const __m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+        const __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+        const __m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+        const __m256i t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+        const __m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+        const __m256i t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+
+        const __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+        const __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+        const __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+        const __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+        const __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+        const __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+        const __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+        const __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+        r[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+        r[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+        r[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+        r[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+        r[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+        r[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+        r[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+        r[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+    }
+
+    ODDLIB_TARGET_AVX2 static inline void MasherColumnPassAvx2(__m256i* v, __m128i shift)
+    {
+        const __m256i s0 = _mm256_slli_epi32(v[0], 13); // * 8192
+        const __m256i s4 = _mm256_slli_epi32(v[4], 13);
+
+        const __m256i t4 = _mm256_add_epi32(_mm256_add_epi32(s0, MulAvx2(v[2], 10703)), _mm256_add_epi32(s4, MulAvx2(v[6], 4433)));
+        const __m256i t5 = _mm256_sub_epi32(_mm256_sub_epi32(_mm256_add_epi32(s0, MulAvx2(v[2], 4433)), s4), MulAvx2(v[6], 10704));
+        const __m256i t6 = _mm256_add_epi32(_mm256_sub_epi32(_mm256_sub_epi32(s0, MulAvx2(v[2], 4433)), s4), MulAvx2(v[6], 10704));
+        const __m256i t7 = _mm256_sub_epi32(_mm256_add_epi32(_mm256_sub_epi32(s0, MulAvx2(v[2], 10703)), s4), MulAvx2(v[6], 4433));
+
+        const __m256i t0 = _mm256_add_epi32(_mm256_add_epi32(MulAvx2(v[1], 11363), MulAvx2(v[3], 9633)), _mm256_add_epi32(MulAvx2(v[5], 6437), MulAvx2(v[7], 2260)));
+        const __m256i t1 = _mm256_sub_epi32(_mm256_sub_epi32(_mm256_sub_epi32(MulAvx2(v[1], 9633), MulAvx2(v[3], 2259)), MulAvx2(v[5], 11362)), MulAvx2(v[7], 6436));
+        const __m256i t2 = _mm256_add_epi32(_mm256_add_epi32(_mm256_sub_epi32(MulAvx2(v[1], 6437), MulAvx2(v[3], 11362)), MulAvx2(v[5], 2261)), MulAvx2(v[7], 9633));
+        const __m256i t3 = _mm256_sub_epi32(_mm256_add_epi32(_mm256_sub_epi32(MulAvx2(v[1], 2260), MulAvx2(v[3], 6436)), MulAvx2(v[5], 9633)), MulAvx2(v[7], 11363));
+
+        v[0] = _mm256_sra_epi32(_mm256_add_epi32(t4, t0), shift);
+        v[1] = _mm256_sra_epi32(_mm256_add_epi32(t5, t1), shift);
+        v[2] = _mm256_sra_epi32(_mm256_add_epi32(t6, t2), shift);
+        v[3] = _mm256_sra_epi32(_mm256_add_epi32(t7, t3), shift);
+        v[4] = _mm256_sra_epi32(_mm256_sub_epi32(t7, t3), shift);
+        v[5] = _mm256_sra_epi32(_mm256_sub_epi32(t6, t2), shift);
+        v[6] = _mm256_sra_epi32(_mm256_sub_epi32(t5, t1), shift);
+        v[7] = _mm256_sra_epi32(_mm256_sub_epi32(t4, t0), shift);
+    }
+
+    ODDLIB_TARGET_AVX2 static void MasherIdctAvx2(const s16* input, s32* output)
+    {
+        __m256i rows[8];
+        for (int row = 0; row < 8; row++)
+        {
+            rows[row] = SignExtend16Avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + (row * 16))));
+        }
+
+        MasherColumnPassAvx2(rows, _mm_cvtsi32_si128(kMasherPass1Shift));
+        Transpose8x8Avx2(rows);
+        MasherColumnPassAvx2(rows, _mm_cvtsi32_si128(kMasherPass2Shift));
+        Transpose8x8Avx2(rows);
+
+        for (int row = 0; row < 8; row++)
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + (row * 8)), rows[row]);
+        }
+    }
+
+    ODDLIB_TARGET_AVX2 static inline __m256i MulShiftAvx2(__m256i a, s32 constant)
+    {
+        return _mm256_srai_epi32(MulAvx2(a, constant), kPsxIdctConstBits);
+    }
+
+    ODDLIB_TARGET_AVX2 static inline void PsxColumnPassAvx2(__m256i* p, __m128i shift)
+    {
+        __m256i z10 = SignExtend16Avx2(_mm256_add_epi32(p[0], p[4]));
+        __m256i z11 = SignExtend16Avx2(_mm256_sub_epi32(p[0], p[4]));
+        __m256i z13 = SignExtend16Avx2(_mm256_add_epi32(p[2], p[6]));
+        __m256i z12 = SignExtend16Avx2(_mm256_sub_epi32(MulShiftAvx2(_mm256_sub_epi32(p[2], p[6]), kPsxIdctFix_1_414213562), z13));
+
+        const __m256i tmp0 = SignExtend16Avx2(_mm256_add_epi32(z10, z13));
+        const __m256i tmp3 = SignExtend16Avx2(_mm256_sub_epi32(z10, z13));
+        const __m256i tmp1 = SignExtend16Avx2(_mm256_add_epi32(z11, z12));
+        const __m256i tmp2 = SignExtend16Avx2(_mm256_sub_epi32(z11, z12));
+
+        z13 = SignExtend16Avx2(_mm256_add_epi32(p[3], p[5]));
+        z10 = SignExtend16Avx2(_mm256_sub_epi32(p[3], p[5]));
+        z11 = SignExtend16Avx2(_mm256_add_epi32(p[1], p[7]));
+        z12 = SignExtend16Avx2(_mm256_sub_epi32(p[1], p[7]));
+
+        const __m256i z5 = SignExtend16Avx2(MulShiftAvx2(_mm256_sub_epi32(z12, z10), kPsxIdctFix_1_847759065));
+        const __m256i tmp7 = SignExtend16Avx2(_mm256_add_epi32(z11, z13));
+        const __m256i tmp6 = SignExtend16Avx2(_mm256_sub_epi32(_mm256_add_epi32(MulShiftAvx2(z10, kPsxIdctFix_2_613125930), z5), tmp7));
+        const __m256i tmp5 = SignExtend16Avx2(_mm256_sub_epi32(MulShiftAvx2(_mm256_sub_epi32(z11, z13), kPsxIdctFix_1_414213562), tmp6));
+        const __m256i tmp4 = SignExtend16Avx2(_mm256_add_epi32(_mm256_sub_epi32(MulShiftAvx2(z12, kPsxIdctFix_1_082392200), z5), tmp5));
+
+        p[0] = SignExtend16Avx2(_mm256_sra_epi32(_mm256_add_epi32(tmp0, tmp7), shift));
+        p[7] = SignExtend16Avx2(_mm256_sra_epi32(_mm256_sub_epi32(tmp0, tmp7), shift));
+        p[1] = SignExtend16Avx2(_mm256_sra_epi32(_mm256_add_epi32(tmp1, tmp6), shift));
+        p[6] = SignExtend16Avx2(_mm256_sra_epi32(_mm256_sub_epi32(tmp1, tmp6), shift));
+        p[2] = SignExtend16Avx2(_mm256_sra_epi32(_mm256_add_epi32(tmp2, tmp5), shift));
+        p[5] = SignExtend16Avx2(_mm256_sra_epi32(_mm256_sub_epi32(tmp2, tmp5), shift));
+        p[4] = SignExtend16Avx2(_mm256_sra_epi32(_mm256_add_epi32(tmp3, tmp4), shift));
+        p[3] = SignExtend16Avx2(_mm256_sra_epi32(_mm256_sub_epi32(tmp3, tmp4), shift));
+    }
+
+    ODDLIB_TARGET_AVX2 static void PsxIdctAvx2(s16* block)
+    {
+        __m256i rows[8];
+        for (int row = 0; row < 8; row++)
+        {
+            rows[row] = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + (row * 8))));
+        }
+
+        PsxColumnPassAvx2(rows, _mm_cvtsi32_si128(0));
+        Transpose8x8Avx2(rows);
+        PsxColumnPassAvx2(rows, _mm_cvtsi32_si128(kPsxIdctPass2Shift));
+        Transpose8x8Avx2(rows);
+
+        for (int row = 0; row < 8; row++)
+        {
+            const __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(rows[row]), _mm256_extracti128_si256(rows[row], 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(block + (row * 8)), packed);
+        }
+    }
+
+    // The colour conversion is bound by the byte packing which AVX2 doesn't help much with
+    static const VideoKernels kAvx2Kernels =
+    {
+        "AVX2",
+        MasherIdctAvx2,
+        PsxIdctAvx2,
+        MasherYCbCrToRgbSse2
+    };
+
+    static bool CpuSupportsAvx2()
+    {
+#ifdef _MSC_VER
+        int info[4] = {};
+        __cpuid(info, 0);
+        if (info[0] < 7)
+        {
+            return false;
+        }
+
+        // The OS must also save the AVX registers
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+        {
+            return false;
+        }
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+#endif
+    }
+
+    const VideoKernels* Sse2VideoKernels()
+    {
+        // Part of the x64 base line
+        return &kSse2Kernels;
+    }
+
+    const VideoKernels* Avx2VideoKernels()
+    {
+        static const bool supported = CpuSupportsAvx2();
+        return supported ? &kAvx2Kernels : nullptr;
+    }
+
+#else
+
+    const VideoKernels* Sse2VideoKernels()
+    {
+        return nullptr;
+    }
+
+    const VideoKernels* Avx2VideoKernels()
+    {
+        return nullptr;
+    }
+
+#endif
+
+    const VideoKernels& BestVideoKernels()
+    {
+        static const VideoKernels& best = Avx2VideoKernels() ? *Avx2VideoKernels() : Sse2VideoKernels() ? *Sse2VideoKernels() : ScalarVideoKernels();
+        return best;
+    }
+}
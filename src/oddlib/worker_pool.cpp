@@ -0,0 +1,109 @@
+#include "oddlib/worker_pool.hpp"
+#include <algorithm>
+
+namespace Oddlib
+{
+    WorkerPool::WorkerPool(u32 numThreads)
+    {
+        for (u32 i = 0; i < numThreads; i++)
+        {
+            mThreads.emplace_back(std::thread(&WorkerPool::WorkerMain, this));
+        }
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mQuit = true;
+        }
+        mWorkCondition.notify_all();
+
+        for (std::thread& thread : mThreads)
+        {
+            thread.join();
+        }
+    }
+
+    void WorkerPool::For(u32 count, const std::function<void(u32)>& fn)
+    {
+        std::lock_guard<std::mutex> forLock(mForMutex);
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mFn = &fn;
+            mCount = count;
+            mNext = 0;
+            mBusyWorkers = static_cast<u32>(mThreads.size());
+            mGeneration++;
+        }
+        mWorkCondition.notify_all();
+
+        RunItems();
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        mDoneCondition.wait(lock, [this]() { return mBusyWorkers == 0; });
+        mFn = nullptr;
+    }
+
+    void WorkerPool::RunItems()
+    {
+        for (;;)
+        {
+            const u32 index = mNext++;
+            if (index >= mCount)
+            {
+                break;
+            }
+            (*mFn)(index);
+        }
+    }
+
+    void WorkerPool::WorkerMain()
+    {
+        u64 seenGeneration = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mWorkCondition.wait(lock, [&]() { return mQuit || mGeneration != seenGeneration; });
+                if (mQuit)
+                {
+                    return;
+                }
+                seenGeneration = mGeneration;
+            }
+
+            RunItems();
+
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mBusyWorkers--;
+            }
+            mDoneCondition.notify_one();
+        }
+    }
+
+    u32 DefaultWorkerThreadCount()
+    {
+        return std::max(std::thread::hardware_concurrency(), 1u) - 1;
+    }
+
+    WorkerPool& SharedWorkerPool()
+    {
+        static WorkerPool pool(DefaultWorkerThreadCount());
+        return pool;
+    }
+
+    static std::atomic<IParallelFor*> gSharedParallelFor{ nullptr };
+
+    IParallelFor& SharedParallelFor()
+    {
+        IParallelFor* parallelFor = gSharedParallelFor;
+        return parallelFor ? *parallelFor : SharedWorkerPool();
+    }
+
+    void SetSharedParallelFor(IParallelFor* parallelFor)
+    {
+        gSharedParallelFor = parallelFor;
+    }
+}
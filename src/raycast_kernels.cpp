@@ -0,0 +1,233 @@
+#include "raycast_kernels.hpp"
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RAYCAST_KERNELS_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC allows AVX intrinsics in any function
+#define RAYCAST_TARGET_AVX
+#else
+#define RAYCAST_TARGET_AVX __attribute__((target("avx")))
+#endif
+#endif
+
+// The maths and the order of every operation must stay the same in all kernels so that they give
+// the same results, it is the segment intersection test that RayCast has always used.
+static void IntersectScalar(const RayKernelRay& ray, const CollisionLineSoA& lines, u32 count, f32* distance, f32* hitX, f32* hitY)
+{
+    const f32 dx12 = ray.mToX - ray.mFromX;
+    const f32 dy12 = ray.mToY - ray.mFromY;
+    for (u32 i = 0; i < count; i++)
+    {
+        distance[i] = kRayMiss;
+        hitX[i] = 0.0f;
+        hitY[i] = 0.0f;
+        if (!(lines.mTypeBits[i] & ray.mTypeMask))
+        {
+            continue;
+        }
+
+        const f32 dx34 = lines.mP2X[i] - lines.mP1X[i];
+        const f32 dy34 = lines.mP2Y[i] - lines.mP1Y[i];
+
+        const f32 denominator = (dy12 * dx34) - (dx12 * dy34);
+        if (denominator == 0.0f)
+        {
+            continue;
+        }
+
+        const f32 t1 = (((ray.mFromX - lines.mP1X[i]) * dy34) + ((lines.mP1Y[i] - ray.mFromY) * dx34)) / denominator;
+        const f32 t2 = (((lines.mP1X[i] - ray.mFromX) * dy12) + ((ray.mFromY - lines.mP1Y[i]) * dx12)) / -denominator;
+
+        const f32 intersectionX = ray.mFromX + (dx12 * t1);
+        const f32 intersectionY = ray.mFromY + (dy12 * t1);
+        hitX[i] = intersectionX;
+        hitY[i] = intersectionY;
+
+        if (t1 >= 0.0f && t1 <= 1.0f && t2 >= 0.0f && t2 <= 1.0f)
+        {
+            // Same as glm::distance(glm::vec2(x), glm::vec2(y)) which is what the distance has always been
+            const f32 d = (ray.mFromX - intersectionX) - (ray.mFromY - intersectionY);
+            distance[i] = std::sqrt((d * d) + (d * d));
+        }
+    }
+}
+
+static const RayKernels kScalarRayKernels =
+{
+    "Scalar",
+    IntersectScalar
+};
+
+const RayKernels& ScalarRayKernels()
+{
+    return kScalarRayKernels;
+}
+
+#ifdef RAYCAST_KERNELS_X86
+
+// ---- SSE2, 4 lines at a time ----
+
+static inline __m128 TypeMatchSse2(const u32* typeBits, __m128i typeMask)
+{
+    const __m128i bits = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(typeBits)), typeMask);
+    return _mm_castsi128_ps(_mm_xor_si128(_mm_cmpeq_epi32(bits, _mm_setzero_si128()), _mm_set1_epi32(-1)));
+}
+
+static void IntersectSse2(const RayKernelRay& ray, const CollisionLineSoA& lines, u32 count, f32* distance, f32* hitX, f32* hitY)
+{
+    const __m128 fromX = _mm_set1_ps(ray.mFromX);
+    const __m128 fromY = _mm_set1_ps(ray.mFromY);
+    const __m128 dx12 = _mm_set1_ps(ray.mToX - ray.mFromX);
+    const __m128 dy12 = _mm_set1_ps(ray.mToY - ray.mFromY);
+    const __m128i typeMask = _mm_set1_epi32(static_cast<int>(ray.mTypeMask));
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    const __m128 miss = _mm_set1_ps(kRayMiss);
+
+    for (u32 i = 0; i < count; i += 4)
+    {
+        const __m128 p1x = _mm_loadu_ps(lines.mP1X + i);
+        const __m128 p1y = _mm_loadu_ps(lines.mP1Y + i);
+        const __m128 dx34 = _mm_sub_ps(_mm_loadu_ps(lines.mP2X + i), p1x);
+        const __m128 dy34 = _mm_sub_ps(_mm_loadu_ps(lines.mP2Y + i), p1y);
+
+        const __m128 denominator = _mm_sub_ps(_mm_mul_ps(dy12, dx34), _mm_mul_ps(dx12, dy34));
+        const __m128 t1 = _mm_div_ps(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(fromX, p1x), dy34), _mm_mul_ps(_mm_sub_ps(p1y, fromY), dx34)), denominator);
+        const __m128 t2 = _mm_div_ps(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(p1x, fromX), dy12), _mm_mul_ps(_mm_sub_ps(fromY, p1y), dx12)), _mm_xor_ps(denominator, signBit));
+
+        const __m128 intersectionX = _mm_add_ps(fromX, _mm_mul_ps(dx12, t1));
+        const __m128 intersectionY = _mm_add_ps(fromY, _mm_mul_ps(dy12, t1));
+
+        __m128 hit = TypeMatchSse2(lines.mTypeBits + i, typeMask);
+        hit = _mm_and_ps(hit, _mm_cmpneq_ps(denominator, zero));
+        hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(t1, zero), _mm_cmple_ps(t1, one)));
+        hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(t2, zero), _mm_cmple_ps(t2, one)));
+
+        const __m128 d = _mm_sub_ps(_mm_sub_ps(fromX, intersectionX), _mm_sub_ps(fromY, intersectionY));
+        const __m128 dist = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(d, d), _mm_mul_ps(d, d)));
+
+        // Lines the scalar version skips before working out the crossing point report 0, 0
+        const __m128 computed = _mm_and_ps(TypeMatchSse2(lines.mTypeBits + i, typeMask), _mm_cmpneq_ps(denominator, zero));
+        _mm_storeu_ps(distance + i, _mm_or_ps(_mm_and_ps(hit, dist), _mm_andnot_ps(hit, miss)));
+        _mm_storeu_ps(hitX + i, _mm_and_ps(computed, intersectionX));
+        _mm_storeu_ps(hitY + i, _mm_and_ps(computed, intersectionY));
+    }
+}
+
+static const RayKernels kSse2RayKernels =
+{
+    "SSE2",
+    IntersectSse2
+};
+
+// ---- AVX, 8 lines at a time ----
+
+// AVX has no 256 bit integer ops so the type test is done in halves. This must be compiled for AVX
+// too, calling SSE code from here would be slowed down by switching between SSE and AVX states.
+RAYCAST_TARGET_AVX static inline __m256 TypeMatchAvx(const u32* typeBits, __m128i typeMask)
+{
+    const __m128i allSet = _mm_set1_epi32(-1);
+    const __m128i lo = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(typeBits)), typeMask);
+    const __m128i hi = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(typeBits + 4)), typeMask);
+    const __m256i zeroLanes = _mm256_insertf128_si256(_mm256_castsi128_si256(_mm_cmpeq_epi32(lo, _mm_setzero_si128())), _mm_cmpeq_epi32(hi, _mm_setzero_si128()), 1);
+    return _mm256_xor_ps(_mm256_castsi256_ps(zeroLanes), _mm256_castsi256_ps(_mm256_insertf128_si256(_mm256_castsi128_si256(allSet), allSet, 1)));
+}
+
+RAYCAST_TARGET_AVX static void IntersectAvx(const RayKernelRay& ray, const CollisionLineSoA& lines, u32 count, f32* distance, f32* hitX, f32* hitY)
+{
+    const __m256 fromX = _mm256_set1_ps(ray.mFromX);
+    const __m256 fromY = _mm256_set1_ps(ray.mFromY);
+    const __m256 dx12 = _mm256_set1_ps(ray.mToX - ray.mFromX);
+    const __m256 dy12 = _mm256_set1_ps(ray.mToY - ray.mFromY);
+    const __m128i typeMask = _mm_set1_epi32(static_cast<int>(ray.mTypeMask));
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+    const __m256 miss = _mm256_set1_ps(kRayMiss);
+
+    for (u32 i = 0; i < count; i += 8)
+    {
+        const __m256 p1x = _mm256_loadu_ps(lines.mP1X + i);
+        const __m256 p1y = _mm256_loadu_ps(lines.mP1Y + i);
+        const __m256 dx34 = _mm256_sub_ps(_mm256_loadu_ps(lines.mP2X + i), p1x);
+        const __m256 dy34 = _mm256_sub_ps(_mm256_loadu_ps(lines.mP2Y + i), p1y);
+
+        const __m256 denominator = _mm256_sub_ps(_mm256_mul_ps(dy12, dx34), _mm256_mul_ps(dx12, dy34));
+        const __m256 t1 = _mm256_div_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(fromX, p1x), dy34), _mm256_mul_ps(_mm256_sub_ps(p1y, fromY), dx34)), denominator);
+        const __m256 t2 = _mm256_div_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(p1x, fromX), dy12), _mm256_mul_ps(_mm256_sub_ps(fromY, p1y), dx12)), _mm256_xor_ps(denominator, signBit));
+
+        const __m256 intersectionX = _mm256_add_ps(fromX, _mm256_mul_ps(dx12, t1));
+        const __m256 intersectionY = _mm256_add_ps(fromY, _mm256_mul_ps(dy12, t1));
+
+        const __m256 computed = _mm256_and_ps(TypeMatchAvx(lines.mTypeBits + i, typeMask), _mm256_cmp_ps(denominator, zero, _CMP_NEQ_UQ));
+        __m256 hit = computed;
+        hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(t1, zero, _CMP_GE_OQ), _mm256_cmp_ps(t1, one, _CMP_LE_OQ)));
+        hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(t2, zero, _CMP_GE_OQ), _mm256_cmp_ps(t2, one, _CMP_LE_OQ)));
+
+        const __m256 d = _mm256_sub_ps(_mm256_sub_ps(fromX, intersectionX), _mm256_sub_ps(fromY, intersectionY));
+        const __m256 dist = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(d, d), _mm256_mul_ps(d, d)));
+
+        _mm256_storeu_ps(distance + i, _mm256_or_ps(_mm256_and_ps(hit, dist), _mm256_andnot_ps(hit, miss)));
+        _mm256_storeu_ps(hitX + i, _mm256_and_ps(computed, intersectionX));
+        _mm256_storeu_ps(hitY + i, _mm256_and_ps(computed, intersectionY));
+    }
+}
+
+static const RayKernels kAvxRayKernels =
+{
+    "AVX",
+    IntersectAvx
+};
+
+static bool CpuSupportsAvx()
+{
+#ifdef _MSC_VER
+    int info[4] = {};
+    __cpuid(info, 1);
+
+    // The OS must also save the AVX registers
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    return osxsave && avx && (_xgetbv(0) & 6) == 6;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx") != 0;
+#endif
+}
+
+const RayKernels* Sse2RayKernels()
+{
+    // Part of the x64 base line
+    return &kSse2RayKernels;
+}
+
+const RayKernels* AvxRayKernels()
+{
+    static const bool supported = CpuSupportsAvx();
+    return supported ? &kAvxRayKernels : nullptr;
+}
+
+#else
+
+const RayKernels* Sse2RayKernels()
+{
+    return nullptr;
+}
+
+const RayKernels* AvxRayKernels()
+{
+    return nullptr;
+}
+
+#endif
+
+const RayKernels& BestRayKernels()
+{
+    static const RayKernels& best = AvxRayKernels() ? *AvxRayKernels() : Sse2RayKernels() ? *Sse2RayKernels() : ScalarRayKernels();
+    return best;
+}
@@ -1,11 +1,17 @@
 #include "rendererfactory.hpp"
 #include "openglrenderer.hpp"
+#include "nullrenderer.hpp"
 #ifdef _MSC_VER
 #include "directx9renderer.hpp"
 #endif
 
-/*static*/ std::unique_ptr<AbstractRenderer> RendererFactory::Create(SDL_Window* window, bool tryDirectX9)
+/*static*/ std::unique_ptr<AbstractRenderer> RendererFactory::Create(SDL_Window* window, bool tryDirectX9, bool headless)
 {
+    if (headless)
+    {
+        return std::make_unique<NullRenderer>();
+    }
+
 #ifdef _MSC_VER
     if (tryDirectX9)
     {
@@ -1,7 +1,11 @@
 #include "resourcemapper.hpp"
 #include "fmv.hpp"
 #include "oddlib/bits_factory.hpp"
+#include "cameracache.hpp"
+#include "scriptcache.hpp"
+#include "hash_util.hpp"
 #include "oddlib/audio/vab.hpp"
+#include "oddlib/stream.hpp"
 #include <cmath>
 #include "oddlib/audio/SequencePlayer.h"
 
@@ -184,7 +188,7 @@ void Animation::Restart()
     mCompleted = false;
 }
 
-bool Animation::Collision(s32 x, s32 y) const
+void Animation::FrameRect(s32& x, s32& y, s32& w, s32& h) const
 {
     const Oddlib::Animation::Frame& frame = mAnim.Animation().GetFrame(FrameNumber());
 
@@ -195,11 +199,24 @@ bool Animation::Collision(s32 x, s32 y) const
     ypos = mYPos + (ypos * mScale);
     xpos = mXPos + (xpos * mScale);
 
-    f32 w = static_cast<f32>(frame.mFrame->w) * ScaleX();
-    f32 h = static_cast<f32>(frame.mFrame->h) * mScale;
+    x = static_cast<s32>(xpos);
+    y = static_cast<s32>(ypos);
+    w = static_cast<s32>(static_cast<f32>(frame.mFrame->w) * ScaleX());
+    h = static_cast<s32>(static_cast<f32>(frame.mFrame->h) * mScale);
+}
 
+bool Animation::Collision(s32 x, s32 y) const
+{
+    s32 frameX = 0, frameY = 0, frameW = 0, frameH = 0;
+    FrameRect(frameX, frameY, frameW, frameH);
+    return PointInRect(x, y, frameX, frameY, frameW, frameH);
+}
 
-    return PointInRect(x, y, static_cast<s32>(xpos), static_cast<s32>(ypos), static_cast<s32>(w), static_cast<s32>(h));
+bool Animation::Collision(s32 x, s32 y, s32 w, s32 h) const
+{
+    s32 frameX = 0, frameY = 0, frameW = 0, frameH = 0;
+    FrameRect(frameX, frameY, frameW, frameH);
+    return RectsOverlap(x, y, w, h, frameX, frameY, frameW, frameH);
 }
 
 void Animation::SetXPos(s32 xpos)
@@ -721,11 +738,20 @@ std::unique_ptr<Oddlib::IBits> ResourceLocator::DoLocateCamera(const char* resou
             if (fs.mFileSystem->FileExists(modName))
             {
                 auto stream = fs.mFileSystem->Open(modName);
+
+                const std::string cacheName = fs.mDataSetName + "_" + resourceName;
+                const u64 sourceHash = mCameraCache ? hash_util::Fnv1a(Oddlib::IStream::ReadAll(*stream)) : 0;
+                auto cached = FindCachedCamera(cacheName, sourceHash);
+                if (cached)
+                {
+                    return cached;
+                }
+
                 auto surface = SDLHelpers::LoadPng(*stream, false);
                 if (surface)
                 {
                     LOG_INFO("Loaded new or replacement camera from mod " << fs.mDataSetName);
-                    return Oddlib::MakeBits(std::move(surface));
+                    return AddCachedCamera(cacheName, sourceHash, Oddlib::MakeBits(std::move(surface)));
                 }
             }
 
@@ -736,11 +762,32 @@ std::unique_ptr<Oddlib::IBits> ResourceLocator::DoLocateCamera(const char* resou
 
             if (fs.mFileSystem->FileExists(deltaName))
             {
-                auto cam = DoLocateCamera(resourceName, true);
-                if (cam)
+                // The delta is only valid for the original camera it was made from
+                std::vector<u8> bitsData;
+                std::vector<u8> fg1Data;
+                for (const DataPaths::FileSystemInfo& originalFs : mDataPaths.ActiveDataPaths())
+                {
+                    if (LoadCameraChunks(originalFs, resourceName, bitsData, fg1Data))
+                    {
+                        break;
+                    }
+                }
+
+                if (!bitsData.empty())
                 {
-                    auto originalCameraSurface = cam->GetSurface();
                     auto deltaPngStream = fs.mFileSystem->Open(deltaName);
+
+                    const std::string cacheName = fs.mDataSetName + "_delta_" + resourceName;
+                    const u64 sourceHash = mCameraCache ? hash_util::Fnv1a(Oddlib::IStream::ReadAll(*deltaPngStream), hash_util::Fnv1a(fg1Data, hash_util::Fnv1a(bitsData))) : 0;
+                    auto cached = FindCachedCamera(cacheName, sourceHash);
+                    if (cached)
+                    {
+                        return cached;
+                    }
+
+                    Oddlib::MemoryStream bitsStream(std::move(bitsData));
+                    auto cam = Oddlib::MakeBits(bitsStream, nullptr);
+                    auto originalCameraSurface = cam->GetSurface();
                     auto deltaSurface = SDLHelpers::LoadPng(*deltaPngStream, false);
                     if (deltaSurface)
                     {
@@ -748,7 +795,7 @@ std::unique_ptr<Oddlib::IBits> ResourceLocator::DoLocateCamera(const char* resou
                         {
                             ApplyDelta(deltaSurface.get(), originalCameraSurface);
                             LOG_INFO("Applied camera upscaling delta from " << fs.mDataSetName);
-                            return Oddlib::MakeBits(std::move(deltaSurface));
+                            return AddCachedCamera(cacheName, sourceHash, Oddlib::MakeBits(std::move(deltaSurface)));
                         }
                     }
                 }
@@ -756,38 +803,106 @@ std::unique_ptr<Oddlib::IBits> ResourceLocator::DoLocateCamera(const char* resou
         }
         else
         {
-            const std::vector<ResourceMapper::DataSetFileAttributes>* locationsInThisDataSet = mResMapper.FindFileLocation(fs.mDataSetName.c_str(), resourceName);
-            if (locationsInThisDataSet)
+            std::vector<u8> bitsData;
+            std::vector<u8> fg1Data;
+            if (LoadCameraChunks(fs, resourceName, bitsData, fg1Data))
             {
-                for (const ResourceMapper::DataSetFileAttributes& attributes : *locationsInThisDataSet)
+                const std::string cacheName = fs.mDataSetName + "_" + resourceName;
+                const u64 sourceHash = mCameraCache ? hash_util::Fnv1a(fg1Data, hash_util::Fnv1a(bitsData)) : 0;
+                auto cached = FindCachedCamera(cacheName, sourceHash);
+                if (cached)
                 {
-                    std::shared_ptr<Oddlib::LvlArchive> lvl = OpenLvl(*fs.mFileSystem, fs.mDataSetName, attributes.mLvlName);
-                    if (lvl)
-                    {
-                        auto lvlFile = lvl->FileByName(resourceName);
-                        if (lvlFile)
-                        {
-                            auto bitsChunk = lvlFile->ChunkByType(Oddlib::MakeType("Bits"));
-                            auto bitsStream = bitsChunk->Stream();
-                      
-                            auto fg1Chunk = lvlFile->ChunkByType(Oddlib::MakeType("FG1 "));
-                            std::unique_ptr<Oddlib::IStream> fg1Stream;
-                            if (fg1Chunk)
-                            {
-                                fg1Stream = fg1Chunk->Stream();
-                            }
+                    return cached;
+                }
 
-                            LOG_INFO("Loaded original camera from " << fs.mDataSetName << " has foreground layer: " << (fg1Stream ? "true" : "false"));
-                            return Oddlib::MakeBits(*bitsStream, fg1Stream.get());
-                        }
-                    }
+                LOG_INFO("Loaded original camera from " << fs.mDataSetName << " has foreground layer: " << (fg1Data.empty() ? "false" : "true"));
+                Oddlib::MemoryStream bitsStream(std::move(bitsData));
+                std::unique_ptr<Oddlib::MemoryStream> fg1Stream;
+                if (!fg1Data.empty())
+                {
+                    fg1Stream = std::make_unique<Oddlib::MemoryStream>(std::move(fg1Data));
                 }
+                return AddCachedCamera(cacheName, sourceHash, Oddlib::MakeBits(bitsStream, fg1Stream.get()));
             }
         }
     }
     return nullptr;
 }
 
+// Reads the Bits and FG1 chunks of a camera if this data set has it
+bool ResourceLocator::LoadCameraChunks(const DataPaths::FileSystemInfo& fs, const char* resourceName, std::vector<u8>& bits, std::vector<u8>& fg1)
+{
+    const std::vector<ResourceMapper::DataSetFileAttributes>* locationsInThisDataSet = mResMapper.FindFileLocation(fs.mDataSetName.c_str(), resourceName);
+    if (locationsInThisDataSet)
+    {
+        for (const ResourceMapper::DataSetFileAttributes& attributes : *locationsInThisDataSet)
+        {
+            std::shared_ptr<Oddlib::LvlArchive> lvl = OpenLvl(*fs.mFileSystem, fs.mDataSetName, attributes.mLvlName);
+            if (lvl)
+            {
+                auto lvlFile = lvl->FileByName(resourceName);
+                if (lvlFile)
+                {
+                    bits = lvlFile->ChunkByType(Oddlib::MakeType("Bits"))->ReadData();
+
+                    auto fg1Chunk = lvlFile->ChunkByType(Oddlib::MakeType("FG1 "));
+                    if (fg1Chunk)
+                    {
+                        fg1 = fg1Chunk->ReadData();
+                    }
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+void ResourceLocator::EnableCameraCache(OSBaseFileSystem& fs)
+{
+    mCameraCache = std::make_unique<CameraCache>(fs);
+}
+
+std::unique_ptr<Oddlib::IBits> ResourceLocator::FindCachedCamera(const std::string& name, u64 sourceHash)
+{
+    if (!mCameraCache)
+    {
+        return nullptr;
+    }
+    return mCameraCache->Find(name, sourceHash);
+}
+
+void ResourceLocator::EnableScriptCache(OSBaseFileSystem& fs)
+{
+    mScriptCache = std::make_unique<ScriptCache>(fs);
+}
+
+const std::vector<u8>* ResourceLocator::FindCompiledScript(const std::string& scriptName, const std::string& source)
+{
+    if (!mScriptCache)
+    {
+        return nullptr;
+    }
+    return mScriptCache->Find(scriptName, ScriptCache::Hash(scriptName, source));
+}
+
+void ResourceLocator::AddCompiledScript(const std::string& scriptName, const std::string& source, std::vector<u8> compiled)
+{
+    if (mScriptCache)
+    {
+        mScriptCache->Add(scriptName, ScriptCache::Hash(scriptName, source), std::move(compiled));
+    }
+}
+
+std::unique_ptr<Oddlib::IBits> ResourceLocator::AddCachedCamera(const std::string& name, u64 sourceHash, std::unique_ptr<Oddlib::IBits> bits)
+{
+    if (mCameraCache && bits)
+    {
+        mCameraCache->Add(name, sourceHash, *bits);
+    }
+    return bits;
+}
+
 std::unique_ptr<IMovie> ResourceLocator::LocateFmv(IAudioController& audioController, const char* resourceName)
 {
     const ResourceMapper::FmvMapping* fmvMapping = mResMapper.FindFmv(resourceName);
@@ -931,16 +1046,16 @@ const MusicTheme* ResourceLocator::LocateSoundTheme(const char* themeName)
     return mResMapper.FindSoundTheme(themeName);
 }
 
-std::unique_ptr<Animation> ResourceLocator::DoLocateAnimation(const DataPaths::FileSystemInfo& fs, const char* resourceName, const ResourceMapper::AnimMapping& animMapping)
+bool ResourceLocator::FindAnimation(const DataPaths::FileSystemInfo& fs, const ResourceMapper::AnimMapping& animMapping, AnimationLocation& location)
 {
     // Each each mapping in the resource record that has matched resourceName
-    for (const ResourceMapper::AnimFileLocations& location : animMapping.mLocations)
+    for (const ResourceMapper::AnimFileLocations& animLocation : animMapping.mLocations)
     {
         // Check if the mapping applies to the data set that fs is
-        if (location.mDataSetName == fs.mDataSetName)
+        if (animLocation.mDataSetName == fs.mDataSetName)
         {
             // Loop through all the locations in the data set where resourceName lives
-            for (const ResourceMapper::AnimFile& animFile : location.mFiles)
+            for (const ResourceMapper::AnimFile& animFile : animLocation.mFiles)
             {
                 // Now find all of the LVLs where animFile lives
                 const std::vector<ResourceMapper::DataSetFileAttributes>* fileLocations = mResMapper.FindFileLocation(fs.mDataSetName.c_str(), animFile.mFile.c_str());
@@ -952,49 +1067,208 @@ std::unique_ptr<Animation> ResourceLocator::DoLocateAnimation(const DataPaths::F
                         auto lvlPtr = OpenLvl(*fs.mFileSystem, fs.mDataSetName, dataSetFileAttributes.mLvlName);
                         if (lvlPtr)
                         {
-                            auto animSetPtr = mCache.GetAnimSet(fs.mDataSetName, dataSetFileAttributes.mLvlName, animFile.mFile, animFile.mId);
-                            if (!animSetPtr)
-                            {
-                                // Open the file within the archive
-                                auto lvlFile = lvlPtr->FileByName(animFile.mFile);
-                                if (lvlFile)
-                                {
-                                    // Get the chunk within the file that lives in the lvl
-                                    Oddlib::LvlArchive::FileChunk* chunk = lvlFile->ChunkById(animFile.mId);
-                                    if (chunk)
-                                    {
-                                        LOG_INFO(resourceName
-                                            << " located in data set " << fs.mDataSetName
-                                            << " mapped to " << fs.mFileSystem->FsPath()
-                                            << " in lvl archive " << dataSetFileAttributes.mLvlName
-                                            << " in lvl file " << animFile.mFile
-                                            << " with lvl file chunk id " << animFile.mId
-                                            << " at anim index " << animFile.mAnimationIndex
-                                            << " is psx " << dataSetFileAttributes.mIsPsx
-                                            << " scale frame offsets " << dataSetFileAttributes.mScaleFrameOffsets);
-
-                                        auto stream = chunk->Stream();
-                                        Oddlib::AnimSerializer as(*stream, dataSetFileAttributes.mIsPsx);
-                                        animSetPtr = mCache.AddAnimSet(std::make_unique<Oddlib::AnimationSet>(as), fs.mDataSetName, dataSetFileAttributes.mLvlName, animFile.mFile, animFile.mId);
-                                    }
-                                }
-                            }
+                            location.mAnimFile = &animFile;
+                            location.mAttributes = &dataSetFileAttributes;
+                            location.mLvl = std::move(lvlPtr);
+                            return true;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
+
+Oddlib::LvlArchive::FileChunk* ResourceLocator::FindAnimationChunk(const AnimationLocation& location)
+{
+    // Open the file within the archive
+    auto lvlFile = location.mLvl->FileByName(location.mAnimFile->mFile);
+    if (lvlFile)
+    {
+        // Get the chunk within the file that lives in the lvl
+        return lvlFile->ChunkById(location.mAnimFile->mId);
+    }
+    return nullptr;
+}
+
+static void LogAnimationLocation(const char* resourceName, const DataPaths::FileSystemInfo& fs, const ResourceMapper::AnimFile& animFile, const ResourceMapper::DataSetFileAttributes& dataSetFileAttributes)
+{
+    LOG_INFO(resourceName
+        << " located in data set " << fs.mDataSetName
+        << " mapped to " << fs.mFileSystem->FsPath()
+        << " in lvl archive " << dataSetFileAttributes.mLvlName
+        << " in lvl file " << animFile.mFile
+        << " with lvl file chunk id " << animFile.mId
+        << " at anim index " << animFile.mAnimationIndex
+        << " is psx " << dataSetFileAttributes.mIsPsx
+        << " scale frame offsets " << dataSetFileAttributes.mScaleFrameOffsets);
+}
+
+std::unique_ptr<Animation> ResourceLocator::DoLocateAnimation(const DataPaths::FileSystemInfo& fs, const char* resourceName, const ResourceMapper::AnimMapping& animMapping)
+{
+    AnimationLocation location;
+    if (!FindAnimation(fs, animMapping, location))
+    {
+        return nullptr;
+    }
+
+    const ResourceMapper::AnimFile& animFile = *location.mAnimFile;
+    const ResourceMapper::DataSetFileAttributes& dataSetFileAttributes = *location.mAttributes;
+    auto animSetPtr = mCache.GetAnimSet(fs.mDataSetName, dataSetFileAttributes.mLvlName, animFile.mFile, animFile.mId);
+    if (!animSetPtr)
+    {
+        Oddlib::LvlArchive::FileChunk* chunk = FindAnimationChunk(location);
+        if (chunk)
+        {
+            LogAnimationLocation(resourceName, fs, animFile, dataSetFileAttributes);
+
+            auto stream = chunk->Stream();
+            Oddlib::AnimSerializer as(*stream, dataSetFileAttributes.mIsPsx);
+            animSetPtr = mCache.AddAnimSet(std::make_unique<Oddlib::AnimationSet>(as), fs.mDataSetName, dataSetFileAttributes.mLvlName, animFile.mFile, animFile.mId);
+        }
+    }
+
+    // Construct the animation from the chunk bytes
+    return std::make_unique<Animation>(
+        Animation::AnimationSetHolder(location.mLvl, animSetPtr, animFile.mAnimationIndex),
+        dataSetFileAttributes.mIsPsx,
+        dataSetFileAttributes.mScaleFrameOffsets,
+        animMapping.mBlendingMode,
+        fs.mDataSetName);
+}
+
+AnimationRequest ResourceLocator::LocateAnimations(const std::vector<std::string>& resourceNames)
+{
+    AnimationRequest request;
+    request.mCache = &mCache;
+
+    // Forget the sets that every request is done with
+    for (auto it = mPendingAnimSets.begin(); it != mPendingAnimSets.end();)
+    {
+        it = it->second.expired() ? mPendingAnimSets.erase(it) : std::next(it);
+    }
 
-                            // Construct the animation from the chunk bytes
-                            return std::make_unique<Animation>(
-                                Animation::AnimationSetHolder(lvlPtr, animSetPtr, animFile.mAnimationIndex),
-                                dataSetFileAttributes.mIsPsx,
-                                dataSetFileAttributes.mScaleFrameOffsets,
-                                animMapping.mBlendingMode,
-                                fs.mDataSetName);
+    std::vector<std::shared_ptr<PendingAnimationSet>> decodes;
+    for (const std::string& resourceName : resourceNames)
+    {
+        AnimationRequest::Item item;
+        const ResourceMapper::AnimMapping* animMapping = mResMapper.FindAnimation(resourceName.c_str());
+        if (animMapping)
+        {
+            for (const DataPaths::FileSystemInfo& fs : mDataPaths.ActiveDataPaths())
+            {
+                // TODO: Look up the override in the mod fs, as LocateAnimation
+                AnimationLocation location;
+                if (fs.mIsMod || !FindAnimation(fs, *animMapping, location))
+                {
+                    continue;
+                }
 
+                const ResourceMapper::AnimFile& animFile = *location.mAnimFile;
+                const ResourceMapper::DataSetFileAttributes& dataSetFileAttributes = *location.mAttributes;
+                item.mLvl = location.mLvl;
+                item.mAnimationIndex = animFile.mAnimationIndex;
+                item.mIsPsx = dataSetFileAttributes.mIsPsx;
+                item.mScaleFrameOffsets = dataSetFileAttributes.mScaleFrameOffsets;
+                item.mBlendingMode = animMapping->mBlendingMode;
+                item.mDataSetName = fs.mDataSetName;
+
+                item.mAnimSet = mCache.GetAnimSet(fs.mDataSetName, dataSetFileAttributes.mLvlName, animFile.mFile, animFile.mId);
+                if (!item.mAnimSet)
+                {
+                    std::weak_ptr<PendingAnimationSet>& pending = mPendingAnimSets[fs.mDataSetName + dataSetFileAttributes.mLvlName + animFile.mFile + std::to_string(animFile.mId)];
+                    item.mPending = pending.lock();
+                    if (!item.mPending)
+                    {
+                        Oddlib::LvlArchive::FileChunk* chunk = FindAnimationChunk(location);
+                        if (chunk)
+                        {
+                            LogAnimationLocation(resourceName.c_str(), fs, animFile, dataSetFileAttributes);
+
+                            // The LVL stream is shared so the chunk is read here rather than on the workers
+                            item.mPending = std::make_shared<PendingAnimationSet>();
+                            item.mPending->mDataSetName = fs.mDataSetName;
+                            item.mPending->mLvlName = dataSetFileAttributes.mLvlName;
+                            item.mPending->mFileName = animFile.mFile;
+                            item.mPending->mChunkId = animFile.mId;
+                            item.mPending->mIsPsx = dataSetFileAttributes.mIsPsx;
+                            item.mPending->mData = chunk->ReadData();
+                            pending = item.mPending;
+                            decodes.push_back(item.mPending);
                         }
                     }
                 }
+                item.mFound = item.mAnimSet || item.mPending;
+                break;
             }
         }
+        request.mItems.push_back(std::move(item));
     }
-    return nullptr;
+
+    for (const auto& pending : decodes)
+    {
+        SharedJobSystem().Run(pending->mDone, [pending]()
+        {
+            try
+            {
+                Oddlib::MemoryStream stream(std::move(pending->mData));
+                Oddlib::AnimSerializer as(stream, pending->mIsPsx);
+                pending->mDecoded = std::make_unique<Oddlib::AnimationSet>(as);
+            }
+            catch (const std::exception& ex)
+            {
+                pending->mError = ex.what();
+            }
+        }, JobSystem::ePriority::eStreaming);
+    }
+
+    return request;
+}
+
+std::vector<std::unique_ptr<Animation>> AnimationRequest::Get()
+{
+    std::vector<std::unique_ptr<Animation>> animations;
+    animations.reserve(mItems.size());
+    for (Item& item : mItems)
+    {
+        if (item.mPending)
+        {
+            PendingAnimationSet& pending = *item.mPending;
+            SharedJobSystem().Wait(pending.mDone);
+            if (!pending.mCached && pending.mDecoded)
+            {
+                // LocateAnimation could have decoded the same set in the mean time
+                pending.mCached = mCache->GetAnimSet(pending.mDataSetName, pending.mLvlName, pending.mFileName, pending.mChunkId);
+                if (!pending.mCached)
+                {
+                    pending.mCached = mCache->AddAnimSet(std::move(pending.mDecoded), pending.mDataSetName, pending.mLvlName, pending.mFileName, pending.mChunkId);
+                }
+            }
+            else if (!pending.mError.empty())
+            {
+                LOG_ERROR("Failed to decode animation set " << pending.mFileName << " " << pending.mChunkId << ": " << pending.mError);
+                pending.mError.clear();
+            }
+            item.mAnimSet = pending.mCached;
+        }
+
+        if (item.mFound && item.mAnimSet)
+        {
+            animations.push_back(std::make_unique<Animation>(
+                Animation::AnimationSetHolder(item.mLvl, item.mAnimSet, item.mAnimationIndex),
+                item.mIsPsx,
+                item.mScaleFrameOffsets,
+                item.mBlendingMode,
+                item.mDataSetName));
+        }
+        else
+        {
+            animations.push_back(nullptr);
+        }
+    }
+    mItems.clear();
+    return animations;
 }
 
 BaseSeqSound::BaseSeqSound(const char* soundName, std::unique_ptr<Vab> vab)
@@ -1008,9 +1282,9 @@ void BaseSeqSound::DebugUi()
     mSeqPlayer->DebugUi();
 }
 
-void BaseSeqSound::Play(f32* stream, u32 len)
+void BaseSeqSound::Play(f32* stream, f32* reverbSend, u32 len)
 {
-    mSeqPlayer->Play(stream, len);
+    mSeqPlayer->Play(stream, reverbSend, len);
 }
 
 bool BaseSeqSound::AtEnd() const
@@ -0,0 +1,66 @@
+#include "scriptcache.hpp"
+#include "hash_util.hpp"
+#include "oddlib/lvlarchive.hpp"
+#include "oddlib/stream.hpp"
+#include "logger.hpp"
+
+// The payload of the cache file is the compiled closure
+static const u32 kScriptCacheMagic = Oddlib::MakeType("SQCC");
+static const u32 kScriptCacheFormat = 2;
+static const u32 kMaxCompiledSize = 16 * 1024 * 1024;
+
+ScriptCache::ScriptCache(OSBaseFileSystem& fs)
+    : mFile(fs, kScriptCacheMagic, kScriptCacheFormat, kMaxCompiledSize)
+{
+
+}
+
+/*static*/ u64 ScriptCache::Hash(const std::string& scriptName, const std::string& source)
+{
+    // The name is part of the compiled closure for error messages
+    return hash_util::Fnv1a(source, hash_util::Fnv1a(scriptName));
+}
+
+std::string ScriptCache::DiskCacheFileName(const std::string& scriptName) const
+{
+    return "{CacheDir}/" + scriptName + ".sqcache";
+}
+
+const std::vector<u8>* ScriptCache::Find(const std::string& scriptName, u64 sourceHash)
+{
+    auto it = mCompiled.find(sourceHash);
+    if (it != std::end(mCompiled))
+    {
+        return &it->second;
+    }
+
+    const std::string fileName = DiskCacheFileName(scriptName);
+    try
+    {
+        // Squirrel trusts the bytecode it is given, so a damaged file must never reach sq_readclosure
+        std::vector<u8> compiled;
+        if (!mFile.Read(fileName, sourceHash, compiled))
+        {
+            return nullptr;
+        }
+
+        LOG_INFO("Loaded compiled script " << scriptName << " from disk cache");
+        return &(mCompiled[sourceHash] = std::move(compiled));
+    }
+    catch (const Oddlib::Exception& ex)
+    {
+        LOG_ERROR("Failed to read cached script " << fileName << ": " << ex.what());
+        return nullptr;
+    }
+}
+
+void ScriptCache::Add(const std::string& scriptName, u64 sourceHash, std::vector<u8> compiled)
+{
+    if (compiled.empty() || compiled.size() > kMaxCompiledSize)
+    {
+        return;
+    }
+
+    mFile.Write(DiskCacheFileName(scriptName), sourceHash, compiled);
+    mCompiled[sourceHash] = std::move(compiled);
+}
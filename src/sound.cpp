@@ -1,10 +1,16 @@
 #include "sound.hpp"
 #include "oddlib/audio/SequencePlayer.h"
 #include "core/audiobuffer.hpp"
+#include "core/jobsystem.hpp"
 #include "logger.hpp"
 #include "resourcemapper.hpp"
 #include "audioconverter.hpp"
 #include "alive_version.h"
+#include <set>
+#include <atomic>
+#include <condition_variable>
+#include "stdthread.h"
+#include <algorithm>
 
 SoundCache::SoundCache(OSBaseFileSystem& fs)
     : mFs(fs)
@@ -12,9 +18,17 @@ SoundCache::SoundCache(OSBaseFileSystem& fs)
 
 }
 
+std::string SoundCache::DiskCacheFileName(const std::string& name) const
+{
+    return mFs.ExpandPath("{CacheDir}/" + name + ".ogg");
+}
+
 void SoundCache::Sync()
 {
-    mSoundDataCache.clear();
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mSoundDataCache.clear();
+    }
 
     bool ok = false;
     std::string versionFile = "{CacheDir}/CacheVersion.txt";
@@ -36,16 +50,22 @@ void SoundCache::DeleteAll()
 {
     TRACE_ENTRYEXIT;
 
-    // Delete *.wav from {CacheDir}/disk
+    // Delete *.ogg from {CacheDir}/disk, along with any *.wav from older versions of the cache
     std::string dirName = mFs.ExpandPath("{CacheDir}");
-    const auto wavFiles = mFs.EnumerateFiles(dirName, "*.wav");
-    for (const auto& wavFile : wavFiles)
+    for (const char* filter : { "*.ogg", "*.wav" })
     {
-        mFs.DeleteFile(dirName + "/" + wavFile);
+        const auto cacheFiles = mFs.EnumerateFiles(dirName, filter);
+        for (const auto& cacheFile : cacheFiles)
+        {
+            mFs.DeleteFile(dirName + "/" + cacheFile);
+        }
     }
 
     // Remove from memory
-    mSoundDataCache.clear();
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mSoundDataCache.clear();
+    }
 
     // Update cache version marker to current
     const std::string fileName = mFs.ExpandPath("{CacheDir}/CacheVersion.txt");
@@ -55,96 +75,297 @@ void SoundCache::DeleteAll()
 
 bool SoundCache::ExistsInMemoryCache(const std::string& name) const
 {
+    std::lock_guard<std::mutex> lock(mMutex);
     return mSoundDataCache.find(name) != std::end(mSoundDataCache);
 }
 
-class WavSound : public ISound
+bool SoundCache::ExistsInDiskCache(const std::string& name) const
+{
+    std::string fileName = DiskCacheFileName(name);
+    return mFs.FileExists(fileName);
+}
+
+class CachedSound : public ISound
 {
 public:
-    WavSound(const std::string& name, std::shared_ptr<std::vector<u8>>& data)
+    CachedSound(const std::string& name, const std::shared_ptr<std::vector<s16>>& data)
         : mName(name), mData(data)
     {
-        memcpy(&mHeader.mData, data->data(), sizeof(mHeader.mData));
-        mOffsetInBytes = sizeof(mHeader.mData);
+
     }
 
     virtual void Load() override { }
     virtual void DebugUi() override {}
 
-    virtual void Play(f32* stream, u32 len) override
+    virtual void Play(f32* stream, f32* /*reverbSend*/, u32 len) override
     {
-        size_t kLenInBytes = len * sizeof(f32);
-        
+        // The reverb was already rendered into the cached data
+        size_t numSamples = len;
+
         // Handle the case where the audio call back wants N data but we only have N-X left
-        if (mOffsetInBytes + kLenInBytes > mData->size())
+        if (mOffset + numSamples > mData->size())
         {
-            kLenInBytes = mData->size() - mOffsetInBytes;
+            numSamples = mData->size() - mOffset;
         }
 
-        const f32* src = reinterpret_cast<const f32*>(mData->data() + mOffsetInBytes);
-        for (auto i = 0u; i < kLenInBytes/sizeof(f32); i++)
+        const s16* src = mData->data() + mOffset;
+        for (auto i = 0u; i < numSamples; i++)
         {
-            stream[i] += src[i];
+            stream[i] += src[i] * (1.0f / 32768.0f);
         }
-        mOffsetInBytes += kLenInBytes;
+        mOffset += numSamples;
     }
 
     virtual bool AtEnd() const override
     {
-        return mOffsetInBytes >= mData->size();
+        return mOffset >= mData->size();
     }
 
     virtual void Restart() override
     {
-        mOffsetInBytes = sizeof(mHeader.mData);
+        mOffset = 0;
     }
 
     virtual void Update() override { }
     virtual const std::string& Name() const override { return mName; }
 
 private:
-    size_t mOffsetInBytes = 0;
+    size_t mOffset = 0;
+    std::string mName;
+    std::shared_ptr<std::vector<s16>> mData;
+};
+
+// Plays a sound from the disk cache. A prefetch thread decodes ahead into a small
+// ring buffer which the audio thread consumes, so memory use doesn't depend on the
+// length of the sound.
+class StreamingSound : public ISound
+{
+public:
+    explicit StreamingSound(const std::string& name)
+        : mName(name), mRing(kRingSizeInSamples)
+    {
+
+    }
+
+    ~StreamingSound()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mQuit = true;
+        }
+        mCondition.notify_one();
+
+        if (mPrefetchThread.joinable())
+        {
+            mPrefetchThread.join();
+        }
+    }
+
+    bool Open(const std::string& fileName)
+    {
+        if (!mOgg.Open(fileName.c_str()))
+        {
+            return false;
+        }
+
+        // Fill the ring up front so the first audio call back doesn't underrun
+        std::vector<s16> chunk(kChunkSizeInSamples);
+        while (kRingSizeInSamples - mCount >= kChunkSizeInSamples && !mDecodeFinished)
+        {
+            Push(chunk.data(), mOgg.Read(chunk.data(), kChunkSizeInSamples));
+        }
+
+        mPrefetchThread = std::thread(&StreamingSound::PrefetchThread, this);
+        return true;
+    }
+
+    virtual void Load() override { }
+    virtual void DebugUi() override {}
+
+    // Audio thread context
+    virtual void Play(f32* stream, f32* /*reverbSend*/, u32 len) override
+    {
+        // The reverb was already rendered into the cached data
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            // If the prefetch thread has fallen behind the rest is left silent
+            const u32 numSamples = std::min(len, mCount);
+            for (u32 i = 0; i < numSamples; i++)
+            {
+                stream[i] += mRing[mReadPos] * (1.0f / 32768.0f);
+                mReadPos = (mReadPos + 1) % kRingSizeInSamples;
+            }
+            mCount -= numSamples;
+        }
+        mCondition.notify_one();
+    }
+
+    virtual bool AtEnd() const override
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mDecodeFinished && mCount == 0;
+    }
+
+    virtual void Restart() override
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mReadPos = 0;
+            mWritePos = 0;
+            mCount = 0;
+            mDecodeFinished = false;
+            mRestart = true;
+        }
+        mCondition.notify_one();
+    }
+
+    virtual void Update() override { }
+    virtual const std::string& Name() const override { return mName; }
+
+private:
+    // Must be called with mMutex held (or before the prefetch thread is started)
+    void Push(const s16* samples, u32 numSamples)
+    {
+        if (numSamples == 0)
+        {
+            mDecodeFinished = true;
+            return;
+        }
+
+        for (u32 i = 0; i < numSamples; i++)
+        {
+            mRing[mWritePos] = samples[i];
+            mWritePos = (mWritePos + 1) % kRingSizeInSamples;
+        }
+        mCount += numSamples;
+    }
+
+    void PrefetchThread()
+    {
+        // Only this thread touches mOgg once started
+        std::vector<s16> chunk(kChunkSizeInSamples);
+        for (;;)
+        {
+            bool rewind = false;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mCondition.wait(lock, [&]()
+                {
+                    return mQuit || mRestart || (!mDecodeFinished && kRingSizeInSamples - mCount >= kChunkSizeInSamples);
+                });
+
+                if (mQuit)
+                {
+                    return;
+                }
+
+                rewind = mRestart;
+                mRestart = false;
+            }
+
+            if (rewind)
+            {
+                mOgg.Rewind();
+            }
+
+            const u32 samplesRead = mOgg.Read(chunk.data(), kChunkSizeInSamples);
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (!mRestart)
+            {
+                // Otherwise this data is from before the restart and is dropped
+                Push(chunk.data(), samplesRead);
+            }
+        }
+    }
+
+    // 0.5 seconds of stereo 44.1khz audio
+    static const u32 kRingSizeInSamples = 44100;
+    static const u32 kChunkSizeInSamples = 4096;
+
     std::string mName;
-    std::shared_ptr<std::vector<u8>> mData;
-    WavHeader mHeader;
+    OggStream mOgg;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::vector<s16> mRing;
+    u32 mReadPos = 0;
+    u32 mWritePos = 0;
+    u32 mCount = 0;
+    bool mDecodeFinished = false;
+    bool mRestart = false;
+    bool mQuit = false;
+
+    std::thread mPrefetchThread;
 };
 
 std::unique_ptr<ISound> SoundCache::GetCached(const std::string& name)
 {
-    auto it = mSoundDataCache.find(name);
-    if (it != std::end(mSoundDataCache))
     {
-        return std::make_unique<WavSound>(name, it->second);
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mSoundDataCache.find(name);
+        if (it != std::end(mSoundDataCache))
+        {
+            return std::make_unique<CachedSound>(name, it->second);
+        }
+    }
+
+    if (ExistsInDiskCache(name))
+    {
+        auto pSound = std::make_unique<StreamingSound>(name);
+        if (pSound->Open(DiskCacheFileName(name)))
+        {
+            return std::move(pSound);
+        }
     }
     return nullptr;
 }
 
 void SoundCache::AddToMemoryAndDiskCache(ISound& sound)
 {
-    const std::string fileName = mFs.ExpandPath("{CacheDir}/" + sound.Name() + ".wav");
+    const std::string fileName = DiskCacheFileName(sound.Name());
 
     // TODO: mod files that are already wav shouldn't be converted
     sound.Load();
-    AudioConverter::Convert<WavEncoder>(sound, fileName.c_str());
 
-    auto stream = mFs.Open(fileName);
-    mSoundDataCache[sound.Name()] = std::make_shared<std::vector<u8>>(Oddlib::IStream::ReadAll(*stream));
+    // Keep the PCM that was rendered rather than decoding what was just written
+    OggAndPcmEncoder encoder(fileName.c_str());
+    AudioConverter::Convert(sound, encoder);
+
+    auto pcm = std::make_shared<std::vector<s16>>(std::move(encoder.Pcm()));
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mSoundDataCache[sound.Name()] = pcm;
+}
+
+void SoundCache::AddToDiskCache(ISound& sound)
+{
+    const std::string fileName = DiskCacheFileName(sound.Name());
+
+    sound.Load();
+    AudioConverter::Convert<OggEncoder>(sound, fileName.c_str());
 }
 
 bool SoundCache::AddToMemoryCacheFromDiskCache(const std::string& name)
 {
-    std::string fileName = mFs.ExpandPath("{CacheDir}/" + name + ".wav");
+    std::string fileName = DiskCacheFileName(name);
     if (mFs.FileExists(fileName))
     {
-        auto stream = mFs.Open(fileName);
-        mSoundDataCache[name] = std::make_shared<std::vector<u8>>(Oddlib::IStream::ReadAll(*stream));
-        return true;
+        auto pcm = std::make_shared<std::vector<s16>>();
+        if (OggDecoder::Decode(fileName.c_str(), *pcm))
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mSoundDataCache[name] = pcm;
+            return true;
+        }
     }
     return false;
 }
 
 void SoundCache::RemoveFromMemoryCache(const std::string& name)
 {
+    std::lock_guard<std::mutex> lock(mMutex);
     auto it = mSoundDataCache.find(name);
     if (it != std::end(mSoundDataCache))
     {
@@ -219,32 +440,36 @@ void Sound::SetTheme(const char* themeName)
     }
 }
 
-void Sound::CacheMemoryResidentSounds()
+void Sound::CacheMemoryResidentSounds(std::function<void(u32, u32)> progress)
 {
     TRACE_ENTRYEXIT;
 
     // initial one time sync
     mCache.Sync();
 
+    std::vector<std::string> names;
     const std::vector<SoundResource>& resources = mLocator.GetSoundResources();
     for (const SoundResource& resource : resources)
     {
         if (resource.mIsCacheResident)
         {
-            CacheSound(resource.mResourceName);
+            names.push_back(resource.mResourceName);
         }
     }
+
+    CacheSounds(names, true, progress);
 }
 
 void Sound::CacheActiveTheme(bool add)
 {
+    std::vector<std::string> names;
     for (auto& entry : mActiveTheme->mEntries)
     {
         for (auto& e : entry.second)
         {
             if (add)
             {
-                CacheSound(e.mMusicName);
+                names.push_back(e.mMusicName);
             }
             else
             {
@@ -252,28 +477,123 @@ void Sound::CacheActiveTheme(bool add)
             }
         }
     }
+
+    if (add)
+    {
+        // Music is long so it only needs to be on disk, it's streamed from there when played
+        CacheSounds(names, false, nullptr);
+    }
 }
 
-void Sound::CacheSound(const std::string& name)
+// Runs the jobs on the shared job system and blocks until they are all done, the calling thread
+// helps with them and reports progress.
+static void RunJobsInParallel(const std::vector<std::function<void()>>& jobs, const std::function<void(u32, u32)>& progress)
 {
-    if (mCache.ExistsInMemoryCache(name))
+    const u32 total = static_cast<u32>(jobs.size());
+    if (total == 0)
     {
-        // Already in memory
         return;
     }
 
-    if (mCache.AddToMemoryCacheFromDiskCache(name))
+    JobSystem& jobSystem = SharedJobSystem();
+    std::atomic<u32> completed(0);
+    JobGroup group;
+    for (const std::function<void()>& job : jobs)
     {
-        // Already on disk and now added to in memory cache
-        return;
+        jobSystem.Run(group, [&job, &completed]()
+        {
+            try
+            {
+                job();
+            }
+            catch (const std::exception& e)
+            {
+                LOG_ERROR("Sound cache job failed: " << e.what());
+            }
+            completed++;
+        }, JobSystem::ePriority::eStreaming);
+    }
+
+    u32 reported = 0;
+    for (;;)
+    {
+        const bool done = jobSystem.WaitFor(group, std::chrono::milliseconds(100));
+        const u32 count = completed;
+        if (count != reported)
+        {
+            reported = count;
+            if (progress)
+            {
+                progress(reported, total);
+            }
+        }
+
+        if (done)
+        {
+            break;
+        }
     }
+}
 
-    std::unique_ptr<ISound> pSound = mLocator.LocateSound(name.c_str(), nullptr, true, true);
-    if (pSound)
+void Sound::CacheSounds(const std::vector<std::string>& names, bool memoryResident, const std::function<void(u32, u32)>& progress)
+{
+    // The resource locator isn't thread safe so only one worker at a time may use it,
+    // decoding from the disk cache and rendering run concurrently.
+    std::mutex locatorMutex;
+
+    std::set<std::string> uniqueNames;
+    std::vector<std::function<void()>> jobs;
+    for (const std::string& name : names)
     {
-        // Write into disk cache and then load from disk cache into memory cache
-        mCache.AddToMemoryAndDiskCache(*pSound);
+        if (mCache.ExistsInMemoryCache(name) || !uniqueNames.insert(name).second)
+        {
+            // Already in memory or already queued
+            continue;
+        }
+
+        if (!memoryResident && mCache.ExistsInDiskCache(name))
+        {
+            // Will be streamed from the disk cache
+            continue;
+        }
+
+        jobs.emplace_back([this, name, memoryResident, &locatorMutex]()
+        {
+            if (memoryResident && mCache.AddToMemoryCacheFromDiskCache(name))
+            {
+                // Already on disk and now added to in memory cache
+                return;
+            }
+
+            std::unique_ptr<ISound> pSound;
+            {
+                std::lock_guard<std::mutex> lock(locatorMutex);
+                pSound = mLocator.LocateSound(name.c_str(), nullptr, true, true);
+            }
+
+            if (pSound)
+            {
+                if (memoryResident)
+                {
+                    // Write into disk cache and memory cache
+                    mCache.AddToMemoryAndDiskCache(*pSound);
+                }
+                else
+                {
+                    mCache.AddToDiskCache(*pSound);
+                }
+            }
+        });
     }
+
+    LOG_INFO("Caching " << jobs.size() << " sounds");
+    RunJobsInParallel(jobs, [&](u32 done, u32 total)
+    {
+        if (progress)
+        {
+            progress(done, total);
+        }
+    });
 }
 
 void Sound::HandleEvent(const char* eventName)
@@ -323,20 +643,26 @@ bool Sound::Play(f32* stream, u32 len)
 {
     std::lock_guard<std::mutex> lock(mSoundPlayersMutex);
 
+    // Every player feeds the same reverb so its cost doesn't grow with the number of sounds
+    mReverbBus.Begin(len);
+    f32* reverbSend = mReverbBus.Send();
+
     if (mAmbiance)
     {
-        mAmbiance->Play(stream, len);
+        mAmbiance->Play(stream, reverbSend, len);
     }
 
     if (mMusicTrack)
     {
-        mMusicTrack->Play(stream, len);
+        mMusicTrack->Play(stream, reverbSend, len);
     }
 
     for (auto& player : mSoundPlayers)
     {
-        player->Play(stream, len);
+        player->Play(stream, reverbSend, len);
     }
+
+    mReverbBus.Mix(stream, len);
     return false;
 }
 
@@ -386,6 +712,8 @@ void Sound::Update()
                     ImGui::Text("Music: %s", mMusicTrack->Name().c_str());
                 }
 
+                ImGui::Text("Reverb bus: %s", mReverbBus.Active() ? "active" : "idle");
+
                 int i = 0;
                 for (auto& player : mSoundPlayers)
                 {
@@ -0,0 +1,582 @@
+#include "zipentrystream.hpp"
+#include "oddlib/exceptions.hpp"
+#include <algorithm>
+#include <cstring>
+
+#undef min
+
+ZipEntryStream::ZipEntryStream(std::shared_ptr<ZipArchive> archive, u32 dataOffset, u32 dataSize, u32 size, const std::string& name)
+    : mArchive(std::move(archive)), mDataOffset(dataOffset), mDataSize(dataSize), mSize(size), mName(name)
+{
+
+}
+
+Oddlib::IStream* ZipEntryStream::Clone(u32 /*start*/, u32 /*size*/)
+{
+    throw Oddlib::Exception("Sub clone not supported on compressed zip entries");
+}
+
+void ZipEntryStream::WriteBytes(const u8* /*pSrc*/, size_t /*srcSize*/)
+{
+    throw Oddlib::Exception("Zip entries are read only");
+}
+
+std::string ZipEntryStream::LoadAllToString()
+{
+    Seek(0);
+    std::string content(mSize, '\0');
+    if (!content.empty())
+    {
+        ReadBytes(reinterpret_cast<u8*>(&content[0]), content.size());
+    }
+    return content;
+}
+
+size_t ZipEntryStream::ReadData(u32 dataPos, u8* pDest, size_t destSize)
+{
+    const size_t count = std::min(destSize, static_cast<size_t>(mDataSize - dataPos));
+    if (count > 0)
+    {
+        std::lock_guard<std::mutex> lock(mArchive->mMutex);
+        mArchive->mStream->Seek(mDataOffset + dataPos);
+        mArchive->mStream->ReadBytes(pDest, count);
+    }
+    return count;
+}
+
+ZipStoredStream::ZipStoredStream(std::shared_ptr<ZipArchive> archive, u32 dataOffset, u32 size, const std::string& name)
+    : ZipEntryStream(std::move(archive), dataOffset, size, size, name)
+{
+
+}
+
+Oddlib::IStream* ZipStoredStream::Clone()
+{
+    return new ZipStoredStream(mArchive, mDataOffset, mDataSize, mName);
+}
+
+Oddlib::IStream* ZipStoredStream::Clone(u32 start, u32 size)
+{
+    if (static_cast<size_t>(start) + size > mSize)
+    {
+        throw Oddlib::Exception("Sub clone is outside of " + mName);
+    }
+    return new ZipStoredStream(mArchive, mDataOffset + start, size, mName + " sub(" + std::to_string(start) + "," + std::to_string(size) + ")");
+}
+
+void ZipStoredStream::ReadBytes(u8* pDest, size_t destSize)
+{
+    if (destSize > mSize - mPos)
+    {
+        throw Oddlib::Exception("ReadBytes failure");
+    }
+
+    if (mPos >= mBufferStart && mPos < mBufferEnd)
+    {
+        const size_t count = std::min(destSize, mBufferEnd - mPos);
+        memcpy(pDest, &mBuffer[mPos - mBufferStart], count);
+        pDest += count;
+        destSize -= count;
+        mPos += count;
+    }
+
+    if (destSize == 0)
+    {
+        return;
+    }
+
+    if (destSize >= kReadAheadSize)
+    {
+        ReadData(static_cast<u32>(mPos), pDest, destSize);
+    }
+    else
+    {
+        mBuffer.resize(kReadAheadSize);
+        mBufferStart = mPos;
+        mBufferEnd = mPos + ReadData(static_cast<u32>(mPos), mBuffer.data(), mBuffer.size());
+        memcpy(pDest, mBuffer.data(), destSize);
+    }
+    mPos += destSize;
+}
+
+void ZipStoredStream::Seek(size_t pos)
+{
+    if (pos > mSize)
+    {
+        throw Oddlib::Exception("Seek get failure");
+    }
+    mPos = pos;
+}
+
+// Length and distance symbols are a base value plus extra bits, see RFC 1951 3.2.5
+static const u16 kLengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const u8 kLengthExtraBits[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const u16 kDistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const u8 kDistanceExtraBits[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+// Order the code length code lengths are stored in for dynamic blocks
+static const u8 kCodeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+void ZipInflateStream::HuffmanTable::Build(const u8* lengths, u32 numSymbols)
+{
+    std::fill(std::begin(mCount), std::end(mCount), static_cast<u16>(0));
+    for (u32 i = 0; i < numSymbols; i++)
+    {
+        mCount[lengths[i]]++;
+    }
+    mCount[0] = 0;
+
+    // Incomplete codes are allowed, such as a single distance code, but not over subscribed ones
+    s32 left = 1;
+    for (u32 len = 1; len <= kMaxCodeLength; len++)
+    {
+        left = (left << 1) - mCount[len];
+        if (left < 0)
+        {
+            throw Oddlib::Exception("Over subscribed Huffman code in compressed data");
+        }
+    }
+
+    // Symbols ordered by code length then value, which is the order of their codes
+    u16 offsets[kMaxCodeLength + 2] = {};
+    for (u32 len = 1; len <= kMaxCodeLength; len++)
+    {
+        offsets[len + 1] = offsets[len] + mCount[len];
+    }
+    for (u32 i = 0; i < numSymbols; i++)
+    {
+        if (lengths[i] != 0)
+        {
+            mSymbol[offsets[lengths[i]]++] = static_cast<u16>(i);
+        }
+    }
+
+    // Codes are packed starting from their most significant bit, so they are looked up bit reversed
+    std::fill(std::begin(mFast), std::end(mFast), static_cast<u16>(0));
+    u32 code = 0;
+    u32 index = 0;
+    for (u32 len = 1; len <= kFastBits; len++)
+    {
+        for (u32 i = 0; i < mCount[len]; i++)
+        {
+            u32 reversed = 0;
+            for (u32 bit = 0; bit < len; bit++)
+            {
+                reversed |= ((code >> bit) & 1) << (len - 1 - bit);
+            }
+
+            const u16 entry = static_cast<u16>((mSymbol[index++] << 4) | len);
+            for (u32 j = reversed; j < (1u << kFastBits); j += 1u << len)
+            {
+                mFast[j] = entry;
+            }
+            code++;
+        }
+        code <<= 1;
+    }
+}
+
+ZipInflateStream::ZipInflateStream(std::shared_ptr<ZipArchive> archive, u32 dataOffset, u32 compressedSize, u32 size, const std::string& name)
+    : ZipEntryStream(std::move(archive), dataOffset, compressedSize, size, name),
+      mInput(kInputBufferSize),
+      mWindow(kWindowSize)
+{
+
+}
+
+Oddlib::IStream* ZipInflateStream::Clone()
+{
+    return new ZipInflateStream(mArchive, mDataOffset, mDataSize, static_cast<u32>(mSize), mName);
+}
+
+void ZipInflateStream::ReadBytes(u8* pDest, size_t destSize)
+{
+    if (destSize > mSize - mPos)
+    {
+        throw Oddlib::Exception("ReadBytes failure");
+    }
+
+    while (destSize > 0)
+    {
+        // Stop at the next checkpoint position to save the state there
+        const size_t nextCheckpoint = (mPos / kCheckpointInterval + 1) * kCheckpointInterval;
+        const size_t count = std::min(destSize, nextCheckpoint - mPos);
+        const size_t written = Inflate(pDest, count);
+        mPos += written;
+        if (written != count)
+        {
+            throw Oddlib::Exception("Compressed data of " + mName + " ended early");
+        }
+        pDest += count;
+        destSize -= count;
+
+        if (mPos == nextCheckpoint && mCheckpoints.size() == mPos / kCheckpointInterval - 1)
+        {
+            SaveCheckpoint();
+        }
+    }
+}
+
+void ZipInflateStream::Seek(size_t pos)
+{
+    if (pos > mSize)
+    {
+        throw Oddlib::Exception("Seek get failure");
+    }
+
+    // Start from the nearest checkpoint when it is closer than the current position
+    const size_t checkpoint = std::min(pos / kCheckpointInterval, mCheckpoints.size());
+    const size_t checkpointPos = checkpoint * kCheckpointInterval;
+    if (pos < mPos || checkpointPos > mPos)
+    {
+        if (checkpoint == 0)
+        {
+            Restart();
+        }
+        else
+        {
+            RestoreCheckpoint(mCheckpoints[checkpoint - 1], checkpointPos);
+        }
+    }
+
+    // The window is already a buffer of the last bytes, but the data in between still has to be
+    // inflated
+    u8 skipped[4096];
+    while (mPos < pos)
+    {
+        ReadBytes(skipped, std::min(sizeof(skipped), pos - mPos));
+    }
+}
+
+void ZipInflateStream::Restart()
+{
+    mInputPos = 0;
+    mInputEnd = 0;
+    mDataPos = 0;
+    mBitBuffer = 0;
+    mBitCount = 0;
+    mWindowPos = 0;
+    mState = eState::eBlockHeader;
+    mFinalBlock = false;
+    mStoredRemaining = 0;
+    mMatchRemaining = 0;
+    mMatchDistance = 0;
+    mPos = 0;
+}
+
+void ZipInflateStream::SaveCheckpoint()
+{
+    // Bytes still in the input buffer are read again when the checkpoint is restored
+    mCheckpoints.push_back(Checkpoint
+    {
+        mWindow, mWindowPos, mDataPos - (mInputEnd - mInputPos), mBitBuffer, mBitCount,
+        mState, mFinalBlock, mStoredRemaining, mMatchRemaining, mMatchDistance,
+        mLiteralTable, mDistanceTable
+    });
+}
+
+void ZipInflateStream::RestoreCheckpoint(const Checkpoint& checkpoint, size_t pos)
+{
+    mInputPos = 0;
+    mInputEnd = 0;
+    mDataPos = checkpoint.mDataPos;
+    mBitBuffer = checkpoint.mBitBuffer;
+    mBitCount = checkpoint.mBitCount;
+    mWindow = checkpoint.mWindow;
+    mWindowPos = checkpoint.mWindowPos;
+    mState = checkpoint.mState;
+    mFinalBlock = checkpoint.mFinalBlock;
+    mStoredRemaining = checkpoint.mStoredRemaining;
+    mMatchRemaining = checkpoint.mMatchRemaining;
+    mMatchDistance = checkpoint.mMatchDistance;
+    mLiteralTable = checkpoint.mLiteralTable;
+    mDistanceTable = checkpoint.mDistanceTable;
+    mPos = pos;
+}
+
+void ZipInflateStream::FillBits()
+{
+    while (mBitCount <= 56)
+    {
+        if (mInputPos == mInputEnd)
+        {
+            mInputPos = 0;
+            mInputEnd = static_cast<u32>(ReadData(mDataPos, mInput.data(), mInput.size()));
+            mDataPos += mInputEnd;
+            if (mInputEnd == 0)
+            {
+                return;
+            }
+        }
+        mBitBuffer |= static_cast<u64>(mInput[mInputPos++]) << mBitCount;
+        mBitCount += 8;
+    }
+}
+
+u32 ZipInflateStream::GetBits(u32 count)
+{
+    if (mBitCount < count)
+    {
+        FillBits();
+        if (mBitCount < count)
+        {
+            throw Oddlib::Exception("Compressed data of " + mName + " ended early");
+        }
+    }
+
+    const u32 value = static_cast<u32>(mBitBuffer & ((1ull << count) - 1));
+    mBitBuffer >>= count;
+    mBitCount -= count;
+    return value;
+}
+
+u32 ZipInflateStream::Decode(const HuffmanTable& table)
+{
+    if (mBitCount < kMaxCodeLength)
+    {
+        FillBits();
+    }
+
+    const u16 entry = table.mFast[mBitBuffer & ((1u << kFastBits) - 1)];
+    const u32 len = entry & 0xF;
+    if (entry != 0 && len <= mBitCount)
+    {
+        mBitBuffer >>= len;
+        mBitCount -= len;
+        return entry >> 4;
+    }
+
+    // Longer codes are walked a bit at a time
+    s32 code = 0;
+    s32 first = 0;
+    s32 index = 0;
+    for (u32 bits = 1; bits <= kMaxCodeLength; bits++)
+    {
+        code |= GetBits(1);
+        const s32 count = table.mCount[bits];
+        if (code - first < count)
+        {
+            return table.mSymbol[index + (code - first)];
+        }
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+    throw Oddlib::Exception("Bad Huffman code in compressed data of " + mName);
+}
+
+void ZipInflateStream::ReadBlockHeader()
+{
+    mFinalBlock = GetBits(1) != 0;
+    switch (GetBits(2))
+    {
+    case 0:
+    {
+        // Stored blocks start on a byte boundary
+        GetBits(mBitCount % 8);
+        const u32 len = GetBits(16);
+        const u32 nlen = GetBits(16);
+        if (len != (~nlen & 0xFFFF))
+        {
+            throw Oddlib::Exception("Bad stored block length in compressed data of " + mName);
+        }
+        mStoredRemaining = len;
+        mState = eState::eStored;
+        break;
+    }
+
+    case 1:
+    {
+        u8 lengths[288 + 30];
+        std::fill(lengths, lengths + 144, static_cast<u8>(8));
+        std::fill(lengths + 144, lengths + 256, static_cast<u8>(9));
+        std::fill(lengths + 256, lengths + 280, static_cast<u8>(7));
+        std::fill(lengths + 280, lengths + 288, static_cast<u8>(8));
+        std::fill(lengths + 288, lengths + 288 + 30, static_cast<u8>(5));
+        mLiteralTable.Build(lengths, 288);
+        mDistanceTable.Build(lengths + 288, 30);
+        mState = eState::eHuffman;
+        break;
+    }
+
+    case 2:
+        ReadDynamicTables();
+        mState = eState::eHuffman;
+        break;
+
+    default:
+        throw Oddlib::Exception("Bad block type in compressed data of " + mName);
+    }
+}
+
+void ZipInflateStream::ReadDynamicTables()
+{
+    const u32 numLiterals = GetBits(5) + 257;
+    const u32 numDistances = GetBits(5) + 1;
+    const u32 numCodeLengths = GetBits(4) + 4;
+    if (numLiterals > 286 || numDistances > 30)
+    {
+        throw Oddlib::Exception("Bad dynamic block in compressed data of " + mName);
+    }
+
+    u8 lengths[286 + 30] = {};
+    for (u32 i = 0; i < numCodeLengths; i++)
+    {
+        lengths[kCodeLengthOrder[i]] = static_cast<u8>(GetBits(3));
+    }
+
+    HuffmanTable codeLengthTable;
+    codeLengthTable.Build(lengths, 19);
+
+    const u32 numLengths = numLiterals + numDistances;
+    u32 index = 0;
+    while (index < numLengths)
+    {
+        const u32 symbol = Decode(codeLengthTable);
+        if (symbol < 16)
+        {
+            lengths[index++] = static_cast<u8>(symbol);
+            continue;
+        }
+
+        u8 value = 0;
+        u32 repeat = 0;
+        if (symbol == 16)
+        {
+            if (index == 0)
+            {
+                throw Oddlib::Exception("Bad dynamic block in compressed data of " + mName);
+            }
+            value = lengths[index - 1];
+            repeat = 3 + GetBits(2);
+        }
+        else if (symbol == 17)
+        {
+            repeat = 3 + GetBits(3);
+        }
+        else
+        {
+            repeat = 11 + GetBits(7);
+        }
+
+        if (index + repeat > numLengths)
+        {
+            throw Oddlib::Exception("Bad dynamic block in compressed data of " + mName);
+        }
+        std::fill(lengths + index, lengths + index + repeat, value);
+        index += repeat;
+    }
+
+    if (lengths[256] == 0)
+    {
+        throw Oddlib::Exception("Dynamic block without an end code in compressed data of " + mName);
+    }
+
+    mLiteralTable.Build(lengths, numLiterals);
+    mDistanceTable.Build(lengths + numLiterals, numDistances);
+}
+
+void ZipInflateStream::Output(u8* pDest, size_t& written, u8 value)
+{
+    pDest[written++] = value;
+    mWindow[mWindowPos] = value;
+    mWindowPos = (mWindowPos + 1) & (kWindowSize - 1);
+}
+
+size_t ZipInflateStream::Inflate(u8* pDest, size_t destSize)
+{
+    size_t written = 0;
+    while (written < destSize)
+    {
+        // Finish the match or stored block of a previous read first
+        while (mMatchRemaining > 0 && written < destSize)
+        {
+            Output(pDest, written, mWindow[(mWindowPos - mMatchDistance) & (kWindowSize - 1)]);
+            mMatchRemaining--;
+        }
+
+        switch (mState)
+        {
+        case eState::eBlockHeader:
+            ReadBlockHeader();
+            break;
+
+        case eState::eStored:
+            while (mStoredRemaining > 0 && written < destSize)
+            {
+                // Whole bytes left in the bit buffer come first, then straight from the input buffer
+                if (mBitCount >= 8)
+                {
+                    Output(pDest, written, static_cast<u8>(GetBits(8)));
+                    mStoredRemaining--;
+                }
+                else if (mInputPos < mInputEnd)
+                {
+                    const u32 count = static_cast<u32>(std::min({ static_cast<size_t>(mStoredRemaining), static_cast<size_t>(mInputEnd - mInputPos), destSize - written }));
+                    for (u32 i = 0; i < count; i++)
+                    {
+                        Output(pDest, written, mInput[mInputPos + i]);
+                    }
+                    mInputPos += count;
+                    mStoredRemaining -= count;
+                }
+                else
+                {
+                    FillBits();
+                    if (mBitCount < 8)
+                    {
+                        throw Oddlib::Exception("Compressed data of " + mName + " ended early");
+                    }
+                }
+            }
+
+            if (mStoredRemaining == 0)
+            {
+                mState = mFinalBlock ? eState::eDone : eState::eBlockHeader;
+            }
+            break;
+
+        case eState::eHuffman:
+            while (mMatchRemaining == 0 && written < destSize)
+            {
+                const u32 symbol = Decode(mLiteralTable);
+                if (symbol < 256)
+                {
+                    Output(pDest, written, static_cast<u8>(symbol));
+                }
+                else if (symbol == 256)
+                {
+                    mState = mFinalBlock ? eState::eDone : eState::eBlockHeader;
+                    break;
+                }
+                else
+                {
+                    const u32 lengthSymbol = symbol - 257;
+                    if (lengthSymbol >= 29)
+                    {
+                        throw Oddlib::Exception("Bad length in compressed data of " + mName);
+                    }
+
+                    mMatchRemaining = kLengthBase[lengthSymbol] + GetBits(kLengthExtraBits[lengthSymbol]);
+
+                    const u32 distanceSymbol = Decode(mDistanceTable);
+                    if (distanceSymbol >= 30)
+                    {
+                        throw Oddlib::Exception("Bad distance in compressed data of " + mName);
+                    }
+
+                    mMatchDistance = kDistanceBase[distanceSymbol] + GetBits(kDistanceExtraBits[distanceSymbol]);
+                    if (mMatchDistance > mPos + written)
+                    {
+                        throw Oddlib::Exception("Distance too far back in compressed data of " + mName);
+                    }
+                }
+            }
+            break;
+
+        case eState::eDone:
+            return written;
+        }
+    }
+    return written;
+}
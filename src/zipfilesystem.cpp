@@ -2,10 +2,11 @@
 #include <memory>
 #include <limits>
 #include "zipfilesystem.hpp"
-#include "libdeflate.h"
 #include "oddlib/stream.hpp"
 #include "logger.hpp"
 #include "oddlib/exceptions.hpp"
+#include "string_util.hpp"
+#include <algorithm>
 
 #undef max
 
@@ -63,17 +64,17 @@ void ZipFileSystem::CentralDirectoryRecord::DeSerialize(Oddlib::IStream& stream)
 }
 
 ZipFileSystem::ZipFileSystem(const std::string& zipFile, IFileSystem& fs)
-    : mFileName(zipFile)
+    : mArchive(std::make_shared<ZipArchive>()), mFileName(zipFile)
 {
     if (fs.FileExists(mFileName))
     {
-        mStream = fs.Open(mFileName);
+        mArchive->mStream = fs.Open(mFileName);
     }
 }
 
 bool ZipFileSystem::Init()
 {
-    if (!mStream)
+    if (!mArchive->mStream)
     {
         LOG_ERROR("Failed to open " << mFileName);
         return false;
@@ -100,23 +101,55 @@ bool ZipFileSystem::LoadCentralDirectoryRecords()
     for (auto i = 0; i < mEndOfCentralDirectoryRecord.mNumEntriesInCentaralDirectory; i++)
     {
         u32 cdrMagic = 0;
-        mStream->Read(cdrMagic);
+        mArchive->mStream->Read(cdrMagic);
         if (cdrMagic != kCentralDirectory)
         {
             LOG_ERROR("Missing central directory record for item " << i);
             return false;
         }
-        mRecords[i].DeSerialize(*mStream);
+        mRecords[i].DeSerialize(*mArchive->mStream);
     }
 
-    // TODO: Sort mRecords by name for faster file look up and directory enumeration
+    // Names are looked up without matching case like the OS file systems do, the first
+    // record wins if a name is in the zip more than once
+    // TODO: Index directories for faster enumeration
+    mRecordIndex.clear();
+    mRecordIndex.reserve(mRecords.size());
+    for (u32 i = 0; i < mRecords.size(); i++)
+    {
+        mRecordIndex.emplace(IndexName(mRecords[i].mLocalFileHeader.mFileName), i);
+    }
 
     return true;
 }
 
+/*static*/ std::string ZipFileSystem::IndexName(std::string fileName)
+{
+    NormalizePath(fileName);
+    std::transform(fileName.begin(), fileName.end(), fileName.begin(), string_util::c_tolower);
+    return fileName;
+}
+
+const ZipFileSystem::CentralDirectoryRecord* ZipFileSystem::FindRecord(const std::string& fileName) const
+{
+    const auto it = mRecordIndex.find(IndexName(fileName));
+    return it != std::end(mRecordIndex) ? &mRecords[it->second] : nullptr;
+}
+
+u32 ZipFileSystem::MaxLookupComparisons() const
+{
+    // A lookup only compares with the names in the bucket of its hash
+    size_t most = 0;
+    for (size_t i = 0; i < mRecordIndex.bucket_count(); i++)
+    {
+        most = std::max(most, mRecordIndex.bucket_size(i));
+    }
+    return static_cast<u32>(most);
+}
+
 bool ZipFileSystem::LocateEndOfCentralDirectoryRecord()
 {
-    const size_t fileSize = mStream->Size();
+    const size_t fileSize = mArchive->mStream->Size();
 
     // The max search size is the size of the structure and the max comment length, if there
     // isn't an ECDR within this range then its not a ZIP file.
@@ -129,10 +162,10 @@ bool ZipFileSystem::LocateEndOfCentralDirectoryRecord()
 
     // Move to the earliest possible start pos for the ECDR
     const size_t baseOffset = fileSize - kMaxSearchPos;
-    mStream->Seek(baseOffset);
+    mArchive->mStream->Seek(baseOffset);
     std::string buffer;
     buffer.resize(kMaxSearchPos);
-    mStream->Read(buffer);
+    mArchive->mStream->Read(buffer);
 
     const std::string needle = { 'P', 'K', 0x05, 0x06 }; // AKA kEndOfCentralDirectory
 
@@ -142,24 +175,24 @@ bool ZipFileSystem::LocateEndOfCentralDirectoryRecord()
         hint = buffer.find(needle, hint);
         if (hint != std::string::npos)
         {
-            mStream->Seek(baseOffset + hint);
+            mArchive->mStream->Seek(baseOffset + hint);
 
             u32 magic = 0;
-            mStream->Read(magic);
+            mArchive->mStream->Read(magic);
             if (magic == kEndOfCentralDirectory)
             {
                 // We do so check that the pos after the stucture + comment len == file size
                 // and then seek to the central directory pos and check that it == correct magic
-                mEndOfCentralDirectoryRecord.DeSerialize(*mStream);
+                mEndOfCentralDirectoryRecord.DeSerialize(*mArchive->mStream);
                 if (mEndOfCentralDirectoryRecord.mCentralDirectoryStartOffset < fileSize - sizeof(u32))
                 {
-                    mStream->Seek(mEndOfCentralDirectoryRecord.mCentralDirectoryStartOffset);
+                    mArchive->mStream->Seek(mEndOfCentralDirectoryRecord.mCentralDirectoryStartOffset);
                     u32 cdrMagic = 0;
-                    mStream->Read(cdrMagic);
+                    mArchive->mStream->Read(cdrMagic);
                     if (cdrMagic == kCentralDirectory)
                     {
                         // Must be a valid ZIP and we are now at the CDR location
-                        mStream->Seek(mStream->Pos() - sizeof(cdrMagic));
+                        mArchive->mStream->Seek(mArchive->mStream->Pos() - sizeof(cdrMagic));
                         return true;
                     }
                 }
@@ -173,29 +206,19 @@ bool ZipFileSystem::LocateEndOfCentralDirectoryRecord()
 
 std::unique_ptr<Oddlib::IStream> ZipFileSystem::Open(const std::string& fileName)
 {
-    size_t idx = 0;
-    bool found = false;
-    for (size_t i = 0; i < mRecords.size(); i++)
-    {
-        CentralDirectoryRecord& r = mRecords[i];
-        if (r.mLocalFileHeader.mFileName == fileName)
-        {
-            idx = i;
-            found = true;
-            break;
-        }
-    }
-
-    if (!found)
+    const CentralDirectoryRecord* record = FindRecord(fileName);
+    if (!record)
     {
         return nullptr;
     }
 
-    CentralDirectoryRecord& r = mRecords[idx];
+    const CentralDirectoryRecord& r = *record;
 
-    mStream->Seek(r.mRelativeLocalFileHeaderOffset);
+    // Entry streams opened earlier read from the same stream
+    std::lock_guard<std::mutex> lock(mArchive->mMutex);
+    mArchive->mStream->Seek(r.mRelativeLocalFileHeaderOffset);
     u32 magic = 0;
-    mStream->Read(magic);
+    mArchive->mStream->Read(magic);
     if (magic != kLocalFileHeader)
     {
         LOG_ERROR("Local file header missing");
@@ -204,8 +227,8 @@ std::unique_ptr<Oddlib::IStream> ZipFileSystem::Open(const std::string& fileName
 
     // The other copy of the local file header might have a comment with a different length etc, so have to check again
     LocalFileHeader localHeader;
-    localHeader.DeSerialize(*mStream);
-    mStream->Seek(mStream->Pos() + localHeader.mFileNameLength + localHeader.mExtraFieldLength);
+    localHeader.DeSerialize(*mArchive->mStream);
+    mArchive->mStream->Seek(mArchive->mStream->Pos() + localHeader.mFileNameLength + localHeader.mExtraFieldLength);
 
     enum GeneralPurposeFlags
     {
@@ -270,41 +293,19 @@ std::unique_ptr<Oddlib::IStream> ZipFileSystem::Open(const std::string& fileName
         return nullptr;
     }
 
-    // TODO: Wrap a stream around the compressed data, loading the whole thing is memory heavy and slow
-    auto compressedSize = r.mLocalFileHeader.mDataDescriptor.mCompressedSize;
-    if (compressedSize > 0)
+    // The entry is read from the zip as the stream is read rather than loaded in to memory here
+    const u32 dataOffset = static_cast<u32>(mArchive->mStream->Pos());
+    const DataDescriptor& sizes = r.mLocalFileHeader.mDataDescriptor;
+    if (sizes.mCompressedSize == 0)
     {
-        std::vector<u8> buffer(compressedSize);
-        std::vector<u8> out(r.mLocalFileHeader.mDataDescriptor.mUnCompressedSize);
-        size_t actualOut = 0;
-
-        mStream->Read(buffer);
-
-        if (r.mLocalFileHeader.mCompressionMethod == eDeflate)
-        {
-            deflate_decompressor* decompressor = deflate_alloc_decompressor();
-            decompress_result result = deflate_decompress(decompressor, buffer.data(), buffer.size(), out.data(), out.size(), &actualOut);
-            switch (result)
-            {
-            case DECOMPRESS_BAD_DATA:
-            case DECOMPRESS_INSUFFICIENT_SPACE:
-            case DECOMPRESS_SHORT_OUTPUT:
-                deflate_free_decompressor(decompressor);
-                return nullptr;
-
-            case DECOMPRESS_SUCCESS:
-                break;
-            }
-            deflate_free_decompressor(decompressor);
-        }
-        else
-        {
-            out = buffer;
-        }
+        return std::make_unique<Oddlib::MemoryStream>(std::vector<u8>());
+    }
 
-        return std::make_unique<Oddlib::MemoryStream>(std::move(out));
+    if (r.mLocalFileHeader.mCompressionMethod == eDeflate)
+    {
+        return std::make_unique<ZipInflateStream>(mArchive, dataOffset, sizes.mCompressedSize, sizes.mUnCompressedSize, fileName);
     }
-    return std::make_unique<Oddlib::MemoryStream>(std::vector<u8>());
+    return std::make_unique<ZipStoredStream>(mArchive, dataOffset, sizes.mCompressedSize, fileName);
 }
 
 std::unique_ptr<Oddlib::IStream> ZipFileSystem::Create(const std::string& /*fileName*/)
@@ -344,15 +345,15 @@ std::vector<std::string> ZipFileSystem::EnumerateFolders(const std::string& /*di
 
 bool ZipFileSystem::FileExists(std::string& fileName)
 {
-    for (size_t i = 0; i < mRecords.size(); i++)
+    const CentralDirectoryRecord* record = FindRecord(fileName);
+    if (!record)
     {
-        CentralDirectoryRecord& r = mRecords[i];
-        if (r.mLocalFileHeader.mFileName == fileName)
-        {
-            return true;
-        }
+        return false;
     }
-    return false;
+
+    // Give back the name as it is in the zip, as OSBaseFileSystem does
+    fileName = record->mLocalFileHeader.mFileName;
+    return true;
 }
 
 std::string ZipFileSystem::FsPath() const
@@ -0,0 +1,90 @@
+#include <gmock/gmock.h>
+#include "activityregions.hpp"
+
+TEST(ActivityRegions, GatherFindsObjectsWithinRadius)
+{
+    ActivityRegions regions;
+    regions.Reset(100.0f, 50.0f, 5, 4);
+
+    regions.Place(0, 10.0f, 10.0f);   // 0, 0
+    regions.Place(1, 250.0f, 120.0f); // 2, 2
+    regions.Place(2, 350.0f, 60.0f);  // 3, 1
+    regions.Place(3, 490.0f, 190.0f); // 4, 3
+
+    std::vector<u32> indices;
+    regions.Gather(2, 2, 0, indices);
+    ASSERT_EQ(std::vector<u32>({ 1 }), indices);
+
+    regions.Gather(2, 2, 1, indices);
+    ASSERT_EQ(std::vector<u32>({ 1, 2 }), indices);
+
+    regions.Gather(2, 2, 2, indices);
+    ASSERT_EQ(std::vector<u32>({ 0, 1, 2, 3 }), indices);
+}
+
+TEST(ActivityRegions, PlaceMovesObjectsBetweenCells)
+{
+    ActivityRegions regions;
+    regions.Reset(100.0f, 100.0f, 4, 4);
+
+    regions.Place(1, 50.0f, 50.0f);
+    regions.Place(0, 50.0f, 50.0f);
+
+    std::vector<u32> indices;
+    regions.Gather(0, 0, 0, indices);
+    ASSERT_EQ(std::vector<u32>({ 0, 1 }), indices);
+
+    regions.Place(1, 350.0f, 350.0f);
+    regions.Gather(0, 0, 0, indices);
+    ASSERT_EQ(std::vector<u32>({ 0 }), indices);
+    regions.Gather(3, 3, 0, indices);
+    ASSERT_EQ(std::vector<u32>({ 1 }), indices);
+    ASSERT_EQ(2u, regions.ObjectCount());
+}
+
+TEST(ActivityRegions, OutsideOfMapClampsToEdgeCells)
+{
+    ActivityRegions regions;
+    regions.Reset(100.0f, 100.0f, 3, 2);
+
+    ASSERT_EQ(0, regions.CellX(-250.0f));
+    ASSERT_EQ(2, regions.CellX(1000.0f));
+    ASSERT_EQ(0, regions.CellY(-1.0f));
+    ASSERT_EQ(1, regions.CellY(200.0f));
+
+    regions.Place(0, -250.0f, 1000.0f);
+    std::vector<u32> indices;
+    regions.Gather(0, 1, 0, indices);
+    ASSERT_EQ(std::vector<u32>({ 0 }), indices);
+}
+
+TEST(ActivityRegions, GatherRect)
+{
+    ActivityRegions regions;
+    regions.Reset(100.0f, 100.0f, 8, 8);
+    regions.Place(0, 150.0f, 150.0f);
+    regions.Place(1, 250.0f, 150.0f);
+    regions.Place(2, 650.0f, 650.0f);
+
+    // A point searches its own cell and the cells next to it
+    std::vector<u32> indices;
+    regions.GatherRect(50.0f, 50.0f, 0.0f, 0.0f, indices);
+    ASSERT_EQ(std::vector<u32>({ 0 }), indices);
+
+    regions.GatherRect(150.0f, 150.0f, 0.0f, 0.0f, indices);
+    ASSERT_EQ(std::vector<u32>({ 0, 1 }), indices);
+
+    regions.GatherRect(350.0f, 150.0f, 200.0f, 400.0f, indices);
+    ASSERT_EQ(std::vector<u32>({ 1, 2 }), indices);
+}
+
+TEST(ObjectTypeIds, InternAndFind)
+{
+    ObjectTypeIds ids;
+    const u32 hoist = ids.Intern("Hoist");
+    const u32 door = ids.Intern("Door");
+    ASSERT_NE(hoist, door);
+    ASSERT_EQ(hoist, ids.Intern("Hoist"));
+    ASSERT_EQ(door, ids.Find("Door"));
+    ASSERT_EQ(ObjectTypeIds::kUnknownType, ids.Find("Switch"));
+}
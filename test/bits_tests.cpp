@@ -0,0 +1,374 @@
+#include <gmock/gmock.h>
+#include "oddlib/bits_ae_pc.hpp"
+#include "oddlib/bits_fg1.hpp"
+#include "oddlib/stream.hpp"
+#include "oddlib/vlctable.hpp"
+#include <random>
+
+// The VLC decode loop from before it used a 64 bit bit buffer, one source word is pulled in for every
+// 16 bits used. Returns false if the strip doesn't end within maxWords.
+static bool ReferenceVlcDecode(const u16* aCamSeg, std::vector<u16>& aDst, size_t maxWords)
+{
+    unsigned int camSrcPtrIndex = 0;
+    unsigned int dstVlcWord = aCamSeg[camSrcPtrIndex + 1] | (aCamSeg[camSrcPtrIndex] << 16);
+    camSrcPtrIndex += 2;
+
+    signed int totalBitsToShiftBy = 0;
+    while (aDst.size() < maxWords)
+    {
+        // Look up the next 11 bits
+        unsigned int vlcTabIndex = 4 * (dstVlcWord >> 21);
+        const unsigned int bitsToShiftBy = Oddlib::g_VlcTab[vlcTabIndex];
+        totalBitsToShiftBy += bitsToShiftBy;
+        dstVlcWord = dstVlcWord << bitsToShiftBy;
+        if (totalBitsToShiftBy > 0xF)
+        {
+            totalBitsToShiftBy = totalBitsToShiftBy & 0xF;
+            dstVlcWord |= aCamSeg[camSrcPtrIndex++] << totalBitsToShiftBy;
+        }
+
+        bool rawWordFollows = false;
+        for (int i = 0; i < 3; i++)
+        {
+            const unsigned short vlcWord = Oddlib::g_VlcTab[++vlcTabIndex];
+            if (vlcWord == 0)
+            {
+                break;
+            }
+            else if (vlcWord == 0xFFFF)
+            {
+                rawWordFollows = true;
+                break;
+            }
+            aDst.push_back(vlcWord);
+        }
+
+        if (rawWordFollows)
+        {
+            aDst.push_back(static_cast<u16>(dstVlcWord >> 19));
+            if (dstVlcWord >> 19 == 1)
+            {
+                return true;
+            }
+
+            totalBitsToShiftBy += 0xD;
+            dstVlcWord = dstVlcWord << 0xD;
+            if (totalBitsToShiftBy > 0xF)
+            {
+                totalBitsToShiftBy = totalBitsToShiftBy & 0xF;
+                dstVlcWord |= aCamSeg[camSrcPtrIndex++] << totalBitsToShiftBy;
+            }
+        }
+    }
+    return false;
+}
+
+// Packs values from their most significant bit into words like the camera strips are
+struct StripBitWriter
+{
+    std::vector<u16> mWords;
+    u32 mBitCount = 0;
+
+    void Put(u32 value, u32 count)
+    {
+        for (u32 i = count; i-- > 0;)
+        {
+            if (mBitCount % 16 == 0)
+            {
+                mWords.push_back(0);
+            }
+            mWords.back() |= static_cast<u16>(((value >> i) & 1) << (15 - (mBitCount % 16)));
+            mBitCount++;
+        }
+    }
+};
+
+static bool VlcCodeHasRawWord(u32 index)
+{
+    for (u32 i = 1; i < 4; i++)
+    {
+        const u16 word = Oddlib::g_VlcTab[index * 4 + i];
+        if (word == 0)
+        {
+            return false;
+        }
+        if (word == 0xFFFF)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// A strip of random codes from the table, with random raw words, ended by a code with a raw word of 1
+static std::vector<u16> MakeRandomStrip(std::mt19937& random, u32 numCodes)
+{
+    StripBitWriter writer;
+    for (u32 i = 0; i < numCodes; i++)
+    {
+        const u32 index = random() % 2048;
+        const u32 length = Oddlib::g_VlcTab[index * 4];
+        writer.Put(index >> (11 - length), length);
+        if (VlcCodeHasRawWord(index))
+        {
+            writer.Put(2 + random() % 0x1FFE, 13);
+        }
+    }
+
+    u32 endIndex = random() % 2048;
+    while (!VlcCodeHasRawWord(endIndex))
+    {
+        endIndex = (endIndex + 1) % 2048;
+    }
+    const u32 length = Oddlib::g_VlcTab[endIndex * 4];
+    writer.Put(endIndex >> (11 - length), length);
+    writer.Put(1, 13);
+
+    // Room for reading ahead
+    writer.mWords.resize(writer.mWords.size() + Oddlib::kAeVlcReadAheadWords + 2);
+    return writer.mWords;
+}
+
+TEST(AeBitsPc, VlcDecodeMatchesReference)
+{
+    // As big as the buffer the camera strips are decoded into
+    const size_t kMaxWords = 0x7E00;
+
+    std::mt19937 random(1234);
+    u32 numStrips = 0;
+    for (u32 i = 0; i < 500; i++)
+    {
+        const std::vector<u16> strip = MakeRandomStrip(random, 1 + random() % 2000);
+
+        std::vector<u16> expected;
+        if (!ReferenceVlcDecode(strip.data(), expected, kMaxWords - 2))
+        {
+            // Codes that continue into the next one can swallow the end
+            continue;
+        }
+        numStrips++;
+
+        std::vector<u16> actual(kMaxWords, 0xCDCD);
+        Oddlib::AeVlcDecode(strip.data(), actual.data());
+        ASSERT_TRUE(std::equal(expected.begin(), expected.end(), actual.begin())) << "strip " << i;
+        ASSERT_EQ(0u, actual[expected.size()]);
+        ASSERT_EQ(0u, actual[expected.size() + 1]);
+    }
+
+    // Nearly all of them end where they were meant to
+    ASSERT_GT(numStrips, 400u);
+}
+
+TEST(AeBitsPc, VlcDecodeEndOfStrip)
+{
+    // A code with a raw word straight away, the raw word of 1 is part of the output
+    u32 endIndex = 0;
+    while (!VlcCodeHasRawWord(endIndex))
+    {
+        endIndex++;
+    }
+
+    StripBitWriter writer;
+    const u32 length = Oddlib::g_VlcTab[endIndex * 4];
+    writer.Put(endIndex >> (11 - length), length);
+    writer.Put(1, 13);
+    writer.mWords.resize(writer.mWords.size() + Oddlib::kAeVlcReadAheadWords + 2);
+
+    std::vector<u16> expected;
+    ASSERT_TRUE(ReferenceVlcDecode(writer.mWords.data(), expected, 16));
+    ASSERT_EQ(1u, expected.back());
+
+    std::vector<u16> actual(16, 0xCDCD);
+    Oddlib::AeVlcDecode(writer.mWords.data(), actual.data());
+    ASSERT_TRUE(std::equal(expected.begin(), expected.end(), actual.begin()));
+}
+
+// Gives the tests the FG1 image that the tiles were built from
+class TestTiledFg1 : public Oddlib::TiledFg1
+{
+public:
+    explicit TestTiledFg1(const SDL_Surface* fg1)
+    {
+        BuildTiles(fg1);
+    }
+};
+
+static u32 GetPixel(const SDL_Surface* surface, s32 x, s32 y)
+{
+    // Clamped to the edges like the borders of the atlas tiles are
+    x = std::min(std::max(x, 0), surface->w - 1);
+    y = std::min(std::max(y, 0), surface->h - 1);
+    return reinterpret_cast<const u32*>(static_cast<const u8*>(surface->pixels) + y * surface->pitch)[x];
+}
+
+static void SetPixel(SDL_Surface* surface, u32 x, u32 y, u32 pixel)
+{
+    reinterpret_cast<u32*>(static_cast<u8*>(surface->pixels) + y * surface->pitch)[x] = pixel;
+}
+
+static SDL_SurfacePtr MakeFg1Image(u32 width, u32 height)
+{
+    return SDL_SurfacePtr(SDL_CreateRGBSurface(0, width, height, 32, 0x000000ff, 0x0000ff00, 0x00ff0000, 0));
+}
+
+TEST(AeBitsPc, Fg1TilesMatchImage)
+{
+    // Not a multiple of the block size so that there are blocks cut off at the edges
+    const u32 kWidth = 150;
+    const u32 kHeight = 70;
+    SDL_SurfacePtr image = MakeFg1Image(kWidth, kHeight);
+
+    std::mt19937 random(42);
+    for (u32 y = 0; y < kHeight; y++)
+    {
+        for (u32 x = 0; x < kWidth; x++)
+        {
+            SetPixel(image.get(), x, y, random() & 0x00FFFFFF);
+        }
+    }
+
+    // Some solid areas, one covering the corner, and single pixels scattered about
+    const SDL_Rect kAreas[] = { { 0, 0, 5, 3 }, { 40, 10, 50, 20 }, { 120, 60, 30, 10 }, { 31, 15, 2, 2 } };
+    for (const SDL_Rect& area : kAreas)
+    {
+        for (s32 y = area.y; y < area.y + area.h; y++)
+        {
+            for (s32 x = area.x; x < area.x + area.w; x++)
+            {
+                SetPixel(image.get(), x, y, GetPixel(image.get(), x, y) | 0xFF000000);
+            }
+        }
+    }
+    for (u32 i = 0; i < 40; i++)
+    {
+        const u32 x = random() % kWidth;
+        const u32 y = random() % kHeight;
+        SetPixel(image.get(), x, y, GetPixel(image.get(), x, y) | 0xFF000000);
+    }
+
+    TestTiledFg1 fg1(image.get());
+    ASSERT_FALSE(fg1.IsEmpty());
+
+    // Every pixel with alpha comes back as it was and nothing else gets any alpha
+    SDL_SurfacePtr composited = fg1.MakeSurface(kWidth, kHeight);
+    for (u32 y = 0; y < kHeight; y++)
+    {
+        for (u32 x = 0; x < kWidth; x++)
+        {
+            const u32 expected = GetPixel(image.get(), x, y);
+            const u32 actual = GetPixel(composited.get(), x, y);
+            if (expected >> 24)
+            {
+                ASSERT_EQ(expected, actual) << x << "," << y;
+            }
+            else
+            {
+                ASSERT_EQ(0u, actual >> 24) << x << "," << y;
+            }
+        }
+    }
+
+    // Texture filtering at the edge of a tile sees the same neighbours as it did in the full image
+    const SDL_Surface* atlas = fg1.GetAtlas();
+    for (const Oddlib::Fg1Tile& tile : fg1.GetTiles())
+    {
+        for (s32 y = -1; y <= tile.mH; y++)
+        {
+            for (s32 x = -1; x <= tile.mW; x++)
+            {
+                ASSERT_EQ(GetPixel(image.get(), tile.mX + x, tile.mY + y), GetPixel(atlas, tile.mAtlasX + x, tile.mAtlasY + y));
+            }
+        }
+    }
+}
+
+TEST(AeBitsPc, Fg1TilesEmptyImage)
+{
+    SDL_SurfacePtr image = MakeFg1Image(64, 32);
+    TestTiledFg1 fg1(image.get());
+    ASSERT_TRUE(fg1.IsEmpty());
+    ASSERT_EQ(nullptr, fg1.GetAtlas());
+}
+
+template<class T>
+static void Put(std::vector<u8>& data, T value)
+{
+    const u8* bytes = reinterpret_cast<const u8*>(&value);
+    data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+static void PutChunk(std::vector<u8>& data, u16 type, u16 x, u16 y, u16 w, u16 h)
+{
+    Put<u16>(data, type);
+    Put<u16>(data, 0);
+    Put<u16>(data, x);
+    Put<u16>(data, y);
+    Put<u16>(data, w);
+    Put<u16>(data, h);
+}
+
+TEST(AeBitsPc, Fg1StreamMaskMatchesTiles)
+{
+    const u32 kWidth = 640;
+    const u32 kHeight = 240;
+    std::vector<bool> mask(kWidth * kHeight);
+
+    // Random bit masked partial blocks and a few full ones, some next to each other
+    std::mt19937 random(7);
+    std::vector<u8> chunks;
+    u32 numPartialChunks = 0;
+    for (u32 i = 0; i < 60; i++)
+    {
+        const u16 x = static_cast<u16>((random() % (kWidth / 32)) * 32);
+        const u16 y = static_cast<u16>((random() % (kHeight / 16)) * 16);
+        if (i % 5 == 0)
+        {
+            PutChunk(chunks, 0xFFFE, x, y, 32, 16);
+            for (u32 py = 0; py < 16; py++)
+            {
+                for (u32 px = 0; px < 32; px++)
+                {
+                    mask[(y + py) * kWidth + x + px] = true;
+                }
+            }
+        }
+        else
+        {
+            const u16 w = static_cast<u16>(1 + random() % 32);
+            const u16 h = static_cast<u16>(1 + random() % 16);
+            PutChunk(chunks, 0, x, y, w, h);
+            numPartialChunks++;
+            for (u32 py = 0; py < h; py++)
+            {
+                // Sparse so that blocks are often only partly used
+                const u32 bits = random() & random() & random();
+                Put<u32>(chunks, bits);
+                for (u32 px = 0; px < w; px++)
+                {
+                    if (bits & (1u << px))
+                    {
+                        mask[(y + py) * kWidth + x + px] = true;
+                    }
+                }
+            }
+        }
+    }
+    PutChunk(chunks, 0xFFFF, 0, 0, 0, 0);
+
+    std::vector<u8> data;
+    Put<u32>(data, numPartialChunks);
+    data.insert(data.end(), chunks.begin(), chunks.end());
+    Oddlib::MemoryStream stream(std::move(data));
+
+    SDL_SurfacePtr camera = MakeFg1Image(kWidth, kHeight);
+    Oddlib::BitsFg1 fg1(camera.get(), stream, true);
+
+    SDL_SurfacePtr composited = fg1.MakeSurface(kWidth, kHeight);
+    for (u32 y = 0; y < kHeight; y++)
+    {
+        for (u32 x = 0; x < kWidth; x++)
+        {
+            ASSERT_EQ(mask[y * kWidth + x], (GetPixel(composited.get(), x, y) >> 24) == 0xFF) << x << "," << y;
+        }
+    }
+}
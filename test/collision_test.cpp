@@ -3,7 +3,11 @@
 #include "resourcemapper.hpp"
 #include "gridmap.hpp"
 #include "abstractrenderer.hpp"
+#include "raycast_kernels.hpp"
 #include <array>
+#include <chrono>
+#include <cstring>
+#include <iostream>
 
 TEST(CollisionLines, IsPointInCircle)
 {
@@ -70,3 +74,238 @@ TEST(Collision, NearestHitPointWins)
     ASSERT_EQ(hitPoint.intersection.x, 1957);
     ASSERT_EQ(hitPoint.intersection.y, 1140);
 }
+
+// Lines moved by the editor must still be found where they are now and not where they were
+TEST(Collision, MovedLineIsFound)
+{
+    Physics::raycast_collision hitPoint;
+    CollisionLines lines;
+    lines.emplace_back(std::make_unique<CollisionLine>(glm::vec2{ 0, 100 }, glm::vec2{ 200, 100 }, CollisionLine::eFloor));
+    lines.emplace_back(std::make_unique<CollisionLine>(glm::vec2{ 4000, 2000 }, glm::vec2{ 4200, 2000 }, CollisionLine::eFloor));
+    ASSERT_TRUE(CollisionLine::RayCast<1>(lines, { 50, 0 }, { 50, 780 }, { CollisionLine::eFloor }, &hitPoint));
+
+    lines[0]->mLine.mP1 += glm::vec2(3000, 0);
+    lines[0]->mLine.mP2 += glm::vec2(3000, 0);
+    lines.LineMoved(0);
+    ASSERT_FALSE(CollisionLine::RayCast<1>(lines, { 50, 0 }, { 50, 780 }, { CollisionLine::eFloor }, &hitPoint));
+    ASSERT_TRUE(CollisionLine::RayCast<1>(lines, { 3050, 0 }, { 3050, 780 }, { CollisionLine::eFloor }, &hitPoint));
+    ASSERT_NEAR(hitPoint.intersection.y, 100.0f, 0.01f);
+    ASSERT_EQ(CollisionLine::Pick(lines, { 3100, 100 }), 0);
+
+    // Outside of the area the lines covered before
+    lines[1]->mLine.mP1 = glm::vec2(-9000, -9000);
+    lines[1]->mLine.mP2 = glm::vec2(-8800, -9000);
+    lines.LineMoved(1);
+    ASSERT_TRUE(CollisionLine::RayCast<1>(lines, { -8900, -9100 }, { -8900, -8000 }, { CollisionLine::eFloor }, &hitPoint));
+    ASSERT_EQ(CollisionLine::Pick(lines, { 4100, 2000 }), -1);
+}
+
+class RayTestRandom
+{
+public:
+    u32 Next()
+    {
+        mState = (mState * 1664525u) + 1013904223u;
+        return mState;
+    }
+
+    f32 Range(f32 min, f32 max)
+    {
+        return min + (static_cast<f32>(Next() >> 8) / 16777216.0f) * (max - min);
+    }
+
+private:
+    u32 mState = 1;
+};
+
+static std::vector<const RayKernels*> SimdRayKernels()
+{
+    std::vector<const RayKernels*> ret;
+    if (Sse2RayKernels())
+    {
+        ret.push_back(Sse2RayKernels());
+    }
+    if (AvxRayKernels())
+    {
+        ret.push_back(AvxRayKernels());
+    }
+    return ret;
+}
+
+struct RayTestLines
+{
+    explicit RayTestLines(u32 count)
+        : mP1X(count), mP1Y(count), mP2X(count), mP2Y(count), mTypeBits(count)
+    {
+    }
+
+    CollisionLineSoA SoA() const
+    {
+        return { mP1X.data(), mP1Y.data(), mP2X.data(), mP2Y.data(), mTypeBits.data() };
+    }
+
+    std::vector<f32> mP1X;
+    std::vector<f32> mP1Y;
+    std::vector<f32> mP2X;
+    std::vector<f32> mP2Y;
+    std::vector<u32> mTypeBits;
+};
+
+TEST(RayKernels, IntersectMatchesScalar)
+{
+    RayTestRandom rng;
+
+    // Whole numbers like the map data so that there are lines that touch, are parallel or have no length
+    const u32 count = 512;
+    RayTestLines lines(count);
+    for (u32 i = 0; i < count; i++)
+    {
+        const u32 kind = rng.Next() % 4;
+        lines.mP1X[i] = std::floor(rng.Range(0.0f, 500.0f));
+        lines.mP1Y[i] = std::floor(rng.Range(0.0f, 500.0f));
+        lines.mP2X[i] = kind == 0 ? lines.mP1X[i] : std::floor(rng.Range(0.0f, 500.0f));
+        lines.mP2Y[i] = kind == 1 ? lines.mP1Y[i] : std::floor(rng.Range(0.0f, 500.0f));
+        lines.mTypeBits[i] = kind == 2 ? 0 : CollisionLines::TypeBit(rng.Next() % 32);
+    }
+
+    for (const RayKernels* kernels : SimdRayKernels())
+    {
+        for (int i = 0; i < 500; i++)
+        {
+            RayKernelRay ray = { std::floor(rng.Range(0.0f, 500.0f)), std::floor(rng.Range(0.0f, 500.0f)), std::floor(rng.Range(0.0f, 500.0f)), std::floor(rng.Range(0.0f, 500.0f)), rng.Next() };
+            if (i % 5 == 0)
+            {
+                ray.mToX = ray.mFromX;
+            }
+
+            std::vector<f32> expected[3] = { std::vector<f32>(count), std::vector<f32>(count), std::vector<f32>(count) };
+            std::vector<f32> actual[3] = { std::vector<f32>(count), std::vector<f32>(count), std::vector<f32>(count) };
+            ScalarRayKernels().mIntersect(ray, lines.SoA(), count, expected[0].data(), expected[1].data(), expected[2].data());
+            kernels->mIntersect(ray, lines.SoA(), count, actual[0].data(), actual[1].data(), actual[2].data());
+            for (u32 j = 0; j < count; j++)
+            {
+                ASSERT_EQ(0, memcmp(&expected[0][j], &actual[0][j], sizeof(f32))) << kernels->mName << " ray " << i << " line " << j;
+                if (expected[0][j] != kRayMiss)
+                {
+                    ASSERT_EQ(expected[1][j], actual[1][j]) << kernels->mName << " ray " << i << " line " << j;
+                    ASSERT_EQ(expected[2][j], actual[2][j]) << kernels->mName << " ray " << i << " line " << j;
+                }
+            }
+        }
+    }
+}
+
+TEST(Collision, BatchMatchesSingleRays)
+{
+    RayTestRandom rng;
+    CollisionLines lines;
+    for (u32 i = 0; i < 300; i++)
+    {
+        const glm::vec2 p1(std::floor(rng.Range(0.0f, 3000.0f)), std::floor(rng.Range(0.0f, 1000.0f)));
+        lines.emplace_back(std::make_unique<CollisionLine>(p1, p1 + glm::vec2(std::floor(rng.Range(-200.0f, 200.0f)), std::floor(rng.Range(-200.0f, 200.0f))), CollisionLine::ToType(rng.Next() % 4)));
+    }
+
+    for (u32 i = 0; i < 200; i++)
+    {
+        const glm::vec2 pos(rng.Range(0.0f, 3000.0f), rng.Range(0.0f, 1000.0f));
+        CollisionLines::RayCastQuery rays[6];
+        CollisionLines::RayCastHit hits[6];
+        for (CollisionLines::RayCastQuery& ray : rays)
+        {
+            ray = { pos, pos + glm::vec2(rng.Range(-300.0f, 300.0f), rng.Range(-300.0f, 300.0f)), rng.Next() & 0xF };
+        }
+        lines.RayCastBatch(rays, 6, hits);
+
+        for (u32 j = 0; j < 6; j++)
+        {
+            CollisionLines::RayCastHit hit;
+            lines.RayCastBatch(&rays[j], 1, &hit);
+            ASSERT_EQ(hit.mLine, hits[j].mLine);
+            if (hit.mLine >= 0)
+            {
+                ASSERT_EQ(hit.mIntersection.x, hits[j].mIntersection.x);
+                ASSERT_EQ(hit.mIntersection.y, hits[j].mIntersection.y);
+            }
+        }
+    }
+}
+
+// Not a pass or fail test, prints how long the kernels and ray casts take on a map that is dense with lines
+TEST(RayKernels, Benchmark)
+{
+    using Clock = std::chrono::high_resolution_clock;
+    RayTestRandom rng;
+
+    const u32 count = 1024;
+    RayTestLines soaLines(count);
+    for (u32 i = 0; i < count; i++)
+    {
+        soaLines.mP1X[i] = rng.Range(0.0f, 1000.0f);
+        soaLines.mP1Y[i] = rng.Range(0.0f, 1000.0f);
+        soaLines.mP2X[i] = rng.Range(0.0f, 1000.0f);
+        soaLines.mP2Y[i] = rng.Range(0.0f, 1000.0f);
+        soaLines.mTypeBits[i] = 1;
+    }
+
+    std::vector<const RayKernels*> allKernels = SimdRayKernels();
+    allKernels.insert(allKernels.begin(), &ScalarRayKernels());
+    std::vector<f32> distance(count);
+    std::vector<f32> hitX(count);
+    std::vector<f32> hitY(count);
+    for (const RayKernels* kernels : allKernels)
+    {
+        const auto start = Clock::now();
+        for (u32 i = 0; i < 2000; i++)
+        {
+            const RayKernelRay ray = { rng.Range(0.0f, 1000.0f), rng.Range(0.0f, 1000.0f), rng.Range(0.0f, 1000.0f), rng.Range(0.0f, 1000.0f), 1 };
+            kernels->mIntersect(ray, soaLines.SoA(), count, distance.data(), hitX.data(), hitY.data());
+        }
+        const f64 ns = std::chrono::duration<f64, std::nano>(Clock::now() - start).count();
+        std::cout << kernels->mName << " kernel: " << (ns / (2000.0 * count)) << " ns per line" << std::endl;
+    }
+
+    // Groups of 8 rays around the same point, like the probes of one object
+    CollisionLines lines;
+    for (u32 i = 0; i < 2000; i++)
+    {
+        lines.emplace_back(std::make_unique<CollisionLine>(
+            glm::vec2(std::floor(rng.Range(0.0f, 2000.0f)), std::floor(rng.Range(0.0f, 1000.0f))),
+            glm::vec2(std::floor(rng.Range(0.0f, 2000.0f)), std::floor(rng.Range(0.0f, 1000.0f))),
+            CollisionLine::eFloor));
+    }
+
+    std::vector<CollisionLines::RayCastQuery> rays(4000);
+    for (u32 i = 0; i < rays.size(); i += 8)
+    {
+        const glm::vec2 pos(rng.Range(100.0f, 1900.0f), rng.Range(100.0f, 900.0f));
+        for (u32 j = i; j < i + 8; j++)
+        {
+            rays[j] = { pos, pos + glm::vec2(rng.Range(-60.0f, 60.0f), rng.Range(-60.0f, 60.0f)), CollisionLines::TypeBit(CollisionLine::eFloor) };
+        }
+    }
+
+    const auto singleStart = Clock::now();
+    u32 singleHits = 0;
+    for (const CollisionLines::RayCastQuery& ray : rays)
+    {
+        singleHits += CollisionLine::RayCast<1>(lines, ray.mFrom, ray.mTo, { CollisionLine::eFloor }, nullptr) ? 1 : 0;
+    }
+    const f64 singleNs = std::chrono::duration<f64, std::nano>(Clock::now() - singleStart).count();
+
+    const auto batchStart = Clock::now();
+    std::vector<CollisionLines::RayCastHit> hits(rays.size());
+    for (u32 i = 0; i < rays.size(); i += 8)
+    {
+        lines.RayCastBatch(&rays[i], 8, &hits[i]);
+    }
+    const f64 batchNs = std::chrono::duration<f64, std::nano>(Clock::now() - batchStart).count();
+
+    u32 batchHits = 0;
+    for (const CollisionLines::RayCastHit& hit : hits)
+    {
+        batchHits += hit.mLine >= 0 ? 1 : 0;
+    }
+    ASSERT_EQ(singleHits, batchHits);
+
+    std::cout << "RayCast: " << (singleNs / rays.size()) << " ns per ray, RayCastBatch of 8: " << (batchNs / rays.size()) << " ns per ray, " << BestRayKernels().mName << " kernels" << std::endl;
+}
@@ -0,0 +1,75 @@
+#include <gmock/gmock.h>
+#include "fsm.hpp"
+
+struct FsmTestContext
+{
+    bool mInputRight = false;
+    bool mAnimationComplete = false;
+    std::vector<std::string> mAnimations;
+    std::vector<std::string> mSounds;
+};
+
+static void AddTestFunctions(FiniteStateMachine& fsm, FsmTestContext& context)
+{
+    fsm.Conditions().Add("InputRight", [](void* c, const FsmArguments&) { return static_cast<FsmTestContext*>(c)->mInputRight; }, &context);
+    fsm.Conditions().Add("IsAnimationComplete", [](void* c, const FsmArguments&) { return static_cast<FsmTestContext*>(c)->mAnimationComplete; }, &context);
+    fsm.Actions().Add("SetAnimation", [](void* c, const FsmArguments& args) { static_cast<FsmTestContext*>(c)->mAnimations.push_back(args.String(0)); }, &context);
+    fsm.Actions().Add("PlaySoundEffect", [](void* c, const FsmArguments& args) { static_cast<FsmTestContext*>(c)->mSounds.push_back(args.String(0)); }, &context);
+}
+
+TEST(FiniteStateMachine, CompiledTransitions)
+{
+    FsmTestContext context;
+    FiniteStateMachine fsm;
+    AddTestFunctions(fsm, context);
+    fsm.Construct();
+
+    ASSERT_EQ("Idle", *fsm.ActiveStateName());
+    ASSERT_EQ(std::vector<std::string>({ "AbeStandIdle" }), context.mAnimations);
+
+    fsm.Update();
+    ASSERT_EQ("Idle", *fsm.ActiveStateName());
+
+    context.mInputRight = true;
+    fsm.Update();
+    ASSERT_EQ("ToWalk", *fsm.ActiveStateName());
+
+    context.mAnimationComplete = true;
+    fsm.Update();
+    ASSERT_EQ("Walking", *fsm.ActiveStateName());
+    ASSERT_EQ(std::vector<std::string>({ "Walk effect" }), context.mSounds);
+
+    // !InputRight is the negation of InputRight
+    fsm.Update();
+    ASSERT_EQ("Walking", *fsm.ActiveStateName());
+    context.mInputRight = false;
+    fsm.Update();
+    ASSERT_EQ("ToIdle", *fsm.ActiveStateName());
+
+    fsm.Update();
+    ASSERT_EQ("Idle", *fsm.ActiveStateName());
+    ASSERT_EQ(std::vector<std::string>({ "AbeStandIdle", "AbeStandToWalk", "AbeWalking", "AbeWalkToStand", "AbeStandIdle" }), context.mAnimations);
+}
+
+TEST(FiniteStateMachine, MissingFunctionsAndStates)
+{
+    FiniteStateMachine fsm;
+
+    FsmState state("Start");
+    FsmStateTransition toMissingState("Nowhere");
+    state.AddTransition(toMissingState);
+    FsmStateTransition missingCondition("End");
+    missingCondition.AddCondition(StateCondition("NotAdded"));
+    state.AddTransition(missingCondition);
+    state.AddEnterAction(StateAction("NotAddedEither"));
+    fsm.AddState(state);
+    fsm.AddState(FsmState("End"));
+    fsm.Compile();
+
+    ASSERT_FALSE(fsm.ToState("Nowhere"));
+    ASSERT_EQ(nullptr, fsm.ActiveStateName());
+
+    ASSERT_TRUE(fsm.ToState("Start"));
+    fsm.Update();
+    ASSERT_EQ("Start", *fsm.ActiveStateName());
+}
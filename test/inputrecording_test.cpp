@@ -0,0 +1,134 @@
+#include <gmock/gmock.h>
+#include "inputrecording.hpp"
+#include "oddlib/stream.hpp"
+#include "oddlib/exceptions.hpp"
+#include <algorithm>
+#include <sstream>
+
+TEST(InputRecording, WriteAndRead)
+{
+    InputRecording recording;
+    recording.Start("R1P15", { "AePc", "AePsxCd1" });
+    recording.Add({ 1, 2, 3, 4 });
+    recording.Add({ 0, 0, 0xFFFFFFFF, 0x100000 });
+
+    Oddlib::MemoryStream stream(std::vector<u8>{});
+    recording.Write(stream);
+    stream.Seek(0);
+
+    InputRecording read;
+    read.Read(stream);
+    ASSERT_EQ("R1P15", read.PathName());
+    ASSERT_EQ((std::vector<std::string>{ "AePc", "AePsxCd1" }), read.DataSetNames());
+    ASSERT_EQ(2u, read.Ticks().size());
+    ASSERT_EQ(3u, read.Ticks()[0].mIsDown);
+    ASSERT_EQ(4u, read.Ticks()[0].mRawDownState);
+    ASSERT_EQ(0xFFFFFFFF, read.Ticks()[1].mIsDown);
+    ASSERT_EQ(0x100000u, read.Ticks()[1].mRawDownState);
+}
+
+TEST(InputRecording, NotARecording)
+{
+    Oddlib::MemoryStream stream(std::vector<u8>(64, 0xAB));
+    InputRecording read;
+    ASSERT_THROW(read.Read(stream), Oddlib::Exception);
+}
+
+TEST(InputRecording, NeedsDataSets)
+{
+    // Without the data sets the replay can't know which game to start
+    InputRecording recording;
+    recording.Start("R1P15", {});
+    recording.Add({ 1, 2, 3, 4 });
+
+    Oddlib::MemoryStream stream(std::vector<u8>{});
+    recording.Write(stream);
+    stream.Seek(0);
+
+    InputRecording read;
+    ASSERT_THROW(read.Read(stream), Oddlib::Exception);
+}
+
+TEST(ReplayBenchmark, Summary)
+{
+    ReplayBenchmark benchmark;
+    for (u32 i = 1; i <= 100; i++)
+    {
+        const f32 ms = static_cast<f32>(i);
+        benchmark.Add({ ms, 0.0f, 0.0f, 0.0f, ms });
+    }
+
+    const std::string summary = benchmark.Summary();
+    ASSERT_NE(std::string::npos, summary.find("100 ticks"));
+    ASSERT_NE(std::string::npos, summary.find("script     mean   50.500 median   51.000 p95   96.000 max  100.000"));
+
+    std::ostringstream csv;
+    benchmark.WriteCsv(csv);
+    const std::string rows = csv.str();
+    ASSERT_EQ(101, std::count(rows.begin(), rows.end(), '\n'));
+}
+
+// Stands in for the map, an object that moves with the input once the path is loaded
+struct ReplayTestMap
+{
+    bool mLoaded = false;
+    s32 mXPos = 0;
+
+    void Load()
+    {
+        mLoaded = true;
+        mXPos = 100;
+    }
+
+    void Update(const InputRecording::Tick& input)
+    {
+        if (mLoaded)
+        {
+            mXPos += (input.mIsDown & 1) ? 3 : 0;
+            mXPos -= (input.mIsDown & 2) ? 1 : 0;
+        }
+    }
+};
+
+TEST(InputReplay, MatchesRecordedRun)
+{
+    // Each engine tick reads the input, hands it to the recorder, can load a path and then
+    // updates the map with the input. Here the path is loaded part way through tick 5.
+    InputRecorder recorder;
+    ReplayTestMap recorded;
+    std::vector<s32> recordedPositions;
+    for (u32 i = 0; i < 40; i++)
+    {
+        const InputRecording::Tick input = { 0, 0, (i * 7) % 4, 0 };
+        recorder.Tick(input);
+        if (i == 5)
+        {
+            recorded.Load();
+            recorder.PathLoaded("R1P15", { "AePc" }, input);
+        }
+        recorded.Update(input);
+
+        if (recorder.IsRecording())
+        {
+            recordedPositions.push_back(recorded.mXPos);
+        }
+    }
+    ASSERT_EQ(35u, recorder.Recording().Ticks().size());
+
+    // The replay loads the path in its first tick, which then gets the first recorded input
+    InputReplay replay(recorder.Recording());
+    ReplayTestMap replayed;
+    std::vector<s32> replayedPositions;
+    while (const InputRecording::Tick* input = replay.NextTick([&](const std::string& pathName)
+    {
+        ASSERT_EQ("R1P15", pathName);
+        replayed.Load();
+    }))
+    {
+        replayed.Update(*input);
+        replayedPositions.push_back(replayed.mXPos);
+    }
+
+    ASSERT_TRUE(replay.IsFinished());
+    ASSERT_EQ(recordedPositions, replayedPositions);
+}
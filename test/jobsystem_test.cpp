@@ -0,0 +1,207 @@
+#include <gmock/gmock.h>
+#include "core/jobsystem.hpp"
+#include <stdexcept>
+
+TEST(JobSystem, ForkJoin)
+{
+    JobSystem jobs(3);
+    std::atomic<u32> sum{ 0 };
+
+    JobGroup group;
+    for (u32 i = 1; i <= 100; i++)
+    {
+        jobs.Run(group, [&sum, &jobs, i]()
+        {
+            // Jobs can fork and join themselves
+            JobGroup inner;
+            jobs.Run(inner, [&sum, i]() { sum += i; });
+            jobs.Run(inner, [&sum, i]() { sum += i; });
+            jobs.Wait(inner);
+        });
+    }
+    jobs.Wait(group);
+
+    ASSERT_TRUE(group.IsDone());
+    ASSERT_EQ(2u * 5050u, sum);
+}
+
+TEST(JobSystem, Continuations)
+{
+    JobSystem jobs(2);
+    std::atomic<u32> decoded{ 0 };
+    std::atomic<u32> seenByContinuation{ 0 };
+
+    JobGroup decodes;
+    for (u32 i = 0; i < 10; i++)
+    {
+        jobs.Run(decodes, [&decoded]() { decoded++; }, JobSystem::ePriority::eStreaming);
+    }
+
+    JobGroup finished;
+    jobs.Then(decodes, finished, [&]() { seenByContinuation = decoded.load(); });
+
+    bool ranOnMainThread = false;
+    jobs.ThenOnMainThread(finished, [&]() { ranOnMainThread = true; });
+
+    jobs.Wait(finished);
+    ASSERT_EQ(10u, seenByContinuation);
+
+    // The main thread job is only run by RunMainThreadJobs()
+    ASSERT_FALSE(ranOnMainThread);
+    jobs.RunMainThreadJobs();
+    ASSERT_TRUE(ranOnMainThread);
+
+    // A continuation of a group that is already done is started straight away
+    JobGroup again;
+    jobs.Then(decodes, again, [&decoded]() { decoded++; });
+    jobs.Wait(again);
+    ASSERT_EQ(11u, decoded);
+}
+
+TEST(JobSystem, StreamingDoesNotStarveFrameWork)
+{
+    JobSystem jobs(2);
+    std::atomic<bool> releaseStreaming{ false };
+    std::atomic<u32> streamingStarted{ 0 };
+
+    JobGroup streaming;
+    for (u32 i = 0; i < 4; i++)
+    {
+        jobs.Run(streaming, [&]()
+        {
+            streamingStarted++;
+            while (!releaseStreaming)
+            {
+                std::this_thread::yield();
+            }
+        }, JobSystem::ePriority::eStreaming);
+    }
+
+    // Give the workers time to take every streaming job they are allowed to before the frame jobs
+    // are queued
+    while (streamingStarted == 0)
+    {
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const u32 streamingRunning = streamingStarted;
+
+    // Only one of the two workers may run streaming jobs so frame work still gets done. The main
+    // thread only polls, a Wait() would run the frame jobs itself.
+    const std::thread::id mainThread = std::this_thread::get_id();
+    std::atomic<u32> frameJobs{ 0 };
+    std::atomic<u32> frameJobsOnMainThread{ 0 };
+    JobGroup frame;
+    for (u32 i = 0; i < 20; i++)
+    {
+        jobs.Run(frame, [&]()
+        {
+            frameJobs++;
+            if (std::this_thread::get_id() == mainThread)
+            {
+                frameJobsOnMainThread++;
+            }
+        });
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!frame.IsDone() && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::yield();
+    }
+    const bool frameDone = frame.IsDone();
+    const bool streamingDone = streaming.IsDone();
+
+    // Let the workers go before checking so a failure doesn't leave them spinning
+    releaseStreaming = true;
+    jobs.Wait(streaming);
+    jobs.Wait(frame);
+
+    ASSERT_EQ(1u, streamingRunning);
+    ASSERT_TRUE(frameDone);
+    ASSERT_EQ(20u, frameJobs);
+    ASSERT_EQ(0u, frameJobsOnMainThread);
+    ASSERT_FALSE(streamingDone);
+}
+
+TEST(JobSystem, FrameJobWaitsForStreamingWork)
+{
+    // A second worker is started so one is always free for frame work
+    JobSystem jobs(1);
+    ASSERT_EQ(2u, jobs.NumThreads());
+
+    // Every worker ends up waiting inside a frame job for streaming jobs, the waits run them
+    std::atomic<u32> decoded{ 0 };
+    JobGroup frame;
+    for (u32 i = 0; i < 4; i++)
+    {
+        jobs.Run(frame, [&decoded, &jobs]()
+        {
+            JobGroup streaming;
+            for (u32 j = 0; j < 3; j++)
+            {
+                jobs.Run(streaming, [&decoded]() { decoded++; }, JobSystem::ePriority::eStreaming);
+            }
+            jobs.Wait(streaming);
+        });
+    }
+    jobs.Wait(frame);
+    ASSERT_EQ(12u, decoded);
+}
+
+TEST(JobSystem, For)
+{
+    JobSystem jobs(3);
+    std::vector<u32> values(1000, 0);
+    jobs.For(static_cast<u32>(values.size()), [&values](u32 i) { values[i] = i * 2; });
+    for (u32 i = 0; i < values.size(); i++)
+    {
+        ASSERT_EQ(i * 2, values[i]);
+    }
+}
+
+TEST(JobSystem, WaitThrowsJobExceptions)
+{
+    JobSystem jobs(2);
+
+    JobGroup group;
+    jobs.Run(group, []() { throw std::runtime_error("Bad data"); });
+    jobs.Run(group, []() { });
+    ASSERT_THROW(jobs.Wait(group), std::runtime_error);
+    ASSERT_TRUE(group.IsDone());
+
+    ASSERT_THROW(jobs.For(100, [](u32 i)
+    {
+        if (i == 50)
+        {
+            throw std::runtime_error("Bad strip");
+        }
+    }), std::runtime_error);
+}
+
+TEST(JobSystem, WaitForGivesUp)
+{
+    JobSystem jobs(2);
+    std::atomic<bool> started{ false };
+    std::atomic<bool> release{ false };
+
+    JobGroup group;
+    jobs.Run(group, [&]()
+    {
+        started = true;
+        while (!release)
+        {
+            std::this_thread::yield();
+        }
+    });
+
+    // The only job is already running on a worker, so this sleeps until the timeout
+    while (!started)
+    {
+        std::this_thread::yield();
+    }
+    ASSERT_FALSE(jobs.WaitFor(group, std::chrono::milliseconds(10)));
+
+    release = true;
+    ASSERT_TRUE(jobs.WaitFor(group, std::chrono::seconds(30)));
+}
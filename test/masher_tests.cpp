@@ -1,5 +1,7 @@
 #include <gmock/gmock.h>
 #include "oddlib/masher.hpp"
+#include "oddlib/video_kernels.hpp"
+#include "hash_util.hpp"
 #include "all_colours_high_compression_30_fps.ddv.g.h"
 #include "ddv_test1.ddv.g.h"
 #include "all_colours_low_compression_30_fps.ddv.g.h"
@@ -1651,6 +1653,7 @@ public:
     }
 
     using Oddlib::Masher::decode_audio_frame;
+    using Oddlib::Masher::SetVideoKernels;
 };
 
 // Audio and video test
@@ -1769,6 +1772,33 @@ TEST(Masher, stereo_16_high_compression_all_samples)
 
 }
 
+TEST(Masher, SeekMatchesSequentialDecode)
+{
+    TestMasher masher(std::make_unique<Oddlib::MemoryStream>(get_stereo_16_high_compression_all_samples()));
+    const size_t frameSize = masher.SingleAudioFrameSizeSamples() * 4;
+
+    std::vector<std::vector<u8>> frames;
+    std::vector<u8> audioBuffer(frameSize);
+    while (masher.Update(nullptr, audioBuffer.data()))
+    {
+        frames.push_back(audioBuffer);
+    }
+    ASSERT_EQ(masher.NumberOfFrames(), frames.size());
+
+    // Backwards, forwards and to the same frame again
+    for (u32 frame : { 17u, 3u, 3u, 0u, 22u, 9u })
+    {
+        ASSERT_EQ(frame, masher.Seek(frame));
+        ASSERT_EQ(frame, masher.FrameNumber());
+        ASSERT_TRUE(masher.Update(nullptr, audioBuffer.data()));
+        ASSERT_EQ(frames[frame], audioBuffer) << "frame " << frame;
+    }
+
+    // Past the end clamps to the end of the stream
+    ASSERT_EQ(masher.NumberOfFrames(), masher.Seek(1000));
+    ASSERT_FALSE(masher.Update(nullptr, audioBuffer.data()));
+}
+
 TEST(Masher, stereo_16_low_compression_all_samples)
 {
     // Oddlib::Masher masher(get_stereo_16_low_compression_all_samples());
@@ -1814,3 +1844,159 @@ TEST(Masher, Decode16BitStereoAudio)
     memcpy(expected16.data(), kExpected.data(), kExpected.size());
     ASSERT_TRUE(memcmp(expected16.data(), outPtr.data(), outPtr.size()*sizeof(u16)) == 0);
 }
+
+// Deterministic input for the kernel tests
+class KernelTestRandom
+{
+public:
+    u32 Next()
+    {
+        mState = (mState * 1664525u) + 1013904223u;
+        return mState;
+    }
+
+    s32 Range(s32 min, s32 max)
+    {
+        return min + static_cast<s32>((Next() >> 8) % static_cast<u32>(max - min + 1));
+    }
+private:
+    u32 mState = 0x12345678;
+};
+
+static std::vector<const Oddlib::VideoKernels*> SimdVideoKernels()
+{
+    std::vector<const Oddlib::VideoKernels*> ret;
+    if (Oddlib::Sse2VideoKernels())
+    {
+        ret.push_back(Oddlib::Sse2VideoKernels());
+    }
+    if (Oddlib::Avx2VideoKernels())
+    {
+        ret.push_back(Oddlib::Avx2VideoKernels());
+    }
+    return ret;
+}
+
+TEST(VideoKernels, MasherIdctMatchesScalar)
+{
+    KernelTestRandom rng;
+    for (const Oddlib::VideoKernels* kernels : SimdVideoKernels())
+    {
+        for (int i = 0; i < 2000; i++)
+        {
+            // Only the low 16 bits of each dword are coefficients, the rest is junk the IDCT must ignore
+            s16 input[128];
+            for (int j = 0; j < 64; j++)
+            {
+                const bool isZero = rng.Range(0, 3) != 0 && j != 0;
+                input[j * 2] = isZero ? 0 : static_cast<s16>(rng.Range(-256, 255));
+                input[(j * 2) + 1] = static_cast<s16>(rng.Next());
+            }
+
+            s32 expected[64] = {};
+            s32 actual[64] = {};
+            Oddlib::ScalarVideoKernels().mMasherIdct(input, expected);
+            kernels->mMasherIdct(input, actual);
+            ASSERT_EQ(0, memcmp(expected, actual, sizeof(expected))) << kernels->mName << " block " << i;
+        }
+    }
+}
+
+TEST(VideoKernels, PsxIdctMatchesScalar)
+{
+    KernelTestRandom rng;
+    for (const Oddlib::VideoKernels* kernels : SimdVideoKernels())
+    {
+        for (int i = 0; i < 2000; i++)
+        {
+            // Mostly empty blocks with the odd large value to hit the 16 bit wrap around and zero column paths
+            s16 expected[64];
+            for (int j = 0; j < 64; j++)
+            {
+                const s32 kind = rng.Range(0, 15);
+                expected[j] = kind < 10 ? 0 : static_cast<s16>(kind < 14 ? rng.Range(-512, 511) : rng.Range(-32768, 32767));
+            }
+
+            s16 actual[64];
+            memcpy(actual, expected, sizeof(actual));
+            Oddlib::ScalarVideoKernels().mPsxIdct(expected);
+            kernels->mPsxIdct(actual);
+            ASSERT_EQ(0, memcmp(expected, actual, sizeof(expected))) << kernels->mName << " block " << i;
+        }
+    }
+}
+
+TEST(VideoKernels, MasherYCbCrToRgbMatchesScalar)
+{
+    KernelTestRandom rng;
+
+    // Not a multiple of 16 so the right and bottom macroblocks are clipped
+    const s32 width = 40;
+    const s32 height = 24;
+    for (const Oddlib::VideoKernels* kernels : SimdVideoKernels())
+    {
+        for (int i = 0; i < 200; i++)
+        {
+            Oddlib::MasherMacroBlock block;
+            for (int j = 0; j < 64; j++)
+            {
+                block.mCr[j] = rng.Range(-300, 300);
+                block.mCb[j] = rng.Range(-300, 300);
+                for (int k = 0; k < 4; k++)
+                {
+                    block.mY[k][j] = rng.Range(-100, 400);
+                }
+            }
+
+            const s32 xoff = rng.Range(0, 2) * 16;
+            const s32 yoff = rng.Range(0, 1) * 16;
+            std::vector<u32> expected(width * height, 0xDEADBEEF);
+            std::vector<u32> actual(width * height, 0xDEADBEEF);
+            Oddlib::ScalarVideoKernels().mMasherYCbCrToRgb(block, expected.data(), xoff, yoff, width, height);
+            kernels->mMasherYCbCrToRgb(block, actual.data(), xoff, yoff, width, height);
+            ASSERT_EQ(expected, actual) << kernels->mName << " block " << i;
+        }
+    }
+}
+
+// FNV-1a of the pixels of every frame of a movie
+static u64 HashMovieFrames(std::vector<u8> movie, const Oddlib::VideoKernels& kernels)
+{
+    TestMasher masher(std::make_unique<Oddlib::MemoryStream>(std::move(movie)));
+    masher.SetVideoKernels(kernels);
+
+    std::vector<u32> pixels(masher.Width() * masher.Height());
+    u64 hash = hash_util::kFnv1aSeed;
+    while (masher.Update(pixels.data(), nullptr))
+    {
+        hash = hash_util::Fnv1a(reinterpret_cast<const u8*>(pixels.data()), pixels.size() * sizeof(u32), hash);
+    }
+    return hash;
+}
+
+TEST(VideoKernels, MasherFramesMatchGoldenHash)
+{
+    // Hashes of the scalar output
+    struct Movie
+    {
+        std::vector<u8>(*mData)();
+        u64 mHash;
+    };
+    const Movie kMovies[] =
+    {
+        { get_all_colours_min_compression_30_fps, 0xbf074814b377a4deull },
+        { get_all_colours_low_compression_30_fps, 0x0839630b05e28063ull },
+        { get_all_colours_medium_compression_30_fps, 0xd2e50a7c9b85b508ull },
+        { get_all_colours_max_compression_30_fps, 0x27f1bab0caae0857ull },
+    };
+
+    std::vector<const Oddlib::VideoKernels*> kernelSets = SimdVideoKernels();
+    kernelSets.insert(kernelSets.begin(), &Oddlib::ScalarVideoKernels());
+    for (const Oddlib::VideoKernels* kernels : kernelSets)
+    {
+        for (const Movie& movie : kMovies)
+        {
+            ASSERT_EQ(movie.mHash, HashMovieFrames(movie.mData(), *kernels)) << kernels->mName;
+        }
+    }
+}
@@ -1,8 +1,112 @@
 #include <gmock/gmock.h>
 #include "zipfilesystem.hpp"
+#include "zipentrystream.hpp"
 #include "inmemoryfs.hpp"
 #include "SimpleNoComp.zip.g.h"
 #include "MaxECDRComment.zip.g.h"
+#include "Deflated.zip.g.h"
+#include "oddlib/exceptions.hpp"
+#include <algorithm>
+
+static void AppendU16(std::vector<u8>& data, u16 value)
+{
+    data.push_back(static_cast<u8>(value));
+    data.push_back(static_cast<u8>(value >> 8));
+}
+
+static void AppendU32(std::vector<u8>& data, u32 value)
+{
+    AppendU16(data, static_cast<u16>(value));
+    AppendU16(data, static_cast<u16>(value >> 16));
+}
+
+static void AppendString(std::vector<u8>& data, const std::string& str)
+{
+    data.insert(data.end(), str.begin(), str.end());
+}
+
+static std::string ZipTestFileName(u32 index)
+{
+    return "Dir" + std::to_string(index % 16) + "/File" + std::to_string(index) + ".txt";
+}
+
+struct ZipTestEntry
+{
+    std::string mName;
+    u16 mCompressionMethod;
+    std::vector<u8> mData;
+    u32 mUnCompressedSize;
+};
+
+static std::vector<u8> MakeZip(const std::vector<ZipTestEntry>& entries)
+{
+    std::vector<u8> data;
+    std::vector<u32> localHeaderOffsets;
+    for (const ZipTestEntry& entry : entries)
+    {
+        localHeaderOffsets.push_back(static_cast<u32>(data.size()));
+        AppendU32(data, 0x04034b50);
+        AppendU16(data, 20); // Version needed
+        AppendU16(data, 0); // Flags
+        AppendU16(data, entry.mCompressionMethod);
+        AppendU16(data, 0); // Time
+        AppendU16(data, 0); // Date
+        AppendU32(data, 0); // Crc32, not checked
+        AppendU32(data, static_cast<u32>(entry.mData.size()));
+        AppendU32(data, entry.mUnCompressedSize);
+        AppendU16(data, static_cast<u16>(entry.mName.size()));
+        AppendU16(data, 0); // Extra field length
+        AppendString(data, entry.mName);
+        data.insert(data.end(), entry.mData.begin(), entry.mData.end());
+    }
+
+    const u32 centralDirectoryOffset = static_cast<u32>(data.size());
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        const ZipTestEntry& entry = entries[i];
+        AppendU32(data, 0x02014b50);
+        AppendU16(data, 20); // Created by
+        AppendU16(data, 20); // Version needed
+        AppendU16(data, 0); // Flags
+        AppendU16(data, entry.mCompressionMethod);
+        AppendU16(data, 0); // Time
+        AppendU16(data, 0); // Date
+        AppendU32(data, 0); // Crc32
+        AppendU32(data, static_cast<u32>(entry.mData.size()));
+        AppendU32(data, entry.mUnCompressedSize);
+        AppendU16(data, static_cast<u16>(entry.mName.size()));
+        AppendU16(data, 0); // Extra field length
+        AppendU16(data, 0); // Comment length
+        AppendU16(data, 0); // Disk number
+        AppendU16(data, 0); // Internal attributes
+        AppendU32(data, 0); // External attributes
+        AppendU32(data, localHeaderOffsets[i]);
+        AppendString(data, entry.mName);
+    }
+
+    const u32 centralDirectorySize = static_cast<u32>(data.size()) - centralDirectoryOffset;
+    AppendU32(data, 0x06054b50);
+    AppendU16(data, 0); // This disk
+    AppendU16(data, 0); // Central directory disk
+    AppendU16(data, static_cast<u16>(entries.size()));
+    AppendU16(data, static_cast<u16>(entries.size()));
+    AppendU32(data, centralDirectorySize);
+    AppendU32(data, centralDirectoryOffset);
+    AppendU16(data, 0); // Comment length
+    return data;
+}
+
+// A zip of numFiles uncompressed entries named by ZipTestFileName() with the name as the content
+static std::vector<u8> MakeStoredZip(u32 numFiles)
+{
+    std::vector<ZipTestEntry> entries;
+    for (u32 i = 0; i < numFiles; i++)
+    {
+        const std::string name = ZipTestFileName(i);
+        entries.push_back({ name, 0, std::vector<u8>(name.begin(), name.end()), static_cast<u32>(name.size()) });
+    }
+    return MakeZip(entries);
+}
 
 TEST(ZipFileSystem, SimpleZip)
 {
@@ -51,3 +155,314 @@ TEST(ZipFileSystem, MaxECDRComment)
     ASSERT_NE(nullptr, s1);
     ASSERT_EQ("Hello world!", s1->LoadAllToString());
 }
+
+TEST(ZipFileSystem, LookupIgnoresCaseAndSlashes)
+{
+    InMemoryFileSystem fs;
+    ASSERT_TRUE(fs.Init());
+    fs.AddFile("test.zip", MakeStoredZip(40));
+
+    ZipFileSystem z("test.zip", fs);
+    ASSERT_TRUE(z.Init());
+
+    // Found names are given back as they are in the zip
+    std::string name = "dir5\\FILE21.TXT";
+    ASSERT_TRUE(z.FileExists(name));
+    ASSERT_EQ("Dir5/File21.txt", name);
+
+    auto s = z.Open("DIR7//file39.TXT");
+    ASSERT_NE(nullptr, s);
+    ASSERT_EQ("Dir7/File39.txt", s->LoadAllToString());
+
+    std::string missing = "Dir5/File40.txt";
+    ASSERT_FALSE(z.FileExists(missing));
+    ASSERT_EQ(nullptr, z.Open(missing));
+}
+
+TEST(ZipFileSystem, LookupDoesNotScanEntries)
+{
+    const u32 kNumFiles = 50000;
+    InMemoryFileSystem fs;
+    ASSERT_TRUE(fs.Init());
+    fs.AddFile("big.zip", MakeStoredZip(kNumFiles));
+
+    ZipFileSystem big("big.zip", fs);
+    ASSERT_TRUE(big.Init());
+
+    // Names spread through the zip
+    for (u32 i = 0; i < 1000; i++)
+    {
+        std::string name = ZipTestFileName((i * 7919) % kNumFiles);
+        ASSERT_TRUE(big.FileExists(name));
+        ASSERT_NE(nullptr, big.Open(name));
+    }
+
+    // Scanning the records would compare with every name in the zip
+    ASSERT_LT(big.MaxLookupComparisons(), 16u);
+}
+
+TEST(ZipFileSystem, DeflatedEntries)
+{
+    InMemoryFileSystem fs;
+    ASSERT_TRUE(fs.Init());
+    fs.AddFile("test.zip", get_Deflated());
+
+    ZipFileSystem z("test.zip", fs);
+    ASSERT_TRUE(z.Init());
+
+    // Dynamic Huffman blocks, stored blocks and a fixed Huffman block
+    ASSERT_EQ(z.Open("TextStored.txt")->LoadAllToString(), z.Open("Text.txt")->LoadAllToString());
+    ASSERT_EQ(z.Open("NoiseStored.bin")->LoadAllToString(), z.Open("Noise.bin")->LoadAllToString());
+    ASSERT_EQ("Hello hello hello world!", z.Open("Short.txt")->LoadAllToString());
+}
+
+TEST(ZipFileSystem, DeflatedEntryReadsAndSeeks)
+{
+    InMemoryFileSystem fs;
+    ASSERT_TRUE(fs.Init());
+    fs.AddFile("test.zip", get_Deflated());
+
+    ZipFileSystem z("test.zip", fs);
+    ASSERT_TRUE(z.Init());
+
+    auto stored = z.Open("TextStored.txt");
+    auto deflated = z.Open("Text.txt");
+    ASSERT_EQ(stored->Size(), deflated->Size());
+
+    // Reads that end part way through matches and blocks
+    const size_t chunkSizes[] = { 1, 7, 258, 4093, 40000 };
+    size_t chunk = 0;
+    while (!deflated->AtEnd())
+    {
+        const size_t size = std::min(chunkSizes[chunk++ % 5], deflated->Size() - deflated->Pos());
+        std::vector<u8> expected(size);
+        std::vector<u8> actual(size);
+        stored->ReadBytes(expected.data(), size);
+        deflated->ReadBytes(actual.data(), size);
+        ASSERT_EQ(expected, actual);
+    }
+
+    // Backwards seeks start again, forwards seeks skip
+    const size_t positions[] = { 10, 40000, 100, 100, 45000, 0 };
+    for (size_t pos : positions)
+    {
+        stored->Seek(pos);
+        deflated->Seek(pos);
+        ASSERT_EQ(pos, deflated->Pos());
+
+        std::vector<u8> expected(64);
+        std::vector<u8> actual(64);
+        stored->ReadBytes(expected.data(), expected.size());
+        deflated->ReadBytes(actual.data(), actual.size());
+        ASSERT_EQ(expected, actual);
+    }
+
+    deflated->Seek(deflated->Size() - 1);
+    u8 bytes[2] = {};
+    ASSERT_THROW(deflated->ReadBytes(bytes, 2), Oddlib::Exception);
+
+    std::unique_ptr<Oddlib::IStream> clone(deflated->Clone());
+    ASSERT_EQ(0u, clone->Pos());
+    ASSERT_EQ(stored->LoadAllToString(), clone->LoadAllToString());
+}
+
+// Packs values from their least significant bit like deflate does, Huffman codes are packed from
+// their most significant bit
+struct DeflateBitWriter
+{
+    std::vector<u8> mData;
+    u32 mBitCount = 0;
+
+    void PutBit(u32 bit)
+    {
+        if (mBitCount % 8 == 0)
+        {
+            mData.push_back(0);
+        }
+        mData.back() |= static_cast<u8>(bit << (mBitCount % 8));
+        mBitCount++;
+    }
+
+    void PutValue(u32 value, u32 count)
+    {
+        for (u32 i = 0; i < count; i++)
+        {
+            PutBit((value >> i) & 1);
+        }
+    }
+
+    void PutCode(u32 code, u32 count)
+    {
+        for (u32 i = count; i-- > 0;)
+        {
+            PutBit((code >> i) & 1);
+        }
+    }
+};
+
+// Fixed Huffman codes and the extra bits of deflate, see RFC 1951 3.2.5 and 3.2.6
+static const u16 kTestLengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const u8 kTestLengthExtraBits[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const u16 kTestDistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const u8 kTestDistanceExtraBits[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+static void PutFixedLiteral(DeflateBitWriter& writer, u8 value)
+{
+    if (value < 144)
+    {
+        writer.PutCode(0x30 + value, 8);
+    }
+    else
+    {
+        writer.PutCode(0x190 + value - 144, 9);
+    }
+}
+
+static void PutFixedMatch(DeflateBitWriter& writer, u32 length, u32 distance)
+{
+    u32 lengthIndex = 28;
+    while (kTestLengthBase[lengthIndex] > length)
+    {
+        lengthIndex--;
+    }
+    const u32 symbol = 257 + lengthIndex;
+    if (symbol <= 279)
+    {
+        writer.PutCode(symbol - 256, 7);
+    }
+    else
+    {
+        writer.PutCode(0xC0 + symbol - 280, 8);
+    }
+    writer.PutValue(length - kTestLengthBase[lengthIndex], kTestLengthExtraBits[lengthIndex]);
+
+    u32 distanceIndex = 29;
+    while (kTestDistanceBase[distanceIndex] > distance)
+    {
+        distanceIndex--;
+    }
+    writer.PutCode(distanceIndex, 5);
+    writer.PutValue(distance - kTestDistanceBase[distanceIndex], kTestDistanceExtraBits[distanceIndex]);
+}
+
+TEST(ZipFileSystem, DeflatedEntrySeeksBackwards)
+{
+    // 3MB of fixed Huffman blocks with literals and matches as far back as the whole window, and
+    // stored blocks in between, so seeks have to start again from the middle of either kind of block
+    std::vector<u8> expected;
+    DeflateBitWriter writer;
+    u32 seed = 1;
+    auto random = [&seed]()
+    {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 16) & 0x7FFF;
+    };
+
+    const size_t kSize = 3 * 1024 * 1024;
+    while (expected.size() < kSize)
+    {
+        const bool stored = random() % 3 == 0;
+        const size_t blockSize = stored ? 1 + random() : 200000 + random();
+        const size_t blockEnd = std::min(kSize, expected.size() + blockSize);
+        const bool finalBlock = blockEnd == kSize;
+        writer.PutValue(finalBlock ? 1 : 0, 1);
+        if (stored)
+        {
+            writer.PutValue(0, 2);
+            while (writer.mBitCount % 8 != 0)
+            {
+                writer.PutBit(0);
+            }
+
+            const u32 len = static_cast<u32>(blockEnd - expected.size());
+            writer.PutValue(len, 16);
+            writer.PutValue(~len & 0xFFFF, 16);
+            for (u32 i = 0; i < len; i++)
+            {
+                const u8 value = static_cast<u8>(random());
+                writer.PutValue(value, 8);
+                expected.push_back(value);
+            }
+        }
+        else
+        {
+            writer.PutValue(1, 2);
+            while (expected.size() < blockEnd)
+            {
+                const u32 length = std::min(3 + random() % 256, static_cast<u32>(blockEnd - expected.size()));
+                if (length >= 3 && expected.size() >= 32768 && random() % 4 == 0)
+                {
+                    const u32 distance = 1 + random();
+                    PutFixedMatch(writer, length, distance);
+                    for (u32 i = 0; i < length; i++)
+                    {
+                        expected.push_back(expected[expected.size() - distance]);
+                    }
+                }
+                else
+                {
+                    const u8 value = static_cast<u8>(random());
+                    PutFixedLiteral(writer, value);
+                    expected.push_back(value);
+                }
+            }
+            writer.PutCode(0, 7); // End of block
+        }
+    }
+
+    InMemoryFileSystem fs;
+    ASSERT_TRUE(fs.Init());
+    fs.AddFile("test.zip", MakeZip({ { "Big.lvl", 8, std::move(writer.mData), static_cast<u32>(expected.size()) } }));
+
+    ZipFileSystem z("test.zip", fs);
+    ASSERT_TRUE(z.Init());
+    auto s = z.Open("Big.lvl");
+    ASSERT_NE(nullptr, s);
+    ASSERT_EQ(expected.size(), s->Size());
+
+    // Reads spanning checkpoints, backwards and forwards over them and back to the start
+    const size_t positions[] = { kSize - 5000, 2500003, 600000, 1300000, 100, 2900000, 1048576 - 1, 1048576, 524288 - 7, 0, kSize - 5000 };
+    for (size_t pos : positions)
+    {
+        s->Seek(pos);
+        ASSERT_EQ(pos, s->Pos());
+
+        std::vector<u8> actual(5000);
+        s->ReadBytes(actual.data(), actual.size());
+        ASSERT_TRUE(std::equal(actual.begin(), actual.end(), expected.begin() + pos)) << "at " << pos;
+    }
+}
+
+TEST(ZipFileSystem, LargeDeflatedEntryIsNotLoadedOnOpen)
+{
+    // One fixed Huffman block of an 'A' then 200MB of matches of 258 bytes at a distance of 1
+    const u32 kMatches = 812850;
+    DeflateBitWriter writer;
+    writer.PutValue(1, 1); // Final block
+    writer.PutValue(1, 2); // Fixed Huffman codes
+    writer.PutCode(0x30 + 'A', 8);
+    for (u32 i = 0; i < kMatches; i++)
+    {
+        writer.PutCode(0xC5, 8); // Length 258
+        writer.PutCode(0, 5); // Distance 1
+    }
+    writer.PutCode(0, 7); // End of block
+
+    const u32 size = 1 + kMatches * 258;
+    InMemoryFileSystem fs;
+    ASSERT_TRUE(fs.Init());
+    fs.AddFile("test.zip", MakeZip({ { "Big.lvl", 8, std::move(writer.mData), size } }));
+
+    ZipFileSystem z("test.zip", fs);
+    ASSERT_TRUE(z.Init());
+
+    // Inflating the whole entry on open would take over 200MB, the entry is inflated as it is read
+    auto s = z.Open("Big.lvl");
+    ASSERT_NE(nullptr, s);
+    ASSERT_NE(nullptr, dynamic_cast<ZipInflateStream*>(s.get()));
+    ASSERT_EQ(size, s->Size());
+
+    std::vector<u8> header(4096);
+    s->ReadBytes(header.data(), header.size());
+    ASSERT_EQ(std::vector<u8>(4096, 'A'), header);
+}
@@ -0,0 +1,454 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "SDL.h"
+#include "oddlib/audio/AliveAudio.h"
+#include "oddlib/audio/SequencePlayer.h"
+#include "oddlib/audio/ReverbBus.h"
+#include "resourcemapper.hpp"
+#include "gamedefinition.hpp"
+#include "gamefilesystem.hpp"
+#include "logger.hpp"
+#include "hash_util.hpp"
+#include "msvc_sdl_link.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <new>
+#include <sstream>
+
+// Renders audio offline through the same path the SDL callback uses and reports
+// how long each callback took, how many heap allocations it made and a hash of the
+// output so that optimisations can be checked to be bit exact.
+//
+// AudioBench [--seconds n] [--frames n] [--voices 1,8,32] [--interp none|linear|cubic|hermite|all] [--resource name]...
+//
+// Without --resource a synthetic sound bank is used so no game data is required.
+
+static std::atomic<bool> gCountAllocations(false);
+static std::atomic<u64> gAllocationCount(0);
+
+void* operator new(std::size_t size)
+{
+    if (gCountAllocations)
+    {
+        gAllocationCount++;
+    }
+
+    void* p = malloc(size ? size : 1);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    free(p);
+}
+
+static const u32 kSyntheticPrograms = 16;
+static const u32 kSyntheticSamples = 4;
+static const u32 kNoteHoldCallbacks = 20;
+
+struct BenchSettings
+{
+    u32 mSeconds = 10;
+    u32 mFrames = 1024;
+    std::vector<u32> mVoiceCounts = { 1, 8, 32, 64 };
+    std::vector<AudioInterpolation> mInterpolations = { AudioInterpolation_none, AudioInterpolation_linear, AudioInterpolation_cubic, AudioInterpolation_hermite };
+    std::vector<std::string> mResources;
+};
+
+class BenchResult
+{
+public:
+    // stream is len interleaved stereo samples
+    void AddCallback(f64 microSeconds, u64 allocations, const f32* stream, u32 len)
+    {
+        mCallbackTimes.push_back(microSeconds);
+        mAllocations += allocations;
+        mRenderedFrames += len / 2;
+
+        // Any change in rendering changes the hash
+        mHash = hash_util::Fnv1a(reinterpret_cast<const u8*>(stream), len * sizeof(f32), mHash);
+    }
+
+    void Print(const std::string& name)
+    {
+        std::sort(mCallbackTimes.begin(), mCallbackTimes.end());
+
+        f64 total = 0.0;
+        for (f64 t : mCallbackTimes)
+        {
+            total += t;
+        }
+
+        // What was rendered rather than what was asked for, callbacks don't divide every duration evenly
+        const f64 renderedMicroSeconds = (mRenderedFrames * 1000000.0) / kAliveAudioSampleRate;
+        const f64 realTimeFactor = total > 0.0 ? renderedMicroSeconds / total : 0.0;
+        const f64 allocsPerCallback = mCallbackTimes.empty() ? 0.0 : static_cast<f64>(mAllocations) / mCallbackTimes.size();
+
+        printf("%-32s rt=%8.1fx p50=%8.1fus p90=%8.1fus p99=%8.1fus max=%8.1fus allocs/cb=%6.2f hash=%016llx\n",
+            name.c_str(),
+            realTimeFactor,
+            Percentile(0.50),
+            Percentile(0.90),
+            Percentile(0.99),
+            mCallbackTimes.empty() ? 0.0 : mCallbackTimes.back(),
+            allocsPerCallback,
+            static_cast<unsigned long long>(mHash));
+    }
+
+private:
+    f64 Percentile(f64 p) const
+    {
+        if (mCallbackTimes.empty())
+        {
+            return 0.0;
+        }
+        const size_t idx = static_cast<size_t>(p * (mCallbackTimes.size() - 1));
+        return mCallbackTimes[idx];
+    }
+
+    std::vector<f64> mCallbackTimes;
+    u64 mAllocations = 0;
+    u64 mRenderedFrames = 0;
+    u64 mHash = hash_util::kFnv1aSeed;
+};
+
+static const char* InterpolationName(AudioInterpolation interpolation)
+{
+    switch (interpolation)
+    {
+    case AudioInterpolation_none:    return "none";
+    case AudioInterpolation_linear:  return "linear";
+    case AudioInterpolation_cubic:   return "cubic";
+    case AudioInterpolation_hermite: return "hermite";
+    }
+    return "?";
+}
+
+// Times a single audio callback, fn must fill stream with len samples
+template<class T>
+static void TimeCallback(BenchResult& result, std::vector<f32>& stream, T fn)
+{
+    std::fill(stream.begin(), stream.end(), 0.0f);
+
+    gAllocationCount = 0;
+    gCountAllocations = true;
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    fn(stream.data(), static_cast<u32>(stream.size()));
+
+    const auto end = std::chrono::high_resolution_clock::now();
+    gCountAllocations = false;
+
+    const f64 us = std::chrono::duration_cast<std::chrono::duration<f64, std::micro>>(end - start).count();
+    result.AddCallback(us, gAllocationCount, stream.data(), static_cast<u32>(stream.size()));
+}
+
+// A few seconds of deterministic tones that exercise looping, one shot, reverb
+// and every resampling ratio without needing any game data.
+static std::unique_ptr<AliveAudioSoundbank> MakeSyntheticSoundbank()
+{
+    auto vab = std::make_unique<Vab>(); // Value initialized so it has no programs
+    auto soundbank = std::make_unique<AliveAudioSoundbank>(*vab);
+
+    u32 noise = 0x12345678;
+    for (u32 i = 0; i < kSyntheticSamples; i++)
+    {
+        auto sample = std::make_unique<AliveAudioSample>();
+        const u32 size = 2048u << i;
+        sample->m_SampleBuffer.resize(size);
+        sample->mSampleSize = size;
+        for (u32 j = 0; j < size; j++)
+        {
+            f32 value = 0.0f;
+            switch (i)
+            {
+            case 0: value = std::sin(j * 0.0628f); break;
+            case 1: value = ((j % 100) / 50.0f) - 1.0f; break;
+            case 2: value = (j % 64) < 32 ? 0.5f : -0.5f; break;
+            default:
+                noise = noise * 1664525u + 1013904223u;
+                value = ((noise >> 16) / 32768.0f) - 1.0f;
+                break;
+            }
+            sample->m_SampleBuffer[j] = static_cast<u16>(static_cast<s16>(value * 16000.0f));
+        }
+        soundbank->m_Samples.emplace_back(std::move(sample));
+    }
+
+    for (u32 i = 0; i < kSyntheticPrograms; i++)
+    {
+        auto tone = std::make_unique<AliveAudioTone>();
+        tone->f_Volume = 0.5f;
+        tone->f_Pan = ((i % 5) / 2.0f) - 1.0f;
+        tone->mMidiRootKey = 60;
+        tone->c_Shift = 0;
+        tone->Min = 0;
+        tone->Max = 127;
+        tone->Pitch = (i % 3) * 0.25f;
+        tone->Reverbate = (i % 2) == 1;
+        tone->Env.AttackTime = 0.005 * (i % 4);
+        tone->Env.DecayTime = 0.1;
+        tone->Env.SustainLevel = 0.6;
+        tone->Env.LinearReleaseTime = 0.2;
+        tone->Env.ExpRelease = (i % 3) == 0;
+        tone->Loop = (i % 4) != 3;
+        tone->m_Sample = soundbank->m_Samples[i % kSyntheticSamples].get();
+        soundbank->m_Programs[i]->m_Tones.emplace_back(std::move(tone));
+    }
+
+    return soundbank;
+}
+
+static void RunSynthetic(const BenchSettings& settings, u32 voiceCount, AudioInterpolation interpolation)
+{
+    srand(0);
+
+    AliveAudio audio;
+    audio.SetSoundbank(MakeSyntheticSoundbank());
+    audio.Interpolation = interpolation;
+
+    ReverbBus reverb;
+    BenchResult result;
+    std::vector<f32> stream(settings.mFrames * 2);
+
+    struct HeldNote
+    {
+        int mProgram;
+        int mNote;
+        u32 mReleaseCallback;
+    };
+    std::deque<HeldNote> heldNotes;
+
+    u32 trigger = 0;
+    const u32 numCallbacks = (settings.mSeconds * kAliveAudioSampleRate) / settings.mFrames;
+    for (u32 cb = 0; cb < numCallbacks; cb++)
+    {
+        // Game thread work, not part of the timing
+        while (!heldNotes.empty() && heldNotes.front().mReleaseCallback <= cb)
+        {
+            audio.NoteOff(heldNotes.front().mProgram, heldNotes.front().mNote);
+            heldNotes.pop_front();
+        }
+
+        while (audio.NumberOfActiveVoices() < voiceCount)
+        {
+            const int program = trigger % kSyntheticPrograms;
+            const int note = 48 + ((trigger * 7) % 25);
+            audio.NoteOn(program, note, 100);
+            heldNotes.push_back({ program, note, cb + kNoteHoldCallbacks + (trigger % 7) });
+            trigger++;
+        }
+
+        TimeCallback(result, stream, [&](f32* data, u32 len)
+        {
+            reverb.Begin(len);
+            audio.Play(data, reverb.Send(), len);
+            reverb.Mix(data, len);
+        });
+    }
+
+    std::stringstream name;
+    name << "synthetic voices=" << voiceCount << " " << InterpolationName(interpolation);
+    result.Print(name.str());
+}
+
+static void RunResource(const BenchSettings& settings, ResourceLocator& locator, const std::string& resourceName, AudioInterpolation interpolation)
+{
+    srand(0);
+
+    std::unique_ptr<ISound> sound = locator.LocateSound(resourceName.c_str());
+    if (!sound)
+    {
+        LOG_ERROR("Sound " << resourceName << " not found");
+        return;
+    }
+
+    sound->Load();
+
+    BaseSeqSound* seqSound = dynamic_cast<BaseSeqSound*>(sound.get());
+    if (seqSound)
+    {
+        seqSound->mSeqPlayer->SetInterpolation(interpolation);
+    }
+
+    ReverbBus reverb;
+    BenchResult result;
+    std::vector<f32> stream(settings.mFrames * 2);
+
+    const u32 numCallbacks = (settings.mSeconds * kAliveAudioSampleRate) / settings.mFrames;
+    for (u32 cb = 0; cb < numCallbacks; cb++)
+    {
+        // Normally done on the game thread
+        sound->Update();
+        if (sound->AtEnd())
+        {
+            sound->Restart();
+        }
+
+        TimeCallback(result, stream, [&](f32* data, u32 len)
+        {
+            reverb.Begin(len);
+            sound->Play(data, reverb.Send(), len);
+            reverb.Mix(data, len);
+        });
+    }
+
+    result.Print(resourceName + " " + InterpolationName(interpolation));
+}
+
+static bool ParseArgs(int argc, char** argv, BenchSettings& settings)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--seconds" && hasValue)
+        {
+            settings.mSeconds = static_cast<u32>(std::max(1, atoi(argv[++i])));
+        }
+        else if (arg == "--frames" && hasValue)
+        {
+            settings.mFrames = static_cast<u32>(std::max(1, atoi(argv[++i])));
+        }
+        else if (arg == "--voices" && hasValue)
+        {
+            settings.mVoiceCounts.clear();
+            std::stringstream ss(argv[++i]);
+            std::string count;
+            while (std::getline(ss, count, ','))
+            {
+                settings.mVoiceCounts.push_back(static_cast<u32>(atoi(count.c_str())));
+            }
+        }
+        else if (arg == "--interp" && hasValue)
+        {
+            const std::string mode = argv[++i];
+            if (mode != "all")
+            {
+                settings.mInterpolations.clear();
+                for (AudioInterpolation interpolation : { AudioInterpolation_none, AudioInterpolation_linear, AudioInterpolation_cubic, AudioInterpolation_hermite })
+                {
+                    if (mode == InterpolationName(interpolation))
+                    {
+                        settings.mInterpolations.push_back(interpolation);
+                    }
+                }
+                if (settings.mInterpolations.empty())
+                {
+                    return false;
+                }
+            }
+        }
+        else if (arg == "--resource" && hasValue)
+        {
+            settings.mResources.emplace_back(argv[++i]);
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    BenchSettings settings;
+    if (!ParseArgs(argc, argv, settings))
+    {
+        printf("Usage: AudioBench [--seconds n] [--frames n] [--voices 1,8,32] [--interp none|linear|cubic|hermite|all] [--resource name]...\n");
+        return 1;
+    }
+
+    stk::Stk::setSampleRate(kAliveAudioSampleRate);
+
+    printf("Rendering %u seconds in callbacks of %u frames\n", settings.mSeconds, settings.mFrames);
+
+    if (settings.mResources.empty())
+    {
+        for (u32 voiceCount : settings.mVoiceCounts)
+        {
+            for (AudioInterpolation interpolation : settings.mInterpolations)
+            {
+                RunSynthetic(settings, voiceCount, interpolation);
+            }
+        }
+        return 0;
+    }
+
+    // Init resources the same way the engine does it
+    GameFileSystem gameFs;
+    if (!gameFs.Init())
+    {
+        LOG_ERROR("Game FS init failed");
+        return 1;
+    }
+
+    DataPaths dataPaths(gameFs,
+        "{GameDir}/data/DataSetIds.json",
+        "{UserDir}/DataSets.json");
+
+    ResourceMapper mapper(gameFs,
+        "{GameDir}/data/dataset_contents.json",
+        "{GameDir}/data/animations.json",
+        "{GameDir}/data/sounds.json",
+        "{GameDir}/data/paths.json",
+        "{GameDir}/data/fmvs.json");
+
+    const auto jsonFiles = gameFs.EnumerateFiles("{GameDir}/data/GameDefinitions", "*.json");
+    std::vector<GameDefinition> gameDefs;
+    for (const auto& gameDef : jsonFiles)
+    {
+        gameDefs.emplace_back(gameFs, (std::string("{GameDir}/data/GameDefinitions") + "/" + gameDef).c_str(), false);
+    }
+
+    ResourceLocator resourceLocator(std::move(mapper), std::move(dataPaths));
+    DataPaths::PathVector dataSet;
+    for (const auto& gd : gameDefs)
+    {
+        DataPaths::Path pd(gd.DataSetName(), &gd);
+        pd.mDataSetPath = resourceLocator.GetDataPaths().PathFor(pd.mDataSetName);
+        dataSet.emplace_back(pd);
+    }
+    resourceLocator.GetDataPaths().SetActiveDataPaths(gameFs, dataSet);
+
+    for (const std::string& resource : settings.mResources)
+    {
+        for (AudioInterpolation interpolation : settings.mInterpolations)
+        {
+            RunResource(settings, resourceLocator, resource, interpolation);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,178 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "SDL.h"
+#include "oddlib/lvlarchive.hpp"
+#include "oddlib/bits_factory.hpp"
+#include "oddlib/stream.hpp"
+#include "logger.hpp"
+#include "msvc_sdl_link.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Decodes every camera in the given LVL files through the same path the engine uses and
+// reports the throughput in MB/s of compressed Bits data, along with a hash of the decoded
+// images so that optimisations can be checked to be bit exact.
+//
+// CameraBench [--repeat n] file.lvl...
+
+struct BenchSettings
+{
+    u32 mRepeat = 5;
+    std::vector<std::string> mLvls;
+};
+
+class BenchResult
+{
+public:
+    void AddCamera(f64 seconds, size_t compressedSize)
+    {
+        mSeconds += seconds;
+        mBytes += compressedSize;
+        mCameras++;
+    }
+
+    void HashImage(const SDL_Surface* surface)
+    {
+        // FNV-1a over the visible pixels, any change in decoding changes the hash
+        const u8* pixels = static_cast<const u8*>(surface->pixels);
+        const u32 rowBytes = surface->w * surface->format->BytesPerPixel;
+        for (int y = 0; y < surface->h; y++)
+        {
+            const u8* row = pixels + (y * surface->pitch);
+            for (u32 i = 0; i < rowBytes; i++)
+            {
+                mHash ^= row[i];
+                mHash *= 1099511628211ull;
+            }
+        }
+    }
+
+    void Add(const BenchResult& other)
+    {
+        mSeconds += other.mSeconds;
+        mBytes += other.mBytes;
+        mCameras += other.mCameras;
+        mHash = (mHash ^ other.mHash) * 1099511628211ull;
+    }
+
+    void Print(const std::string& name) const
+    {
+        const f64 megaBytes = mBytes / (1024.0 * 1024.0);
+        printf("%-24s cameras=%6u in=%9.2fMB %9.2fMB/s %8.3fms/camera hash=%016llx\n",
+            name.c_str(),
+            mCameras,
+            megaBytes,
+            mSeconds > 0.0 ? megaBytes / mSeconds : 0.0,
+            mCameras ? (mSeconds * 1000.0) / mCameras : 0.0,
+            static_cast<unsigned long long>(mHash));
+    }
+
+private:
+    f64 mSeconds = 0.0;
+    u64 mBytes = 0;
+    u32 mCameras = 0;
+    u64 mHash = 14695981039346656037ull;
+};
+
+static BenchResult RunLvl(const BenchSettings& settings, const std::string& lvlName)
+{
+    BenchResult result;
+
+    // Read every Bits chunk up front so that only decoding is timed
+    Oddlib::LvlArchive archive(lvlName);
+    std::vector<std::vector<u8>> cameras;
+    for (u32 i = 0; i < archive.FileCount(); i++)
+    {
+        Oddlib::LvlArchive::File* file = archive.FileByIndex(i);
+        for (u32 j = 0; j < file->ChunkCount(); j++)
+        {
+            Oddlib::LvlArchive::FileChunk* chunk = file->ChunkByIndex(j);
+            if (chunk->Type() == Oddlib::MakeType("Bits"))
+            {
+                cameras.emplace_back(chunk->ReadData());
+            }
+        }
+    }
+
+    for (u32 repeat = 0; repeat < settings.mRepeat; repeat++)
+    {
+        for (const std::vector<u8>& camera : cameras)
+        {
+            std::vector<u8> data = camera;
+            Oddlib::MemoryStream stream(std::move(data));
+
+            const auto start = std::chrono::high_resolution_clock::now();
+            std::unique_ptr<Oddlib::IBits> bits = Oddlib::MakeBits(stream, nullptr);
+            const auto end = std::chrono::high_resolution_clock::now();
+
+            result.AddCamera(std::chrono::duration<f64>(end - start).count(), camera.size());
+
+            // Every repeat decodes the same images so only the first is hashed
+            if (repeat == 0)
+            {
+                result.HashImage(bits->GetSurface());
+            }
+        }
+    }
+
+    result.Print(lvlName);
+    return result;
+}
+
+static bool ParseArgs(int argc, char** argv, BenchSettings& settings)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--repeat" && hasValue)
+        {
+            settings.mRepeat = static_cast<u32>(std::max(1, atoi(argv[++i])));
+        }
+        else if (!arg.empty() && arg[0] != '-')
+        {
+            settings.mLvls.emplace_back(arg);
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return !settings.mLvls.empty();
+}
+
+int main(int argc, char** argv)
+{
+    BenchSettings settings;
+    if (!ParseArgs(argc, argv, settings))
+    {
+        printf("Usage: CameraBench [--repeat n] file.lvl...\n");
+        return 1;
+    }
+
+    printf("Decoding every camera %u times\n", settings.mRepeat);
+
+    BenchResult total;
+    for (const std::string& lvl : settings.mLvls)
+    {
+        try
+        {
+            total.Add(RunLvl(settings, lvl));
+        }
+        catch (const Oddlib::Exception& e)
+        {
+            LOG_ERROR("Failed to decode cameras of " << lvl << ": " << e.what());
+            return 1;
+        }
+    }
+
+    if (settings.mLvls.size() > 1)
+    {
+        total.Print("total");
+    }
+    return 0;
+}
@@ -403,7 +403,7 @@ public:
                         {
                             auto fg1Stream = fg1Chunk->Stream();
                             auto bits = Oddlib::MakeBits(*bitsStream, fg1Stream.get());
-                            bits->GetFg1()->Save(dataSetName);
+                            bits->GetFg1()->Save(dataSetName, bits->GetSurface()->w, bits->GetSurface()->h);
                         }
                     }
                 }